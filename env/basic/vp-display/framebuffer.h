@@ -4,6 +4,8 @@
 #include <cstring>
 
 #define SHMKEY 1338
+// the shared memory segment holds the Framebuffer followed by the FrameUpdate
+#define SHMSIZE (sizeof(Framebuffer) + sizeof(FrameUpdate))
 
 struct Framebuffer {
 	static constexpr uint16_t screenWidth = 800;
@@ -38,6 +40,10 @@ struct Framebuffer {
 		fillFrame,
 		applyFrame,
 		drawLine,
+		fillRect,
+		copyRect,
+		blendRect,
+		drawBitmap,
 	} volatile command;
 	union Parameter {
 		struct {
@@ -52,6 +58,30 @@ struct Framebuffer {
 			PointF to;
 			Color color;
 		} line;
+		struct {
+			//fillRect
+			Type frame;
+			Color color;
+			uint16_t x, y, width, height;
+		} rect;
+		struct {
+			//copyRect (pixels equal to *key* are skipped if *useKey* is set) and blendRect
+			Type src;
+			Type dst;
+			uint16_t srcX, srcY, dstX, dstY, width, height;
+			Color key;
+			uint8_t useKey;
+			uint8_t alpha;  // blendRect: dst = src * alpha / 255 + dst * (255 - alpha) / 255
+		} copy;
+		struct {
+			//drawBitmap (1 bit per pixel, MSB first, each row starts at a new byte)
+			Type frame;
+			uint8_t transparent;  // leave the pixels of cleared bits untouched instead of drawing *bg*
+			uint16_t x, y, width, height;
+			Color fg;
+			Color bg;
+			uint32_t bitmap;  // address in main memory
+		} bitmap;
 		inline Parameter(){};
 	} parameter;
 	Frame frames[2];
@@ -79,6 +109,22 @@ struct Framebuffer {
 	}
 };
 
+/* Not visible to the guest. With each presented frame the VP publishes the screen regions that changed and wakes
+ * the viewer, which waits on *sequence* (futex). *sequence* is odd while the VP writes the update (seqlock). */
+struct FrameUpdate {
+	static constexpr unsigned maxRects = 64;
+
+	struct Rect {
+		uint16_t x;
+		uint16_t y;
+		uint16_t width;
+		uint16_t height;
+	};
+
+	uint32_t sequence;
+	uint32_t numRects;
+	Rect rects[maxRects];
+};
 
 inline Framebuffer::PointF operator+(const Framebuffer::PointF l, Framebuffer::PointF const r) {
 	return Framebuffer::PointF(l.x + r.x, l.y + r.y);
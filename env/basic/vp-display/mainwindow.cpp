@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include <qpainter.h>
+#include <QPaintEvent>
 #include <cassert>
 #include "framebuffer.h"
 #include "ui_mainwindow.h"
@@ -17,18 +18,18 @@ VPDisplay::~VPDisplay() {
 	delete frame;
 }
 
-void VPDisplay::drawMainPage(QImage* mem) {
-	Framebuffer::Frame activeFrame = framebuffer->getActiveFrame();
-	Framebuffer::Frame background = framebuffer->getBackground();
-	for (int row = 0; row < mem->height(); row++) {
+void VPDisplay::drawMainPage(QImage* mem, const QRect& area) {
+	const Framebuffer::Frame& activeFrame = framebuffer->getActiveFrame();
+	const Framebuffer::Frame& background = framebuffer->getBackground();
+	for (int row = area.top(); row <= area.bottom(); row++) {
 		uint16_t* line = reinterpret_cast<uint16_t*>(mem->scanLine(row));  // Two bytes per pixel
-		for (int x = 0; x < mem->width(); x++) {
+		for (int x = area.left(); x <= area.right(); x++) {
 			line[x] = activeFrame.raw[row][x] == 0 ? background.raw[row][x] : activeFrame.raw[row][x];
 		}
 	}
 }
 
-void VPDisplay::paintEvent(QPaintEvent*) {
+void VPDisplay::paintEvent(QPaintEvent* event) {
 	QPainter painter(this);
 
 	// painter.scale(size_factor, size_factor);
@@ -36,12 +37,17 @@ void VPDisplay::paintEvent(QPaintEvent*) {
 	// Draw Header
 	// QPainter mempaint(&memory);
 
-	drawMainPage(frame);
-	painter.drawImage(QPoint(0, 0), *frame);
+	// only the regions reported by the VP (or exposed by the window system)
+	for (const QRect& area : event->region()) {
+		QRect visible = area.intersected(frame->rect());
+		drawMainPage(frame, visible);
+		painter.drawImage(visible.topLeft(), *frame, visible);
+	}
 	painter.end();
 }
 
-void VPDisplay::notifyChange(bool success) {
-	assert(success);
-	update();
+void VPDisplay::notifyChange(const std::vector<FrameUpdate::Rect>& rects) {
+	for (auto& r : rects) {
+		update(r.x, r.y, r.width, r.height);
+	}
 }
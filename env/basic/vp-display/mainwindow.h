@@ -18,7 +18,7 @@ class VPDisplay : public QWidget {
 	~VPDisplay();
 	void paintEvent(QPaintEvent*);
 	// void keyPressEvent(QKeyEvent *e);
-	void drawMainPage(QImage* mem);
+	void drawMainPage(QImage* mem, const QRect& area);
 
-	void notifyChange(bool success);
+	void notifyChange(const std::vector<FrameUpdate::Rect>& rects);
 };
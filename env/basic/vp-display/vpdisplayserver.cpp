@@ -1,9 +1,12 @@
 #include "vpdisplayserver.h"
+#include <linux/futex.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <iostream>
 
 VPDisplayserver::VPDisplayserver(unsigned int sharedMemoryKey) : mSharedMemoryKey(sharedMemoryKey), stop(false) {}
@@ -16,7 +19,7 @@ VPDisplayserver::~VPDisplayserver() {
 Framebuffer* VPDisplayserver::createSM() {
 	int shmid;
 	// TODO: Dont create, but check if exists
-	if ((shmid = shmget(mSharedMemoryKey, sizeof(Framebuffer), 0666)) < 0) {
+	if ((shmid = shmget(mSharedMemoryKey, SHMSIZE, 0666)) < 0) {
 		perror("shmget");
 		exit(1);
 	}
@@ -26,20 +29,44 @@ Framebuffer* VPDisplayserver::createSM() {
 		perror("shmat");
 		exit(1);
 	}
+	update = reinterpret_cast<FrameUpdate*>(reinterpret_cast<uint8_t*>(framebuffer) + sizeof(Framebuffer));
 	return framebuffer;
 }
 
-void VPDisplayserver::startListening(std::function<void(bool)> notifyChange) {
-	// TODO: While loop around buffer changer
+static std::vector<FrameUpdate::Rect> fullScreen() {
+	FrameUpdate::Rect all = {0, 0, Framebuffer::screenWidth, Framebuffer::screenHeight};
+	return std::vector<FrameUpdate::Rect>(1, all);
+}
+
+void VPDisplayserver::startListening(Listener notifyChange) {
 	active_watch = std::thread([=]() {
-		uint8_t lastFrame = -1;
+		uint32_t seen = __atomic_load_n(&update->sequence, __ATOMIC_ACQUIRE);
+		std::vector<FrameUpdate::Rect> rects;
 		while (!stop.load()) {
-			if (framebuffer->activeFrame != lastFrame) {
-				notifyChange(true);
-				lastFrame = framebuffer->activeFrame;
+			uint32_t sequence = __atomic_load_n(&update->sequence, __ATOMIC_ACQUIRE);
+			if (sequence == seen) {
+				// the timeout only serves to notice *stop*
+				struct timespec timeout = {0, 100 * 1000 * 1000};
+				syscall(SYS_futex, &update->sequence, FUTEX_WAIT, sequence, &timeout, nullptr, 0);
+				continue;
+			}
+			if (sequence & 1) {  // the VP is writing the update
+				std::this_thread::yield();
+				continue;
 			}
-			// std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+			uint32_t num = update->numRects;
+			if (num > FrameUpdate::maxRects)  // torn read, checked below
+				num = 0;
+			rects.assign(update->rects, update->rects + num);
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&update->sequence, __ATOMIC_RELAXED) != sequence)
+				continue;  // overwritten while copying
+
+			// missed updates (or a restarted VP) are not tracked, redraw everything
+			notifyChange(sequence == seen + 2 ? rects : fullScreen());
+			seen = sequence;
 		}
 	});
-	notifyChange(true);
+	notifyChange(fullScreen());
 }
@@ -2,17 +2,22 @@
 #include <atomic>
 #include <functional>
 #include <thread>
+#include <vector>
 #include "framebuffer.h"
 
 class VPDisplayserver {
 	unsigned int mSharedMemoryKey;
 	Framebuffer* framebuffer;
+	FrameUpdate* update;
 	std::atomic<bool> stop;
 	std::thread active_watch;
 
    public:
+	// changed screen regions, a single rect covering the screen if updates have been missed
+	typedef std::function<void(const std::vector<FrameUpdate::Rect>&)> Listener;
+
 	VPDisplayserver(unsigned int sharedMemoryKey = 1338);
 	~VPDisplayserver();
 	Framebuffer* createSM();
-	void startListening(std::function<void(bool)> notifyChange);
+	void startListening(Listener notifyChange);
 };
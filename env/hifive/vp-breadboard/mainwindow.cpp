@@ -5,6 +5,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include "ui_mainwindow.h"
 
@@ -301,8 +302,10 @@ void printBin(char* buf, uint8_t len) {
 void VPBreadboard::paintEvent(QPaintEvent*) {
 	QPainter painter(this);
 
+	// the VP pushes the pin changes, update() only applies what arrived
 	if (!inited || !gpio.update()) {
-		inited = gpio.setupConnection(host, port);
+		bool local = strcmp(host, "localhost") == 0 || strcmp(host, "127.0.0.1") == 0;
+		inited = gpio.setupConnection(host, port) && gpio.subscribe(~GpioCommon::Reg(0), local);
 		showConnectionErrorOverlay(painter);
 		if (!inited)
 			usleep(500000);
@@ -7,7 +7,9 @@ static constexpr unsigned int BLOCKSIZE = 512;
 static constexpr unsigned int FLASH_ADDR_REG = 0;
 static constexpr unsigned int FLASH_SIZE_REG = sizeof(uint64_t);
 static constexpr unsigned int DATA_ADDR = FLASH_SIZE_REG + sizeof(uint64_t);
-// static constexpr unsigned int ADDR_SPACE = DATA_ADDR + BLOCKSIZE;
+static constexpr unsigned int FLASH_CTRL_REG = DATA_ADDR + BLOCKSIZE;
+// static constexpr unsigned int ADDR_SPACE = FLASH_CTRL_REG + sizeof(uint32_t);
+static constexpr uint32_t FLASH_CTRL_FLUSH = 1;
 
 static uint8_t* volatile const FLASH_CONTROLLER = (uint8_t * volatile const)(0x71000000);
 
@@ -31,6 +33,10 @@ int main() {
 	writeFlash(reinterpret_cast<char*>(&++counter), 0, sizeof(unsigned long));
 
 	cout << " Counter after: " << counter << endl;
+
+	// the controller caches blocks, make sure the counter is persistent
+	const uint32_t flush = FLASH_CTRL_FLUSH;
+	memcpy(FLASH_CONTROLLER + FLASH_CTRL_REG, &flush, sizeof(uint32_t));
 }
 
 void setTargetBlock(uint64_t addr) {
@@ -51,17 +51,60 @@ void fillRect(Framebuffer::Type frame, PointF ol, PointF ur, Color color) {
 	if (ol.y > ur.y) {
 		std::swap(ol.y, ur.y);
 	}
-	if (ur.x - ol.x > ur.y - ol.y) {
-		// Horizontal
-		for (uint16_t y = ol.y; y <= ur.y; y++) {
-			drawLine(frame, PointF(ol.x, y), PointF(ur.x, y), color);
-		}
-	} else {
-		// Vertical
-		for (uint16_t x = ol.x; x <= ur.x; x++) {
-			drawLine(frame, PointF(x, ol.y), PointF(x, ur.y), color);
-		}
-	}
+	uint16_t x = ol.x, y = ol.y;
+	framebuffer->parameter.rect.frame = frame;
+	framebuffer->parameter.rect.color = color;
+	framebuffer->parameter.rect.x = x;
+	framebuffer->parameter.rect.y = y;
+	framebuffer->parameter.rect.width = uint16_t(ur.x) - x + 1;
+	framebuffer->parameter.rect.height = uint16_t(ur.y) - y + 1;
+	framebuffer->command = Framebuffer::Command::fillRect;
+}
+
+static void transferRect(Framebuffer::Type src, Point from, Framebuffer::Type dst, Point to, uint16_t width,
+                         uint16_t height) {
+	framebuffer->parameter.copy.src = src;
+	framebuffer->parameter.copy.dst = dst;
+	framebuffer->parameter.copy.srcX = from.x;
+	framebuffer->parameter.copy.srcY = from.y;
+	framebuffer->parameter.copy.dstX = to.x;
+	framebuffer->parameter.copy.dstY = to.y;
+	framebuffer->parameter.copy.width = width;
+	framebuffer->parameter.copy.height = height;
+}
+
+void copyRect(Framebuffer::Type src, Point from, Framebuffer::Type dst, Point to, uint16_t width, uint16_t height) {
+	transferRect(src, from, dst, to, width, height);
+	framebuffer->command = Framebuffer::Command::copyRect;
+}
+
+void copyRectKeyed(Framebuffer::Type src, Point from, Framebuffer::Type dst, Point to, uint16_t width, uint16_t height,
+                   Color key) {
+	transferRect(src, from, dst, to, width, height);
+	framebuffer->parameter.copy.key = key;
+	framebuffer->parameter.copy.useKey = 1;
+	framebuffer->command = Framebuffer::Command::copyRect;
+}
+
+void blendRect(Framebuffer::Type src, Point from, Framebuffer::Type dst, Point to, uint16_t width, uint16_t height,
+               uint8_t alpha) {
+	transferRect(src, from, dst, to, width, height);
+	framebuffer->parameter.copy.alpha = alpha;
+	framebuffer->command = Framebuffer::Command::blendRect;
+}
+
+void drawBitmap(Framebuffer::Type frame, Point pos, uint16_t width, uint16_t height, const uint8_t* bitmap, Color fg,
+                Color bg, bool transparent) {
+	framebuffer->parameter.bitmap.frame = frame;
+	framebuffer->parameter.bitmap.transparent = transparent;
+	framebuffer->parameter.bitmap.x = pos.x;
+	framebuffer->parameter.bitmap.y = pos.y;
+	framebuffer->parameter.bitmap.width = width;
+	framebuffer->parameter.bitmap.height = height;
+	framebuffer->parameter.bitmap.fg = fg;
+	framebuffer->parameter.bitmap.bg = bg;
+	framebuffer->parameter.bitmap.bitmap = reinterpret_cast<uintptr_t>(bitmap);
+	framebuffer->command = Framebuffer::Command::drawBitmap;
 }
 
 void applyFrame() {
@@ -28,6 +28,21 @@ void drawRect(Framebuffer::Type frame, Framebuffer::PointF ol, Framebuffer::Poin
 
 void fillRect(Framebuffer::Type frame, Framebuffer::PointF ol, Framebuffer::PointF ur, Framebuffer::Color color);
 
+void copyRect(Framebuffer::Type src, Framebuffer::Point from, Framebuffer::Type dst, Framebuffer::Point to,
+              uint16_t width, uint16_t height);
+
+// pixels of the *key* color are not copied
+void copyRectKeyed(Framebuffer::Type src, Framebuffer::Point from, Framebuffer::Type dst, Framebuffer::Point to,
+                   uint16_t width, uint16_t height, Framebuffer::Color key);
+
+// alpha 255 copies the source, 0 leaves the destination untouched
+void blendRect(Framebuffer::Type src, Framebuffer::Point from, Framebuffer::Type dst, Framebuffer::Point to,
+               uint16_t width, uint16_t height, uint8_t alpha);
+
+// 1 bit per pixel, MSB first, each row of *bitmap* starts at a new byte; a transparent background leaves 0 bits
+void drawBitmap(Framebuffer::Type frame, Framebuffer::Point pos, uint16_t width, uint16_t height,
+                const uint8_t* bitmap, Framebuffer::Color fg, Framebuffer::Color bg, bool transparent = false);
+
 void applyFrame();
 
 void fillFrame(Framebuffer::Type frame = Framebuffer::Type::foreground, Framebuffer::Color color = 0);
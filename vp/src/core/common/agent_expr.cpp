@@ -0,0 +1,258 @@
+#include "agent_expr.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+enum Op : uint8_t {
+	OP_ADD = 0x02,
+	OP_SUB = 0x03,
+	OP_MUL = 0x04,
+	OP_DIV_SIGNED = 0x05,
+	OP_DIV_UNSIGNED = 0x06,
+	OP_REM_SIGNED = 0x07,
+	OP_REM_UNSIGNED = 0x08,
+	OP_LSH = 0x09,
+	OP_RSH_SIGNED = 0x0a,
+	OP_RSH_UNSIGNED = 0x0b,
+	OP_LOG_NOT = 0x0e,
+	OP_BIT_AND = 0x0f,
+	OP_BIT_OR = 0x10,
+	OP_BIT_XOR = 0x11,
+	OP_BIT_NOT = 0x12,
+	OP_EQUAL = 0x13,
+	OP_LESS_SIGNED = 0x14,
+	OP_LESS_UNSIGNED = 0x15,
+	OP_EXT = 0x16,
+	OP_REF8 = 0x17,
+	OP_REF16 = 0x18,
+	OP_REF32 = 0x19,
+	OP_REF64 = 0x1a,
+	OP_IF_GOTO = 0x20,
+	OP_GOTO = 0x21,
+	OP_CONST8 = 0x22,
+	OP_CONST16 = 0x23,
+	OP_CONST32 = 0x24,
+	OP_CONST64 = 0x25,
+	OP_REG = 0x26,
+	OP_END = 0x27,
+	OP_DUP = 0x28,
+	OP_POP = 0x29,
+	OP_ZERO_EXT = 0x2a,
+	OP_SWAP = 0x2b,
+	OP_PICK = 0x32,
+	OP_ROT = 0x33,
+};
+
+// bounds the evaluation of expressions that loop
+constexpr unsigned MAX_STEPS = 100000;
+constexpr size_t MAX_STACK = 1024;
+
+class Machine {
+	const std::vector<uint8_t> &code;
+	std::vector<uint64_t> stack;
+	size_t pc = 0;
+
+   public:
+	Machine(const std::vector<uint8_t> &code) : code(code) {}
+
+	/* big endian immediate of *n* bytes */
+	uint64_t fetch(unsigned n) {
+		if (code.size() - pc < n)
+			throw std::runtime_error("agent expression truncated");
+		uint64_t v = 0;
+		for (unsigned i = 0; i < n; ++i)
+			v = v << 8 | code[pc++];
+		return v;
+	}
+
+	void push(uint64_t v) {
+		if (stack.size() >= MAX_STACK)
+			throw std::runtime_error("agent expression stack overflow");
+		stack.push_back(v);
+	}
+
+	uint64_t pop() {
+		if (stack.empty())
+			throw std::runtime_error("agent expression stack underflow");
+		uint64_t v = stack.back();
+		stack.pop_back();
+		return v;
+	}
+
+	uint64_t &top(size_t depth = 0) {
+		if (stack.size() <= depth)
+			throw std::runtime_error("agent expression stack underflow");
+		return stack[stack.size() - 1 - depth];
+	}
+
+	void jump(uint64_t target) {
+		if (target >= code.size())
+			throw std::runtime_error("agent expression jumps out of bounds");
+		pc = target;
+	}
+
+	int64_t run(agent_expr_env &env) {
+		for (unsigned steps = 0; steps < MAX_STEPS; ++steps) {
+			if (pc >= code.size())
+				throw std::runtime_error("agent expression without end");
+
+			uint8_t op = code[pc++];
+			switch (op) {
+				case OP_ADD: {
+					uint64_t b = pop();
+					top() += b;
+				} break;
+				case OP_SUB: {
+					uint64_t b = pop();
+					top() -= b;
+				} break;
+				case OP_MUL: {
+					uint64_t b = pop();
+					top() *= b;
+				} break;
+				case OP_DIV_SIGNED:
+				case OP_REM_SIGNED: {
+					int64_t b = (int64_t)pop();
+					int64_t a = (int64_t)top();
+					if (b == 0)
+						throw std::runtime_error("agent expression divides by zero");
+					if (b == -1)  // avoids the overflow of INT64_MIN / -1
+						top() = (op == OP_DIV_SIGNED) ? -(uint64_t)a : 0;
+					else
+						top() = (op == OP_DIV_SIGNED) ? a / b : a % b;
+				} break;
+				case OP_DIV_UNSIGNED:
+				case OP_REM_UNSIGNED: {
+					uint64_t b = pop();
+					if (b == 0)
+						throw std::runtime_error("agent expression divides by zero");
+					top() = (op == OP_DIV_UNSIGNED) ? top() / b : top() % b;
+				} break;
+				case OP_LSH: {
+					uint64_t b = pop();
+					top() = b < 64 ? top() << b : 0;
+				} break;
+				case OP_RSH_SIGNED: {
+					uint64_t b = pop();
+					top() = (uint64_t)((int64_t)top() >> (b < 64 ? b : 63));
+				} break;
+				case OP_RSH_UNSIGNED: {
+					uint64_t b = pop();
+					top() = b < 64 ? top() >> b : 0;
+				} break;
+				case OP_LOG_NOT:
+					top() = !top();
+					break;
+				case OP_BIT_AND: {
+					uint64_t b = pop();
+					top() &= b;
+				} break;
+				case OP_BIT_OR: {
+					uint64_t b = pop();
+					top() |= b;
+				} break;
+				case OP_BIT_XOR: {
+					uint64_t b = pop();
+					top() ^= b;
+				} break;
+				case OP_BIT_NOT:
+					top() = ~top();
+					break;
+				case OP_EQUAL: {
+					uint64_t b = pop();
+					top() = top() == b;
+				} break;
+				case OP_LESS_SIGNED: {
+					int64_t b = (int64_t)pop();
+					top() = (int64_t)top() < b;
+				} break;
+				case OP_LESS_UNSIGNED: {
+					uint64_t b = pop();
+					top() = top() < b;
+				} break;
+				case OP_EXT: {
+					uint64_t n = fetch(1);
+					if (n > 0 && n < 64) {
+						uint64_t sign = uint64_t(1) << (n - 1);
+						top() = ((top() & ((sign << 1) - 1)) ^ sign) - sign;
+					}
+				} break;
+				case OP_ZERO_EXT: {
+					uint64_t n = fetch(1);
+					if (n < 64)
+						top() &= (uint64_t(1) << n) - 1;
+				} break;
+				case OP_REF8:
+				case OP_REF16:
+				case OP_REF32:
+				case OP_REF64:
+					top() = env.ax_memory(top(), 1u << (op - OP_REF8));
+					break;
+				case OP_IF_GOTO: {
+					uint64_t target = fetch(2);
+					if (pop())
+						jump(target);
+				} break;
+				case OP_GOTO:
+					jump(fetch(2));
+					break;
+				case OP_CONST8:
+				case OP_CONST16:
+				case OP_CONST32:
+				case OP_CONST64:
+					push(fetch(1u << (op - OP_CONST8)));
+					break;
+				case OP_REG:
+					push(env.ax_register((unsigned)fetch(2)));
+					break;
+				case OP_END:
+					return (int64_t)top();
+				case OP_DUP:
+					push(top());
+					break;
+				case OP_POP:
+					pop();
+					break;
+				case OP_SWAP:
+					std::swap(top(), top(1));
+					break;
+				case OP_PICK:
+					push(top(fetch(1)));
+					break;
+				case OP_ROT: {
+					// a b c => c a b
+					uint64_t c = top();
+					top() = top(1);
+					top(1) = top(2);
+					top(2) = c;
+				} break;
+				default:
+					throw std::runtime_error("unsupported agent expression opcode " + std::to_string(op));
+			}
+		}
+		throw std::runtime_error("agent expression does not terminate");
+	}
+};
+
+}  // namespace
+
+int64_t AgentExpr::eval(agent_expr_env &env) const {
+	return Machine(code).run(env);
+}
+
+bool AgentExpr::any_holds(const std::vector<AgentExpr> &conds, agent_expr_env &env) {
+	if (conds.empty())
+		return true;
+
+	for (auto &c : conds) {
+		try {
+			if (c.eval(env))
+				return true;
+		} catch (const std::runtime_error &) {
+			return true;  // let the user see why
+		}
+	}
+	return false;
+}
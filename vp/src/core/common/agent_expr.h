@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+/* Register and memory access of agent expressions, failed accesses throw std::runtime_error. */
+struct agent_expr_env {
+	virtual ~agent_expr_env() {}
+
+	/* GDB register number (x0-x31, pc = 32) */
+	virtual uint64_t ax_register(unsigned regno) = 0;
+	virtual uint64_t ax_memory(uint64_t addr, unsigned num_bytes) = 0;
+};
+
+/* Bytecode of a GDB agent expression, as sent along with breakpoints to be evaluated on the target (see "Agent
+ * Expressions" in the GDB manual). Only the integer operations are supported, expressions using floating point, trace
+ * state variables or tracing fail to evaluate. */
+class AgentExpr {
+	std::vector<uint8_t> code;
+
+   public:
+	explicit AgentExpr(std::vector<uint8_t> code) : code(std::move(code)) {}
+
+	/* throws std::runtime_error if the expression cannot be evaluated */
+	int64_t eval(agent_expr_env &env) const;
+
+	/* A breakpoint stops if it has no conditions, if one of them holds or if one cannot be evaluated. */
+	static bool any_holds(const std::vector<AgentExpr> &conds, agent_expr_env &env);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <bitset>
+#include <unordered_map>
+#include <vector>
+
+#include "agent_expr.h"
+#include "util/common.h"
+
+/* Breakpoints of a hart with their conditions (see AgentExpr).
+ *
+ * The ISS looks up the pc before every instruction while it has breakpoints. *find* therefore tests a filter with one
+ * bit per page number modulo its size first, only pcs on a page that may contain a breakpoint are looked up in the
+ * map. */
+class Breakpoints {
+	static constexpr unsigned PAGE_SHIFT = 12;
+	static constexpr unsigned FILTER_SIZE = 4096;
+
+	std::unordered_map<uint64_t, std::vector<AgentExpr>> breakpoints;  // pc -> conditions
+	std::bitset<FILTER_SIZE> pages;
+
+	static unsigned filter_index(uint64_t pc) {
+		return (pc >> PAGE_SHIFT) % FILTER_SIZE;
+	}
+
+   public:
+	bool empty() const {
+		return breakpoints.empty();
+	}
+
+	/* inserting a breakpoint again replaces its conditions */
+	void insert(uint64_t pc, const std::vector<AgentExpr> &conds) {
+		breakpoints[pc] = conds;
+		pages.set(filter_index(pc));
+	}
+
+	void erase(uint64_t pc) {
+		breakpoints.erase(pc);
+		pages.reset();
+		for (auto &e : breakpoints)
+			pages.set(filter_index(e.first));
+	}
+
+	/* conditions of the breakpoint at *pc*, nullptr if there is none */
+	inline const std::vector<AgentExpr> *find(uint64_t pc) const {
+		if (likely(!pages[filter_index(pc)]))
+			return nullptr;
+		auto it = breakpoints.find(pc);
+		return it == breakpoints.end() ? nullptr : &it->second;
+	}
+};
@@ -5,6 +5,8 @@
 #include "irq_if.h"
 
 #include <tlm_utils/simple_target_socket.h>
+#include <array>
+#include <iostream>
 #include <systemc>
 
 #include "util/memory_map.h"
@@ -52,22 +54,32 @@ struct CLINT : public clint_if, public sc_core::sc_module {
 	RegisterRange regs_msip{0x0, 4 * NumberOfCores};
 	ArrayView<uint32_t> msip{regs_msip};
 
-	std::vector<RegisterRange *> register_ranges{&regs_mtime, &regs_mtimecmp, &regs_msip};
+	vp::mm::RegisterMap register_map{"CLINT", {&regs_mtime, &regs_mtimecmp, &regs_msip}};
 
 	std::array<clint_interrupt_target *, NumberOfCores> target_harts{};
 
+	static constexpr uint64_t NO_DEADLINE = UINT64_MAX;
+
+	// per hart state, the interrupt lines are only toggled on actual changes
+	std::array<uint64_t, NumberOfCores> deadlines;  // mtime value at which the timer interrupt is due
+	std::array<bool, NumberOfCores> timer_irq_active{};
+	std::array<bool, NumberOfCores> software_irq_active{};
+	std::array<uint64_t, NumberOfCores> num_timer_interrupts{};
+
 	SC_HAS_PROCESS(CLINT);
 
 	CLINT(sc_core::sc_module_name) {
 		tsock.register_b_transport(this, &CLINT::transport);
 
-		regs_mtimecmp.alignment = 4;
-		regs_msip.alignment = 4;
-		regs_mtime.alignment = 4;
+		regs_mtimecmp.set_alignment(4);
+		regs_msip.set_alignment(4);
+		regs_mtime.set_alignment(4);
+
+		regs_mtime.pre_read_callback.bind<CLINT, &CLINT::pre_read_mtime>(this);
+		regs_mtimecmp.post_write_callback.bind<CLINT, &CLINT::post_write_mtimecmp>(this);
+		regs_msip.post_write_callback.bind<CLINT, &CLINT::post_write_msip>(this);
 
-		regs_mtime.pre_read_callback = std::bind(&CLINT::pre_read_mtime, this, std::placeholders::_1);
-		regs_mtimecmp.post_write_callback = std::bind(&CLINT::post_write_mtimecmp, this, std::placeholders::_1);
-		regs_msip.post_write_callback = std::bind(&CLINT::post_write_msip, this, std::placeholders::_1);
+		deadlines.fill(NO_DEADLINE);
 
 		SC_THREAD(run);
 	}
@@ -79,34 +91,45 @@ struct CLINT : public clint_if, public sc_core::sc_module {
 		return mtime;
 	}
 
+	/* Wakes up at the earliest pending deadline (irq_event keeps only its earliest notification) and raises the timer
+	 * interrupt of all harts that are due by then. */
 	void run() {
 		while (true) {
 			sc_core::wait(irq_event);
 
 			update_and_get_mtime();
 
+			uint64_t next = NO_DEADLINE;
 			for (unsigned i = 0; i < NumberOfCores; ++i) {
-				auto cmp = mtimecmp[i];
-				// std::cout << "[vp::clint] process mtimecmp[" << i << "]=" << cmp << ", mtime=" << mtime << std::endl;
-				if (cmp > 0 && mtime >= cmp) {
-					// std::cout << "[vp::clint] set timer interrupt for core " << i << std::endl;
-					target_harts[i]->trigger_timer_interrupt(true);
+				if (deadlines[i] <= mtime) {
+					deadlines[i] = NO_DEADLINE;
+					set_timer_interrupt(i, true);
 				} else {
-					// std::cout << "[vp::clint] unset timer interrupt for core " << i << std::endl;
-					target_harts[i]->trigger_timer_interrupt(false);
-					if (cmp > 0 && cmp < UINT64_MAX) {
-						auto time = sc_core::sc_time::from_value(mtime * scaler);
-						auto goal = sc_core::sc_time::from_value(cmp * scaler);
-						// std::cout << "[vp::clint] time=" << time << std::endl;
-						// std::cout << "[vp::clint] goal=" << goal << std::endl;
-						// std::cout << "[vp::clint] goal-time=delay=" << goal-time << std::endl;
-						irq_event.notify(goal - time);
-					}
+					next = std::min(next, deadlines[i]);
 				}
 			}
+			notify_deadline(next);
 		}
 	}
 
+	void set_timer_interrupt(unsigned hart, bool active) {
+		if (timer_irq_active[hart] == active)
+			return;
+		timer_irq_active[hart] = active;
+		if (active)
+			++num_timer_interrupts[hart];
+		target_harts[hart]->trigger_timer_interrupt(active);
+	}
+
+	void notify_deadline(uint64_t deadline) {
+		// far away deadlines (also the ones written by the two step update sequence on RV32) are not representable
+		if (deadline == NO_DEADLINE || deadline > UINT64_MAX / scaler)
+			return;
+		auto goal = sc_core::sc_time::from_value(deadline * scaler);
+		auto now = sc_core::sc_time_stamp();
+		irq_event.notify(goal > now ? goal - now : sc_core::SC_ZERO_TIME);
+	}
+
 	bool pre_read_mtime(RegisterRange::ReadInfo t) {
 		sc_core::sc_time now = sc_core::sc_time_stamp() + t.delay;
 
@@ -115,23 +138,42 @@ struct CLINT : public clint_if, public sc_core::sc_module {
 		return true;
 	}
 
+	/* Only re-evaluates the written hart, taking the local time offset of the access into account. */
 	void post_write_mtimecmp(RegisterRange::WriteInfo t) {
-		// std::cout << "[vp::clint] write mtimecmp[addr=" << t.addr << "]=" << mtimecmp[t.addr / 8] << ", mtime=" <<
-		// mtime << std::endl;
-		irq_event.notify(t.delay);
+		unsigned idx = t.addr / 8;
+		uint64_t cmp = mtimecmp[idx];
+		uint64_t now = std::max<uint64_t>(mtime, (sc_core::sc_time_stamp() + t.delay).value() / scaler);
+
+		if (cmp > 0 && now >= cmp) {
+			deadlines[idx] = NO_DEADLINE;
+			set_timer_interrupt(idx, true);
+		} else {
+			set_timer_interrupt(idx, false);
+			deadlines[idx] = (cmp > 0) ? cmp : NO_DEADLINE;
+			notify_deadline(deadlines[idx]);
+		}
 	}
 
 	void post_write_msip(RegisterRange::WriteInfo t) {
 		assert(t.addr % 4 == 0);
 		unsigned idx = t.addr / 4;
 		msip[idx] &= 0x1;
-		target_harts[idx]->trigger_software_interrupt(msip[idx] != 0);
+		bool active = msip[idx] != 0;
+		if (software_irq_active[idx] != active) {
+			software_irq_active[idx] = active;
+			target_harts[idx]->trigger_software_interrupt(active);
+		}
+	}
+
+	void show() {
+		for (unsigned i = 0; i < NumberOfCores; ++i)
+			std::cout << "[vp::clint] hart " << i << ": " << num_timer_interrupts[i] << " timer interrupts" << std::endl;
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 		delay += 2 * clock_cycle;
 
-		vp::mm::route("CLINT", register_ranges, trans, delay);
+		register_map.route(trans, delay);
 	}
 };
 
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Access attributes of all 4096 CSR addresses, computed at compile time from the address encoding (see RISC-V
+ * privileged spec, section 2.1), such that the access checks of the CSR instructions need a single table load. Shared
+ * by the RV32 and RV64 cores. */
+struct CsrAccessTable {
+	static constexpr unsigned NUM_ADDRESSES = 4096;
+
+	static constexpr uint8_t PRV_MASK = 0b11;  // lowest privilege level allowed to access the CSR
+	static constexpr uint8_t READ_ONLY = 1 << 2;
+	static constexpr uint8_t COUNTER = 1 << 3;  // user level counter, gated by mcounteren/scounteren
+	static constexpr uint8_t FP = 1 << 4;       // fflags, frm and fcsr, require the F extension
+
+	uint8_t flags[NUM_ADDRESSES];
+
+	constexpr CsrAccessTable() : flags() {
+		for (unsigned addr = 0; addr < NUM_ADDRESSES; ++addr) {
+			uint8_t f = (addr >> 8) & PRV_MASK;
+			if (((addr >> 10) & 0b11) == 0b11)
+				f |= READ_ONLY;
+			if ((addr >= 0xC00 && addr <= 0xC1F) || (addr >= 0xC80 && addr <= 0xC9F))
+				f |= COUNTER;
+			if (addr >= 0x001 && addr <= 0x003)
+				f |= FP;
+			flags[addr] = f;
+		}
+	}
+
+	constexpr uint8_t operator[](unsigned addr) const {
+		return flags[addr];
+	}
+};
+
+constexpr CsrAccessTable CSR_ACCESS_TABLE;
@@ -0,0 +1,1230 @@
+/* Check of the CSR tables of the RV32 and RV64 core (csr_table::entries) against the address switches they replaced
+ * in ISS::get_csr_value and ISS::set_csr_value. For every CSR address, reads and writes with random register
+ * contents and values have to give the same value, the same CSR and PMP state and the same illegal instruction traps.
+ * Both versions are kept verbatim below, based on a minimal hart with the state they depend on.
+ *
+ * Usage: csr-table-check [trials] [seed], the exit status is non-zero if any access differs. */
+
+// the CSR headers expect the core definitions to be included before, like in the ISS headers
+#include "core_defs.h"
+#include "irq_if.h"
+#include "pmp.h"
+
+#include "core/rv32/csr.h"
+#include "core/rv64/csr.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <array>
+#include <initializer_list>
+#include <new>
+#include <random>
+
+namespace {
+
+struct IllegalInstruction {};
+
+}  // namespace
+
+#define RAISE_ILLEGAL_INSTRUCTION() throw IllegalInstruction()
+
+// address ranges of the switches before the CSR table
+#define SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32 \
+	case HPMCOUNTER3_ADDR:                    \
+	case HPMCOUNTER4_ADDR:                    \
+	case HPMCOUNTER5_ADDR:                    \
+	case HPMCOUNTER6_ADDR:                    \
+	case HPMCOUNTER7_ADDR:                    \
+	case HPMCOUNTER8_ADDR:                    \
+	case HPMCOUNTER9_ADDR:                    \
+	case HPMCOUNTER10_ADDR:                   \
+	case HPMCOUNTER11_ADDR:                   \
+	case HPMCOUNTER12_ADDR:                   \
+	case HPMCOUNTER13_ADDR:                   \
+	case HPMCOUNTER14_ADDR:                   \
+	case HPMCOUNTER15_ADDR:                   \
+	case HPMCOUNTER16_ADDR:                   \
+	case HPMCOUNTER17_ADDR:                   \
+	case HPMCOUNTER18_ADDR:                   \
+	case HPMCOUNTER19_ADDR:                   \
+	case HPMCOUNTER20_ADDR:                   \
+	case HPMCOUNTER21_ADDR:                   \
+	case HPMCOUNTER22_ADDR:                   \
+	case HPMCOUNTER23_ADDR:                   \
+	case HPMCOUNTER24_ADDR:                   \
+	case HPMCOUNTER25_ADDR:                   \
+	case HPMCOUNTER26_ADDR:                   \
+	case HPMCOUNTER27_ADDR:                   \
+	case HPMCOUNTER28_ADDR:                   \
+	case HPMCOUNTER29_ADDR:                   \
+	case HPMCOUNTER30_ADDR:                   \
+	case HPMCOUNTER31_ADDR:                   \
+	case HPMCOUNTER3H_ADDR:                   \
+	case HPMCOUNTER4H_ADDR:                   \
+	case HPMCOUNTER5H_ADDR:                   \
+	case HPMCOUNTER6H_ADDR:                   \
+	case HPMCOUNTER7H_ADDR:                   \
+	case HPMCOUNTER8H_ADDR:                   \
+	case HPMCOUNTER9H_ADDR:                   \
+	case HPMCOUNTER10H_ADDR:                  \
+	case HPMCOUNTER11H_ADDR:                  \
+	case HPMCOUNTER12H_ADDR:                  \
+	case HPMCOUNTER13H_ADDR:                  \
+	case HPMCOUNTER14H_ADDR:                  \
+	case HPMCOUNTER15H_ADDR:                  \
+	case HPMCOUNTER16H_ADDR:                  \
+	case HPMCOUNTER17H_ADDR:                  \
+	case HPMCOUNTER18H_ADDR:                  \
+	case HPMCOUNTER19H_ADDR:                  \
+	case HPMCOUNTER20H_ADDR:                  \
+	case HPMCOUNTER21H_ADDR:                  \
+	case HPMCOUNTER22H_ADDR:                  \
+	case HPMCOUNTER23H_ADDR:                  \
+	case HPMCOUNTER24H_ADDR:                  \
+	case HPMCOUNTER25H_ADDR:                  \
+	case HPMCOUNTER26H_ADDR:                  \
+	case HPMCOUNTER27H_ADDR:                  \
+	case HPMCOUNTER28H_ADDR:                  \
+	case HPMCOUNTER29H_ADDR:                  \
+	case HPMCOUNTER30H_ADDR:                  \
+	case HPMCOUNTER31H_ADDR:                  \
+	case MHPMCOUNTER3_ADDR:                   \
+	case MHPMCOUNTER4_ADDR:                   \
+	case MHPMCOUNTER5_ADDR:                   \
+	case MHPMCOUNTER6_ADDR:                   \
+	case MHPMCOUNTER7_ADDR:                   \
+	case MHPMCOUNTER8_ADDR:                   \
+	case MHPMCOUNTER9_ADDR:                   \
+	case MHPMCOUNTER10_ADDR:                  \
+	case MHPMCOUNTER11_ADDR:                  \
+	case MHPMCOUNTER12_ADDR:                  \
+	case MHPMCOUNTER13_ADDR:                  \
+	case MHPMCOUNTER14_ADDR:                  \
+	case MHPMCOUNTER15_ADDR:                  \
+	case MHPMCOUNTER16_ADDR:                  \
+	case MHPMCOUNTER17_ADDR:                  \
+	case MHPMCOUNTER18_ADDR:                  \
+	case MHPMCOUNTER19_ADDR:                  \
+	case MHPMCOUNTER20_ADDR:                  \
+	case MHPMCOUNTER21_ADDR:                  \
+	case MHPMCOUNTER22_ADDR:                  \
+	case MHPMCOUNTER23_ADDR:                  \
+	case MHPMCOUNTER24_ADDR:                  \
+	case MHPMCOUNTER25_ADDR:                  \
+	case MHPMCOUNTER26_ADDR:                  \
+	case MHPMCOUNTER27_ADDR:                  \
+	case MHPMCOUNTER28_ADDR:                  \
+	case MHPMCOUNTER29_ADDR:                  \
+	case MHPMCOUNTER30_ADDR:                  \
+	case MHPMCOUNTER31_ADDR:                  \
+	case MHPMCOUNTER3H_ADDR:                  \
+	case MHPMCOUNTER4H_ADDR:                  \
+	case MHPMCOUNTER5H_ADDR:                  \
+	case MHPMCOUNTER6H_ADDR:                  \
+	case MHPMCOUNTER7H_ADDR:                  \
+	case MHPMCOUNTER8H_ADDR:                  \
+	case MHPMCOUNTER9H_ADDR:                  \
+	case MHPMCOUNTER10H_ADDR:                 \
+	case MHPMCOUNTER11H_ADDR:                 \
+	case MHPMCOUNTER12H_ADDR:                 \
+	case MHPMCOUNTER13H_ADDR:                 \
+	case MHPMCOUNTER14H_ADDR:                 \
+	case MHPMCOUNTER15H_ADDR:                 \
+	case MHPMCOUNTER16H_ADDR:                 \
+	case MHPMCOUNTER17H_ADDR:                 \
+	case MHPMCOUNTER18H_ADDR:                 \
+	case MHPMCOUNTER19H_ADDR:                 \
+	case MHPMCOUNTER20H_ADDR:                 \
+	case MHPMCOUNTER21H_ADDR:                 \
+	case MHPMCOUNTER22H_ADDR:                 \
+	case MHPMCOUNTER23H_ADDR:                 \
+	case MHPMCOUNTER24H_ADDR:                 \
+	case MHPMCOUNTER25H_ADDR:                 \
+	case MHPMCOUNTER26H_ADDR:                 \
+	case MHPMCOUNTER27H_ADDR:                 \
+	case MHPMCOUNTER28H_ADDR:                 \
+	case MHPMCOUNTER29H_ADDR:                 \
+	case MHPMCOUNTER30H_ADDR:                 \
+	case MHPMCOUNTER31H_ADDR:                 \
+	case MHPMEVENT3_ADDR:                     \
+	case MHPMEVENT4_ADDR:                     \
+	case MHPMEVENT5_ADDR:                     \
+	case MHPMEVENT6_ADDR:                     \
+	case MHPMEVENT7_ADDR:                     \
+	case MHPMEVENT8_ADDR:                     \
+	case MHPMEVENT9_ADDR:                     \
+	case MHPMEVENT10_ADDR:                    \
+	case MHPMEVENT11_ADDR:                    \
+	case MHPMEVENT12_ADDR:                    \
+	case MHPMEVENT13_ADDR:                    \
+	case MHPMEVENT14_ADDR:                    \
+	case MHPMEVENT15_ADDR:                    \
+	case MHPMEVENT16_ADDR:                    \
+	case MHPMEVENT17_ADDR:                    \
+	case MHPMEVENT18_ADDR:                    \
+	case MHPMEVENT19_ADDR:                    \
+	case MHPMEVENT20_ADDR:                    \
+	case MHPMEVENT21_ADDR:                    \
+	case MHPMEVENT22_ADDR:                    \
+	case MHPMEVENT23_ADDR:                    \
+	case MHPMEVENT24_ADDR:                    \
+	case MHPMEVENT25_ADDR:                    \
+	case MHPMEVENT26_ADDR:                    \
+	case MHPMEVENT27_ADDR:                    \
+	case MHPMEVENT28_ADDR:                    \
+	case MHPMEVENT29_ADDR:                    \
+	case MHPMEVENT30_ADDR:                    \
+	case MHPMEVENT31_ADDR
+
+#define SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV64 \
+	case HPMCOUNTER3_ADDR:                    \
+	case HPMCOUNTER4_ADDR:                    \
+	case HPMCOUNTER5_ADDR:                    \
+	case HPMCOUNTER6_ADDR:                    \
+	case HPMCOUNTER7_ADDR:                    \
+	case HPMCOUNTER8_ADDR:                    \
+	case HPMCOUNTER9_ADDR:                    \
+	case HPMCOUNTER10_ADDR:                   \
+	case HPMCOUNTER11_ADDR:                   \
+	case HPMCOUNTER12_ADDR:                   \
+	case HPMCOUNTER13_ADDR:                   \
+	case HPMCOUNTER14_ADDR:                   \
+	case HPMCOUNTER15_ADDR:                   \
+	case HPMCOUNTER16_ADDR:                   \
+	case HPMCOUNTER17_ADDR:                   \
+	case HPMCOUNTER18_ADDR:                   \
+	case HPMCOUNTER19_ADDR:                   \
+	case HPMCOUNTER20_ADDR:                   \
+	case HPMCOUNTER21_ADDR:                   \
+	case HPMCOUNTER22_ADDR:                   \
+	case HPMCOUNTER23_ADDR:                   \
+	case HPMCOUNTER24_ADDR:                   \
+	case HPMCOUNTER25_ADDR:                   \
+	case HPMCOUNTER26_ADDR:                   \
+	case HPMCOUNTER27_ADDR:                   \
+	case HPMCOUNTER28_ADDR:                   \
+	case HPMCOUNTER29_ADDR:                   \
+	case HPMCOUNTER30_ADDR:                   \
+	case HPMCOUNTER31_ADDR:                   \
+	case MHPMCOUNTER3_ADDR:                   \
+	case MHPMCOUNTER4_ADDR:                   \
+	case MHPMCOUNTER5_ADDR:                   \
+	case MHPMCOUNTER6_ADDR:                   \
+	case MHPMCOUNTER7_ADDR:                   \
+	case MHPMCOUNTER8_ADDR:                   \
+	case MHPMCOUNTER9_ADDR:                   \
+	case MHPMCOUNTER10_ADDR:                  \
+	case MHPMCOUNTER11_ADDR:                  \
+	case MHPMCOUNTER12_ADDR:                  \
+	case MHPMCOUNTER13_ADDR:                  \
+	case MHPMCOUNTER14_ADDR:                  \
+	case MHPMCOUNTER15_ADDR:                  \
+	case MHPMCOUNTER16_ADDR:                  \
+	case MHPMCOUNTER17_ADDR:                  \
+	case MHPMCOUNTER18_ADDR:                  \
+	case MHPMCOUNTER19_ADDR:                  \
+	case MHPMCOUNTER20_ADDR:                  \
+	case MHPMCOUNTER21_ADDR:                  \
+	case MHPMCOUNTER22_ADDR:                  \
+	case MHPMCOUNTER23_ADDR:                  \
+	case MHPMCOUNTER24_ADDR:                  \
+	case MHPMCOUNTER25_ADDR:                  \
+	case MHPMCOUNTER26_ADDR:                  \
+	case MHPMCOUNTER27_ADDR:                  \
+	case MHPMCOUNTER28_ADDR:                  \
+	case MHPMCOUNTER29_ADDR:                  \
+	case MHPMCOUNTER30_ADDR:                  \
+	case MHPMCOUNTER31_ADDR:                  \
+	case MHPMEVENT3_ADDR:                     \
+	case MHPMEVENT4_ADDR:                     \
+	case MHPMEVENT5_ADDR:                     \
+	case MHPMEVENT6_ADDR:                     \
+	case MHPMEVENT7_ADDR:                     \
+	case MHPMEVENT8_ADDR:                     \
+	case MHPMEVENT9_ADDR:                     \
+	case MHPMEVENT10_ADDR:                    \
+	case MHPMEVENT11_ADDR:                    \
+	case MHPMEVENT12_ADDR:                    \
+	case MHPMEVENT13_ADDR:                    \
+	case MHPMEVENT14_ADDR:                    \
+	case MHPMEVENT15_ADDR:                    \
+	case MHPMEVENT16_ADDR:                    \
+	case MHPMEVENT17_ADDR:                    \
+	case MHPMEVENT18_ADDR:                    \
+	case MHPMEVENT19_ADDR:                    \
+	case MHPMEVENT20_ADDR:                    \
+	case MHPMEVENT21_ADDR:                    \
+	case MHPMEVENT22_ADDR:                    \
+	case MHPMEVENT23_ADDR:                    \
+	case MHPMEVENT24_ADDR:                    \
+	case MHPMEVENT25_ADDR:                    \
+	case MHPMEVENT26_ADDR:                    \
+	case MHPMEVENT27_ADDR:                    \
+	case MHPMEVENT28_ADDR:                    \
+	case MHPMEVENT29_ADDR:                    \
+	case MHPMEVENT30_ADDR:                    \
+	case MHPMEVENT31_ADDR
+
+#define SWITCH_CASE_MATCH_ANY_PMPADDR \
+	case PMPADDR0_ADDR:               \
+	case PMPADDR1_ADDR:               \
+	case PMPADDR2_ADDR:               \
+	case PMPADDR3_ADDR:               \
+	case PMPADDR4_ADDR:               \
+	case PMPADDR5_ADDR:               \
+	case PMPADDR6_ADDR:               \
+	case PMPADDR7_ADDR:               \
+	case PMPADDR8_ADDR:               \
+	case PMPADDR9_ADDR:               \
+	case PMPADDR10_ADDR:              \
+	case PMPADDR11_ADDR:              \
+	case PMPADDR12_ADDR:              \
+	case PMPADDR13_ADDR:              \
+	case PMPADDR14_ADDR:              \
+	case PMPADDR15_ADDR
+
+namespace rv32 {
+
+/* The state the CSR accesses of the ISS depend on */
+struct Hart {
+	csr_table csrs;
+	PMP pmp{32};
+	uint64_t mtime = 0;
+	uint64_t cycles = 0;
+	bool compressed = true;
+	Hart *clint = this;
+
+	// the address mapping of the default accesses before the CSR table
+	std::array<uint32_t *, CsrAccessTable::NUM_ADDRESSES> register_mapping{};
+
+	Hart() {
+		using namespace csr;
+
+		register_mapping[CYCLE_ADDR] = (uint32_t *)(&csrs.cycle.reg);
+		register_mapping[CYCLEH_ADDR] = (uint32_t *)(&csrs.cycle.reg) + 1;
+		register_mapping[TIME_ADDR] = (uint32_t *)(&csrs.time.reg);
+		register_mapping[TIMEH_ADDR] = (uint32_t *)(&csrs.time.reg) + 1;
+		register_mapping[INSTRET_ADDR] = (uint32_t *)(&csrs.instret.reg);
+		register_mapping[INSTRETH_ADDR] = (uint32_t *)(&csrs.instret.reg) + 1;
+		register_mapping[MCYCLE_ADDR] = (uint32_t *)(&csrs.cycle.reg);
+		register_mapping[MCYCLEH_ADDR] = (uint32_t *)(&csrs.cycle.reg) + 1;
+		register_mapping[MTIME_ADDR] = (uint32_t *)(&csrs.time.reg);
+		register_mapping[MTIMEH_ADDR] = (uint32_t *)(&csrs.time.reg) + 1;
+		register_mapping[MINSTRET_ADDR] = (uint32_t *)(&csrs.instret.reg);
+		register_mapping[MINSTRETH_ADDR] = (uint32_t *)(&csrs.instret.reg) + 1;
+
+		register_mapping[MVENDORID_ADDR] = &csrs.mvendorid.reg;
+		register_mapping[MARCHID_ADDR] = &csrs.marchid.reg;
+		register_mapping[MIMPID_ADDR] = &csrs.mimpid.reg;
+		register_mapping[MHARTID_ADDR] = &csrs.mhartid.reg;
+
+		register_mapping[MSTATUS_ADDR] = &csrs.mstatus.reg;
+		register_mapping[MISA_ADDR] = &csrs.misa.reg;
+		register_mapping[MEDELEG_ADDR] = &csrs.medeleg.reg;
+		register_mapping[MIDELEG_ADDR] = &csrs.mideleg.reg;
+		register_mapping[MIE_ADDR] = &csrs.mie.reg;
+		register_mapping[MTVEC_ADDR] = &csrs.mtvec.reg;
+		register_mapping[MCOUNTEREN_ADDR] = &csrs.mcounteren.reg;
+		register_mapping[MCOUNTINHIBIT_ADDR] = &csrs.mcountinhibit.reg;
+
+		register_mapping[MSCRATCH_ADDR] = &csrs.mscratch.reg;
+		register_mapping[MEPC_ADDR] = &csrs.mepc.reg;
+		register_mapping[MCAUSE_ADDR] = &csrs.mcause.reg;
+		register_mapping[MTVAL_ADDR] = &csrs.mtval.reg;
+		register_mapping[MIP_ADDR] = &csrs.mip.reg;
+
+		for (unsigned i = 0; i < 16; ++i) register_mapping[PMPADDR0_ADDR + i] = &csrs.pmpaddr[i].reg;
+
+		for (unsigned i = 0; i < 4; ++i) register_mapping[PMPCFG0_ADDR + i] = &csrs.pmpcfg[i].reg;
+
+		register_mapping[SEDELEG_ADDR] = &csrs.sedeleg.reg;
+		register_mapping[SIDELEG_ADDR] = &csrs.sideleg.reg;
+		register_mapping[STVEC_ADDR] = &csrs.stvec.reg;
+		register_mapping[SCOUNTEREN_ADDR] = &csrs.scounteren.reg;
+		register_mapping[SSCRATCH_ADDR] = &csrs.sscratch.reg;
+		register_mapping[SEPC_ADDR] = &csrs.sepc.reg;
+		register_mapping[SCAUSE_ADDR] = &csrs.scause.reg;
+		register_mapping[STVAL_ADDR] = &csrs.stval.reg;
+		register_mapping[SATP_ADDR] = &csrs.satp.reg;
+
+		register_mapping[UTVEC_ADDR] = &csrs.utvec.reg;
+		register_mapping[USCRATCH_ADDR] = &csrs.uscratch.reg;
+		register_mapping[UEPC_ADDR] = &csrs.uepc.reg;
+		register_mapping[UCAUSE_ADDR] = &csrs.ucause.reg;
+		register_mapping[UTVAL_ADDR] = &csrs.utval.reg;
+
+		register_mapping[FCSR_ADDR] = &csrs.fcsr.reg;
+	}
+
+	uint64_t update_and_get_mtime() {
+		return mtime;
+	}
+
+	uint64_t _compute_and_get_current_cycles() {
+		return cycles;
+	}
+
+	uint32_t pc_alignment_mask() {
+		return compressed ? ~0x1u : ~0x3u;
+	}
+
+	void validate_csr_counter_read_access_rights(uint64_t) {}
+
+	bool is_valid_csr_addr(unsigned addr) {
+		return register_mapping[addr] != nullptr;
+	}
+
+	uint32_t default_read(unsigned addr) {
+		return *register_mapping[addr];
+	}
+
+	void default_write(unsigned addr, uint32_t value) {
+		*register_mapping[addr] = value;
+	}
+
+	// before the CSR table
+	uint32_t baseline_get_csr_value(uint32_t addr) {
+		validate_csr_counter_read_access_rights(addr);
+
+		auto read = [=](auto &x, uint32_t mask) { return x.reg & mask; };
+
+		using namespace csr;
+
+		switch (addr) {
+			case TIME_ADDR:
+			case MTIME_ADDR: {
+				uint64_t mtime = clint->update_and_get_mtime();
+				csrs.time.reg = mtime;
+				return csrs.time.low;
+			}
+
+			case TIMEH_ADDR:
+			case MTIMEH_ADDR: {
+				uint64_t mtime = clint->update_and_get_mtime();
+				csrs.time.reg = mtime;
+				return csrs.time.high;
+			}
+
+			case MCYCLE_ADDR:
+				csrs.cycle.reg = _compute_and_get_current_cycles();
+				return csrs.cycle.low;
+
+			case MCYCLEH_ADDR:
+				csrs.cycle.reg = _compute_and_get_current_cycles();
+				return csrs.cycle.high;
+
+			case MINSTRET_ADDR:
+				return csrs.instret.low;
+
+			case MINSTRETH_ADDR:
+				return csrs.instret.high;
+
+			SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32:  // not implemented
+				return 0;
+
+			case MSTATUS_ADDR:
+				return read(csrs.mstatus, MSTATUS_MASK);
+			case SSTATUS_ADDR:
+				return read(csrs.mstatus, SSTATUS_MASK);
+			case USTATUS_ADDR:
+				return read(csrs.mstatus, USTATUS_MASK);
+
+			case MIP_ADDR:
+				return read(csrs.mip, MIP_READ_MASK);
+			case SIP_ADDR:
+				return read(csrs.mip, SIP_MASK);
+			case UIP_ADDR:
+				return read(csrs.mip, UIP_MASK);
+
+			case MIE_ADDR:
+				return read(csrs.mie, MIE_MASK);
+			case SIE_ADDR:
+				return read(csrs.mie, SIE_MASK);
+			case UIE_ADDR:
+				return read(csrs.mie, UIE_MASK);
+
+			case SATP_ADDR:
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case FCSR_ADDR:
+				return read(csrs.fcsr, FCSR_MASK);
+
+			case FFLAGS_ADDR:
+				return csrs.fcsr.fflags;
+
+			case FRM_ADDR:
+				return csrs.fcsr.frm;
+
+	        // debug CSRs not supported, thus hardwired
+	        case TSELECT_ADDR:
+	            return 1; // if a zero write by SW is preserved, then debug mode is supported (thus hardwire to non-zero)
+	        case TDATA1_ADDR:
+	        case TDATA2_ADDR:
+	        case TDATA3_ADDR:
+	        case DCSR_ADDR:
+	        case DPC_ADDR:
+	        case DSCRATCH0_ADDR:
+	        case DSCRATCH1_ADDR:
+	            return 0;
+		}
+
+		if (!is_valid_csr_addr(addr))
+			RAISE_ILLEGAL_INSTRUCTION();
+
+		return default_read(addr);
+	}
+
+	void baseline_set_csr_value(uint32_t addr, uint32_t value) {
+		auto write = [=](auto &x, uint32_t mask) { x.reg = (x.reg & ~mask) | (value & mask); };
+
+		using namespace csr;
+
+		switch (addr) {
+			case MISA_ADDR:                         // currently, read-only, thus cannot be changed at runtime
+			SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32:  // not implemented
+				break;
+
+	        case SATP_ADDR: {
+	            if (csrs.mstatus.tvm)
+	                RAISE_ILLEGAL_INSTRUCTION();
+	            write(csrs.satp, SATP_MASK);
+	            // std::cout << "[iss] satp=" << boost::format("%x") % csrs.satp.reg << std::endl;
+	        } break;
+
+			case MTVEC_ADDR:
+				write(csrs.mtvec, MTVEC_MASK);
+				break;
+			case STVEC_ADDR:
+				write(csrs.stvec, MTVEC_MASK);
+				break;
+			case UTVEC_ADDR:
+				write(csrs.utvec, MTVEC_MASK);
+				break;
+
+			case MEPC_ADDR:
+				write(csrs.mepc, pc_alignment_mask());
+				break;
+			case SEPC_ADDR:
+				write(csrs.sepc, pc_alignment_mask());
+				break;
+			case UEPC_ADDR:
+				write(csrs.uepc, pc_alignment_mask());
+				break;
+
+			case MSTATUS_ADDR:
+				write(csrs.mstatus, MSTATUS_MASK);
+				break;
+			case SSTATUS_ADDR:
+				write(csrs.mstatus, SSTATUS_MASK);
+				break;
+			case USTATUS_ADDR:
+				write(csrs.mstatus, USTATUS_MASK);
+				break;
+
+			case MIP_ADDR:
+				write(csrs.mip, MIP_WRITE_MASK);
+				break;
+			case SIP_ADDR:
+				write(csrs.mip, SIP_MASK);
+				break;
+			case UIP_ADDR:
+				write(csrs.mip, UIP_MASK);
+				break;
+
+			case MIE_ADDR:
+				write(csrs.mie, MIE_MASK);
+				break;
+			case SIE_ADDR:
+				write(csrs.mie, SIE_MASK);
+				break;
+			case UIE_ADDR:
+				write(csrs.mie, UIE_MASK);
+				break;
+
+			case MIDELEG_ADDR:
+				write(csrs.mideleg, MIDELEG_MASK);
+				break;
+
+			case MEDELEG_ADDR:
+				write(csrs.medeleg, MEDELEG_MASK);
+				break;
+
+			case SIDELEG_ADDR:
+				write(csrs.sideleg, SIDELEG_MASK);
+				break;
+
+			case SEDELEG_ADDR:
+				write(csrs.sedeleg, SEDELEG_MASK);
+				break;
+
+			case MCOUNTEREN_ADDR:
+				write(csrs.mcounteren, MCOUNTEREN_MASK);
+				break;
+
+			case SCOUNTEREN_ADDR:
+				write(csrs.scounteren, MCOUNTEREN_MASK);
+				break;
+
+			case MCOUNTINHIBIT_ADDR:
+				write(csrs.mcountinhibit, MCOUNTINHIBIT_MASK);
+				break;
+
+			case PMPCFG0_ADDR:
+			case PMPCFG1_ADDR:
+			case PMPCFG2_ADDR:
+			case PMPCFG3_ADDR: {
+				unsigned n = addr - PMPCFG0_ADDR;
+				uint32_t reg = 0;
+				for (unsigned i = 0; i < 4; ++i) {
+					pmp.set_cfg(n * 4 + i, value >> (i * 8));
+					reg |= (uint32_t)pmp.get_cfg(n * 4 + i) << (i * 8);
+				}
+				csrs.pmpcfg[n].reg = reg;
+			} break;
+
+			SWITCH_CASE_MATCH_ANY_PMPADDR: {
+				unsigned n = addr - PMPADDR0_ADDR;
+				pmp.set_addr(n, value);
+				csrs.pmpaddr[n].reg = pmp.get_addr(n);
+			} break;
+
+			case FCSR_ADDR:
+				write(csrs.fcsr, FCSR_MASK);
+				break;
+
+			case FFLAGS_ADDR:
+				csrs.fcsr.fflags = value;
+				break;
+
+			case FRM_ADDR:
+				csrs.fcsr.frm = value;
+				break;
+
+	        // debug CSRs not supported, thus hardwired
+	        case TSELECT_ADDR:
+	        case TDATA1_ADDR:
+	        case TDATA2_ADDR:
+	        case TDATA3_ADDR:
+	        case DCSR_ADDR:
+	        case DPC_ADDR:
+	        case DSCRATCH0_ADDR:
+	        case DSCRATCH1_ADDR:
+	            break;
+
+			default:
+				if (!is_valid_csr_addr(addr))
+					RAISE_ILLEGAL_INSTRUCTION();
+
+				default_write(addr, value);
+		}
+	}
+
+	// CSR table
+	uint32_t get_csr_value(uint32_t addr) {
+		validate_csr_counter_read_access_rights(addr);
+
+		using Handler = csr_table::Handler;
+
+		auto &e = csrs.entries[addr];
+		switch (e.handler) {
+			case Handler::Invalid:
+				RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Time:
+				csrs.time.reg = clint->update_and_get_mtime();
+				break;
+
+			case Handler::Cycle:
+				csrs.cycle.reg = _compute_and_get_current_cycles();
+				break;
+
+			case Handler::Satp:
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Fflags:
+				return csrs.fcsr.fflags;
+
+			case Handler::Frm:
+				return csrs.fcsr.frm;
+
+			default:
+				break;
+		}
+
+		return *e.reg & e.read_mask;
+	}
+
+	void set_csr_value(uint32_t addr, uint32_t value) {
+		using Handler = csr_table::Handler;
+		using namespace csr;
+
+		auto &e = csrs.entries[addr];
+		uint32_t mask = e.write_mask;
+		switch (e.handler) {
+			case Handler::Invalid:
+				RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Satp:
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Epc:
+				mask = pc_alignment_mask();
+				break;
+
+			case Handler::Pmpcfg: {
+				unsigned n = addr - PMPCFG0_ADDR;
+				uint32_t reg = 0;
+				for (unsigned i = 0; i < 4; ++i) {
+					pmp.set_cfg(n * 4 + i, value >> (i * 8));
+					reg |= (uint32_t)pmp.get_cfg(n * 4 + i) << (i * 8);
+				}
+				csrs.pmpcfg[n].reg = reg;
+				return;
+			}
+
+			case Handler::Pmpaddr: {
+				unsigned n = addr - PMPADDR0_ADDR;
+				pmp.set_addr(n, value);
+				csrs.pmpaddr[n].reg = pmp.get_addr(n);
+				return;
+			}
+
+			case Handler::Fflags:
+				csrs.fcsr.fflags = value;
+				return;
+
+			case Handler::Frm:
+				csrs.fcsr.frm = value;
+				return;
+
+			default:
+				break;
+		}
+
+		*e.reg = (*e.reg & ~mask) | (value & mask);
+	}
+};
+
+}  // namespace rv32
+
+namespace rv64 {
+
+/* The state the CSR accesses of the ISS depend on */
+struct Hart {
+	csr_table csrs;
+	PMP pmp{64};
+	uint64_t mtime = 0;
+	uint64_t cycles = 0;
+	bool compressed = true;
+	Hart *clint = this;
+
+	// the address mapping of the default accesses before the CSR table
+	std::array<uint64_t *, CsrAccessTable::NUM_ADDRESSES> register_mapping{};
+
+	Hart() {
+		using namespace csr;
+
+		register_mapping[CYCLE_ADDR] = &csrs.cycle.reg;
+		register_mapping[TIME_ADDR] = &csrs.time.reg;
+		register_mapping[INSTRET_ADDR] = &csrs.instret.reg;
+		register_mapping[MCYCLE_ADDR] = &csrs.cycle.reg;
+		register_mapping[MTIME_ADDR] = &csrs.time.reg;
+		register_mapping[MINSTRET_ADDR] = &csrs.instret.reg;
+
+		register_mapping[MVENDORID_ADDR] = &csrs.mvendorid.reg;
+		register_mapping[MARCHID_ADDR] = &csrs.marchid.reg;
+		register_mapping[MIMPID_ADDR] = &csrs.mimpid.reg;
+		register_mapping[MHARTID_ADDR] = &csrs.mhartid.reg;
+
+		register_mapping[MSTATUS_ADDR] = &csrs.mstatus.reg;
+		register_mapping[MISA_ADDR] = &csrs.misa.reg;
+		register_mapping[MEDELEG_ADDR] = &csrs.medeleg.reg;
+		register_mapping[MIDELEG_ADDR] = &csrs.mideleg.reg;
+		register_mapping[MIE_ADDR] = &csrs.mie.reg;
+		register_mapping[MTVEC_ADDR] = &csrs.mtvec.reg;
+		register_mapping[MCOUNTEREN_ADDR] = &csrs.mcounteren.reg;
+		register_mapping[MCOUNTINHIBIT_ADDR] = &csrs.mcountinhibit.reg;
+
+		register_mapping[MSCRATCH_ADDR] = &csrs.mscratch.reg;
+		register_mapping[MEPC_ADDR] = &csrs.mepc.reg;
+		register_mapping[MCAUSE_ADDR] = &csrs.mcause.reg;
+		register_mapping[MTVAL_ADDR] = &csrs.mtval.reg;
+		register_mapping[MIP_ADDR] = &csrs.mip.reg;
+
+		for (unsigned i = 0; i < 16; ++i) register_mapping[PMPADDR0_ADDR + i] = &csrs.pmpaddr[i].reg;
+
+		// RV64 only has the even numbered pmpcfg registers
+		register_mapping[PMPCFG0_ADDR] = &csrs.pmpcfg[0].reg;
+		register_mapping[PMPCFG2_ADDR] = &csrs.pmpcfg[1].reg;
+
+		register_mapping[SEDELEG_ADDR] = &csrs.sedeleg.reg;
+		register_mapping[SIDELEG_ADDR] = &csrs.sideleg.reg;
+		register_mapping[STVEC_ADDR] = &csrs.stvec.reg;
+		register_mapping[SCOUNTEREN_ADDR] = &csrs.scounteren.reg;
+		register_mapping[SSCRATCH_ADDR] = &csrs.sscratch.reg;
+		register_mapping[SEPC_ADDR] = &csrs.sepc.reg;
+		register_mapping[SCAUSE_ADDR] = &csrs.scause.reg;
+		register_mapping[STVAL_ADDR] = &csrs.stval.reg;
+		register_mapping[SATP_ADDR] = &csrs.satp.reg;
+
+		register_mapping[UTVEC_ADDR] = &csrs.utvec.reg;
+		register_mapping[USCRATCH_ADDR] = &csrs.uscratch.reg;
+		register_mapping[UEPC_ADDR] = &csrs.uepc.reg;
+		register_mapping[UCAUSE_ADDR] = &csrs.ucause.reg;
+		register_mapping[UTVAL_ADDR] = &csrs.utval.reg;
+
+		register_mapping[FCSR_ADDR] = &csrs.fcsr.reg;
+	}
+
+	uint64_t update_and_get_mtime() {
+		return mtime;
+	}
+
+	uint64_t _compute_and_get_current_cycles() {
+		return cycles;
+	}
+
+	uint64_t pc_alignment_mask() {
+		return compressed ? ~uint64_t(0x1) : ~uint64_t(0x3);
+	}
+
+	void validate_csr_counter_read_access_rights(uint64_t) {}
+
+	bool is_valid_csr_addr(unsigned addr) {
+		return register_mapping[addr] != nullptr;
+	}
+
+	uint64_t default_read(unsigned addr) {
+		return *register_mapping[addr];
+	}
+
+	void default_write(unsigned addr, uint64_t value) {
+		*register_mapping[addr] = value;
+	}
+
+	// before the CSR table
+	uint64_t baseline_get_csr_value(uint64_t addr) {
+		validate_csr_counter_read_access_rights(addr);
+
+		auto read = [=](auto &x, uint64_t mask) { return x.reg & mask; };
+
+		using namespace csr;
+
+		switch (addr) {
+			case TIME_ADDR:
+			case MTIME_ADDR: {
+				uint64_t mtime = clint->update_and_get_mtime();
+				csrs.time.reg = mtime;
+				return csrs.time.reg;
+			}
+
+			case MCYCLE_ADDR:
+				csrs.cycle.reg = _compute_and_get_current_cycles();
+				return csrs.cycle.reg;
+
+			case MINSTRET_ADDR:
+				return csrs.instret.reg;
+
+			SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV64:  // not implemented
+				return 0;
+
+				// TODO: SD should be updated as SD=XS|FS and SD should be read-only -> update mask
+			case MSTATUS_ADDR:
+				return read(csrs.mstatus, MSTATUS_READ_MASK);
+			case SSTATUS_ADDR:
+				return read(csrs.mstatus, SSTATUS_READ_MASK);
+			case USTATUS_ADDR:
+				return read(csrs.mstatus, USTATUS_MASK);
+
+			case MIP_ADDR:
+				return read(csrs.mip, MIP_READ_MASK);
+			case SIP_ADDR:
+				return read(csrs.mip, SIP_MASK);
+			case UIP_ADDR:
+				return read(csrs.mip, UIP_MASK);
+
+			case MIE_ADDR:
+				return read(csrs.mie, MIE_MASK);
+			case SIE_ADDR:
+				return read(csrs.mie, SIE_MASK);
+			case UIE_ADDR:
+				return read(csrs.mie, UIE_MASK);
+
+			case SATP_ADDR:
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case FCSR_ADDR:
+				return read(csrs.fcsr, FCSR_MASK);
+
+			case FFLAGS_ADDR:
+				return csrs.fcsr.fflags;
+
+			case FRM_ADDR:
+				return csrs.fcsr.frm;
+		}
+
+		if (!is_valid_csr_addr(addr))
+			RAISE_ILLEGAL_INSTRUCTION();
+
+		return default_read(addr);
+	}
+
+	void baseline_set_csr_value(uint64_t addr, uint64_t value) {
+		auto write = [=](auto &x, uint64_t mask) { x.reg = (x.reg & ~mask) | (value & mask); };
+
+		using namespace csr;
+
+		switch (addr) {
+			case MISA_ADDR:                         // currently, read-only, thus cannot be changed at runtime
+			SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV64:  // not implemented
+				break;
+
+			case SATP_ADDR: {
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				auto mode = csrs.satp.mode;
+				write(csrs.satp, SATP_MASK);
+				if (csrs.satp.mode != SATP_MODE_BARE && csrs.satp.mode != SATP_MODE_SV39 &&
+				    csrs.satp.mode != SATP_MODE_SV48)
+					csrs.satp.mode = mode;
+				// std::cout << "[iss] satp=" << boost::format("%x") % csrs.satp.reg << std::endl;
+			} break;
+
+			case MTVEC_ADDR:
+				write(csrs.mtvec, MTVEC_MASK);
+				break;
+			case STVEC_ADDR:
+				write(csrs.stvec, MTVEC_MASK);
+				break;
+			case UTVEC_ADDR:
+				write(csrs.utvec, MTVEC_MASK);
+				break;
+
+			case MEPC_ADDR:
+				write(csrs.mepc, pc_alignment_mask());
+				break;
+			case SEPC_ADDR:
+				write(csrs.sepc, pc_alignment_mask());
+				break;
+			case UEPC_ADDR:
+				write(csrs.uepc, pc_alignment_mask());
+				break;
+
+			case MSTATUS_ADDR:
+				write(csrs.mstatus, MSTATUS_WRITE_MASK);
+				break;
+			case SSTATUS_ADDR:
+				write(csrs.mstatus, SSTATUS_WRITE_MASK);
+				break;
+			case USTATUS_ADDR:
+				write(csrs.mstatus, USTATUS_MASK);
+				break;
+
+			case MIP_ADDR:
+				write(csrs.mip, MIP_WRITE_MASK);
+				break;
+			case SIP_ADDR:
+				write(csrs.mip, SIP_MASK);
+				break;
+			case UIP_ADDR:
+				write(csrs.mip, UIP_MASK);
+				break;
+
+			case MIE_ADDR:
+				write(csrs.mie, MIE_MASK);
+				break;
+			case SIE_ADDR:
+				write(csrs.mie, SIE_MASK);
+				break;
+			case UIE_ADDR:
+				write(csrs.mie, UIE_MASK);
+				break;
+
+			case MIDELEG_ADDR:
+				write(csrs.mideleg, MIDELEG_MASK);
+				break;
+
+			case MEDELEG_ADDR:
+				write(csrs.medeleg, MEDELEG_MASK);
+				break;
+
+			case SIDELEG_ADDR:
+				write(csrs.sideleg, SIDELEG_MASK);
+				break;
+
+			case SEDELEG_ADDR:
+				write(csrs.sedeleg, SEDELEG_MASK);
+				break;
+
+			case MCOUNTEREN_ADDR:
+				write(csrs.mcounteren, MCOUNTEREN_MASK);
+				break;
+
+			case SCOUNTEREN_ADDR:
+				write(csrs.scounteren, MCOUNTEREN_MASK);
+				break;
+
+			case MCOUNTINHIBIT_ADDR:
+				write(csrs.mcountinhibit, MCOUNTINHIBIT_MASK);
+				break;
+
+			case PMPCFG0_ADDR:
+			case PMPCFG2_ADDR: {
+				// each (even numbered) pmpcfg register holds the configuration of eight entries
+				unsigned n = (addr - PMPCFG0_ADDR) / 2;
+				uint64_t reg = 0;
+				for (unsigned i = 0; i < 8; ++i) {
+					pmp.set_cfg(n * 8 + i, value >> (i * 8));
+					reg |= (uint64_t)pmp.get_cfg(n * 8 + i) << (i * 8);
+				}
+				csrs.pmpcfg[n].reg = reg;
+			} break;
+
+			SWITCH_CASE_MATCH_ANY_PMPADDR: {
+				unsigned n = addr - PMPADDR0_ADDR;
+				pmp.set_addr(n, value);
+				csrs.pmpaddr[n].reg = pmp.get_addr(n);
+			} break;
+
+			case FCSR_ADDR:
+				write(csrs.fcsr, FCSR_MASK);
+				break;
+
+			case FFLAGS_ADDR:
+				csrs.fcsr.fflags = value;
+				break;
+
+			case FRM_ADDR:
+				csrs.fcsr.frm = value;
+				break;
+
+			default:
+				if (!is_valid_csr_addr(addr))
+					RAISE_ILLEGAL_INSTRUCTION();
+
+				default_write(addr, value);
+		}
+	}
+
+	// CSR table
+	uint64_t get_csr_value(uint64_t addr) {
+		validate_csr_counter_read_access_rights(addr);
+
+		using Handler = csr_table::Handler;
+
+		auto &e = csrs.entries[addr];
+		switch (e.handler) {
+			case Handler::Invalid:
+				RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Time:
+				csrs.time.reg = clint->update_and_get_mtime();
+				break;
+
+			case Handler::Cycle:
+				csrs.cycle.reg = _compute_and_get_current_cycles();
+				break;
+
+			case Handler::Satp:
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Fflags:
+				return csrs.fcsr.fflags;
+
+			case Handler::Frm:
+				return csrs.fcsr.frm;
+
+			default:
+				break;
+		}
+
+		return *e.reg & e.read_mask;
+	}
+
+	void set_csr_value(uint64_t addr, uint64_t value) {
+		using Handler = csr_table::Handler;
+		using namespace csr;
+
+		auto &e = csrs.entries[addr];
+		uint64_t mask = e.write_mask;
+		switch (e.handler) {
+			case Handler::Invalid:
+				RAISE_ILLEGAL_INSTRUCTION();
+				break;
+
+			case Handler::Satp: {
+				if (csrs.mstatus.tvm)
+					RAISE_ILLEGAL_INSTRUCTION();
+				auto mode = csrs.satp.mode;
+				csrs.satp.reg = (csrs.satp.reg & ~mask) | (value & mask);
+				if (csrs.satp.mode != SATP_MODE_BARE && csrs.satp.mode != SATP_MODE_SV39 &&
+				    csrs.satp.mode != SATP_MODE_SV48)
+					csrs.satp.mode = mode;
+				return;
+			}
+
+			case Handler::Epc:
+				mask = pc_alignment_mask();
+				break;
+
+			case Handler::Pmpcfg: {
+				// each (even numbered) pmpcfg register holds the configuration of eight entries
+				unsigned n = (addr - PMPCFG0_ADDR) / 2;
+				uint64_t reg = 0;
+				for (unsigned i = 0; i < 8; ++i) {
+					pmp.set_cfg(n * 8 + i, value >> (i * 8));
+					reg |= (uint64_t)pmp.get_cfg(n * 8 + i) << (i * 8);
+				}
+				csrs.pmpcfg[n].reg = reg;
+				return;
+			}
+
+			case Handler::Pmpaddr: {
+				unsigned n = addr - PMPADDR0_ADDR;
+				pmp.set_addr(n, value);
+				csrs.pmpaddr[n].reg = pmp.get_addr(n);
+				return;
+			}
+
+			case Handler::Fflags:
+				csrs.fcsr.fflags = value;
+				return;
+
+			case Handler::Frm:
+				csrs.fcsr.frm = value;
+				return;
+
+			default:
+				break;
+		}
+
+		*e.reg = (*e.reg & ~mask) | (value & mask);
+	}
+};
+
+}  // namespace rv64
+
+namespace {
+
+std::mt19937_64 rng;
+unsigned long mismatches = 0;
+
+/* The CSR registers of the table, i.e. all of its state besides the mapping */
+template <typename Hart>
+uint8_t *registers(Hart &hart, size_t &size) {
+	size = (uint8_t *)&hart.csrs.entries - (uint8_t *)&hart.csrs;
+	return (uint8_t *)&hart.csrs;
+}
+
+template <typename Hart>
+bool same_state(Hart &a, Hart &b) {
+	size_t size;
+	uint8_t *ra = registers(a, size);
+	uint8_t *rb = registers(b, size);
+	if (memcmp(ra, rb, size) != 0)
+		return false;
+	for (unsigned i = 0; i < PMP::NUM_ENTRIES; ++i) {
+		if (a.pmp.get_cfg(i) != b.pmp.get_cfg(i) || a.pmp.get_addr(i) != b.pmp.get_addr(i))
+			return false;
+	}
+	return true;
+}
+
+/* Sets both harts to the same random state. */
+template <typename Hart>
+void randomize(Hart &a, Hart &b, unsigned xlen) {
+	size_t size;
+	uint8_t *ra = registers(a, size);
+	for (size_t i = 0; i < size; ++i) ra[i] = (uint8_t)rng();
+	memcpy(registers(b, size), ra, size);
+
+	// reset the PMP, locked entries can not be cleared by writes
+	for (Hart *h : {&a, &b}) {
+		h->pmp.~PMP();
+		new (&h->pmp) PMP(xlen);
+	}
+	a.mtime = b.mtime = rng();
+	a.cycles = b.cycles = rng();
+	a.compressed = b.compressed = rng() & 1;
+}
+
+template <typename Hart, typename T>
+void check(const char *arch, unsigned xlen, Hart &baseline, Hart &table, unsigned addr) {
+	randomize(baseline, table, xlen);
+	T value = (T)rng();
+
+	T read_baseline = 0, read_table = 0;
+	bool trap_baseline = false, trap_table = false;
+	try {
+		read_baseline = baseline.baseline_get_csr_value(addr);
+	} catch (IllegalInstruction &) {
+		trap_baseline = true;
+	}
+	try {
+		read_table = table.get_csr_value(addr);
+	} catch (IllegalInstruction &) {
+		trap_table = true;
+	}
+	if (read_baseline != read_table || trap_baseline != trap_table || !same_state(baseline, table)) {
+		if (++mismatches <= 20)
+			printf("%s read of csr 0x%03x differs: baseline %s%llx, table %s%llx\n", arch, addr,
+			       trap_baseline ? "trap " : "", (unsigned long long)read_baseline, trap_table ? "trap " : "",
+			       (unsigned long long)read_table);
+		return;
+	}
+
+	trap_baseline = trap_table = false;
+	try {
+		baseline.baseline_set_csr_value(addr, value);
+	} catch (IllegalInstruction &) {
+		trap_baseline = true;
+	}
+	try {
+		table.set_csr_value(addr, value);
+	} catch (IllegalInstruction &) {
+		trap_table = true;
+	}
+	if (trap_baseline != trap_table || !same_state(baseline, table)) {
+		if (++mismatches <= 20)
+			printf("%s write of 0x%llx to csr 0x%03x differs%s%s\n", arch, (unsigned long long)value, addr,
+			       trap_baseline ? ", baseline traps" : "", trap_table ? ", table traps" : "");
+	}
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	unsigned long trials = argc > 1 ? strtoul(argv[1], nullptr, 0) : 100;
+	unsigned long long seed = argc > 2 ? strtoull(argv[2], nullptr, 0) : 42;
+	rng.seed(seed);
+
+	// the harts are large (the CSR tables), and hold pointers to themselves
+	auto baseline32 = new rv32::Hart(), table32 = new rv32::Hart();
+	auto baseline64 = new rv64::Hart(), table64 = new rv64::Hart();
+
+	for (unsigned long i = 0; i < trials; ++i) {
+		for (unsigned addr = 0; addr < CsrAccessTable::NUM_ADDRESSES; ++addr) {
+			check<rv32::Hart, uint32_t>("rv32", 32, *baseline32, *table32, addr);
+			check<rv64::Hart, uint64_t>("rv64", 64, *baseline64, *table64, addr);
+		}
+	}
+
+	printf("%lu mismatches in %lu trials of all CSR addresses (seed %llu)\n", mismatches, trials, seed);
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
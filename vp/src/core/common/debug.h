@@ -6,8 +6,19 @@
 #include <unordered_set>
 #include <vector>
 
+#include "agent_expr.h"
 #include "core_defs.h"
 
+enum class WatchpointType {
+	Write,
+	Read,
+	Access,
+};
+
+struct WatchpointHit {
+	WatchpointType type;
+	uint64_t addr;  // accessed address within the watched range
+};
 
 struct debug_target_if {
 	virtual ~debug_target_if() {}
@@ -17,9 +28,15 @@ struct debug_target_if {
 	virtual void set_status(CoreExecStatus) = 0;
 	virtual void block_on_wfi(bool) = 0;
 
-	virtual void insert_breakpoint(uint64_t) = 0;
+	/* *conds* is empty for an unconditional breakpoint, inserting it again replaces the conditions */
+	virtual void insert_breakpoint(uint64_t, const std::vector<AgentExpr> &conds) = 0;
 	virtual void remove_breakpoint(uint64_t) = 0;
 
+	virtual void insert_watchpoint(uint64_t addr, uint64_t len, WatchpointType) = 0;
+	virtual void remove_watchpoint(uint64_t addr, uint64_t len, WatchpointType) = 0;
+	/* the watchpoint that stopped the last run, nullptr if it was not stopped by one */
+	virtual const WatchpointHit *get_watchpoint_hit(void) = 0;
+
 	virtual Architecture get_architecture(void) = 0;
 	virtual uint64_t get_hart_id(void) = 0;
 
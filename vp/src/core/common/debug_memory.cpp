@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -43,49 +44,79 @@ unsigned DebugMemoryInterface::_do_dbg_transaction(tlm::tlm_command cmd, uint64_
 	return nbytes;
 }
 
+uint8_t *DebugMemoryInterface::dmi_memory(uint64_t addr, unsigned nbytes, bool write) {
+	for (auto &e : dmi_ranges) {
+		if (e.contains(addr) && nbytes <= e.get_end() - addr) {
+			if (write && e.tracks_writes() && nbytes > 0)
+				e.mark_dirty(addr, nbytes);
+			return e.get_mem_ptr_to_global_addr<uint8_t>(addr);
+		}
+	}
+	return nullptr;
+}
+
+unsigned DebugMemoryInterface::read(uint64_t start, uint8_t *data, unsigned nbytes) {
+	if (uint8_t *mem = dmi_memory(start, nbytes, false)) {
+		memcpy(data, mem, nbytes);
+		return nbytes;
+	}
+	return _do_dbg_transaction(tlm::TLM_READ_COMMAND, start, data, nbytes);
+}
+
+unsigned DebugMemoryInterface::write(uint64_t start, const uint8_t *data, unsigned nbytes) {
+	if (uint8_t *mem = dmi_memory(start, nbytes, true)) {
+		memcpy(mem, data, nbytes);
+		return nbytes;
+	}
+	// the payload is not modified by writes
+	return _do_dbg_transaction(tlm::TLM_WRITE_COMMAND, start, const_cast<uint8_t *>(data), nbytes);
+}
+
+static const char hexdigits[] = "0123456789abcdef";
+
+static int hexval(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
 std::string DebugMemoryInterface::read_memory(uint64_t start, unsigned nbytes) {
 	std::vector<uint8_t> buf(nbytes);  // NOTE: every element is zero-initialized by default
 
-	unsigned nbytes_read = _do_dbg_transaction(tlm::TLM_READ_COMMAND, start, buf.data(), buf.size());
+	unsigned nbytes_read = read(start, buf.data(), nbytes);
 	if(nbytes_read < nbytes) {
 		std::cerr << "DebugMemoryInterface::read_memory: not all bytes read."
 					"Mostly this is caused by reading unmapped memory location."
 					<< std::endl;
 	}
 
-	std::stringstream stream;
-	stream << std::setfill('0') << std::hex;
-	for (uint8_t byte : buf) {
-		stream << std::setw(2) << (unsigned)byte;
+	std::string hex(2 * nbytes, '0');
+	for (unsigned i = 0; i < nbytes; i++) {
+		hex[2 * i] = hexdigits[buf[i] >> 4];
+		hex[2 * i + 1] = hexdigits[buf[i] & 0xF];
 	}
 
-	return stream.str();
+	return hex;
 }
 
 void DebugMemoryInterface::write_memory(uint64_t start, unsigned nbytes, const std::string &data) {
-	unsigned i, j;
 	std::vector<uint8_t> buf(data.length() / 2);
 
 	assert(data.length() % 2 == 0);
 	assert(buf.size() == nbytes);
 
-	for (j = 0, i = 0; i + 1 < nbytes; j++, i += 2) {
-		long num;
-		char hex[3];
-
-		hex[0] = data.at(i);
-		hex[1] = data.at(i+1);
-		hex[2] = '\0';
-
-		errno = 0;
-		num = strtol(hex, NULL, 16);
-		if (num == 0 && errno != 0)
-			throw std::system_error(errno, std::generic_category());
-
-		assert(num >= 0 && num <= UINT8_MAX);
-		buf.at(j) = (uint8_t)num;
+	for (unsigned i = 0; i < buf.size(); i++) {
+		int hi = hexval(data[2 * i]);
+		int lo = hexval(data[2 * i + 1]);
+		if (hi < 0 || lo < 0)
+			throw std::runtime_error("invalid hex data");
+		buf[i] = (uint8_t)(hi << 4 | lo);
 	}
 
-	unsigned nbytes_write = _do_dbg_transaction(tlm::TLM_WRITE_COMMAND, start, buf.data(), buf.size());
+	unsigned nbytes_write = write(start, buf.data(), buf.size());
 	assert(nbytes_write == nbytes && "not all data written");
 }
@@ -3,23 +3,43 @@
 
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <tlm_utils/simple_initiator_socket.h>
 #include <systemc>
 
 #include "core_defs.h"
+#include "dmi.h"
 #include "trap.h"
 
 struct DebugMemoryInterface : public sc_core::sc_module {
 	tlm_utils::simple_initiator_socket<DebugMemoryInterface> isock;
 
+	// main memory accessed directly, everything else goes through the bus
+	std::vector<MemoryDMI> dmi_ranges;
+	// address ranges (start, inclusive end) reported to GDB, empty if the debugger sees virtual addresses
+	std::vector<std::pair<uint64_t, uint64_t>> memory_map;
+
 	DebugMemoryInterface(sc_core::sc_module_name) {}
 
+	template <typename Bus>
+	void add_memory_map(const Bus &bus) {
+		for (auto port : bus.ports)
+			memory_map.emplace_back(port->start, port->end);
+	}
+
 	unsigned _do_dbg_transaction(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, unsigned num_bytes);
 
+	unsigned read(uint64_t start, uint8_t *data, unsigned nbytes);
+	unsigned write(uint64_t start, const uint8_t *data, unsigned nbytes);
+
 	std::string read_memory(uint64_t start, unsigned nbytes);
 
 	void write_memory(uint64_t start, unsigned nbytes, const std::string &data);
+
+   private:
+	uint8_t *dmi_memory(uint64_t addr, unsigned nbytes, bool write);
 };
 
 #endif  // RISCV_ISA_GDB_STUB_H
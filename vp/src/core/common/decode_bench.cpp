@@ -0,0 +1,74 @@
+/* Host benchmark of the instruction decoder (see instr.cpp): decodes a random mix of valid RV32 and RV64 instructions,
+ * compressed instructions are expanded like in the ISS. The instructions are generated up front, so that only the
+ * decode path is measured.
+ *
+ * Usage: decode-bench [instructions] [runs], prints the best of *runs* for each architecture. */
+
+#include "instr.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace {
+
+unsigned long instructions = 1 << 20;
+unsigned runs = 20;
+
+/* Random instruction words which decode to a valid opcode, compressed and uncompressed. */
+std::vector<uint32_t> random_instructions(Architecture arch) {
+	std::mt19937 rng(42);
+	std::vector<uint32_t> words;
+	while (words.size() < instructions) {
+		uint32_t w = rng();
+		Instruction instr(w);
+		if (instr.is_compressed()) {
+			instr = Instruction(w & 0xffff);
+			if (instr.decode_and_expand_compressed(arch) == Opcode::UNDEF)
+				continue;
+		} else if (instr.decode_normal(arch) == Opcode::UNDEF) {
+			continue;
+		}
+		words.push_back(instr.data());
+	}
+	return words;
+}
+
+void bench(const char *name, Architecture arch) {
+	std::vector<uint32_t> words = random_instructions(arch);
+
+	double best = 0;
+	unsigned long sum = 0;  // keeps the decoder from being optimized away
+	for (unsigned r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		for (uint32_t w : words) {
+			Instruction instr(w);
+			if (instr.is_compressed())
+				sum += instr.decode_and_expand_compressed(arch) + instr.data();
+			else
+				sum += instr.decode_normal(arch);
+		}
+		std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+		best = r ? std::min(best, t.count()) : t.count();
+	}
+
+	printf("%s: %6.2f ns per instruction (checksum %lx)\n", name, best / words.size(), sum);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc > 1)
+		instructions = std::max(1ul, strtoul(argv[1], nullptr, 0));
+	if (argc > 2)
+		runs = std::max(1ul, strtoul(argv[2], nullptr, 0));
+
+	bench("RV32", RV32);
+	bench("RV64", RV64);
+	return 0;
+}
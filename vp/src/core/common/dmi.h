@@ -2,11 +2,22 @@
 
 #include <stdint.h>
 
+#include <cassert>
+#include <cstring>
+#include <systemc>
+
 class MemoryDMI {
 	uint8_t *mem;
 	uint64_t start;
 	uint64_t size;
 	uint64_t end;
+	// optional latency per accessed byte (e.g. for MRAM), annotated in addition to the DMI access delay of the core
+	sc_core::sc_time read_latency;
+	sc_core::sc_time write_latency;
+	bool latency = false;
+	// optional write tracking (e.g. for a framebuffer), each store sets the byte of its 2^dirty_shift sized block
+	uint8_t *dirty = nullptr;
+	unsigned dirty_shift = 0;
 
 	MemoryDMI(uint8_t *mem, uint64_t start, uint64_t size) : mem(mem), start(start), size(size), end(start + size) {}
 
@@ -21,6 +32,40 @@ class MemoryDMI {
 		return MemoryDMI(mem, start, size);
 	}
 
+	void set_latency_per_byte(const sc_core::sc_time &read, const sc_core::sc_time &write) {
+		read_latency = read;
+		write_latency = write;
+		latency = read != sc_core::SC_ZERO_TIME || write != sc_core::SC_ZERO_TIME;
+	}
+
+	bool has_latency() const {
+		return latency;
+	}
+
+	sc_core::sc_time get_read_latency(unsigned num_bytes) const {
+		return read_latency * num_bytes;
+	}
+
+	sc_core::sc_time get_write_latency(unsigned num_bytes) const {
+		return write_latency * num_bytes;
+	}
+
+	void set_dirty_map(uint8_t *map, unsigned block_shift) {
+		dirty = map;
+		dirty_shift = block_shift;
+	}
+
+	bool tracks_writes() const {
+		return dirty != nullptr;
+	}
+
+	void mark_dirty(uint64_t addr, uint64_t num_bytes) {
+		assert(contains(addr) && (addr + num_bytes) <= end);
+		uint64_t first = (addr - start) >> dirty_shift;
+		uint64_t last = (addr - start + num_bytes - 1) >> dirty_shift;
+		memset(dirty + first, 1, last - first + 1);
+	}
+
 	uint8_t *get_raw_mem_ptr() {
 		return mem;
 	}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "fp.h"
+#include "util/common.h"
+
+#include <string.h>
+
+/* Host floating point fast path for the most common F/D operations.
+ *
+ * For the default round to nearest even mode the IEEE 754 results of the host SSE unit match the SoftFloat results
+ * bit by bit, except for NaNs: RISC-V always produces the canonical NaN. The host exception flags are captured from
+ * MXCSR and merged into *softfloat_exceptionFlags*, so callers can use these functions as drop-in replacement for the
+ * corresponding SoftFloat functions (fp_update_exception_flags works unchanged).
+ *
+ * SoftFloat is used for all other rounding modes, if the host MXCSR is not in its default configuration (e.g. FTZ/DAZ
+ * enabled) and on hosts without SSE2. */
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define HOST_FP_FAST_PATH 1
+#else
+#define HOST_FP_FAST_PATH 0
+#endif
+
+#if HOST_FP_FAST_PATH
+
+namespace host_fp {
+
+// MXCSR layout
+constexpr uint32_t MXCSR_IE = 1 << 0;  // invalid operation
+constexpr uint32_t MXCSR_DE = 1 << 1;  // denormal operand, no RISC-V equivalent
+constexpr uint32_t MXCSR_ZE = 1 << 2;  // divide by zero
+constexpr uint32_t MXCSR_OE = 1 << 3;  // overflow
+constexpr uint32_t MXCSR_UE = 1 << 4;  // underflow
+constexpr uint32_t MXCSR_PE = 1 << 5;  // inexact
+constexpr uint32_t MXCSR_FLAGS = 0x3f;
+// all exceptions masked, round to nearest, no flush-to-zero and no denormals-are-zero
+constexpr uint32_t MXCSR_DEFAULT_CONTROL = 0x1f80;
+
+/* All accesses use volatile asm such that the compiler keeps the operation between the two MXCSR accesses. */
+inline uint32_t get_mxcsr() {
+	uint32_t csr;
+	asm volatile("stmxcsr %0" : "=m"(csr));
+	return csr;
+}
+
+inline void set_mxcsr(uint32_t csr) {
+	asm volatile("ldmxcsr %0" : : "m"(csr));
+}
+
+/* Returns true if the host can compute the next operation, clears stale host flags if necessary. */
+inline bool begin() {
+	if (softfloat_roundingMode != softfloat_round_near_even)
+		return false;
+
+	uint32_t csr = get_mxcsr();
+	if (unlikely((csr & ~MXCSR_FLAGS) != MXCSR_DEFAULT_CONTROL))
+		return false;
+	if (unlikely(csr & MXCSR_FLAGS))
+		set_mxcsr(csr & ~MXCSR_FLAGS);
+	return true;
+}
+
+/* Merges the host flags of the last operation into the SoftFloat flags. Flags are only reset (ldmxcsr is
+ * comparatively slow) if any have been raised. */
+inline void finish() {
+	uint32_t csr = get_mxcsr();
+	uint32_t flags = csr & (MXCSR_FLAGS & ~MXCSR_DE);
+	if (flags) {
+		uint_fast8_t sf = 0;
+		if (flags & MXCSR_IE)
+			sf |= softfloat_flag_invalid;
+		if (flags & MXCSR_ZE)
+			sf |= softfloat_flag_infinite;
+		if (flags & MXCSR_OE)
+			sf |= softfloat_flag_overflow;
+		if (flags & MXCSR_UE)
+			sf |= softfloat_flag_underflow;
+		if (flags & MXCSR_PE)
+			sf |= softfloat_flag_inexact;
+		softfloat_exceptionFlags |= sf;
+	}
+	if (csr & MXCSR_FLAGS)
+		set_mxcsr(csr & ~MXCSR_FLAGS);
+}
+
+inline float32_t canonicalize(float32_t x) {
+	return f32_isNaN(x) ? f32_defaultNaN : x;
+}
+
+inline float64_t canonicalize(float64_t x) {
+	return f64_isNaN(x) ? f64_defaultNaN : x;
+}
+
+#define HOST_FP_BINARY_OP(name, insn, type, reg_t)       \
+	inline type name(type a, type b) {                   \
+		reg_t x, y;                                      \
+		memcpy(&x, &a, sizeof(x));                       \
+		memcpy(&y, &b, sizeof(y));                       \
+		asm volatile(insn " %1, %0" : "+x"(x) : "x"(y)); \
+		type r;                                          \
+		memcpy(&r, &x, sizeof(r));                       \
+		return r;                                        \
+	}
+
+#define HOST_FP_UNARY_OP(name, insn, type, reg_t) \
+	inline type name(type a) {                    \
+		reg_t x;                                  \
+		memcpy(&x, &a, sizeof(x));                \
+		asm volatile(insn " %0, %0" : "+x"(x));   \
+		type r;                                   \
+		memcpy(&r, &x, sizeof(r));                \
+		return r;                                 \
+	}
+
+HOST_FP_BINARY_OP(add, "addss", float32_t, float)
+HOST_FP_BINARY_OP(sub, "subss", float32_t, float)
+HOST_FP_BINARY_OP(mul, "mulss", float32_t, float)
+HOST_FP_BINARY_OP(div, "divss", float32_t, float)
+HOST_FP_UNARY_OP(sqrt, "sqrtss", float32_t, float)
+
+HOST_FP_BINARY_OP(add, "addsd", float64_t, double)
+HOST_FP_BINARY_OP(sub, "subsd", float64_t, double)
+HOST_FP_BINARY_OP(mul, "mulsd", float64_t, double)
+HOST_FP_BINARY_OP(div, "divsd", float64_t, double)
+HOST_FP_UNARY_OP(sqrt, "sqrtsd", float64_t, double)
+
+#undef HOST_FP_BINARY_OP
+#undef HOST_FP_UNARY_OP
+
+}  // namespace host_fp
+
+#define HOST_FP_DISPATCH_BINARY(name, type, host_fn, softfloat_fn)  \
+	inline type name(type a, type b) {                              \
+		if (likely(host_fp::begin())) {                             \
+			type r = host_fp::canonicalize(host_fp::host_fn(a, b)); \
+			host_fp::finish();                                      \
+			return r;                                               \
+		}                                                           \
+		return softfloat_fn(a, b);                                  \
+	}
+
+#define HOST_FP_DISPATCH_UNARY(name, type, host_fn, softfloat_fn) \
+	inline type name(type a) {                                    \
+		if (likely(host_fp::begin())) {                           \
+			type r = host_fp::canonicalize(host_fp::host_fn(a));  \
+			host_fp::finish();                                    \
+			return r;                                             \
+		}                                                         \
+		return softfloat_fn(a);                                   \
+	}
+
+#else
+
+#define HOST_FP_DISPATCH_BINARY(name, type, host_fn, softfloat_fn) \
+	inline type name(type a, type b) {                             \
+		return softfloat_fn(a, b);                                 \
+	}
+
+#define HOST_FP_DISPATCH_UNARY(name, type, host_fn, softfloat_fn) \
+	inline type name(type a) {                                    \
+		return softfloat_fn(a);                                   \
+	}
+
+#endif
+
+HOST_FP_DISPATCH_BINARY(fast_f32_add, float32_t, add, f32_add)
+HOST_FP_DISPATCH_BINARY(fast_f32_sub, float32_t, sub, f32_sub)
+HOST_FP_DISPATCH_BINARY(fast_f32_mul, float32_t, mul, f32_mul)
+HOST_FP_DISPATCH_BINARY(fast_f32_div, float32_t, div, f32_div)
+HOST_FP_DISPATCH_UNARY(fast_f32_sqrt, float32_t, sqrt, f32_sqrt)
+
+HOST_FP_DISPATCH_BINARY(fast_f64_add, float64_t, add, f64_add)
+HOST_FP_DISPATCH_BINARY(fast_f64_sub, float64_t, sub, f64_sub)
+HOST_FP_DISPATCH_BINARY(fast_f64_mul, float64_t, mul, f64_mul)
+HOST_FP_DISPATCH_BINARY(fast_f64_div, float64_t, div, f64_div)
+HOST_FP_DISPATCH_UNARY(fast_f64_sqrt, float64_t, sqrt, f64_sqrt)
+
+#undef HOST_FP_DISPATCH_BINARY
+#undef HOST_FP_DISPATCH_UNARY
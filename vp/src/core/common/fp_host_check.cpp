@@ -0,0 +1,159 @@
+/* Differential test of the host floating point fast path (see fp_host.h): runs random operands through the fast_*
+ * functions and the corresponding SoftFloat functions and compares results and exception flags bit by bit.
+ *
+ * The operands are biased towards the cases where host and SoftFloat are most likely to disagree: NaNs (quiet and
+ * signaling), infinities, zeros, subnormals and exponents close to the overflow and underflow boundaries. Most
+ * operations use round to nearest even (the host path), the others check the SoftFloat fallback.
+ *
+ * Usage: fp-host-check [operations] [seed], the exit status is non-zero if any result differs. */
+
+#include "fp_host.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+
+namespace {
+
+std::mt19937_64 rng;
+
+const uint32_t f32_special[] = {
+    0x00000000, 0x80000000,  // zeros
+    0x7f800000, 0xff800000,  // infinities
+    0x7fc00000, 0xffc00001,  // quiet NaNs
+    0x7f800001, 0xff800fff,  // signaling NaNs
+    0x00000001, 0x807fffff, 0x00400000,  // subnormals
+    0x00800000, 0x7f7fffff, 0x3f800000,  // smallest and largest normal, one
+};
+
+const uint64_t f64_special[] = {
+    0x0000000000000000, 0x8000000000000000,  // zeros
+    0x7ff0000000000000, 0xfff0000000000000,  // infinities
+    0x7ff8000000000000, 0xfff8000000000001,  // quiet NaNs
+    0x7ff0000000000001, 0xfff0000000000fff,  // signaling NaNs
+    0x0000000000000001, 0x800fffffffffffff, 0x0008000000000000,  // subnormals
+    0x0010000000000000, 0x7fefffffffffffff, 0x3ff0000000000000,  // smallest and largest normal, one
+};
+
+template <typename T, size_t N>
+size_t count(const T (&)[N]) {
+	return N;
+}
+
+uint32_t random_f32() {
+	uint32_t r = (uint32_t)rng();
+	switch (rng() % 4) {
+		case 0:
+			return f32_special[rng() % count(f32_special)];
+		case 1:  // subnormal or smallest exponents, products and quotients underflow
+			return (r & 0x807fffff) | (uint32_t)(rng() % 3) << 23;
+		case 2:  // largest exponents, sums and products overflow
+			return (r & 0x807fffff) | (uint32_t)(0xf6 + rng() % 9) << 23;
+		default:
+			return r;
+	}
+}
+
+uint64_t random_f64() {
+	uint64_t r = rng();
+	switch (rng() % 4) {
+		case 0:
+			return f64_special[rng() % count(f64_special)];
+		case 1:
+			return (r & 0x800fffffffffffff) | (rng() % 3) << 52;
+		case 2:
+			return (r & 0x800fffffffffffff) | (0x7f6 + rng() % 9) << 52;
+		default:
+			return r;
+	}
+}
+
+const uint_fast8_t rounding_modes[] = {
+    softfloat_round_near_even, softfloat_round_minMag, softfloat_round_min,
+    softfloat_round_max,       softfloat_round_near_maxMag,
+};
+
+const char *op_names[] = {"add", "sub", "mul", "div", "sqrt"};
+
+template <typename T>
+struct Ops {
+	T (*softfloat[5])(T, T);
+	T (*host[5])(T, T);
+};
+
+// unary operations ignore the second operand
+float32_t sf_f32_sqrt(float32_t a, float32_t) {
+	return f32_sqrt(a);
+}
+float32_t host_f32_sqrt(float32_t a, float32_t) {
+	return fast_f32_sqrt(a);
+}
+float64_t sf_f64_sqrt(float64_t a, float64_t) {
+	return f64_sqrt(a);
+}
+float64_t host_f64_sqrt(float64_t a, float64_t) {
+	return fast_f64_sqrt(a);
+}
+
+const Ops<float32_t> f32_ops = {
+    {f32_add, f32_sub, f32_mul, f32_div, sf_f32_sqrt},
+    {fast_f32_add, fast_f32_sub, fast_f32_mul, fast_f32_div, host_f32_sqrt},
+};
+
+const Ops<float64_t> f64_ops = {
+    {f64_add, f64_sub, f64_mul, f64_div, sf_f64_sqrt},
+    {fast_f64_add, fast_f64_sub, fast_f64_mul, fast_f64_div, host_f64_sqrt},
+};
+
+/* Returns true if both implementations agree, prints the operation otherwise. */
+template <typename T>
+bool check(const Ops<T> &ops, unsigned op, T a, T b, int width) {
+	softfloat_exceptionFlags = 0;
+	T expected = ops.softfloat[op](a, b);
+	uint_fast8_t expected_flags = softfloat_exceptionFlags;
+
+	softfloat_exceptionFlags = 0;
+	T actual = ops.host[op](a, b);
+	uint_fast8_t actual_flags = softfloat_exceptionFlags;
+
+	if (expected.v == actual.v && expected_flags == actual_flags)
+		return true;
+
+	printf("f%d_%s(%0*llx, %0*llx) rm %u: softfloat %0*llx flags %02x, host %0*llx flags %02x\n", width, op_names[op],
+	       width / 4, (unsigned long long)a.v, width / 4, (unsigned long long)b.v, (unsigned)softfloat_roundingMode,
+	       width / 4, (unsigned long long)expected.v, (unsigned)expected_flags, width / 4,
+	       (unsigned long long)actual.v, (unsigned)actual_flags);
+	return false;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	unsigned long long n = argc > 1 ? strtoull(argv[1], nullptr, 0) : 20000000;
+	unsigned long long seed = argc > 2 ? strtoull(argv[2], nullptr, 0) : 42;
+	rng.seed(seed);
+
+	printf("fast path: %s\n", HOST_FP_FAST_PATH ? "host SSE" : "SoftFloat only");
+
+	unsigned long long mismatches = 0;
+	for (unsigned long long i = 0; i < n; ++i) {
+		softfloat_roundingMode = (rng() % 8) ? (uint_fast8_t)softfloat_round_near_even : rounding_modes[rng() % 5];
+		unsigned op = rng() % 5;
+
+		bool ok;
+		if (rng() & 1)
+			ok = check(f32_ops, op, float32_t{random_f32()}, float32_t{random_f32()}, 32);
+		else
+			ok = check(f64_ops, op, float64_t{random_f64()}, float64_t{random_f64()}, 64);
+
+		if (!ok && ++mismatches >= 20) {
+			printf("too many mismatches, stopping\n");
+			break;
+		}
+	}
+
+	printf("%llu mismatches in %llu operations (seed %llu)\n", mismatches, n, seed);
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
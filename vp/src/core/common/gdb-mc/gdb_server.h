@@ -10,6 +10,7 @@
 #include <systemc>
 #include <thread>
 #include <map>
+#include <string>
 #include <tuple>
 #include <functional>
 
@@ -31,9 +32,11 @@ public:
 	void killServer(int, gdb_command_t *);
 	void readMemory(int, gdb_command_t *);
 	void writeMemory(int, gdb_command_t *);
+	void writeMemoryBinary(int, gdb_command_t *);
 	void readRegister(int, gdb_command_t *);
 	void qAttached(int, gdb_command_t *);
 	void qSupported(int, gdb_command_t *);
+	void qXfer(int, gdb_command_t *);
 	void threadInfo(int, gdb_command_t *);
 	void threadInfoEnd(int, gdb_command_t *);
 	void vCont(int, gdb_command_t *);
@@ -83,6 +86,9 @@ private:
 	/* hart → mmu */
 	std::map<debug_target_if *, mmu_memory_if *> mmu;
 
+	/* qXfer:memory-map:read reply, built on first request */
+	std::string memory_map_xml;
+
 	void create_sock(uint16_t);
 	std::vector<debug_target_if *> get_threads(int);
 	uint64_t translate_addr(debug_target_if *, uint64_t, MemoryAccessType type);
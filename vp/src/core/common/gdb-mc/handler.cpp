@@ -1,6 +1,10 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
 
 #include <libgdb/parser2.h>
 
@@ -9,7 +13,7 @@
 #include "register_format.h"
 
 enum {
-	GDB_PKTSIZ = 4096,
+	GDB_PKTSIZ = 0x10000,
 	GDB_PC_REG = 32,
 };
 
@@ -23,11 +27,13 @@ std::map<std::string, GDBServer::packet_handler> handlers {
 	{ "p", &GDBServer::readRegister },
 	{ "qAttached", &GDBServer::qAttached },
 	{ "qSupported", &GDBServer::qSupported },
+	{ "qXfer", &GDBServer::qXfer },
 	{ "qfThreadInfo", &GDBServer::threadInfo },
 	{ "qsThreadInfo", &GDBServer::threadInfoEnd },
 	{ "T", &GDBServer::isAlive },
 	{ "vCont", &GDBServer::vCont },
 	{ "vCont?", &GDBServer::vContSupported },
+	{ "X", &GDBServer::writeMemoryBinary },
 	{ "z", &GDBServer::removeBreakpoint },
 	{ "Z", &GDBServer::setBreakpoint },
 };
@@ -130,6 +136,37 @@ void GDBServer::writeMemory(int conn, gdb_command_t *cmd) {
 	send_packet(conn, "OK");
 }
 
+void GDBServer::writeMemoryBinary(int conn, gdb_command_t *cmd) {
+	gdb_memory_t *loc;
+	gdb_memory_write_t *mem;
+
+	mem = &cmd->v.memw;
+	loc = &mem->location;
+
+	assert(loc->length <= UINT_MAX);
+
+	// GDB probes for binary downloads with an empty write
+	if (loc->length == 0) {
+		send_packet(conn, "OK");
+		return;
+	}
+
+	auto fn = [this, loc, mem] (debug_target_if *hart) {
+		uint64_t addr = translate_addr(hart, loc->addr, STORE);
+		if (memory->write(addr, (const uint8_t *)mem->data, (unsigned)loc->length) != loc->length)
+			throw std::runtime_error("not all data written");
+	};
+
+	try {
+		exec_thread(fn);
+	} catch (const std::runtime_error&) {
+		send_packet(conn, "E01");
+		return;
+	}
+
+	send_packet(conn, "OK");
+}
+
 void GDBServer::readRegister(int conn, gdb_command_t *cmd) {
 	int reg;
 	auto formatter = new RegisterFormater(arch);
@@ -202,7 +239,43 @@ void GDBServer::qAttached(int conn, gdb_command_t *cmd) {
 void GDBServer::qSupported(int conn, gdb_command_t *cmd) {
 	(void)cmd;
 
-	send_packet(conn, ("vContSupported+;PacketSize=" + std::to_string(GDB_PKTSIZ)).c_str());
+	std::stringstream features;
+	features << "vContSupported+;ConditionalBreakpoints+;PacketSize=" << std::hex << GDB_PKTSIZ;
+	if (!memory->memory_map.empty())
+		features << ";qXfer:memory-map:read+";
+
+	send_packet(conn, features.str().c_str());
+}
+
+void GDBServer::qXfer(int conn, gdb_command_t *cmd) {
+	gdb_xfer_t *xfer;
+
+	xfer = &cmd->v.xfer;
+	if (strcmp(xfer->object, "memory-map") || memory->memory_map.empty()) {
+		send_packet(conn, ""); /* not supported */
+		return;
+	}
+
+	if (memory_map_xml.empty()) {
+		auto ranges = memory->memory_map;
+		std::sort(ranges.begin(), ranges.end());
+
+		std::stringstream xml;
+		xml << "<memory-map>" << std::hex;
+		for (auto &r : ranges) {
+			xml << "<memory type=\"ram\" start=\"0x" << r.first
+			    << "\" length=\"0x" << (r.second - r.first + 1) << "\"/>";
+		}
+		xml << "</memory-map>";
+		memory_map_xml = xml.str();
+	}
+
+	// ‘m’ if more data follows, ‘l’ for the last chunk
+	size_t offset = std::min(xfer->offset, memory_map_xml.size());
+	size_t length = std::min(xfer->length, memory_map_xml.size() - offset);
+	bool last = offset + length == memory_map_xml.size();
+
+	send_packet(conn, ((last ? "l" : "m") + memory_map_xml.substr(offset, length)).c_str());
 }
 
 void GDBServer::isAlive(int conn, gdb_command_t *cmd) {
@@ -219,10 +292,31 @@ void GDBServer::isAlive(int conn, gdb_command_t *cmd) {
 	send_packet(conn, "OK");
 }
 
+static std::string watch_reason(const WatchpointHit *hit) {
+	if (!hit)
+		return "";
+
+	std::stringstream reason;
+	switch (hit->type) {
+	case WatchpointType::Write:
+		reason << "watch";
+		break;
+	case WatchpointType::Read:
+		reason << "rwatch";
+		break;
+	case WatchpointType::Access:
+		reason << "awatch";
+		break;
+	}
+	reason << ":" << std::hex << hit->addr << ";";
+	return reason.str();
+}
+
 void GDBServer::vCont(int conn, gdb_command_t *cmd) {
 	gdb_vcont_t *vcont;
 	int stopped_thread = -1;
 	const char *stop_reason = NULL;
+	std::string watch; /* stop reason detail, e.g. "watch:addr;" */
 	std::map<debug_target_if *, bool> matched;
 
 	/* This handler attempts to implement the all-stop mode.
@@ -258,6 +352,7 @@ void GDBServer::vCont(int conn, gdb_command_t *cmd) {
 			case CoreExecStatus::HitBreakpoint:
 				stop_reason = "05";
 				stopped_thread = hart->get_hart_id() + 1;
+				watch = watch_reason(hart->get_watchpoint_hit());
 
 				/* mark runnable again */
 				hart->set_status(CoreExecStatus::Runnable);
@@ -266,6 +361,7 @@ void GDBServer::vCont(int conn, gdb_command_t *cmd) {
 			case CoreExecStatus::Terminated:
 				stop_reason = "03";
 				stopped_thread = hart->get_hart_id() + 1;
+				watch.clear();
 				break;
 			case CoreExecStatus::Runnable:
 				continue;
@@ -294,7 +390,7 @@ void GDBServer::vCont(int conn, gdb_command_t *cmd) {
 	 * XXX: No idea if the stub is really required to do this. */
 	thread_ops['g'] = stopped_thread;
 
-	const std::string msg = std::string("T") + stop_reason + "thread:" +
+	const std::string msg = std::string("T") + stop_reason + watch + "thread:" +
 	                        std::to_string(stopped_thread) + ";";
 	send_packet(conn, msg.c_str());
 }
@@ -307,30 +403,53 @@ void GDBServer::vContSupported(int conn, gdb_command_t *cmd) {
 	send_packet(conn, "vCont;c;C");
 }
 
+/* GDB watchpoint kinds, indexed by gdb_ztype_t - GDB_ZKIND_WATCHW */
+static const WatchpointType watch_types[] = {
+	WatchpointType::Write,
+	WatchpointType::Read,
+	WatchpointType::Access,
+};
+
 void GDBServer::removeBreakpoint(int conn, gdb_command_t *cmd) {
 	gdb_breakpoint_t *bpoint;
 
 	bpoint = &cmd->v.bval;
-	if (bpoint->type != GDB_ZKIND_SOFT) {
-		send_packet(conn, ""); /* not supported */
-		return;
+	for (debug_target_if *hart : harts) {
+		if (bpoint->type == GDB_ZKIND_SOFT || bpoint->type == GDB_ZKIND_HARD)
+			hart->remove_breakpoint(bpoint->address);
+		else
+			hart->remove_watchpoint(bpoint->address, bpoint->kind, watch_types[bpoint->type - GDB_ZKIND_WATCHW]);
 	}
-
-	for (debug_target_if *hart : harts)
-		hart->remove_breakpoint(bpoint->address);
 	send_packet(conn, "OK");
 }
 
 void GDBServer::setBreakpoint(int conn, gdb_command_t *cmd) {
 	gdb_breakpoint_t *bpoint;
+	gdb_cond_t *cond;
 
 	bpoint = &cmd->v.bval;
-	if (bpoint->type != GDB_ZKIND_SOFT) {
-		send_packet(conn, ""); /* not supported */
+	if (bpoint->type == GDB_ZKIND_WATCHW || bpoint->type == GDB_ZKIND_WATCHR || bpoint->type == GDB_ZKIND_WATCHA) {
+		if (bpoint->conds) {
+			send_packet(conn, "E01"); /* conditions are only defined for breakpoints */
+			return;
+		}
+		for (debug_target_if *hart : harts)
+			hart->insert_watchpoint(bpoint->address, bpoint->kind, watch_types[bpoint->type - GDB_ZKIND_WATCHW]);
+		send_packet(conn, "OK");
 		return;
 	}
 
+	/* software and hardware breakpoints are the same for the ISS */
+	std::vector<AgentExpr> conds;
+	for (cond = bpoint->conds; cond; cond = cond->next) {
+		if (!cond->bytecode) {
+			send_packet(conn, "E01");
+			return;
+		}
+		conds.emplace_back(std::vector<uint8_t>(cond->bytecode, cond->bytecode + cond->length));
+	}
+
 	for (debug_target_if *hart : harts)
-		hart->insert_breakpoint(bpoint->address);
+		hart->insert_breakpoint(bpoint->address, conds);
 	send_packet(conn, "OK");
 }
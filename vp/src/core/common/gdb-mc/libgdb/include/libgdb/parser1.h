@@ -20,7 +20,8 @@ typedef enum {
 
 typedef struct {
 	gdb_kind_t kind;
-	char *data;
+	char *data; /* null-terminated, may contain null bytes (see len) */
+	size_t len;
 	char csum[GDB_CSUM_LEN];
 } gdb_packet_t;
 
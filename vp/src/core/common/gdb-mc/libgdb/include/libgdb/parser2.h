@@ -40,10 +40,20 @@ typedef enum {
 	GDB_ZKIND_WATCHA,
 } gdb_ztype_t;
 
+typedef struct _gdb_cond_t gdb_cond_t;
+
+struct _gdb_cond_t {
+	size_t length;
+	uint8_t *bytecode; /* agent expression, NULL if malformed */
+
+	gdb_cond_t *next; /* NULL on end */
+};
+
 typedef struct {
 	gdb_ztype_t type;
 	gdb_addr_t address;
 	size_t kind;
+	gdb_cond_t *conds; /* NULL if unconditional */
 } gdb_breakpoint_t;
 
 typedef struct {
@@ -53,9 +63,16 @@ typedef struct {
 
 typedef struct {
 	gdb_memory_t location;
-	char *data; /* null-terminated hexstring */
+	char *data; /* hexstring ('M') or binary data ('X'), null-terminated */
 } gdb_memory_write_t;
 
+typedef struct {
+	char *object;
+	char *annex;
+	size_t offset;
+	size_t length;
+} gdb_xfer_t;
+
 typedef struct {
 	char op;
 	gdb_thread_t id;
@@ -80,6 +97,7 @@ typedef enum {
 	GDB_ARG_MEMORYW,
 	GDB_ARG_BREAK,
 	GDB_ARG_THREAD,
+	GDB_ARG_XFER,
 } gdb_argument_t;
 
 typedef struct {
@@ -94,6 +112,7 @@ typedef struct {
 		gdb_memory_write_t memw;
 		gdb_breakpoint_t bval;
 		gdb_thread_t tval;
+		gdb_xfer_t xfer;
 	} v;
 } gdb_command_t;
 
@@ -18,9 +18,9 @@ char *xstrdup(char *);
 
 gdb_command_t *gdb_new_cmd(char *, gdb_argument_t);
 
-int calc_csum(const char *);
+int calc_csum(const char *, size_t);
 bool gdb_is_valid(gdb_packet_t *);
-char *gdb_unescape(char *);
-char *gdb_decode_runlen(char *);
+char *gdb_unescape(const char *, size_t, size_t *);
+char *gdb_decode_runlen(const char *, size_t, size_t *);
 
 #endif
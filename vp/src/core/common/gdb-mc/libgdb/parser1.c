@@ -1,134 +1,96 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <libgdb/parser1.h>
 
-#include "mpc/mpc.h"
 #include "internal.h"
 
-static mpc_val_t *
-gdbf_packet(int n, mpc_val_t** xs)
-{
-	gdb_packet_t *pkt;
-	char *start, *csum;
-
-	xassert(n == 3);
+#define GDB_DATA_STEP 4096
 
-	pkt = xmalloc(sizeof(*pkt));
-	pkt->data = (char*)xs[1];
-
-	start = (char*)xs[0];
-	switch (*start) {
-	case '%':
-		pkt->kind = GDB_KIND_NOTIFY;
-		break;
-	case '$':
-		pkt->kind = GDB_KIND_PACKET;
-		break;
-	default:
-		xassert(0);
+/* Reads the packet data up to the checksum delimiter. Packets can be
+ * as large as the PacketSize announced to GDB (binary memory writes),
+ * the data is therefore read with a single stream lock and a buffer
+ * that grows geometrically. */
+static bool
+gdb_read_data(FILE *stream, gdb_packet_t *pkt)
+{
+	int c;
+	size_t i, len, cap;
+	char *data;
+
+	len = 0;
+	cap = GDB_DATA_STEP;
+	data = xmalloc(cap);
+
+	while ((c = getc_unlocked(stream)) != '#') {
+		if (c == EOF || c == '$' ||
+		    (c == '%' && pkt->kind == GDB_KIND_NOTIFY))
+			goto err;
+
+		if (len + 1 >= cap) {
+			cap *= 2;
+			data = xrealloc(data, cap);
+		}
+		data[len++] = (char)c;
 	}
+	data[len] = '\0';
 
-	csum = (char*)xs[2];
-	csum++; /* skip leading '#' */
-	memcpy(pkt->csum, csum, GDB_CSUM_LEN);
-
-	/* data (xs[1]) is still used in struct, don't free it */
-	free(xs[0]);
-	free(xs[2]);
+	for (i = 0; i < GDB_CSUM_LEN; i++) {
+		if ((c = getc_unlocked(stream)) == EOF)
+			goto err;
+		pkt->csum[i] = (char)c;
+	}
 
-	return pkt;
+	pkt->data = data;
+	pkt->len = len;
+	return true;
+err:
+	free(data);
+	return false;
 }
 
-static mpc_val_t *
-gdbf_acknowledge(mpc_val_t* xs)
+/* The GDB protocol has no delimiters between messages, the first
+ * byte determines the kind: acknowledgments consist of this byte
+ * only, packets and notifications continue up to the checksum. */
+gdb_packet_t *
+gdb_parse_pkt(FILE *stream)
 {
+	int c;
 	gdb_packet_t *pkt;
-	char *str;
 
 	pkt = xmalloc(sizeof(*pkt));
 	pkt->data = NULL;
+	pkt->len = 0;
 	memset(pkt->csum, 0, GDB_CSUM_LEN);
 
-	str = (char*)xs;
-	switch (*str) {
+	flockfile(stream);
+	switch ((c = getc_unlocked(stream))) {
 	case '+':
 		pkt->kind = GDB_KIND_ACK;
 		break;
 	case '-':
 		pkt->kind = GDB_KIND_NACK;
 		break;
+	case '$':
+	case '%':
+		pkt->kind = (c == '$') ? GDB_KIND_PACKET : GDB_KIND_NOTIFY;
+		if (!gdb_read_data(stream, pkt))
+			goto err;
+		break;
 	default:
-		xassert(0);
-	}
-
-	free(xs);
-	return pkt;
-}
-
-static mpc_parser_t *
-gdb_csum(void)
-{
-	mpc_parser_t *csum;
-
-	csum = mpc_and(2, mpcf_strfold, mpc_any(), mpc_any(), free);
-	return mpc_and(2, mpcf_strfold, mpc_char('#'), csum, free);
-}
-
-static mpc_parser_t *
-gdb_packet(void)
-{
-	mpc_parser_t *data;
-
-	data = mpc_many(mpcf_strfold, mpc_noneof("#$"));
-	return mpc_and(3, gdbf_packet, mpc_char('$'),
-	               data, gdb_csum(), free, free);
-}
-
-static mpc_parser_t *
-gdb_notification(void)
-{
-	mpc_parser_t *data;
-
-	data = mpc_many(mpcf_strfold, mpc_noneof("#$%"));
-	return mpc_and(3, gdbf_packet, mpc_char('%'),
-	               data, gdb_csum(), free, free);
-}
-
-static mpc_parser_t *
-gdb_acknowledge(void)
-{
-	return mpc_apply(mpc_oneof("+-"), gdbf_acknowledge);
-}
-
-static mpc_parser_t *
-gdb_parse_stage1(void)
-{
-	return mpc_or(3, gdb_acknowledge(),
-	              gdb_packet(),
-	              gdb_notification());
-}
-
-gdb_packet_t *
-gdb_parse_pkt(FILE *stream)
-{
-	gdb_packet_t *pkt;
-	mpc_parser_t *par;
-	mpc_result_t r;
-
-	pkt = NULL;
-	par = mpc_predictive(gdb_parse_stage1());
-
-	if (mpc_parse_pipe("<stream>", stream, par, &r)) {
-		pkt = (gdb_packet_t *)r.output;
-	} else {
 #ifdef GDB_PARSER_DEBUG
-		mpc_err_print(r.error);
+		if (c != EOF)
+			fprintf(stderr, "unexpected start of packet: 0x%02x\n", c);
 #endif
-		mpc_err_delete(r.error);
+		goto err;
 	}
+	funlockfile(stream);
 
-	mpc_cleanup(1, par);
 	return pkt;
+err:
+	funlockfile(stream);
+	free(pkt);
+	return NULL;
 }
@@ -1,4 +1,5 @@
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,6 +10,18 @@
 #include "parser2.h"
 #include "internal.h"
 
+static int
+hexval(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
 static mpc_val_t *
 gdbf_ignarg(mpc_val_t* xs)
 {
@@ -254,20 +267,56 @@ gdb_packet_m(void)
 	return mpc_and(2, gdbf_packet_m, mpc_char('m'), gdb_memory(), free);
 }
 
-gdbf_fold(M, GDB_ARG_MEMORYW, GDBF_ARG_MEMORYW)
-
 static mpc_parser_t *
-gdb_packet_M(void)
+gdb_arg(mpc_parser_t *par)
 {
-	return mpc_and(4, gdbf_packet_M, mpc_char('M'),
-	               gdb_memory(), mpc_char(':'), mpc_hexdigits(),
-	               free, free, free);
+	return mpc_and(2, mpcf_fst_free, par, mpc_char(','), free);
 }
 
-static mpc_parser_t *
-gdb_arg(mpc_parser_t *par)
+static mpc_val_t *
+gdbf_cond(int n, mpc_val_t **xs)
 {
-	return mpc_and(2, mpcf_fst_free, par, mpc_char(','), free);
+	size_t i, len;
+	char *hex;
+	gdb_cond_t *cond;
+
+	xassert(n == 3);
+
+	len = *(size_t *)xs[1];
+	hex = (char *)xs[2];
+
+	cond = xmalloc(sizeof(*cond));
+	cond->length = len;
+	cond->next = NULL;
+
+	/* A length that doesn't match the bytecode leaves it unset,
+	 * such breakpoints are rejected by the caller. */
+	cond->bytecode = NULL;
+	if (strlen(hex) == 2 * len) {
+		cond->bytecode = xmalloc(len + 1);
+		for (i = 0; i < len; i++)
+			cond->bytecode[i] = (uint8_t)(hexval(hex[2 * i]) << 4 | hexval(hex[2 * i + 1]));
+	}
+
+	free(xs[0]);
+	free(xs[1]);
+	free(xs[2]);
+
+	return cond;
+}
+
+static mpc_val_t *
+gdbf_conds(int n, mpc_val_t **xs)
+{
+	int i;
+
+	if (n == 0)
+		return NULL; /* unconditional */
+
+	for (i = 0; i + 1 < n; i++)
+		((gdb_cond_t *)xs[i])->next = (gdb_cond_t *)xs[i + 1];
+
+	return xs[0];
 }
 
 gdbf_fold(z, GDB_ARG_BREAK, GDBF_ARG_BREAK)
@@ -275,16 +324,39 @@ gdbf_fold(z, GDB_ARG_BREAK, GDBF_ARG_BREAK)
 static mpc_parser_t *
 gdb_packet_z(void)
 {
-	mpc_parser_t *name, *type;
+	mpc_parser_t *name, *type, *cond;
 
-	/* TODO: parse cond_list */
+	/* Conditions are agent expressions: ';X' len ',' bytecode.
+	 * TODO: parse the command list (';cmds:') */
 
 	name = mpc_or(2, mpc_char('z'), mpc_char('Z'));
 	type = mpc_apply(mpc_re("[0-4]"), mpcf_int);
+	cond = mpc_and(3, gdbf_cond, mpc_string(";X"),
+	               gdb_arg(gdb_uhex()), mpc_hexdigits(), free, free);
 
-	return mpc_and(4, gdbf_packet_z, name,
+	return mpc_and(5, gdbf_packet_z, name,
 	               gdb_arg(type), gdb_arg(gdb_address()),
-	               gdb_uhex(), free, free, free);
+	               gdb_uhex(), mpc_many(gdbf_conds, cond),
+	               free, free, free, free); /* destructor incorrect but unused */
+}
+
+gdbf_fold(qXfer, GDB_ARG_XFER, GDBF_ARG_XFER)
+
+static mpc_parser_t *
+gdb_packet_qxfer(void)
+{
+	mpc_parser_t *object, *annex;
+
+	/* Only reads are supported, the annex may be empty. */
+	object = mpc_and(2, mpcf_snd_free, mpc_char(':'),
+	                 mpc_many1(mpcf_strfold, mpc_noneof(":")), free);
+	annex = mpc_and(3, mpcf_snd_free, mpc_string(":read:"),
+	                mpc_many(mpcf_strfold, mpc_noneof(":")),
+	                mpc_char(':'), free, free);
+
+	return mpc_and(5, gdbf_packet_qXfer, mpc_string("qXfer"),
+	               object, annex, gdb_arg(gdb_uhex()), gdb_uhex(),
+	               free, free, free, free);
 }
 
 gdbf_fold(T, GDB_ARG_THREAD, GDBF_ARG_THREAD)
@@ -308,6 +380,71 @@ gdb_cmd(mpc_parser_t *cmd)
 	return mpc_and(2, mpcf_fst_free, cmd, mpc_eoi(), gdb_free_cmd);
 }
 
+/* Parses the hex number at *str up to the delimiter, which is skipped. */
+static bool
+gdb_scan_hex(const char **str, const char *end, char delim, uint64_t *out)
+{
+	const char *p;
+	uint64_t v;
+	int d;
+
+	for (v = 0, p = *str; p < end && *p != delim; p++) {
+		if ((d = hexval(*p)) < 0 || v >> 60)
+			return false;
+		v = v << 4 | (uint64_t)d;
+	}
+	if (p == *str || p == end)
+		return false;
+
+	*str = p + 1;
+	*out = v;
+	return true;
+}
+
+/* Memory writes carry up to PacketSize bytes, they are parsed by hand
+ * since mpc folds its input one character at a time. The data of 'M'
+ * is a hexstring of twice the length, 'X' carries the (unescaped)
+ * bytes themselves. */
+static gdb_command_t *
+gdb_parse_memw(const char *data, size_t len)
+{
+	const char *p, *end;
+	uint64_t addr, length;
+	size_t i, plen;
+	gdb_memory_write_t memw;
+	gdb_command_t *cmd;
+	bool binary;
+
+	xassert(len > 0);
+	binary = data[0] == 'X';
+
+	p = data + 1;
+	end = data + len;
+	if (!gdb_scan_hex(&p, end, ',', &addr) ||
+	    !gdb_scan_hex(&p, end, ':', &length) || length > SIZE_MAX / 2)
+		return NULL;
+
+	plen = (size_t)(end - p);
+	if (plen != (binary ? length : 2 * length))
+		return NULL;
+	if (!binary) {
+		for (i = 0; i < plen; i++)
+			if (hexval(p[i]) < 0)
+				return NULL;
+	}
+
+	memw.location.addr = (gdb_addr_t)addr;
+	memw.location.length = (size_t)length;
+	memw.data = xmalloc(plen + 1);
+	memcpy(memw.data, p, plen);
+	memw.data[plen] = '\0';
+
+	cmd = gdb_new_cmd(xstrdup(binary ? "X" : "M"), GDB_ARG_MEMORYW);
+	cmd->v.memw = memw;
+
+	return cmd;
+}
+
 static mpc_parser_t *
 gdb_parse_stage2(void)
 {
@@ -316,8 +453,8 @@ gdb_parse_stage2(void)
 	              gdb_cmd(gdb_packet_p()),
 	              gdb_cmd(gdb_packet_vcont()),
 	              gdb_cmd(gdb_packet_m()),
-	              gdb_cmd(gdb_packet_M()),
 	              gdb_cmd(gdb_packet_z()),
+	              gdb_cmd(gdb_packet_qxfer()),
 	              gdb_cmd(gdb_packet_T()),
 	              gdb_any());
 }
@@ -328,10 +465,10 @@ gdb_parse_cmd(gdb_packet_t *pkt)
 	mpc_result_t r;
 	mpc_parser_t *par;
 	char *data, *unesc;
+	size_t len;
 	gdb_command_t *cmd;
 
 	cmd = NULL;
-	par = gdb_parse_stage2();
 
 	if (pkt->kind != GDB_KIND_PACKET) {
 		errno = EINVAL;
@@ -343,14 +480,22 @@ gdb_parse_cmd(gdb_packet_t *pkt)
 		return NULL;
 	}
 
-	if (!(data = gdb_decode_runlen(pkt->data))) {
+	if (!(data = gdb_decode_runlen(pkt->data, pkt->len, &len))) {
 		errno = EBADMSG;
 		return NULL;
 	}
 
-	unesc = gdb_unescape(data);
+	unesc = gdb_unescape(data, len, &len);
 	free(data);
 
+	if (len > 0 && (*unesc == 'X' || *unesc == 'M')) {
+		if (!(cmd = gdb_parse_memw(unesc, len)))
+			errno = EBADMSG;
+		free(unesc);
+		return cmd;
+	}
+
+	par = gdb_parse_stage2();
 	if (mpc_parse("<packet>", unesc, par, &r)) {
 		cmd = (gdb_command_t *)r.output;
 	} else {
@@ -48,31 +48,34 @@
 		free(xs[1]);                                                   \
 	} while (0)
 
-#define GDBF_ARG_MEMORYW                                                       \
-	do {                                                                   \
-		xassert(n == 4);                                               \
-		cmd->v.memw.location = *((gdb_memory_t *)xs[1]);               \
-		cmd->v.memw.data = (char *)xs[3];                              \
-		free(xs[1]);                                                   \
-		free(xs[2]);                                                   \
-	} while (0)
-
 #define GDBF_ARG_BREAK                                                         \
 	do {                                                                   \
 		int type;                                                      \
 		                                                               \
-		xassert(n == 4);                                               \
+		xassert(n == 4 || n == 5);                                     \
 		type = *(int *)(xs[1]);                                        \
 		xassert(type >= GDB_ZKIND_SOFT && type <= GDB_ZKIND_WATCHA);   \
 		                                                               \
 		cmd->v.bval.type = (gdb_ztype_t)type;                          \
 		cmd->v.bval.address = *((gdb_addr_t *)xs[2]);                  \
 		cmd->v.bval.kind = *(size_t *)(xs[3]);                         \
+		cmd->v.bval.conds = (n == 5) ? (gdb_cond_t *)xs[4] : NULL;     \
 		free(xs[1]);                                                   \
 		free(xs[2]);                                                   \
 		free(xs[3]);                                                   \
 	} while (0)
 
+#define GDBF_ARG_XFER                                                          \
+	do {                                                                   \
+		xassert(n == 5);                                               \
+		cmd->v.xfer.object = (char *)xs[1];                            \
+		cmd->v.xfer.annex = (char *)xs[2];                             \
+		cmd->v.xfer.offset = *(size_t *)(xs[3]);                       \
+		cmd->v.xfer.length = *(size_t *)(xs[4]);                       \
+		free(xs[3]);                                                   \
+		free(xs[4]);                                                   \
+	} while (0)
+
 #define GDBF_ARG_THREAD                                                        \
 	do {                                                                   \
 		xassert(n == 2);                                               \
@@ -30,7 +30,7 @@ kind_to_char(gdb_kind_t kind)
 char *
 gdb_serialize(gdb_kind_t kind, const char *data)
 {
-	size_t pktlen;
+	size_t datalen, pktlen;
 	char *serialized;
 	char pktkind;
 	int csum, ret;
@@ -46,10 +46,11 @@ gdb_serialize(gdb_kind_t kind, const char *data)
 		return serialized;
 	}
 
-	csum = calc_csum(data);
+	datalen = strlen(data);
+	csum = calc_csum(data, datalen);
 
 	/* + 3 → nullbyte, checksum delimiter, kind */
-	pktlen = strlen(data) + GDB_CSUM_LEN + 3;
+	pktlen = datalen + GDB_CSUM_LEN + 3;
 	serialized = xmalloc(pktlen);
 
 	ret = snprintf(serialized, pktlen, "%c%s#%.2x", pktkind, data, csum);
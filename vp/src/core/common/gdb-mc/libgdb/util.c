@@ -19,19 +19,19 @@
 #define GDB_ESCAPE_BYTE 0x20
 
 int
-calc_csum(const char *data)
+calc_csum(const char *data, size_t len)
 {
 	size_t i;
-	int csum = 0;
+	unsigned csum = 0;
 
-	for (i = 0; i < strlen(data); i++)
-		csum += (int)data[i];
+	for (i = 0; i < len; i++)
+		csum += (unsigned char)data[i];
 
-	return csum % 256;
+	return (int)(csum % 256);
 }
 
 char *
-gdb_decode_runlen(char *data)
+gdb_decode_runlen(const char *data, size_t len, size_t *outlen)
 {
 	int rcount, j;
 	size_t i, nlen, nrem;
@@ -39,42 +39,41 @@ gdb_decode_runlen(char *data)
 	char *ndat;
 
 	nlen = 0;
-	nrem = strlen(data);
-	ndat = xmalloc(nrem);
+	nrem = len;
+	ndat = xmalloc(nrem + 1);
 
-	for (runlen = -1, i = 0; i < strlen(data); i++) {
+	for (runlen = -1, i = 0; i < len; i++) {
 		if (data[i] == GDB_RUNLEN_CHAR) {
 			if (i <= 0)
 				goto err;
-			runlen = data[i - 1];
+			runlen = (unsigned char)data[i - 1];
 			continue;
 		}
 
 		if (runlen == -1) {
-			runlen = data[i];
+			runlen = (unsigned char)data[i];
 			rcount = 1;
 		} else {
-			rcount = (int)data[i] - GDB_RUNLEN_OFF;
+			rcount = (unsigned char)data[i] - GDB_RUNLEN_OFF;
 			if (rcount <= 0)
 				goto err;
 		}
 
 		for (j = 0; j < rcount; j++) {
 			if (nrem-- == 0) {
-				ndat = xrealloc(ndat, nlen + GDB_RUNLEN_STEP);
+				ndat = xrealloc(ndat, nlen + GDB_RUNLEN_STEP + 1);
 				nrem += GDB_RUNLEN_STEP;
 			}
 
-			xassert(runlen >= 0 && runlen <= CHAR_MAX);
+			xassert(runlen >= 0 && runlen <= UCHAR_MAX);
 			ndat[nlen++] = (char)runlen;
 		}
 
 		runlen = -1;
 	}
 
-	/* shrink to actual size */
-	ndat = xrealloc(ndat, nlen + 1);
 	ndat[nlen] = '\0';
+	*outlen = nlen;
 
 	return ndat;
 err:
@@ -83,28 +82,27 @@ err:
 }
 
 char *
-gdb_unescape(char *data)
+gdb_unescape(const char *data, size_t len, size_t *outlen)
 {
 	size_t i, nlen;
 	char *ndat;
 	bool esc;
 
-	ndat = xmalloc(strlen(data));
+	ndat = xmalloc(len + 1);
 	nlen = 0;
 
-	for (esc = false, i = 0; i < strlen(data); i++) {
+	for (esc = false, i = 0; i < len; i++) {
 		if (data[i] == GDB_ESCAPE_CHAR) {
 			esc = true;
 			continue;
 		}
 
-		ndat[nlen++] = (esc) ? data[i] ^ GDB_ESCAPE_BYTE : data[i];
+		ndat[nlen++] = (esc) ? (char)(data[i] ^ GDB_ESCAPE_BYTE) : data[i];
 		esc = false;
 	}
 
-	/* shrink to actual size */
-	ndat = xrealloc(ndat, nlen + 1);
 	ndat[nlen] = '\0';
+	*outlen = nlen;
 
 	return ndat;
 }
@@ -118,7 +116,7 @@ gdb_is_valid(gdb_packet_t *pkt)
 
 	if (!pkt->data)
 		return true;
-	expcsum = calc_csum(pkt->data);
+	expcsum = calc_csum(pkt->data, pkt->len);
 
 	ret = snprintf(strcsum, sizeof(strcsum), "%.2x", expcsum);
 	xassert(ret == GDB_CSUM_LEN);
@@ -142,10 +140,24 @@ void
 gdb_free_cmd(gdb_command_t *cmd)
 {
 	gdb_vcont_t *parent, *next;
+	gdb_cond_t *cond, *cnext;
 
 	if (cmd->type == GDB_ARG_MEMORYW)
 		free(cmd->v.memw.data);
 
+	if (cmd->type == GDB_ARG_BREAK) {
+		for (cond = cmd->v.bval.conds; cond; cond = cnext) {
+			cnext = cond->next;
+			free(cond->bytecode);
+			free(cond);
+		}
+	}
+
+	if (cmd->type == GDB_ARG_XFER) {
+		free(cmd->v.xfer.object);
+		free(cmd->v.xfer.annex);
+	}
+
 	if (cmd->type == GDB_ARG_VCONT) {
 		parent = cmd->v.vval;
 		while (parent) {
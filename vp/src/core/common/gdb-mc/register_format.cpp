@@ -1,27 +1,33 @@
-#include <iomanip>
-
-#include <byteswap.h>
+#include <stdexcept>
 
 #include "register_format.h"
 
 RegisterFormater::RegisterFormater(Architecture arch) {
 	this->arch = arch;
-	this->stream << std::setfill('0') << std::hex;
 }
 
 void RegisterFormater::formatRegister(uint64_t value) {
+	static const char hexdigits[] = "0123456789abcdef";
+	unsigned nbytes;
+
 	switch (arch) {
 	case RV32:
-		stream << std::setw(8) << bswap_32(value);
+		nbytes = 4;
 		break;
 	case RV64:
-		stream << std::setw(16) << bswap_64(value);
+		nbytes = 8;
 		break;
 	default:
 		throw std::invalid_argument("Architecture not implemented");
 	}
+
+	// target byte order (little endian), i.e. least significant byte first
+	for (unsigned i = 0; i < nbytes; i++, value >>= 8) {
+		hex += hexdigits[(value >> 4) & 0xF];
+		hex += hexdigits[value & 0xF];
+	}
 }
 
 std::string RegisterFormater::str(void) {
-	return this->stream.str();
+	return hex;
 }
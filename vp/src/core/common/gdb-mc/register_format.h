@@ -1,7 +1,7 @@
 #ifndef RISCV_GDB_REGISTER
 #define RISCV_GDB_REGISTER
 
-#include <sstream>
+#include <string>
 
 #include <stdint.h>
 
@@ -10,7 +10,7 @@
 class RegisterFormater {
   private:
 	Architecture arch;
-	std::ostringstream stream;
+	std::string hex;
 
   public:
 	RegisterFormater(Architecture);
@@ -4,6 +4,7 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 
 constexpr uint32_t LUI_MASK = 0b00000000000000000000000001111111;
 constexpr uint32_t LUI_ENCODING = 0b00000000000000000000000000110111;
@@ -341,12 +342,194 @@ constexpr uint32_t FCVT_D_LU_ENCODING = 0b11010010001100000000000001010011;
 constexpr uint32_t FMV_D_X_MASK = 0b11111111111100000111000001111111;
 constexpr uint32_t FMV_D_X_ENCODING = 0b11110010000000000000000001010011;
 
-#define MATCH_AND_RETURN_INSTR2(instr, result)                     \
-	if (unlikely((data() & (instr##_MASK)) != (instr##_ENCODING))) \
-		return UNDEF;                                              \
-	return result;
+/* Encoding spec of all uncompressed instructions: an instruction word *w* encodes *op* iff (w & mask) == match.
+ * RV32 and RV64 only differ in the immediate shifts, which use one more shamt bit on RV64. The decoder lookup tables
+ * and the instruction types used for tracing are derived from this table. */
+struct InstructionSpec {
+	Opcode::Mapping op;
+	uint32_t mask;
+	uint32_t match;
+	unsigned archs;
+	Opcode::Type type;
+};
+
+#define INSTRUCTION_SPEC2(encoding, op, archs, type) \
+	{ Opcode::op, encoding##_MASK, encoding##_ENCODING, archs, Opcode::Type::type }
+#define INSTRUCTION_SPEC(op, archs, type) INSTRUCTION_SPEC2(op, op, archs, type)
+
+constexpr InstructionSpec INSTRUCTION_SPECS[] = {
+	INSTRUCTION_SPEC(LUI, RV32 | RV64, U),
+	INSTRUCTION_SPEC(AUIPC, RV32 | RV64, U),
+	INSTRUCTION_SPEC(JAL, RV32 | RV64, J),
+	INSTRUCTION_SPEC(JALR, RV32 | RV64, I),
+	INSTRUCTION_SPEC(BEQ, RV32 | RV64, B),
+	INSTRUCTION_SPEC(BNE, RV32 | RV64, B),
+	INSTRUCTION_SPEC(BLT, RV32 | RV64, B),
+	INSTRUCTION_SPEC(BGE, RV32 | RV64, B),
+	INSTRUCTION_SPEC(BLTU, RV32 | RV64, B),
+	INSTRUCTION_SPEC(BGEU, RV32 | RV64, B),
+	INSTRUCTION_SPEC(LB, RV32 | RV64, I),
+	INSTRUCTION_SPEC(LH, RV32 | RV64, I),
+	INSTRUCTION_SPEC(LW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(LBU, RV32 | RV64, I),
+	INSTRUCTION_SPEC(LHU, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SB, RV32 | RV64, S),
+	INSTRUCTION_SPEC(SH, RV32 | RV64, S),
+	INSTRUCTION_SPEC(SW, RV32 | RV64, S),
+	INSTRUCTION_SPEC(ADDI, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SLTI, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SLTIU, RV32 | RV64, I),
+	INSTRUCTION_SPEC(XORI, RV32 | RV64, I),
+	INSTRUCTION_SPEC(ORI, RV32 | RV64, I),
+	INSTRUCTION_SPEC(ANDI, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SLLI, RV64, R),
+	INSTRUCTION_SPEC(SRLI, RV64, R),
+	INSTRUCTION_SPEC(SRAI, RV64, R),
+	INSTRUCTION_SPEC2(SLLI_32, SLLI, RV32, R),
+	INSTRUCTION_SPEC2(SRLI_32, SRLI, RV32, R),
+	INSTRUCTION_SPEC2(SRAI_32, SRAI, RV32, R),
+	INSTRUCTION_SPEC(ADD, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SUB, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SLL, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SLT, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SLTU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(XOR, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SRL, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SRA, RV32 | RV64, R),
+	INSTRUCTION_SPEC(OR, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AND, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FENCE, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(FENCE_I, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(ECALL, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(EBREAK, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRW, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRS, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRC, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRWI, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRSI, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(CSRRCI, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(MUL, RV32 | RV64, R),
+	INSTRUCTION_SPEC(MULH, RV32 | RV64, R),
+	INSTRUCTION_SPEC(MULHSU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(MULHU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(DIV, RV32 | RV64, R),
+	INSTRUCTION_SPEC(DIVU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(REM, RV32 | RV64, R),
+	INSTRUCTION_SPEC(REMU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(LR_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SC_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOSWAP_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOADD_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOXOR_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOAND_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOOR_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMIN_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMAX_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMINU_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMAXU_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(URET, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(SRET, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(MRET, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(WFI, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(SFENCE_VMA, RV32 | RV64, UNKNOWN),
+	INSTRUCTION_SPEC(LWU, RV32 | RV64, I),
+	INSTRUCTION_SPEC(LD, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SD, RV32 | RV64, S),
+	INSTRUCTION_SPEC(ADDIW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SLLIW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SRLIW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(SRAIW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(ADDW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SUBW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SLLW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SRLW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SRAW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(MULW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(DIVW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(DIVUW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(REMW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(REMUW, RV32 | RV64, R),
+	INSTRUCTION_SPEC(LR_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(SC_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOSWAP_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOADD_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOXOR_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOAND_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOOR_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMIN_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMAX_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMINU_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(AMOMAXU_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLW, RV32 | RV64, I),
+	INSTRUCTION_SPEC(FSW, RV32 | RV64, S),
+	INSTRUCTION_SPEC(FMADD_S, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FMSUB_S, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FNMADD_S, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FNMSUB_S, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FADD_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSUB_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMUL_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FDIV_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSQRT_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJ_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJN_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJX_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMIN_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMAX_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_W_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_WU_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMV_X_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FEQ_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLT_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLE_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCLASS_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_S_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_S_WU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMV_W_X, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_L_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_LU_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_S_L, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_S_LU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLD, RV32 | RV64, I),
+	INSTRUCTION_SPEC(FSD, RV32 | RV64, S),
+	INSTRUCTION_SPEC(FMADD_D, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FMSUB_D, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FNMSUB_D, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FNMADD_D, RV32 | RV64, R4),
+	INSTRUCTION_SPEC(FADD_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSUB_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMUL_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FDIV_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSQRT_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJ_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJN_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FSGNJX_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMIN_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMAX_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_S_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_D_S, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FEQ_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLT_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FLE_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCLASS_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_W_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_WU_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_D_W, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_D_WU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_L_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_LU_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMV_X_D, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_D_L, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FCVT_D_LU, RV32 | RV64, R),
+	INSTRUCTION_SPEC(FMV_D_X, RV32 | RV64, R),
+};
 
-#define MATCH_AND_RETURN_INSTR(instr) MATCH_AND_RETURN_INSTR2(instr, instr)
+#undef INSTRUCTION_SPEC
+#undef INSTRUCTION_SPEC2
+
+constexpr unsigned NUMBER_OF_INSTRUCTION_SPECS = sizeof(INSTRUCTION_SPECS) / sizeof(INSTRUCTION_SPECS[0]);
+static_assert(NUMBER_OF_INSTRUCTION_SPECS < 256, "spec indices are stored as uint8_t");
+static_assert(Opcode::NUMBER_OF_INSTRUCTIONS <= 256, "opcodes are stored as uint8_t");
 
 namespace Compressed {
 enum Opcode {
@@ -608,164 +791,14 @@ std::array<const char *, Opcode::NUMBER_OF_INSTRUCTIONS> Opcode::mappingStr = {
 };
 
 Opcode::Type Opcode::getType(Opcode::Mapping mapping) {
-	switch (mapping) {
-		case SLLI:
-		case SRLI:
-		case SRAI:
-		case ADD:
-		case SUB:
-		case SLL:
-		case SLT:
-		case SLTU:
-		case XOR:
-		case SRL:
-		case SRA:
-		case OR:
-		case AND:
-		case MUL:
-		case MULH:
-		case MULHSU:
-		case MULHU:
-		case DIV:
-		case DIVU:
-		case REM:
-		case REMU:
-		case ADDW:
-		case SUBW:
-		case SLLW:
-		case SRLW:
-		case SRAW:
-		case MULW:
-		case DIVW:
-		case DIVUW:
-		case REMW:
-		case REMUW:
-		case LR_W:
-		case SC_W:
-		case AMOSWAP_W:
-		case AMOADD_W:
-		case AMOXOR_W:
-		case AMOAND_W:
-		case AMOOR_W:
-		case AMOMIN_W:
-		case AMOMAX_W:
-		case AMOMINU_W:
-		case AMOMAXU_W:
-		case LR_D:
-		case SC_D:
-		case AMOSWAP_D:
-		case AMOADD_D:
-		case AMOXOR_D:
-		case AMOAND_D:
-		case AMOOR_D:
-		case AMOMIN_D:
-		case AMOMAX_D:
-		case AMOMINU_D:
-		case AMOMAXU_D:
-		case FADD_S:
-		case FSUB_S:
-		case FMUL_S:
-		case FDIV_S:
-		case FSQRT_S:
-		case FSGNJ_S:
-		case FSGNJN_S:
-		case FSGNJX_S:
-		case FMIN_S:
-		case FMAX_S:
-		case FCVT_W_S:
-		case FCVT_WU_S:
-		case FMV_X_W:
-		case FEQ_S:
-		case FLT_S:
-		case FLE_S:
-		case FCLASS_S:
-		case FCVT_S_W:
-		case FCVT_S_WU:
-		case FMV_W_X:
-		case FCVT_L_S:
-		case FCVT_LU_S:
-		case FCVT_S_L:
-		case FCVT_S_LU:
-		case FADD_D:
-		case FSUB_D:
-		case FMUL_D:
-		case FDIV_D:
-		case FSQRT_D:
-		case FSGNJ_D:
-		case FSGNJN_D:
-		case FSGNJX_D:
-		case FMIN_D:
-		case FMAX_D:
-		case FCVT_S_D:
-		case FCVT_D_S:
-		case FEQ_D:
-		case FLT_D:
-		case FLE_D:
-		case FCLASS_D:
-		case FCVT_W_D:
-		case FCVT_WU_D:
-		case FCVT_D_W:
-		case FCVT_D_WU:
-		case FCVT_L_D:
-		case FCVT_LU_D:
-		case FMV_X_D:
-		case FCVT_D_L:
-		case FCVT_D_LU:
-		case FMV_D_X:
-			return Type::R;
-		case JALR:
-		case LB:
-		case LH:
-		case LW:
-		case LD:
-		case LBU:
-		case LHU:
-		case LWU:
-		case ADDI:
-		case SLTI:
-		case SLTIU:
-		case XORI:
-		case ORI:
-		case ANDI:
-		case ADDIW:
-		case SLLIW:
-		case SRLIW:
-		case SRAIW:
-		case FLW:
-		case FLD:
-			return Type::I;
-		case SB:
-		case SH:
-		case SW:
-		case SD:
-		case FSW:
-		case FSD:
-			return Type::S;
-		case BEQ:
-		case BNE:
-		case BLT:
-		case BGE:
-		case BLTU:
-		case BGEU:
-			return Type::B;
-		case LUI:
-		case AUIPC:
-			return Type::U;
-		case JAL:
-			return Type::J;
-		case FMADD_S:
-		case FMSUB_S:
-		case FNMSUB_S:
-		case FNMADD_S:
-		case FMADD_D:
-		case FMSUB_D:
-		case FNMSUB_D:
-		case FNMADD_D:
-			return Type::R4;
-
-		default:
-			return Type::UNKNOWN;
-	}
+	static const auto types = [] {
+		std::array<Opcode::Type, NUMBER_OF_INSTRUCTIONS> ans;
+		ans.fill(Type::UNKNOWN);
+		for (auto &spec : INSTRUCTION_SPECS) ans[spec.op] = spec.type;
+		return ans;
+	}();
+
+	return types.at(mapping);
 }
 
 unsigned C_ADDI4SPN_NZUIMM(uint32_t n) {
@@ -1341,558 +1374,97 @@ Opcode::Mapping expand_compressed(Instruction &instr, Compressed::Opcode op, Arc
 	throw std::runtime_error("some compressed instruction not handled");
 }
 
-Opcode::Mapping Instruction::decode_and_expand_compressed(Architecture arch) {
-	auto c_op = decode_compressed(*this, arch);
-	return expand_compressed(*this, c_op, arch);
-}
-
-Opcode::Mapping Instruction::decode_normal(Architecture arch) {
-	using namespace Opcode;
-
-	Instruction &instr = *this;
-
-	switch (instr.opcode()) {
-		case OP_LUI:
-			MATCH_AND_RETURN_INSTR(LUI);
-
-		case OP_AUIPC:
-			MATCH_AND_RETURN_INSTR(AUIPC);
-
-		case OP_JAL:
-			MATCH_AND_RETURN_INSTR(JAL);
-
-		case OP_JALR: {
-			MATCH_AND_RETURN_INSTR(JALR);
-		}
-
-		case OP_BEQ: {
-			switch (instr.funct3()) {
-				case F3_BEQ:
-					MATCH_AND_RETURN_INSTR(BEQ);
-				case F3_BNE:
-					MATCH_AND_RETURN_INSTR(BNE);
-				case F3_BLT:
-					MATCH_AND_RETURN_INSTR(BLT);
-				case F3_BGE:
-					MATCH_AND_RETURN_INSTR(BGE);
-				case F3_BLTU:
-					MATCH_AND_RETURN_INSTR(BLTU);
-				case F3_BGEU:
-					MATCH_AND_RETURN_INSTR(BGEU);
-			}
-			break;
-		}
-
-		case OP_LB: {
-			switch (instr.funct3()) {
-				case F3_LB:
-					MATCH_AND_RETURN_INSTR(LB);
-				case F3_LH:
-					MATCH_AND_RETURN_INSTR(LH);
-				case F3_LW:
-					MATCH_AND_RETURN_INSTR(LW);
-				case F3_LBU:
-					MATCH_AND_RETURN_INSTR(LBU);
-				case F3_LHU:
-					MATCH_AND_RETURN_INSTR(LHU);
-				case F3_LWU:
-					MATCH_AND_RETURN_INSTR(LWU);
-				case F3_LD:
-					MATCH_AND_RETURN_INSTR(LD);
-			}
-			break;
-		}
-
-		case OP_SB: {
-			switch (instr.funct3()) {
-				case F3_SB:
-					MATCH_AND_RETURN_INSTR(SB);
-				case F3_SH:
-					MATCH_AND_RETURN_INSTR(SH);
-				case F3_SW:
-					MATCH_AND_RETURN_INSTR(SW);
-				case F3_SD:
-					MATCH_AND_RETURN_INSTR(SD);
-			}
-			break;
-		}
-
-		case OP_ADDI: {
-			switch (instr.funct3()) {
-				case F3_ADDI:
-					MATCH_AND_RETURN_INSTR(ADDI);
-				case F3_SLTI:
-					MATCH_AND_RETURN_INSTR(SLTI);
-				case F3_SLTIU:
-					MATCH_AND_RETURN_INSTR(SLTIU);
-				case F3_XORI:
-					MATCH_AND_RETURN_INSTR(XORI);
-				case F3_ORI:
-					MATCH_AND_RETURN_INSTR(ORI);
-				case F3_ANDI:
-					MATCH_AND_RETURN_INSTR(ANDI);
-				case F3_SLLI:
-					if (arch == RV32) {
-						MATCH_AND_RETURN_INSTR2(SLLI_32, SLLI);
-					} else {
-						MATCH_AND_RETURN_INSTR(SLLI);
-					}
-				case F3_SRLI: {
-					switch (instr.funct6()) {
-						case F6_SRLI:
-							if (arch == RV32) {
-								MATCH_AND_RETURN_INSTR2(SRLI_32, SRLI);
-							} else {
-								MATCH_AND_RETURN_INSTR(SRLI);
-							}
-						case F6_SRAI:
-							if (arch == RV32) {
-								MATCH_AND_RETURN_INSTR2(SRAI_32, SRAI);
-							} else {
-								MATCH_AND_RETURN_INSTR(SRAI);
-							}
-					}
-				}
-			}
-			break;
-		}
-
-		case OP_ADDIW: {
-			switch (instr.funct3()) {
-				case F3_ADDIW:
-					MATCH_AND_RETURN_INSTR(ADDIW);
-				case F3_SLLIW:
-					MATCH_AND_RETURN_INSTR(SLLIW);
-				case F3_SRLIW: {
-					switch (instr.funct7()) {
-						case F7_SRLIW:
-							MATCH_AND_RETURN_INSTR(SRLIW);
-						case F7_SRAIW:
-							MATCH_AND_RETURN_INSTR(SRAIW);
-					}
-				}
-			}
-			break;
-		}
-
-		case OP_ADD: {
-			switch (instr.funct7()) {
-				case F7_ADD:
-					switch (instr.funct3()) {
-						case F3_ADD:
-							MATCH_AND_RETURN_INSTR(ADD);
-						case F3_SLL:
-							MATCH_AND_RETURN_INSTR(SLL);
-						case F3_SLT:
-							MATCH_AND_RETURN_INSTR(SLT);
-						case F3_SLTU:
-							MATCH_AND_RETURN_INSTR(SLTU);
-						case F3_XOR:
-							MATCH_AND_RETURN_INSTR(XOR);
-						case F3_SRL:
-							MATCH_AND_RETURN_INSTR(SRL);
-						case F3_OR:
-							MATCH_AND_RETURN_INSTR(OR);
-						case F3_AND:
-							MATCH_AND_RETURN_INSTR(AND);
-					}
-					break;
-
-				case F7_SUB:
-					switch (instr.funct3()) {
-						case F3_SUB:
-							MATCH_AND_RETURN_INSTR(SUB);
-						case F3_SRA:
-							MATCH_AND_RETURN_INSTR(SRA);
-					}
-					break;
-
-				case F7_MUL:
-					switch (instr.funct3()) {
-						case F3_MUL:
-							MATCH_AND_RETURN_INSTR(MUL);
-						case F3_MULH:
-							MATCH_AND_RETURN_INSTR(MULH);
-						case F3_MULHSU:
-							MATCH_AND_RETURN_INSTR(MULHSU);
-						case F3_MULHU:
-							MATCH_AND_RETURN_INSTR(MULHU);
-						case F3_DIV:
-							MATCH_AND_RETURN_INSTR(DIV);
-						case F3_DIVU:
-							MATCH_AND_RETURN_INSTR(DIVU);
-						case F3_REM:
-							MATCH_AND_RETURN_INSTR(REM);
-						case F3_REMU:
-							MATCH_AND_RETURN_INSTR(REMU);
-					}
-					break;
-			}
-			break;
+/* Both decoders are generated once per architecture on first use.
+ *
+ * The compressed decoder covers the complete 16 bit encoding space: every entry holds the expanded 32 bit instruction
+ * together with its opcode, so decoding a compressed instruction is a single table access.
+ *
+ * The uncompressed decoder buckets the instruction specs by the opcode, funct3 and funct7 bits of the instruction
+ * word. Nearly all buckets hold zero or one candidate, only instructions that are further distinguished by the rs1/rs2
+ * fields (e.g. FCVT_*, ECALL/EBREAK) share a bucket. */
+struct CompressedDecodeTable {
+	std::array<uint32_t, 1 << 16> instrs;
+	std::array<uint8_t, 1 << 16> ops;
+
+	explicit CompressedDecodeTable(Architecture arch) {
+		for (uint32_t n = 0; n < instrs.size(); ++n) {
+			Instruction instr(n);
+			auto op = Opcode::UNDEF;
+			// the uncompressed quadrant is never looked up
+			if (instr.is_compressed())
+				op = expand_compressed(instr, decode_compressed(instr, arch), arch);
+			instrs[n] = instr.data();
+			ops[n] = op;
 		}
+	}
+};
 
-		case OP_ADDW: {
-			switch (instr.funct7()) {
-				case F7_ADDW:
-					switch (instr.funct3()) {
-						case F3_ADDW:
-							MATCH_AND_RETURN_INSTR(ADDW);
-						case F3_SLLW:
-							MATCH_AND_RETURN_INSTR(SLLW);
-						case F3_SRLW:
-							MATCH_AND_RETURN_INSTR(SRLW);
-					}
-					break;
+struct NormalDecodeTable {
+	static constexpr uint32_t KEY_MASK = 0b11111110000000000111000001111100;
 
-				case F7_SUBW:
-					switch (instr.funct3()) {
-						case F3_SUBW:
-							MATCH_AND_RETURN_INSTR(SUBW);
-						case F3_SRAW:
-							MATCH_AND_RETURN_INSTR(SRAW);
-					}
-					break;
+	static unsigned key(uint32_t instr) {
+		return ((instr >> 2) & 0x1f) | (((instr >> 12) & 0x7) << 5) | ((instr >> 25) << 8);
+	}
 
-				case F7_MULW:
-					switch (instr.funct3()) {
-						case F3_MULW:
-							MATCH_AND_RETURN_INSTR(MULW);
-						case F3_DIVW:
-							MATCH_AND_RETURN_INSTR(DIVW);
-						case F3_DIVUW:
-							MATCH_AND_RETURN_INSTR(DIVUW);
-						case F3_REMW:
-							MATCH_AND_RETURN_INSTR(REMW);
-						case F3_REMUW:
-							MATCH_AND_RETURN_INSTR(REMUW);
-					}
-					break;
-			}
-			break;
-		}
+	// offset into *candidates* (upper 24 bits) and number of candidates (lower 8 bits) of each bucket
+	std::array<uint32_t, 1 << 15> buckets;
+	std::vector<uint8_t> candidates;
 
-		case OP_FENCE: {
-			switch (instr.funct3()) {
-				case F3_FENCE:
-					MATCH_AND_RETURN_INSTR(FENCE);
-				case F3_FENCE_I:
-					MATCH_AND_RETURN_INSTR(FENCE_I);
-			}
-			break;
-		}
+	explicit NormalDecodeTable(Architecture arch) {
+		for (uint32_t k = 0; k < buckets.size(); ++k) {
+			uint32_t bits = ((k & 0x1f) << 2) | (((k >> 5) & 0x7) << 12) | ((k >> 8) << 25);
+			assert(key(bits) == k && (bits & ~KEY_MASK) == 0);
 
-		case OP_ECALL: {
-			switch (instr.funct3()) {
-				case F3_SYS: {
-					switch (instr.funct12()) {
-						case F12_ECALL:
-							MATCH_AND_RETURN_INSTR(ECALL);
-						case F12_EBREAK:
-							MATCH_AND_RETURN_INSTR(EBREAK);
-						case F12_URET:
-							MATCH_AND_RETURN_INSTR(URET);
-						case F12_SRET:
-							MATCH_AND_RETURN_INSTR(SRET);
-						case F12_MRET:
-							MATCH_AND_RETURN_INSTR(MRET);
-						case F12_WFI:
-							MATCH_AND_RETURN_INSTR(WFI);
-						default:
-							MATCH_AND_RETURN_INSTR(SFENCE_VMA);
-					}
-					break;
-				}
-				case F3_CSRRW:
-					MATCH_AND_RETURN_INSTR(CSRRW);
-				case F3_CSRRS:
-					MATCH_AND_RETURN_INSTR(CSRRS);
-				case F3_CSRRC:
-					MATCH_AND_RETURN_INSTR(CSRRC);
-				case F3_CSRRWI:
-					MATCH_AND_RETURN_INSTR(CSRRWI);
-				case F3_CSRRSI:
-					MATCH_AND_RETURN_INSTR(CSRRSI);
-				case F3_CSRRCI:
-					MATCH_AND_RETURN_INSTR(CSRRCI);
+			uint32_t offset = candidates.size();
+			for (unsigned i = 0; i < NUMBER_OF_INSTRUCTION_SPECS; ++i) {
+				auto &spec = INSTRUCTION_SPECS[i];
+				if ((spec.archs & arch) && ((bits ^ spec.match) & spec.mask & KEY_MASK) == 0)
+					candidates.push_back(i);
 			}
-			break;
+			buckets[k] = (offset << 8) | (candidates.size() - offset);
 		}
+	}
 
-		case OP_AMO: {
-			switch (instr.funct5()) {
-				case F5_LR_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(LR_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(LR_W);
-					}
-				case F5_SC_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(SC_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(SC_W);
-					}
-				case F5_AMOSWAP_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOSWAP_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOSWAP_W);
-					}
-				case F5_AMOADD_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOADD_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOADD_W);
-					}
-				case F5_AMOXOR_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOXOR_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOXOR_W);
-					}
-				case F5_AMOAND_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOAND_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOAND_W);
-					}
-				case F5_AMOOR_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOOR_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOOR_W);
-					}
-				case F5_AMOMIN_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOMIN_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOMIN_W);
-					}
-				case F5_AMOMAX_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOMAX_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOMAX_W);
-					}
-				case F5_AMOMINU_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOMINU_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOMINU_W);
-					}
-				case F5_AMOMAXU_W:
-					if (instr.funct3() == F3_AMO_D) {
-						MATCH_AND_RETURN_INSTR(AMOMAXU_D);
-					} else {
-						MATCH_AND_RETURN_INSTR(AMOMAXU_W);
-					}
-			}
-			break;
+	Opcode::Mapping lookup(uint32_t instr) const {
+		uint32_t bucket = buckets[key(instr)];
+		const uint8_t *p = candidates.data() + (bucket >> 8);
+		for (const uint8_t *end = p + (bucket & 0xff); p != end; ++p) {
+			auto &spec = INSTRUCTION_SPECS[*p];
+			if ((instr & spec.mask) == spec.match)
+				return spec.op;
 		}
+		return Opcode::UNDEF;
+	}
+};
 
-		// RV32/64 FD Extension
-		case OP_FMADD_S:
-			switch (instr.funct2()) {
-				case F2_FMADD_S:
-					MATCH_AND_RETURN_INSTR(FMADD_S);
-				case F2_FMADD_D:
-					MATCH_AND_RETURN_INSTR(FMADD_D);
-			}
-			break;
+static const CompressedDecodeTable &compressed_decode_table(Architecture arch) {
+	if (arch == RV32) {
+		static const CompressedDecodeTable rv32(RV32);
+		return rv32;
+	}
+	static const CompressedDecodeTable rv64(RV64);
+	return rv64;
+}
 
-		case OP_FADD_S:
-			switch (instr.funct7()) {
-				case F7_FADD_S:
-					MATCH_AND_RETURN_INSTR(FADD_S);
-				case F7_FADD_D:
-					MATCH_AND_RETURN_INSTR(FADD_D);
-				case F7_FSUB_S:
-					MATCH_AND_RETURN_INSTR(FSUB_S);
-				case F7_FSUB_D:
-					MATCH_AND_RETURN_INSTR(FSUB_D);
-				case F7_FCVT_D_S:
-					MATCH_AND_RETURN_INSTR(FCVT_D_S);
-				case F7_FMUL_S:
-					MATCH_AND_RETURN_INSTR(FMUL_S);
-				case F7_FMUL_D:
-					MATCH_AND_RETURN_INSTR(FMUL_D);
-				case F7_FDIV_S:
-					MATCH_AND_RETURN_INSTR(FDIV_S);
-				case F7_FDIV_D:
-					MATCH_AND_RETURN_INSTR(FDIV_D);
-				case F7_FLE_S:
-					switch (instr.funct3()) {
-						case F3_FLE_S:
-							MATCH_AND_RETURN_INSTR(FLE_S);
-						case F3_FLT_S:
-							MATCH_AND_RETURN_INSTR(FLT_S);
-						case F3_FEQ_S:
-							MATCH_AND_RETURN_INSTR(FEQ_S);
-					}
-					break;
-				case F7_FSGNJ_D:
-					switch (instr.funct3()) {
-						case F3_FSGNJ_D:
-							MATCH_AND_RETURN_INSTR(FSGNJ_D);
-						case F3_FSGNJN_D:
-							MATCH_AND_RETURN_INSTR(FSGNJN_D);
-						case F3_FSGNJX_D:
-							MATCH_AND_RETURN_INSTR(FSGNJX_D);
-					}
-					break;
-				case F7_FMIN_S:
-					switch (instr.funct3()) {
-						case F3_FMIN_S:
-							MATCH_AND_RETURN_INSTR(FMIN_S);
-						case F3_FMAX_S:
-							MATCH_AND_RETURN_INSTR(FMAX_S);
-					}
-					break;
-				case F7_FMIN_D:
-					switch (instr.funct3()) {
-						case F3_FMIN_D:
-							MATCH_AND_RETURN_INSTR(FMIN_D);
-						case F3_FMAX_D:
-							MATCH_AND_RETURN_INSTR(FMAX_D);
-					}
-					break;
-				case F7_FCVT_S_D:
-					MATCH_AND_RETURN_INSTR(FCVT_S_D);
-				case F7_FSGNJ_S:
-					switch (instr.funct3()) {
-						case F3_FSGNJ_S:
-							MATCH_AND_RETURN_INSTR(FSGNJ_S);
-						case F3_FSGNJN_S:
-							MATCH_AND_RETURN_INSTR(FSGNJN_S);
-						case F3_FSGNJX_S:
-							MATCH_AND_RETURN_INSTR(FSGNJX_S);
-					}
-					break;
-				case F7_FLE_D:
-					switch (instr.funct3()) {
-						case F3_FLE_D:
-							MATCH_AND_RETURN_INSTR(FLE_D);
-						case F3_FLT_D:
-							MATCH_AND_RETURN_INSTR(FLT_D);
-						case F3_FEQ_D:
-							MATCH_AND_RETURN_INSTR(FEQ_D);
-					}
-					break;
-				case F7_FCVT_S_W:
-					switch (instr.rs2()) {
-						case RS2_FCVT_S_W:
-							MATCH_AND_RETURN_INSTR(FCVT_S_W);
-						case RS2_FCVT_S_WU:
-							MATCH_AND_RETURN_INSTR(FCVT_S_WU);
-						case RS2_FCVT_S_L:
-							MATCH_AND_RETURN_INSTR(FCVT_S_L);
-						case RS2_FCVT_S_LU:
-							MATCH_AND_RETURN_INSTR(FCVT_S_LU);
-					}
-					break;
-				case F7_FCVT_D_W:
-					switch (instr.rs2()) {
-						case RS2_FCVT_D_W:
-							MATCH_AND_RETURN_INSTR(FCVT_D_W);
-						case RS2_FCVT_D_WU:
-							MATCH_AND_RETURN_INSTR(FCVT_D_WU);
-						case RS2_FCVT_D_L:
-							MATCH_AND_RETURN_INSTR(FCVT_D_L);
-						case RS2_FCVT_D_LU:
-							MATCH_AND_RETURN_INSTR(FCVT_D_LU);
-					}
-					break;
-				case F7_FCVT_W_D:
-					switch (instr.rs2()) {
-						case RS2_FCVT_W_D:
-							MATCH_AND_RETURN_INSTR(FCVT_W_D);
-						case RS2_FCVT_WU_D:
-							MATCH_AND_RETURN_INSTR(FCVT_WU_D);
-						case RS2_FCVT_L_D:
-							MATCH_AND_RETURN_INSTR(FCVT_L_D);
-						case RS2_FCVT_LU_D:
-							MATCH_AND_RETURN_INSTR(FCVT_LU_D);
-					}
-					break;
-				case F7_FSQRT_S:
-					MATCH_AND_RETURN_INSTR(FSQRT_S);
-				case F7_FSQRT_D:
-					MATCH_AND_RETURN_INSTR(FSQRT_D);
-				case F7_FCVT_W_S:
-					switch (instr.rs2()) {
-						case RS2_FCVT_W_S:
-							MATCH_AND_RETURN_INSTR(FCVT_W_S);
-						case RS2_FCVT_WU_S:
-							MATCH_AND_RETURN_INSTR(FCVT_WU_S);
-						case RS2_FCVT_L_S:
-							MATCH_AND_RETURN_INSTR(FCVT_L_S);
-						case RS2_FCVT_LU_S:
-							MATCH_AND_RETURN_INSTR(FCVT_LU_S);
-					}
-					break;
-				case F7_FMV_X_W:
-					switch (instr.funct3()) {
-						case F3_FMV_X_W:
-							MATCH_AND_RETURN_INSTR(FMV_X_W);
-						case F3_FCLASS_S:
-							MATCH_AND_RETURN_INSTR(FCLASS_S);
-					}
-					break;
-				case F7_FMV_X_D:
-					switch (instr.funct3()) {
-						case F3_FMV_X_D:
-							MATCH_AND_RETURN_INSTR(FMV_X_D);
-						case F3_FCLASS_D:
-							MATCH_AND_RETURN_INSTR(FCLASS_D);
-					}
-					break;
-				case F7_FMV_W_X:
-					MATCH_AND_RETURN_INSTR(FMV_W_X);
-				case F7_FMV_D_X:
-					MATCH_AND_RETURN_INSTR(FMV_D_X);
-			}
-			break;
-		case OP_FLW:
-			switch (instr.funct3()) {
-				case F3_FLW:
-					MATCH_AND_RETURN_INSTR(FLW);
-				case F3_FLD:
-					MATCH_AND_RETURN_INSTR(FLD);
-			}
-			break;
-		case OP_FSW:
-			switch (instr.funct3()) {
-				case F3_FSW:
-					MATCH_AND_RETURN_INSTR(FSW);
-				case F3_FSD:
-					MATCH_AND_RETURN_INSTR(FSD);
-			}
-			break;
-		case OP_FMSUB_S:
-			switch (instr.funct2()) {
-				case F2_FMSUB_S:
-					MATCH_AND_RETURN_INSTR(FMSUB_S);
-				case F2_FMSUB_D:
-					MATCH_AND_RETURN_INSTR(FMSUB_D);
-			}
-			break;
-		case OP_FNMSUB_S:
-			switch (instr.funct2()) {
-				case F2_FNMSUB_S:
-					MATCH_AND_RETURN_INSTR(FNMSUB_S);
-				case F2_FNMSUB_D:
-					MATCH_AND_RETURN_INSTR(FNMSUB_D);
-			}
-			break;
-		case OP_FNMADD_S:
-			switch (instr.funct2()) {
-				case F2_FNMADD_S:
-					MATCH_AND_RETURN_INSTR(FNMADD_S);
-				case F2_FNMADD_D:
-					MATCH_AND_RETURN_INSTR(FNMADD_D);
-			}
-			break;
+static const NormalDecodeTable &normal_decode_table(Architecture arch) {
+	if (arch == RV32) {
+		static const NormalDecodeTable rv32(RV32);
+		return rv32;
 	}
+	static const NormalDecodeTable rv64(RV64);
+	return rv64;
+}
 
-	return UNDEF;
+Opcode::Mapping Instruction::decode_and_expand_compressed(Architecture arch) {
+	auto &table = compressed_decode_table(arch);
+	uint32_t n = instr & 0xffff;
+	auto op = (Opcode::Mapping)table.ops[n];
+	// keep the original instruction word for illegal instructions
+	if (likely(op != Opcode::UNDEF))
+		instr = table.instrs[n];
+	return op;
+}
+
+Opcode::Mapping Instruction::decode_normal(Architecture arch) {
+	return normal_decode_table(arch).lookup(instr);
 }
@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 
+namespace sc_core {
+class sc_event;
+}
+
 typedef uint32_t PrivilegeLevel;
 
 constexpr uint32_t MachineMode = 0b11;
@@ -29,6 +33,16 @@ struct interrupt_gateway {
 	virtual ~interrupt_gateway() {}
 
 	virtual void gateway_trigger_interrupt(uint32_t irq_id) = 0;
+
+	/* Periodic sources skip their wakeups while no hart has the interrupt enabled and wait for the enable event
+	 * instead. Gateways without an enable event report every interrupt as enabled. */
+	virtual bool gateway_interrupt_enabled(uint32_t irq_id) {
+		(void)irq_id;
+		return true;
+	}
+	virtual const sc_core::sc_event *gateway_enable_event() {
+		return nullptr;
+	}
 };
 
 #endif  // RISCV_ISA_IRQ_IF_H
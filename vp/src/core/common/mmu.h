@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mmu_mem_if.h"
+#include "pmp.h"
 
 constexpr unsigned PTE_PPN_SHIFT = 10;
 constexpr unsigned PGSHIFT = 12;
@@ -122,6 +123,22 @@ struct GenericMMU {
         return paddr;
     }
 
+    /* Translation of debugger accesses, without side effects: no timing, no TLB update, no A/D bit update and no PMP
+     * checks. Raises a page fault like a regular access if *vaddr* is not mapped. */
+    uint64_t translate_debug(uint64_t vaddr, MemoryAccessType type) {
+        if (core.csrs.satp.mode == SATP_MODE_BARE)
+            return vaddr;
+
+        auto mode = core.prv;
+        if (type != FETCH && core.csrs.mstatus.mprv)
+            mode = core.csrs.mstatus.mpp;
+
+        if (mode == MachineMode)
+            return vaddr;
+
+        return walk(vaddr, type, mode, true);
+    }
+
     vm_info decode_vm_info(PrivilegeLevel prv) {
         assert(prv <= SupervisorMode);
         uint64_t ptbase = (uint64_t)core.csrs.satp.ppn << PGSHIFT;
@@ -151,7 +168,19 @@ struct GenericMMU {
         return ok;
     }
 
-    uint64_t walk(uint64_t vaddr, MemoryAccessType type, PrivilegeLevel mode) {
+    uint64_t load_pte(uint64_t paddr, unsigned ptesize, bool debug) {
+        if (debug) {
+            uint64_t value = 0;
+            if (mem->mmu_debug_load(paddr, (uint8_t *)&value, ptesize) != ptesize)
+                return 0;  // not readable, treated as invalid PTE
+            return value;
+        }
+        if (ptesize == 4)
+            return mem->mmu_load_pte32(paddr);
+        return mem->mmu_load_pte64(paddr);
+    }
+
+    uint64_t walk(uint64_t vaddr, MemoryAccessType type, PrivilegeLevel mode, bool debug = false) {
         bool s_mode = mode == SupervisorMode;
         bool sum = core.csrs.mstatus.sum;
         bool mxr = core.csrs.mstatus.mxr;
@@ -169,15 +198,15 @@ struct GenericMMU {
             unsigned vpn_field = (vaddr >> (PGSHIFT + ptshift)) & ((1 << vm.idxbits) - 1);
 
             auto pte_paddr = base + vpn_field * vm.ptesize;
-            // TODO: PMP checks for pte_paddr with (LOAD, PRV_S)
+            // page table accesses are checked as S-mode accesses, a violation raises an access fault of the original
+            // access type
+            if (!debug && !core.pmp.is_allowed(pte_paddr, vm.ptesize, LOAD, SupervisorMode))
+                PMP::raise_access_fault(type, vaddr);
 
             assert(vm.ptesize == 4 || vm.ptesize == 8);
             assert(mem);
             pte_t pte;
-            if (vm.ptesize == 4)
-                pte.value = mem->mmu_load_pte32(pte_paddr);
-            else
-                pte.value = mem->mmu_load_pte64(pte_paddr);
+            pte.value = load_pte(pte_paddr, vm.ptesize, debug);
 
             uint64_t ppn = pte >> PTE_PPN_SHIFT;
 
@@ -218,11 +247,12 @@ struct GenericMMU {
                 break;  // misaligned superpage
 
             uint64_t ad = PTE_A | ((type == STORE) * PTE_D);
-            if ((pte & ad) != ad) {
+            if ((pte & ad) != ad && !debug) {
                 if (page_fault_on_AD) {
                     break;  // let SW deal with this
                 } else {
-                    // TODO: PMP checks for pte_paddr with (STORE, PRV_S)
+                    if (!core.pmp.is_allowed(pte_paddr, vm.ptesize, STORE, SupervisorMode))
+                        PMP::raise_access_fault(type, vaddr);
 
                     // NOTE: the store has to be atomic with the above load of the PTE, i.e. lock the bus if required
                     // NOTE: only need to update A / D flags, hence it is enough to store 32 bit (8 bit might be enough
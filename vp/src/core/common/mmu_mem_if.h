@@ -12,6 +12,8 @@ struct mmu_memory_if {
     virtual uint64_t mmu_load_pte64(uint64_t addr) = 0;
     virtual uint64_t mmu_load_pte32(uint64_t addr) = 0;
     virtual void mmu_store_pte32(uint64_t addr, uint32_t value) = 0;
+    // debugger access to physical memory without side effects, returns the number of bytes read
+    virtual unsigned mmu_debug_load(uint64_t addr, uint8_t *data, unsigned num_bytes) = 0;
 };
 
 #endif //RISCV_VP_MMU_MEM_IF_H
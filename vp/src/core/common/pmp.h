@@ -0,0 +1,253 @@
+#pragma once
+
+#include "irq_if.h"
+#include "mmu_mem_if.h"
+#include "trap.h"
+#include "util/common.h"
+
+#include <stdint.h>
+
+#include <array>
+
+/* Physical memory protection (PMP) with 16 entries, shared by the RV32 and RV64 cores.
+ *
+ * The PMP owns the architectural pmpcfg/pmpaddr state (the ISS mirrors the legalized values into its CSR table).
+ * Resolved permissions are cached per 4 KiB page. The cache is flushed on every pmpcfg/pmpaddr write, hence a steady
+ * state access costs a single table lookup. Pages that are only partially covered by an entry are not cached and
+ * always take the slow path.
+ *
+ * NOTE: as long as no entry is enabled, all accesses are permitted, i.e. software that does not use the PMP runs
+ * unchanged in S/U-mode (strictly, an S/U-mode access without matching entry fails once any entry is implemented). */
+class PMP {
+   public:
+	static constexpr unsigned NUM_ENTRIES = 16;
+
+	// pmpcfg fields
+	static constexpr uint8_t CFG_R = 1 << 0;
+	static constexpr uint8_t CFG_W = 1 << 1;
+	static constexpr uint8_t CFG_X = 1 << 2;
+	static constexpr uint8_t CFG_A = 0b11 << 3;
+	static constexpr uint8_t CFG_L = 1 << 7;
+	static constexpr uint8_t CFG_MASK = CFG_L | CFG_A | CFG_X | CFG_W | CFG_R;
+
+	enum AddressMatching {
+		A_OFF = 0,
+		A_TOR = 1,
+		A_NA4 = 2,
+		A_NAPOT = 3,
+	};
+
+	explicit PMP(unsigned xlen) : addr_mask(xlen == 32 ? 0xffffffff : 0x3fffffffffffff) {
+		cfg.fill(0);
+		addr.fill(0);
+		update();
+	}
+
+	uint8_t get_cfg(unsigned i) const {
+		return cfg.at(i);
+	}
+
+	uint64_t get_addr(unsigned i) const {
+		return addr.at(i);
+	}
+
+	/* Writes are WARL: locked entries are not modified and the reserved R=0/W=1 combination is not stored. */
+	void set_cfg(unsigned i, uint8_t value) {
+		if (cfg.at(i) & CFG_L)
+			return;
+		value &= CFG_MASK;
+		if (!(value & CFG_R))
+			value &= ~CFG_W;
+		if (cfg[i] != value) {
+			cfg[i] = value;
+			update();
+		}
+	}
+
+	void set_addr(unsigned i, uint64_t value) {
+		if (cfg.at(i) & CFG_L)
+			return;
+		// a locked TOR entry also locks the address register of the entry below
+		if (i + 1 < NUM_ENTRIES && (cfg[i + 1] & CFG_L) && address_matching(cfg[i + 1]) == A_TOR)
+			return;
+		value &= addr_mask;
+		if (addr[i] != value) {
+			addr[i] = value;
+			update();
+		}
+	}
+
+	/* Raises an access fault (with *trap_addr* as mtval) unless the access of *size* bytes at physical address *paddr*
+	 * is permitted for privilege level *prv*. */
+	inline void check(uint64_t paddr, unsigned size, MemoryAccessType type, PrivilegeLevel prv, uint64_t trap_addr) {
+		if (likely(!enabled))
+			return;
+
+		uint64_t page = paddr >> PAGE_SHIFT;
+		auto &e = cache[page % CACHE_ENTRIES];
+		if (likely(e.page == page && (paddr & PAGE_MASK) + size <= PAGE_SIZE)) {
+			if (likely(e.perms[prv == MachineMode] & access_bit(type)))
+				return;
+		} else if (is_allowed(paddr, size, type, prv)) {
+			return;
+		}
+
+		raise_access_fault(type, trap_addr);
+	}
+
+	bool is_allowed(uint64_t paddr, unsigned size, MemoryAccessType type, PrivilegeLevel prv) {
+		if (likely(!enabled))
+			return true;
+
+		uint64_t last = paddr + size - 1;
+
+		if ((paddr >> PAGE_SHIFT) == (last >> PAGE_SHIFT) && fill_cache(paddr >> PAGE_SHIFT))
+			return cache[(paddr >> PAGE_SHIFT) % CACHE_ENTRIES].perms[prv == MachineMode] & access_bit(type);
+
+		for (unsigned i = 0; i < num_regions; ++i) {
+			auto &r = regions[i];
+			if (last < r.first || paddr > r.last)
+				continue;
+			// the first matching entry decides, all bytes of the access have to be covered
+			if (paddr < r.first || last > r.last)
+				return false;
+			return permissions(r.cfg, prv) & access_bit(type);
+		}
+
+		return prv == MachineMode;
+	}
+
+	static void raise_access_fault(MemoryAccessType type, uint64_t trap_addr) {
+		switch (type) {
+			case FETCH:
+				raise_trap(EXC_INSTR_ACCESS_FAULT, trap_addr);
+				break;
+			case LOAD:
+				raise_trap(EXC_LOAD_ACCESS_FAULT, trap_addr);
+				break;
+			case STORE:
+				raise_trap(EXC_STORE_AMO_ACCESS_FAULT, trap_addr);
+				break;
+		}
+	}
+
+   private:
+	static constexpr unsigned PAGE_SHIFT = 12;
+	static constexpr uint64_t PAGE_SIZE = 1 << PAGE_SHIFT;
+	static constexpr uint64_t PAGE_MASK = PAGE_SIZE - 1;
+	static constexpr unsigned CACHE_ENTRIES = 256;
+	static constexpr uint64_t INVALID_PAGE = -1;
+
+	struct Region {
+		uint64_t first;
+		uint64_t last;  // inclusive, to represent regions that reach the end of the address space
+		uint8_t cfg;
+	};
+
+	struct CacheEntry {
+		uint64_t page = INVALID_PAGE;
+		// indexed by (prv == MachineMode), contains the access_bit of each permitted access type
+		uint8_t perms[2];
+	};
+
+	std::array<uint8_t, NUM_ENTRIES> cfg;
+	std::array<uint64_t, NUM_ENTRIES> addr;
+	const uint64_t addr_mask;
+
+	bool enabled = false;
+	std::array<Region, NUM_ENTRIES> regions;
+	unsigned num_regions = 0;
+	std::array<CacheEntry, CACHE_ENTRIES> cache;
+
+	static AddressMatching address_matching(uint8_t cfg) {
+		return AddressMatching((cfg & CFG_A) >> 3);
+	}
+
+	static uint8_t access_bit(MemoryAccessType type) {
+		return 1 << type;
+	}
+
+	static uint8_t permissions(uint8_t cfg, PrivilegeLevel prv) {
+		// unlocked entries do not restrict M-mode
+		if (prv == MachineMode && !(cfg & CFG_L))
+			return access_bit(FETCH) | access_bit(LOAD) | access_bit(STORE);
+
+		uint8_t ans = 0;
+		if (cfg & CFG_X)
+			ans |= access_bit(FETCH);
+		if (cfg & CFG_R)
+			ans |= access_bit(LOAD);
+		if (cfg & CFG_W)
+			ans |= access_bit(STORE);
+		return ans;
+	}
+
+	/* Recomputes the address regions of all enabled entries (in priority order) and flushes the permission cache. */
+	void update() {
+		num_regions = 0;
+		enabled = false;
+
+		for (unsigned i = 0; i < NUM_ENTRIES; ++i) {
+			uint64_t first, last;
+			switch (address_matching(cfg[i])) {
+				case A_OFF:
+					continue;
+
+				case A_TOR: {
+					uint64_t start = (i == 0) ? 0 : (addr[i - 1] << 2);
+					uint64_t end = addr[i] << 2;
+					enabled = true;
+					if (start >= end)
+						continue;  // never matches
+					first = start;
+					last = end - 1;
+				} break;
+
+				case A_NA4:
+					first = addr[i] << 2;
+					last = first + 3;
+					break;
+
+				case A_NAPOT: {
+					// the number of trailing ones encodes the region size: 2^(ones + 3) bytes
+					unsigned ones = __builtin_ctzll(~addr[i]);
+					uint64_t size_mask = (ones + 3 >= 64) ? ~uint64_t(0) : (uint64_t(1) << (ones + 3)) - 1;
+					first = (addr[i] << 2) & ~size_mask;
+					last = first | size_mask;
+				} break;
+			}
+
+			enabled = true;
+			regions[num_regions++] = {first, last, cfg[i]};
+		}
+
+		for (auto &e : cache) e.page = INVALID_PAGE;
+	}
+
+	/* Resolves the permissions of a complete page, returns false if the page is not uniformly covered. */
+	bool fill_cache(uint64_t page) {
+		auto &e = cache[page % CACHE_ENTRIES];
+		if (e.page == page)
+			return true;
+
+		uint64_t first = page << PAGE_SHIFT;
+		uint64_t last = first + PAGE_SIZE - 1;
+
+		for (unsigned i = 0; i < num_regions; ++i) {
+			auto &r = regions[i];
+			if (last < r.first || first > r.last)
+				continue;
+			if (first < r.first || last > r.last)
+				return false;
+			e.perms[0] = permissions(r.cfg, UserMode);
+			e.perms[1] = permissions(r.cfg, MachineMode);
+			e.page = page;
+			return true;
+		}
+
+		e.perms[0] = 0;
+		e.perms[1] = permissions(0, MachineMode);
+		e.page = page;
+		return true;
+	}
+};
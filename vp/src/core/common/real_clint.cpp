@@ -36,21 +36,23 @@ RealCLINT::RealCLINT(sc_core::sc_module_name, std::vector<clint_interrupt_target
 	  mtimecmp(regs_mtimecmp),
 	  mtime(regs_mtime),
 
+	  register_map("RealCLINT"),
 	  harts(_harts) {
 	for (size_t i = 0; i < harts.size(); i++) {
 		Timer *timer = new Timer(timercb, &event);
 		timers.push_back(timer);
 	}
 
-	register_ranges.insert(register_ranges.end(), {&regs_mtimecmp, &regs_msip, &regs_mtime});
-	for (auto reg : register_ranges)
-		reg->alignment = 4;
+	for (auto reg : {&regs_mtimecmp, &regs_msip, &regs_mtime})
+		register_map.add(reg);
+	for (auto reg : register_map)
+		reg->set_alignment(4);
 
-	regs_mtimecmp.post_write_callback = std::bind(&RealCLINT::post_write_mtimecmp, this, std::placeholders::_1);
-	regs_msip.post_write_callback = std::bind(&RealCLINT::post_write_msip, this, std::placeholders::_1);
+	regs_mtimecmp.post_write_callback.bind<RealCLINT, &RealCLINT::post_write_mtimecmp>(this);
+	regs_msip.post_write_callback.bind<RealCLINT, &RealCLINT::post_write_msip>(this);
 
-	regs_mtime.pre_read_callback = std::bind(&RealCLINT::pre_read_mtime, this, std::placeholders::_1);
-	regs_mtime.post_write_callback = std::bind(&RealCLINT::post_write_mtime, this, std::placeholders::_1);
+	regs_mtime.pre_read_callback.bind<RealCLINT, &RealCLINT::pre_read_mtime>(this);
+	regs_mtime.post_write_callback.bind<RealCLINT, &RealCLINT::post_write_mtime>(this);
 
 	first_mtime = std::chrono::high_resolution_clock::now();
 	tsock.register_b_transport(this, &RealCLINT::transport);
@@ -142,5 +144,5 @@ void RealCLINT::interrupt(void) {
 }
 
 void RealCLINT::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
-	vp::mm::route("RealCLINT", register_ranges, trans, delay);
+	register_map.route(trans, delay);
 }
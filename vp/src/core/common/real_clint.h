@@ -42,7 +42,7 @@ public:
 	ArrayView<uint64_t> mtimecmp;
 	IntegerView<uint64_t> mtime;
 
-	std::vector<RegisterRange*> register_ranges;
+	vp::mm::RegisterMap register_map;
 	std::vector<clint_interrupt_target*> &harts;
 
 	AsyncEvent event;
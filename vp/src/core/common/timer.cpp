@@ -1,119 +1,173 @@
 #include <assert.h>
-#include <limits.h>
-#include <stdlib.h>
-#include <signal.h>
 #include <errno.h>
-#include <err.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 
 #include "timer.h"
 
-/* As defined in nanosleep(3) */
-#define NS_MAX 999999999UL
-#define US_MAX (NS_MAX / 1000)
+/* About 100 years */
+#define MAX_DURATION_US (100ULL * 365 * 24 * 3600 * 1000000)
 
-/* Signal used to unblock nanosleep in thread */
-#define SIGNUM SIGUSR1
+static void
+throw_errno(void) {
+	throw std::system_error(errno, std::generic_category());
+}
 
-static int
-xnanosleep(const struct timespec *timespec) {
-	if (nanosleep(timespec, NULL) == 0)
-		return 0; /* success */
+/* Background thread that serves all timers of the process. Pending
+ * timers are kept in a set ordered by deadline, the timerfd is armed
+ * for the earliest one. The eventfd is only used for shutdown. */
+class TimerThread {
+public:
+	static TimerThread &get(void) {
+		static TimerThread instance;
+		return instance;
+	}
 
-	if (errno == EINTR)
-		return -1; /* received signal via pthread_kill, terminate */
+	void schedule(Timer *timer, Timer::time_point deadline) {
+		std::lock_guard<std::mutex> lock(mutex);
 
-	err(EXIT_FAILURE, "nanosleep failed"); /* EFAULT, EINVAL, … */
-}
+		if (timer->running)
+			pending.erase({timer->deadline, timer});
+		timer->deadline = deadline;
+		timer->running = true;
+		pending.insert({deadline, timer});
 
-static void *
-callback(void *arg)
-{
-	struct timespec timespec;
-	Timer::Context *ctx = (Timer::Context*)arg;
-
-	/* Initialize the seconds field, we use nanoseconds though */
-	timespec.tv_sec = 0;
-
-	auto count = ctx->duration.count();
-	while (count > US_MAX) {
-		timespec.tv_nsec = NS_MAX;
-		if (xnanosleep(&timespec))
-			return NULL; /* pthread_kill */
-		count -= US_MAX;
+		if (pending.begin()->second == timer)
+			arm(deadline);
 	}
 
-	// Convert remaining us → ns with overflow check
-	uint64_t ns = count * 1000;
-	assert(ns > count);
-
-	assert(ns <= LONG_MAX); // tv_nsec is a long
-	timespec.tv_nsec = ns;
-	if (xnanosleep(&timespec))
-		return NULL; /* pthread_kill */
+	void cancel(Timer *timer) {
+		// the callbacks run with the lock held, see run()
+		std::lock_guard<std::mutex> lock(mutex);
 
-	ctx->fn(ctx->arg);
-	return NULL;
-}
+		if (!timer->running)
+			return;
+		pending.erase({timer->deadline, timer});
+		timer->running = false;
+		// the timerfd stays armed, a spurious expiration is ignored
+	}
 
-Timer::Timer(Callback fn, void *arg)
-  : ctx(usecs(0), fn, arg) {
-	running = false;
-}
+private:
+	int epollfd;
+	int timerfd;
+	int stopfd;
+	std::thread thread;
+
+	std::mutex mutex;
+	std::set<std::pair<Timer::time_point, Timer*>> pending;
+
+	TimerThread(void) {
+		if ((epollfd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+			throw_errno();
+		if ((timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1)
+			throw_errno();
+		if ((stopfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+			throw_errno();
+
+		for (int fd : {timerfd, stopfd}) {
+			struct epoll_event ev;
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.fd = fd;
+			if (epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &ev) == -1)
+				throw_errno();
+		}
+
+		thread = std::thread(&TimerThread::run, this);
+	}
 
-Timer::~Timer(void) {
-	pause();
-}
+	~TimerThread(void) {
+		uint64_t one = 1;
+		if (write(stopfd, &one, sizeof(one)) == sizeof(one))
+			thread.join();
+		else
+			thread.detach();
 
-void Timer::start(usecs duration) {
-	if (running && (errno = pthread_join(thread, NULL)))
-		throw std::system_error(errno, std::generic_category());
+		close(stopfd);
+		close(timerfd);
+		close(epollfd);
+	}
 
-	/* Update duration for new callback */
-	ctx.duration = duration;
+	/* steady_clock is CLOCK_MONOTONIC on Linux, hence deadlines can
+	 * be programmed as absolute timerfd expirations. */
+	void arm(Timer::time_point deadline) {
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
 
-	if ((errno = pthread_create(&thread, NULL, callback, &ctx)))
-		throw std::system_error(errno, std::generic_category());
-	running = true;
-}
+		struct itimerspec spec;
+		memset(&spec, 0, sizeof(spec));
+		spec.it_value.tv_sec = ns / 1000000000;
+		spec.it_value.tv_nsec = ns % 1000000000;
+		if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+			spec.it_value.tv_nsec = 1; /* zero would disarm the timer */
 
-void Timer::pause(void) {
-	struct sigaction sa;
+		if (timerfd_settime(timerfd, TFD_TIMER_ABSTIME, &spec, NULL) == -1)
+			throw_errno();
+	}
 
-	if (!running)
-		return;
+	void expire(void) {
+		std::lock_guard<std::mutex> lock(mutex);
 
-	sa.sa_handler = SIG_IGN;
-	sa.sa_flags = SA_RESTART;
-	if (sigemptyset(&sa.sa_mask) == -1)
-		throw std::system_error(errno, std::generic_category());
+		auto now = std::chrono::steady_clock::now();
+		while (!pending.empty() && pending.begin()->first <= now) {
+			Timer *timer = pending.begin()->second;
+			pending.erase(pending.begin());
+			timer->running = false;
+			timer->fn(timer->arg);
+		}
 
-	if (sigaction(SIGNUM, &sa, NULL) == -1)
-		throw std::system_error(errno, std::generic_category());
+		if (!pending.empty())
+			arm(pending.begin()->first);
+	}
 
-	/* Signal is ignored in main thread, send it to background
-	 * thread and restore the default handler afterwards. */
-	stop_thread();
+	void run(void) {
+		for (;;) {
+			struct epoll_event ev;
+			int n = epoll_wait(epollfd, &ev, 1, -1);
+			if (n == -1) {
+				if (errno == EINTR)
+					continue;
+				throw_errno();
+			}
+
+			if (ev.data.fd == stopfd)
+				return;
+
+			uint64_t expirations;
+			if (read(timerfd, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+				throw_errno();
+			expire();
+		}
+	}
+};
 
-	sa.sa_handler = SIG_DFL;
-	if (sigaction(SIGNUM, &sa, NULL) == -1)
-		throw std::system_error(errno, std::generic_category());
+Timer::Timer(Callback fn, void *arg)
+  : fn(fn), arg(arg), running(false) {
+	/* start the background thread outside of the time critical path */
+	TimerThread::get();
 }
 
-void Timer::stop_thread(void) {
-	/* Attempt to cancel thread first, for the event that it hasn't
-	 * invoked nanosleep yet. The nanosleep function is a
-	 * cancelation point, as per pthreads(7). If the thread is
-	 * blocked in nanosleep the signal should interrupt the
-	 * nanosleep system call and cause thread termination. */
+Timer::~Timer(void) {
+	pause();
+}
 
-	assert(running);
+void Timer::start(usecs duration) {
+	/* Clamp far away deadlines (e.g. mtimecmp set to all ones) to
+	 * avoid an overflow of the signed steady_clock representation. */
+	duration = std::min(duration, usecs(MAX_DURATION_US));
 
-	// Either pthread_cancel or pthread_kill will stop the thread, in
-	// which case the other one will error out thus the error is ignored.
-	pthread_cancel(thread);
-	pthread_kill(thread, SIGNUM);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration);
+	TimerThread::get().schedule(this, deadline);
+}
 
-	if ((errno = pthread_join(thread, NULL)))
-		throw std::system_error(errno, std::generic_category());
-	running = false;
+void Timer::pause(void) {
+	TimerThread::get().cancel(this);
 }
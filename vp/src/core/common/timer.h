@@ -5,36 +5,42 @@
 #include <system_error>
 
 #include <stdint.h>
-#include <pthread.h>
 #include <stdbool.h>
 
+/* One-shot host timer. All timers of the process share a single
+ * background thread (see timer.cpp), hence starting, restarting and
+ * pausing a timer does not create or join any threads.
+ *
+ * The callback is invoked on the background thread. It must not
+ * start or pause any timer and should return quickly, e.g. by
+ * notifying an AsyncEvent. */
 class Timer {
 public:
 	typedef std::chrono::duration<uint64_t, std::micro> usecs;
+	typedef std::chrono::steady_clock::time_point time_point;
 
 	typedef void (*Callback) (void*);
-	class Context {
-	public:
-		Timer::usecs duration;
-		Callback fn;
-		void *arg;
-
-		Context(usecs _duration, Callback _fn, void *_arg)
-			: duration(_duration), fn(_fn), arg(_arg) {};
-	};
 
 	Timer(Callback fn, void *arg);
 	~Timer(void);
 
+	Timer(const Timer&) = delete;
+	Timer &operator=(const Timer&) = delete;
+
+	/* Once pause returns, the callback is neither running nor invoked
+	 * until the timer is started again. */
 	void pause(void);
+	/* (Re-)schedules the callback *duration* from now. */
 	void start(usecs duration);
 
 private:
-	Context ctx;
-	pthread_t thread;
-	bool running;
+	friend class TimerThread;
 
-	void stop_thread(void);
+	Callback fn;
+	void *arg;
+
+	bool running;
+	time_point deadline;
 };
 
 #endif
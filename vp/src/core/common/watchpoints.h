@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <bitset>
+#include <vector>
+
+#include "debug.h"
+#include "mmu_mem_if.h"
+#include "util/common.h"
+
+/* Data watchpoints of a hart (GDB Z2, Z3 and Z4 packets), checked by the memory interface on every data access.
+ *
+ * Accesses return after a single bit test unless they touch a page marked in *pages*, a filter indexed by the page
+ * number modulo its size. Only then are the watchpoints compared one by one, programs that do not access the pages of
+ * a watchpoint thus run at full speed. */
+class Watchpoints {
+	static constexpr unsigned PAGE_SHIFT = 12;
+	static constexpr unsigned FILTER_SIZE = 4096;
+
+	struct Watchpoint {
+		uint64_t addr;
+		uint64_t len;
+		WatchpointType type;
+
+		bool operator==(const Watchpoint &o) const {
+			return addr == o.addr && len == o.len && type == o.type;
+		}
+	};
+
+	std::vector<Watchpoint> watchpoints;
+	std::bitset<FILTER_SIZE> pages;
+	WatchpointHit last_hit;
+	bool hit = false;
+
+	static unsigned filter_index(uint64_t addr) {
+		return (addr >> PAGE_SHIFT) % FILTER_SIZE;
+	}
+
+	void update_filter() {
+		pages.reset();
+		for (auto &w : watchpoints) {
+			uint64_t first = w.addr >> PAGE_SHIFT;
+			uint64_t num_pages = ((w.addr + (w.len - 1)) >> PAGE_SHIFT) - first + 1;
+			if (num_pages >= FILTER_SIZE) {
+				pages.set();
+				return;
+			}
+			for (uint64_t p = first; p < first + num_pages; ++p)
+				pages.set(p % FILTER_SIZE);
+		}
+	}
+
+	void match(uint64_t addr, unsigned num_bytes, MemoryAccessType access) {
+		if (hit)
+			return;
+		for (auto &w : watchpoints) {
+			if (addr + num_bytes <= w.addr || addr >= w.addr + w.len)
+				continue;
+			if ((w.type == WatchpointType::Write && access != STORE) ||
+			    (w.type == WatchpointType::Read && access != LOAD))
+				continue;
+			last_hit = {w.type, std::max(addr, w.addr)};
+			hit = true;
+			return;
+		}
+	}
+
+   public:
+	void insert(uint64_t addr, uint64_t len, WatchpointType type) {
+		Watchpoint w = {addr, std::max(len, uint64_t(1)), type};
+		if (std::find(watchpoints.begin(), watchpoints.end(), w) == watchpoints.end())
+			watchpoints.push_back(w);
+		update_filter();
+	}
+
+	void remove(uint64_t addr, uint64_t len, WatchpointType type) {
+		Watchpoint w = {addr, std::max(len, uint64_t(1)), type};
+		watchpoints.erase(std::remove(watchpoints.begin(), watchpoints.end(), w), watchpoints.end());
+		update_filter();
+	}
+
+	inline void check(uint64_t addr, unsigned num_bytes, MemoryAccessType access) {
+		if (likely(watchpoints.empty()))
+			return;
+		if (pages[filter_index(addr)] || pages[filter_index(addr + num_bytes - 1)])
+			match(addr, num_bytes, access);
+	}
+
+	bool triggered() const {
+		return hit;
+	}
+
+	/* the first watchpoint hit since the last *clear_hit*, nullptr if none */
+	const WatchpointHit *get_hit() const {
+		return hit ? &last_hit : nullptr;
+	}
+
+	void clear_hit() {
+		hit = false;
+	}
+};
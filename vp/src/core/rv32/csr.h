@@ -1,11 +1,15 @@
 #pragma once
 
 #include <assert.h>
+#include <ctype.h>
 #include <stdint.h>
 
+#include <array>
+#include <initializer_list>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
 
+#include "core/common/csr_access.h"
 #include "core/common/trap.h"
 #include "util/common.h"
 
@@ -59,6 +63,48 @@ struct csr_misa {
 		return extensions & S;
 	}
 
+	/* Select the unprivileged extensions from an ISA string, e.g. "rv32imac" or "rv32gc". The privilege mode
+	 * extensions (N, U, S) are kept. */
+	void select_isa_string(const std::string &isa) {
+		if (isa.compare(0, 4, "rv32") != 0)
+			throw std::invalid_argument("ISA string '" + isa + "' does not start with 'rv32'");
+
+		unsigned ext = extensions & (N | U | S);
+		for (auto c : isa.substr(4)) {
+			switch (tolower(c)) {
+				case 'i':
+					ext |= I;
+					break;
+				case 'e':
+					ext |= E;
+					break;
+				case 'g':
+					ext |= I | M | A | F | D;
+					break;
+				case 'm':
+					ext |= M;
+					break;
+				case 'a':
+					ext |= A;
+					break;
+				case 'f':
+					ext |= F;
+					break;
+				case 'd':
+					ext |= D;
+					break;
+				case 'c':
+					ext |= C;
+					break;
+				default:
+					throw std::invalid_argument(std::string("unsupported extension '") + c + "' in ISA string '" + isa + "'");
+			}
+		}
+		if (!(ext & (I | E)))
+			throw std::invalid_argument("ISA string '" + isa + "' selects no base integer ISA");
+		extensions = ext;
+	}
+
 	enum {
 		A = 1,
 		C = 1 << 2,
@@ -633,229 +679,120 @@ struct csr_table {
 
 	csr_fcsr fcsr;
 
-	std::unordered_map<unsigned, uint32_t *> register_mapping;
+	// how ISS::get_csr_value and ISS::set_csr_value access a CSR, in addition to the masks of its entry
+	enum class Handler : uint8_t {
+		Invalid,  // not implemented, raises an illegal instruction
+		Masked,   // read and write the register through the read and write mask
+		Time,     // reads update the time from the CLINT first
+		Cycle,    // reads update the cycle count first
+		Satp,     // trapped by mstatus.TVM
+		Epc,      // writes use the current pc alignment as write mask
+		Pmpcfg,
+		Pmpaddr,
+		Fflags,
+		Frm,
+	};
 
-	csr_table() {
-		using namespace csr;
+	struct entry {
+		uint32_t *reg = nullptr;
+		uint32_t read_mask = 0;
+		uint32_t write_mask = 0;
+		Handler handler = Handler::Invalid;
+	};
 
-		register_mapping[CYCLE_ADDR] = (uint32_t *)(&cycle.reg);
-		register_mapping[CYCLEH_ADDR] = (uint32_t *)(&cycle.reg) + 1;
-		register_mapping[TIME_ADDR] = (uint32_t *)(&time.reg);
-		register_mapping[TIMEH_ADDR] = (uint32_t *)(&time.reg) + 1;
-		register_mapping[INSTRET_ADDR] = (uint32_t *)(&instret.reg);
-		register_mapping[INSTRETH_ADDR] = (uint32_t *)(&instret.reg) + 1;
-		register_mapping[MCYCLE_ADDR] = (uint32_t *)(&cycle.reg);
-		register_mapping[MCYCLEH_ADDR] = (uint32_t *)(&cycle.reg) + 1;
-		register_mapping[MTIME_ADDR] = (uint32_t *)(&time.reg);
-		register_mapping[MTIMEH_ADDR] = (uint32_t *)(&time.reg) + 1;
-		register_mapping[MINSTRET_ADDR] = (uint32_t *)(&instret.reg);
-		register_mapping[MINSTRETH_ADDR] = (uint32_t *)(&instret.reg) + 1;
-
-		register_mapping[MVENDORID_ADDR] = &mvendorid.reg;
-		register_mapping[MARCHID_ADDR] = &marchid.reg;
-		register_mapping[MIMPID_ADDR] = &mimpid.reg;
-		register_mapping[MHARTID_ADDR] = &mhartid.reg;
-
-		register_mapping[MSTATUS_ADDR] = &mstatus.reg;
-		register_mapping[MISA_ADDR] = &misa.reg;
-		register_mapping[MEDELEG_ADDR] = &medeleg.reg;
-		register_mapping[MIDELEG_ADDR] = &mideleg.reg;
-		register_mapping[MIE_ADDR] = &mie.reg;
-		register_mapping[MTVEC_ADDR] = &mtvec.reg;
-		register_mapping[MCOUNTEREN_ADDR] = &mcounteren.reg;
-		register_mapping[MCOUNTINHIBIT_ADDR] = &mcountinhibit.reg;
-
-		register_mapping[MSCRATCH_ADDR] = &mscratch.reg;
-		register_mapping[MEPC_ADDR] = &mepc.reg;
-		register_mapping[MCAUSE_ADDR] = &mcause.reg;
-		register_mapping[MTVAL_ADDR] = &mtval.reg;
-		register_mapping[MIP_ADDR] = &mip.reg;
-
-		for (unsigned i = 0; i < 16; ++i) register_mapping[PMPADDR0_ADDR + i] = &pmpaddr[i].reg;
-
-		for (unsigned i = 0; i < 4; ++i) register_mapping[PMPCFG0_ADDR + i] = &pmpcfg[i].reg;
-
-		register_mapping[SEDELEG_ADDR] = &sedeleg.reg;
-		register_mapping[SIDELEG_ADDR] = &sideleg.reg;
-		register_mapping[STVEC_ADDR] = &stvec.reg;
-		register_mapping[SCOUNTEREN_ADDR] = &scounteren.reg;
-		register_mapping[SSCRATCH_ADDR] = &sscratch.reg;
-		register_mapping[SEPC_ADDR] = &sepc.reg;
-		register_mapping[SCAUSE_ADDR] = &scause.reg;
-		register_mapping[STVAL_ADDR] = &stval.reg;
-		register_mapping[SATP_ADDR] = &satp.reg;
-
-		register_mapping[UTVEC_ADDR] = &utvec.reg;
-		register_mapping[USCRATCH_ADDR] = &uscratch.reg;
-		register_mapping[UEPC_ADDR] = &uepc.reg;
-		register_mapping[UCAUSE_ADDR] = &ucause.reg;
-		register_mapping[UTVAL_ADDR] = &utval.reg;
-
-		register_mapping[FCSR_ADDR] = &fcsr.reg;
-	}
+	// dense mapping of the 12 bit CSR address space
+	std::array<entry, CsrAccessTable::NUM_ADDRESSES> entries;
 
-	bool is_valid_csr32_addr(unsigned addr) {
-		return register_mapping.find(addr) != register_mapping.end();
-	}
+	// backing registers of the hardwired CSRs, never written due to a zero write mask
+	uint32_t hardwired_zero = 0;
+	uint32_t hardwired_one = 1;
 
-	void default_write32(unsigned addr, uint32_t value) {
-		auto it = register_mapping.find(addr);
-		ensure((it != register_mapping.end()) && "validate address before calling this function");
-		*it->second = value;
+	void map(unsigned addr, uint32_t *reg, uint32_t read_mask = ~0u, uint32_t write_mask = ~0u,
+	         Handler handler = Handler::Masked) {
+		entries[addr] = {reg, read_mask, write_mask, handler};
 	}
 
-	uint32_t default_read32(unsigned addr) {
-		auto it = register_mapping.find(addr);
-		ensure((it != register_mapping.end()) && "validate address before calling this function");
-		return *it->second;
+	csr_table() {
+		using namespace csr;
+
+		map(CYCLE_ADDR, (uint32_t *)(&cycle.reg));
+		map(CYCLEH_ADDR, (uint32_t *)(&cycle.reg) + 1);
+		map(TIME_ADDR, (uint32_t *)(&time.reg), ~0u, ~0u, Handler::Time);
+		map(TIMEH_ADDR, (uint32_t *)(&time.reg) + 1, ~0u, ~0u, Handler::Time);
+		map(INSTRET_ADDR, (uint32_t *)(&instret.reg));
+		map(INSTRETH_ADDR, (uint32_t *)(&instret.reg) + 1);
+		map(MCYCLE_ADDR, (uint32_t *)(&cycle.reg), ~0u, ~0u, Handler::Cycle);
+		map(MCYCLEH_ADDR, (uint32_t *)(&cycle.reg) + 1, ~0u, ~0u, Handler::Cycle);
+		map(MTIME_ADDR, (uint32_t *)(&time.reg), ~0u, ~0u, Handler::Time);
+		map(MTIMEH_ADDR, (uint32_t *)(&time.reg) + 1, ~0u, ~0u, Handler::Time);
+		map(MINSTRET_ADDR, (uint32_t *)(&instret.reg));
+		map(MINSTRETH_ADDR, (uint32_t *)(&instret.reg) + 1);
+
+		// hpm counters are not implemented
+		for (unsigned i = 3; i < 32; ++i) {
+			map(HPMCOUNTER3_ADDR + i - 3, &hardwired_zero, ~0u, 0);
+			map(HPMCOUNTER3H_ADDR + i - 3, &hardwired_zero, ~0u, 0);
+			map(MHPMCOUNTER3_ADDR + i - 3, &hardwired_zero, ~0u, 0);
+			map(MHPMCOUNTER3H_ADDR + i - 3, &hardwired_zero, ~0u, 0);
+			map(MHPMEVENT3_ADDR + i - 3, &hardwired_zero, ~0u, 0);
+		}
+
+		map(MVENDORID_ADDR, &mvendorid.reg);
+		map(MARCHID_ADDR, &marchid.reg);
+		map(MIMPID_ADDR, &mimpid.reg);
+		map(MHARTID_ADDR, &mhartid.reg);
+
+		map(MSTATUS_ADDR, &mstatus.reg, MSTATUS_MASK, MSTATUS_MASK);
+		map(MISA_ADDR, &misa.reg, ~0u, 0);  // currently, read-only, thus cannot be changed at runtime
+		map(MEDELEG_ADDR, &medeleg.reg, ~0u, MEDELEG_MASK);
+		map(MIDELEG_ADDR, &mideleg.reg, ~0u, MIDELEG_MASK);
+		map(MIE_ADDR, &mie.reg, MIE_MASK, MIE_MASK);
+		map(MTVEC_ADDR, &mtvec.reg, ~0u, MTVEC_MASK);
+		map(MCOUNTEREN_ADDR, &mcounteren.reg, ~0u, MCOUNTEREN_MASK);
+		map(MCOUNTINHIBIT_ADDR, &mcountinhibit.reg, ~0u, MCOUNTINHIBIT_MASK);
+
+		map(MSCRATCH_ADDR, &mscratch.reg);
+		map(MEPC_ADDR, &mepc.reg, ~0u, ~0u, Handler::Epc);
+		map(MCAUSE_ADDR, &mcause.reg);
+		map(MTVAL_ADDR, &mtval.reg);
+		map(MIP_ADDR, &mip.reg, MIP_READ_MASK, MIP_WRITE_MASK);
+
+		for (unsigned i = 0; i < 16; ++i) map(PMPADDR0_ADDR + i, &pmpaddr[i].reg, ~0u, ~0u, Handler::Pmpaddr);
+
+		for (unsigned i = 0; i < 4; ++i) map(PMPCFG0_ADDR + i, &pmpcfg[i].reg, ~0u, ~0u, Handler::Pmpcfg);
+
+		map(SSTATUS_ADDR, &mstatus.reg, SSTATUS_MASK, SSTATUS_MASK);
+		map(SEDELEG_ADDR, &sedeleg.reg, ~0u, SEDELEG_MASK);
+		map(SIDELEG_ADDR, &sideleg.reg, ~0u, SIDELEG_MASK);
+		map(SIE_ADDR, &mie.reg, SIE_MASK, SIE_MASK);
+		map(STVEC_ADDR, &stvec.reg, ~0u, MTVEC_MASK);
+		map(SCOUNTEREN_ADDR, &scounteren.reg, ~0u, MCOUNTEREN_MASK);
+		map(SSCRATCH_ADDR, &sscratch.reg);
+		map(SEPC_ADDR, &sepc.reg, ~0u, ~0u, Handler::Epc);
+		map(SCAUSE_ADDR, &scause.reg);
+		map(STVAL_ADDR, &stval.reg);
+		map(SIP_ADDR, &mip.reg, SIP_MASK, SIP_MASK);
+		map(SATP_ADDR, &satp.reg, ~0u, SATP_MASK, Handler::Satp);
+
+		map(USTATUS_ADDR, &mstatus.reg, USTATUS_MASK, USTATUS_MASK);
+		map(UIE_ADDR, &mie.reg, UIE_MASK, UIE_MASK);
+		map(UTVEC_ADDR, &utvec.reg, ~0u, MTVEC_MASK);
+		map(USCRATCH_ADDR, &uscratch.reg);
+		map(UEPC_ADDR, &uepc.reg, ~0u, ~0u, Handler::Epc);
+		map(UCAUSE_ADDR, &ucause.reg);
+		map(UTVAL_ADDR, &utval.reg);
+		map(UIP_ADDR, &mip.reg, UIP_MASK, UIP_MASK);
+
+		map(FFLAGS_ADDR, &fcsr.reg, ~0u, ~0u, Handler::Fflags);
+		map(FRM_ADDR, &fcsr.reg, ~0u, ~0u, Handler::Frm);
+		map(FCSR_ADDR, &fcsr.reg, FCSR_MASK, FCSR_MASK);
+
+		// debug CSRs not supported, thus hardwired
+		// if a zero write by SW is preserved, then debug mode is supported (thus hardwire tselect to non-zero)
+		map(TSELECT_ADDR, &hardwired_one, ~0u, 0);
+		for (unsigned addr : {TDATA1_ADDR, TDATA2_ADDR, TDATA3_ADDR, DCSR_ADDR, DPC_ADDR, DSCRATCH0_ADDR, DSCRATCH1_ADDR})
+			map(addr, &hardwired_zero, ~0u, 0);
 	}
 };
 
-#define SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32 \
-	case HPMCOUNTER3_ADDR:                    \
-	case HPMCOUNTER4_ADDR:                    \
-	case HPMCOUNTER5_ADDR:                    \
-	case HPMCOUNTER6_ADDR:                    \
-	case HPMCOUNTER7_ADDR:                    \
-	case HPMCOUNTER8_ADDR:                    \
-	case HPMCOUNTER9_ADDR:                    \
-	case HPMCOUNTER10_ADDR:                   \
-	case HPMCOUNTER11_ADDR:                   \
-	case HPMCOUNTER12_ADDR:                   \
-	case HPMCOUNTER13_ADDR:                   \
-	case HPMCOUNTER14_ADDR:                   \
-	case HPMCOUNTER15_ADDR:                   \
-	case HPMCOUNTER16_ADDR:                   \
-	case HPMCOUNTER17_ADDR:                   \
-	case HPMCOUNTER18_ADDR:                   \
-	case HPMCOUNTER19_ADDR:                   \
-	case HPMCOUNTER20_ADDR:                   \
-	case HPMCOUNTER21_ADDR:                   \
-	case HPMCOUNTER22_ADDR:                   \
-	case HPMCOUNTER23_ADDR:                   \
-	case HPMCOUNTER24_ADDR:                   \
-	case HPMCOUNTER25_ADDR:                   \
-	case HPMCOUNTER26_ADDR:                   \
-	case HPMCOUNTER27_ADDR:                   \
-	case HPMCOUNTER28_ADDR:                   \
-	case HPMCOUNTER29_ADDR:                   \
-	case HPMCOUNTER30_ADDR:                   \
-	case HPMCOUNTER31_ADDR:                   \
-	case HPMCOUNTER3H_ADDR:                   \
-	case HPMCOUNTER4H_ADDR:                   \
-	case HPMCOUNTER5H_ADDR:                   \
-	case HPMCOUNTER6H_ADDR:                   \
-	case HPMCOUNTER7H_ADDR:                   \
-	case HPMCOUNTER8H_ADDR:                   \
-	case HPMCOUNTER9H_ADDR:                   \
-	case HPMCOUNTER10H_ADDR:                  \
-	case HPMCOUNTER11H_ADDR:                  \
-	case HPMCOUNTER12H_ADDR:                  \
-	case HPMCOUNTER13H_ADDR:                  \
-	case HPMCOUNTER14H_ADDR:                  \
-	case HPMCOUNTER15H_ADDR:                  \
-	case HPMCOUNTER16H_ADDR:                  \
-	case HPMCOUNTER17H_ADDR:                  \
-	case HPMCOUNTER18H_ADDR:                  \
-	case HPMCOUNTER19H_ADDR:                  \
-	case HPMCOUNTER20H_ADDR:                  \
-	case HPMCOUNTER21H_ADDR:                  \
-	case HPMCOUNTER22H_ADDR:                  \
-	case HPMCOUNTER23H_ADDR:                  \
-	case HPMCOUNTER24H_ADDR:                  \
-	case HPMCOUNTER25H_ADDR:                  \
-	case HPMCOUNTER26H_ADDR:                  \
-	case HPMCOUNTER27H_ADDR:                  \
-	case HPMCOUNTER28H_ADDR:                  \
-	case HPMCOUNTER29H_ADDR:                  \
-	case HPMCOUNTER30H_ADDR:                  \
-	case HPMCOUNTER31H_ADDR:                  \
-	case MHPMCOUNTER3_ADDR:                   \
-	case MHPMCOUNTER4_ADDR:                   \
-	case MHPMCOUNTER5_ADDR:                   \
-	case MHPMCOUNTER6_ADDR:                   \
-	case MHPMCOUNTER7_ADDR:                   \
-	case MHPMCOUNTER8_ADDR:                   \
-	case MHPMCOUNTER9_ADDR:                   \
-	case MHPMCOUNTER10_ADDR:                  \
-	case MHPMCOUNTER11_ADDR:                  \
-	case MHPMCOUNTER12_ADDR:                  \
-	case MHPMCOUNTER13_ADDR:                  \
-	case MHPMCOUNTER14_ADDR:                  \
-	case MHPMCOUNTER15_ADDR:                  \
-	case MHPMCOUNTER16_ADDR:                  \
-	case MHPMCOUNTER17_ADDR:                  \
-	case MHPMCOUNTER18_ADDR:                  \
-	case MHPMCOUNTER19_ADDR:                  \
-	case MHPMCOUNTER20_ADDR:                  \
-	case MHPMCOUNTER21_ADDR:                  \
-	case MHPMCOUNTER22_ADDR:                  \
-	case MHPMCOUNTER23_ADDR:                  \
-	case MHPMCOUNTER24_ADDR:                  \
-	case MHPMCOUNTER25_ADDR:                  \
-	case MHPMCOUNTER26_ADDR:                  \
-	case MHPMCOUNTER27_ADDR:                  \
-	case MHPMCOUNTER28_ADDR:                  \
-	case MHPMCOUNTER29_ADDR:                  \
-	case MHPMCOUNTER30_ADDR:                  \
-	case MHPMCOUNTER31_ADDR:                  \
-	case MHPMCOUNTER3H_ADDR:                  \
-	case MHPMCOUNTER4H_ADDR:                  \
-	case MHPMCOUNTER5H_ADDR:                  \
-	case MHPMCOUNTER6H_ADDR:                  \
-	case MHPMCOUNTER7H_ADDR:                  \
-	case MHPMCOUNTER8H_ADDR:                  \
-	case MHPMCOUNTER9H_ADDR:                  \
-	case MHPMCOUNTER10H_ADDR:                 \
-	case MHPMCOUNTER11H_ADDR:                 \
-	case MHPMCOUNTER12H_ADDR:                 \
-	case MHPMCOUNTER13H_ADDR:                 \
-	case MHPMCOUNTER14H_ADDR:                 \
-	case MHPMCOUNTER15H_ADDR:                 \
-	case MHPMCOUNTER16H_ADDR:                 \
-	case MHPMCOUNTER17H_ADDR:                 \
-	case MHPMCOUNTER18H_ADDR:                 \
-	case MHPMCOUNTER19H_ADDR:                 \
-	case MHPMCOUNTER20H_ADDR:                 \
-	case MHPMCOUNTER21H_ADDR:                 \
-	case MHPMCOUNTER22H_ADDR:                 \
-	case MHPMCOUNTER23H_ADDR:                 \
-	case MHPMCOUNTER24H_ADDR:                 \
-	case MHPMCOUNTER25H_ADDR:                 \
-	case MHPMCOUNTER26H_ADDR:                 \
-	case MHPMCOUNTER27H_ADDR:                 \
-	case MHPMCOUNTER28H_ADDR:                 \
-	case MHPMCOUNTER29H_ADDR:                 \
-	case MHPMCOUNTER30H_ADDR:                 \
-	case MHPMCOUNTER31H_ADDR:                 \
-	case MHPMEVENT3_ADDR:                     \
-	case MHPMEVENT4_ADDR:                     \
-	case MHPMEVENT5_ADDR:                     \
-	case MHPMEVENT6_ADDR:                     \
-	case MHPMEVENT7_ADDR:                     \
-	case MHPMEVENT8_ADDR:                     \
-	case MHPMEVENT9_ADDR:                     \
-	case MHPMEVENT10_ADDR:                    \
-	case MHPMEVENT11_ADDR:                    \
-	case MHPMEVENT12_ADDR:                    \
-	case MHPMEVENT13_ADDR:                    \
-	case MHPMEVENT14_ADDR:                    \
-	case MHPMEVENT15_ADDR:                    \
-	case MHPMEVENT16_ADDR:                    \
-	case MHPMEVENT17_ADDR:                    \
-	case MHPMEVENT18_ADDR:                    \
-	case MHPMEVENT19_ADDR:                    \
-	case MHPMEVENT20_ADDR:                    \
-	case MHPMEVENT21_ADDR:                    \
-	case MHPMEVENT22_ADDR:                    \
-	case MHPMEVENT23_ADDR:                    \
-	case MHPMEVENT24_ADDR:                    \
-	case MHPMEVENT25_ADDR:                    \
-	case MHPMEVENT26_ADDR:                    \
-	case MHPMEVENT27_ADDR:                    \
-	case MHPMEVENT28_ADDR:                    \
-	case MHPMEVENT29_ADDR:                    \
-	case MHPMEVENT30_ADDR:                    \
-	case MHPMEVENT31_ADDR
-
 }  // namespace rv32
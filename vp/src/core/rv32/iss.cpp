@@ -9,8 +9,9 @@ using namespace rv32;
 
 #define RAISE_ILLEGAL_INSTRUCTION() raise_trap(EXC_ILLEGAL_INSTR, instr.data());
 
-#define REQUIRE_ISA(X)          \
-    if (!(csrs.misa.reg & X))   \
+// NOTE: only available in ISS::exec_step, which is specialised for the ISA extension set *Isa*
+#define REQUIRE_ISA(X)           \
+    if (!Isa::has(csrs.misa, X)) \
         RAISE_ILLEGAL_INSTRUCTION()
 
 #define RD instr.rd()
@@ -142,8 +143,9 @@ void ISS::benchmark_start(int pc, int syscall){
 	this->trace = true;
 }
 
+template <typename Isa>
 void ISS::exec_step() {
-	assert(((pc & ~pc_alignment_mask()) == 0) && "misaligned instruction");
+	assert(((pc & ~pc_alignment_mask<Isa>()) == 0) && "misaligned instruction");
 
 	try {
 		uint32_t mem_word = instr_mem->load_instr(pc);
@@ -168,6 +170,9 @@ void ISS::exec_step() {
 		this->benchmark_tick(4);
 	}
 
+	if (timing)
+		timing->update_timing(instr, op, *this);
+
 	if (trace) {
 		printf("core %2u: prv %1x: pc %8x: %s ", csrs.mhartid.reg, prv, last_pc, Opcode::mappingStr[op]);
 		switch (Opcode::getType(op)) {
@@ -294,14 +299,14 @@ void ISS::exec_step() {
 		case Opcode::JAL: {
 			auto link = pc;
 			pc = last_pc + instr.J_imm();
-			trap_check_pc_alignment();
+			trap_check_pc_alignment<Isa>();
 			regs[instr.rd()] = link;
 		} break;
 
 		case Opcode::JALR: {
 			auto link = pc;
 			pc = (regs[instr.rs1()] + instr.I_imm()) & ~1;
-			trap_check_pc_alignment();
+			trap_check_pc_alignment<Isa>();
 			regs[instr.rd()] = link;
 		} break;
 
@@ -353,42 +358,42 @@ void ISS::exec_step() {
 		case Opcode::BEQ:
 			if (regs[instr.rs1()] == regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BNE:
 			if (regs[instr.rs1()] != regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BLT:
 			if (regs[instr.rs1()] < regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BGE:
 			if (regs[instr.rs1()] >= regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BLTU:
 			if ((uint32_t)regs[instr.rs1()] < (uint32_t)regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BGEU:
 			if ((uint32_t)regs[instr.rs1()] >= (uint32_t)regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
@@ -676,7 +681,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(F_ISA_EXT);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_add(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_add(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
@@ -684,7 +689,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(F_ISA_EXT);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_sub(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_sub(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
@@ -692,7 +697,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(F_ISA_EXT);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_mul(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_mul(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
@@ -700,7 +705,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(F_ISA_EXT);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_div(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_div(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
@@ -708,7 +713,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(F_ISA_EXT);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_sqrt(fp_regs.f32(RS1)));
+			fp_regs.write(RD, fast_f32_sqrt(fp_regs.f32(RS1)));
 			fp_finish_instr();
 		} break;
 
@@ -901,7 +906,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(D_ISA_EXT);
             fp_prepare_instr();
             fp_setup_rm();
-            fp_regs.write(RD, f64_add(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+            fp_regs.write(RD, fast_f64_add(fp_regs.f64(RS1), fp_regs.f64(RS2)));
             fp_finish_instr();
         } break;
 
@@ -909,7 +914,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(D_ISA_EXT);
             fp_prepare_instr();
             fp_setup_rm();
-            fp_regs.write(RD, f64_sub(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+            fp_regs.write(RD, fast_f64_sub(fp_regs.f64(RS1), fp_regs.f64(RS2)));
             fp_finish_instr();
         } break;
 
@@ -917,7 +922,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(D_ISA_EXT);
             fp_prepare_instr();
             fp_setup_rm();
-            fp_regs.write(RD, f64_mul(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+            fp_regs.write(RD, fast_f64_mul(fp_regs.f64(RS1), fp_regs.f64(RS2)));
             fp_finish_instr();
         } break;
 
@@ -925,7 +930,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(D_ISA_EXT);
             fp_prepare_instr();
             fp_setup_rm();
-            fp_regs.write(RD, f64_div(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+            fp_regs.write(RD, fast_f64_div(fp_regs.f64(RS1), fp_regs.f64(RS2)));
             fp_finish_instr();
         } break;
 
@@ -933,7 +938,7 @@ void ISS::exec_step() {
             REQUIRE_ISA(D_ISA_EXT);
             fp_prepare_instr();
             fp_setup_rm();
-            fp_regs.write(RD, f64_sqrt(fp_regs.f64(RS1)));
+            fp_regs.write(RD, fast_f64_sqrt(fp_regs.f64(RS1)));
             fp_finish_instr();
         } break;
 
@@ -1211,11 +1216,11 @@ uint64_t ISS::_compute_and_get_current_cycles() {
 
 
 bool ISS::is_invalid_csr_access(uint32_t csr_addr, bool is_write) {
-    if (csr_addr == csr::FFLAGS_ADDR || csr_addr == csr::FRM_ADDR || csr_addr == csr::FCSR_ADDR) {
-        REQUIRE_ISA(F_ISA_EXT);
-    }
-    PrivilegeLevel csr_prv = (0x300 & csr_addr) >> 8;
-    bool csr_readonly = ((0xC00 & csr_addr) >> 10) == 3;
+    uint8_t flags = CSR_ACCESS_TABLE[csr_addr];
+    if ((flags & CsrAccessTable::FP) && !isa::Generic::has(csrs.misa, F_ISA_EXT))
+        RAISE_ILLEGAL_INSTRUCTION();
+    PrivilegeLevel csr_prv = flags & CsrAccessTable::PRV_MASK;
+    bool csr_readonly = flags & CsrAccessTable::READ_ONLY;
     bool s_invalid = (csr_prv == SupervisorMode) && !csrs.misa.has_supervisor_mode_extension();
     bool u_invalid = (csr_prv == UserMode) && !csrs.misa.has_user_mode_extension();
     return (is_write && csr_readonly) || (prv < csr_prv) || s_invalid || u_invalid;
@@ -1224,7 +1229,7 @@ bool ISS::is_invalid_csr_access(uint32_t csr_addr, bool is_write) {
 
 void ISS::validate_csr_counter_read_access_rights(uint32_t addr) {
 	// match against counter CSR addresses, see RISC-V privileged spec for the address definitions
-	if ((addr >= 0xC00 && addr <= 0xC1F) || (addr >= 0xC80 && addr <= 0xC9F)) {
+	if (CSR_ACCESS_TABLE[addr] & CsrAccessTable::COUNTER) {
 		auto cnt = addr & 0x1F;  // 32 counter in total, naturally aligned with the mcounteren and scounteren CSRs
 
 		if (s_mode() && !csr::is_bitset(csrs.mcounteren, cnt))
@@ -1238,220 +1243,91 @@ void ISS::validate_csr_counter_read_access_rights(uint32_t addr) {
 uint32_t ISS::get_csr_value(uint32_t addr) {
 	validate_csr_counter_read_access_rights(addr);
 
-	auto read = [=](auto &x, uint32_t mask) { return x.reg & mask; };
-
-	using namespace csr;
+	using Handler = csr_table::Handler;
 
-	switch (addr) {
-		case TIME_ADDR:
-		case MTIME_ADDR: {
-			uint64_t mtime = clint->update_and_get_mtime();
-			csrs.time.reg = mtime;
-			return csrs.time.low;
-		}
+	auto &e = csrs.entries[addr];
+	switch (e.handler) {
+		case Handler::Invalid:
+			RAISE_ILLEGAL_INSTRUCTION();
+			break;
 
-		case TIMEH_ADDR:
-		case MTIMEH_ADDR: {
-			uint64_t mtime = clint->update_and_get_mtime();
-			csrs.time.reg = mtime;
-			return csrs.time.high;
-		}
+		case Handler::Time:
+			csrs.time.reg = clint->update_and_get_mtime();
+			break;
 
-		case MCYCLE_ADDR:
+		case Handler::Cycle:
 			csrs.cycle.reg = _compute_and_get_current_cycles();
-			return csrs.cycle.low;
+			break;
 
-		case MCYCLEH_ADDR:
-			csrs.cycle.reg = _compute_and_get_current_cycles();
-			return csrs.cycle.high;
-
-		case MINSTRET_ADDR:
-			return csrs.instret.low;
-
-		case MINSTRETH_ADDR:
-			return csrs.instret.high;
-
-		SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32:  // not implemented
-			return 0;
-
-		case MSTATUS_ADDR:
-			return read(csrs.mstatus, MSTATUS_MASK);
-		case SSTATUS_ADDR:
-			return read(csrs.mstatus, SSTATUS_MASK);
-		case USTATUS_ADDR:
-			return read(csrs.mstatus, USTATUS_MASK);
-
-		case MIP_ADDR:
-			return read(csrs.mip, MIP_READ_MASK);
-		case SIP_ADDR:
-			return read(csrs.mip, SIP_MASK);
-		case UIP_ADDR:
-			return read(csrs.mip, UIP_MASK);
-
-		case MIE_ADDR:
-			return read(csrs.mie, MIE_MASK);
-		case SIE_ADDR:
-			return read(csrs.mie, SIE_MASK);
-		case UIE_ADDR:
-			return read(csrs.mie, UIE_MASK);
-
-		case SATP_ADDR:
+		case Handler::Satp:
 			if (csrs.mstatus.tvm)
 				RAISE_ILLEGAL_INSTRUCTION();
 			break;
 
-		case FCSR_ADDR:
-			return read(csrs.fcsr, FCSR_MASK);
-
-		case FFLAGS_ADDR:
+		case Handler::Fflags:
 			return csrs.fcsr.fflags;
 
-		case FRM_ADDR:
+		case Handler::Frm:
 			return csrs.fcsr.frm;
 
-        // debug CSRs not supported, thus hardwired
-        case TSELECT_ADDR:
-            return 1; // if a zero write by SW is preserved, then debug mode is supported (thus hardwire to non-zero)
-        case TDATA1_ADDR:
-        case TDATA2_ADDR:
-        case TDATA3_ADDR:
-        case DCSR_ADDR:
-        case DPC_ADDR:
-        case DSCRATCH0_ADDR:
-        case DSCRATCH1_ADDR:
-            return 0;
+		default:
+			break;
 	}
 
-	if (!csrs.is_valid_csr32_addr(addr))
-		RAISE_ILLEGAL_INSTRUCTION();
-
-	return csrs.default_read32(addr);
+	return *e.reg & e.read_mask;
 }
 
 void ISS::set_csr_value(uint32_t addr, uint32_t value) {
-	auto write = [=](auto &x, uint32_t mask) { x.reg = (x.reg & ~mask) | (value & mask); };
-
+	using Handler = csr_table::Handler;
 	using namespace csr;
 
-	switch (addr) {
-		case MISA_ADDR:                         // currently, read-only, thus cannot be changed at runtime
-		SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV32:  // not implemented
-			break;
-
-        case SATP_ADDR: {
-            if (csrs.mstatus.tvm)
-                RAISE_ILLEGAL_INSTRUCTION();
-            write(csrs.satp, SATP_MASK);
-            // std::cout << "[iss] satp=" << boost::format("%x") % csrs.satp.reg << std::endl;
-        } break;
-
-		case MTVEC_ADDR:
-			write(csrs.mtvec, MTVEC_MASK);
-			break;
-		case STVEC_ADDR:
-			write(csrs.stvec, MTVEC_MASK);
-			break;
-		case UTVEC_ADDR:
-			write(csrs.utvec, MTVEC_MASK);
-			break;
-
-		case MEPC_ADDR:
-			write(csrs.mepc, pc_alignment_mask());
-			break;
-		case SEPC_ADDR:
-			write(csrs.sepc, pc_alignment_mask());
-			break;
-		case UEPC_ADDR:
-			write(csrs.uepc, pc_alignment_mask());
-			break;
-
-		case MSTATUS_ADDR:
-			write(csrs.mstatus, MSTATUS_MASK);
-			break;
-		case SSTATUS_ADDR:
-			write(csrs.mstatus, SSTATUS_MASK);
-			break;
-		case USTATUS_ADDR:
-			write(csrs.mstatus, USTATUS_MASK);
-			break;
-
-		case MIP_ADDR:
-			write(csrs.mip, MIP_WRITE_MASK);
-			break;
-		case SIP_ADDR:
-			write(csrs.mip, SIP_MASK);
-			break;
-		case UIP_ADDR:
-			write(csrs.mip, UIP_MASK);
-			break;
-
-		case MIE_ADDR:
-			write(csrs.mie, MIE_MASK);
-			break;
-		case SIE_ADDR:
-			write(csrs.mie, SIE_MASK);
-			break;
-		case UIE_ADDR:
-			write(csrs.mie, UIE_MASK);
-			break;
-
-		case MIDELEG_ADDR:
-			write(csrs.mideleg, MIDELEG_MASK);
-			break;
-
-		case MEDELEG_ADDR:
-			write(csrs.medeleg, MEDELEG_MASK);
-			break;
-
-		case SIDELEG_ADDR:
-			write(csrs.sideleg, SIDELEG_MASK);
-			break;
-
-		case SEDELEG_ADDR:
-			write(csrs.sedeleg, SEDELEG_MASK);
+	auto &e = csrs.entries[addr];
+	uint32_t mask = e.write_mask;
+	switch (e.handler) {
+		case Handler::Invalid:
+			RAISE_ILLEGAL_INSTRUCTION();
 			break;
 
-		case MCOUNTEREN_ADDR:
-			write(csrs.mcounteren, MCOUNTEREN_MASK);
+		case Handler::Satp:
+			if (csrs.mstatus.tvm)
+				RAISE_ILLEGAL_INSTRUCTION();
 			break;
 
-		case SCOUNTEREN_ADDR:
-			write(csrs.scounteren, MCOUNTEREN_MASK);
+		case Handler::Epc:
+			mask = pc_alignment_mask();
 			break;
 
-		case MCOUNTINHIBIT_ADDR:
-			write(csrs.mcountinhibit, MCOUNTINHIBIT_MASK);
-			break;
+		case Handler::Pmpcfg: {
+			unsigned n = addr - PMPCFG0_ADDR;
+			uint32_t reg = 0;
+			for (unsigned i = 0; i < 4; ++i) {
+				pmp.set_cfg(n * 4 + i, value >> (i * 8));
+				reg |= (uint32_t)pmp.get_cfg(n * 4 + i) << (i * 8);
+			}
+			csrs.pmpcfg[n].reg = reg;
+			return;
+		}
 
-		case FCSR_ADDR:
-			write(csrs.fcsr, FCSR_MASK);
-			break;
+		case Handler::Pmpaddr: {
+			unsigned n = addr - PMPADDR0_ADDR;
+			pmp.set_addr(n, value);
+			csrs.pmpaddr[n].reg = pmp.get_addr(n);
+			return;
+		}
 
-		case FFLAGS_ADDR:
+		case Handler::Fflags:
 			csrs.fcsr.fflags = value;
-			break;
+			return;
 
-		case FRM_ADDR:
+		case Handler::Frm:
 			csrs.fcsr.frm = value;
-			break;
-
-        // debug CSRs not supported, thus hardwired
-        case TSELECT_ADDR:
-        case TDATA1_ADDR:
-        case TDATA2_ADDR:
-        case TDATA3_ADDR:
-        case DCSR_ADDR:
-        case DPC_ADDR:
-        case DSCRATCH0_ADDR:
-        case DSCRATCH1_ADDR:
-            break;
+			return;
 
 		default:
-			if (!csrs.is_valid_csr32_addr(addr))
-				RAISE_ILLEGAL_INSTRUCTION();
-
-			csrs.default_write32(addr, value);
+			break;
 	}
+
+	*e.reg = (*e.reg & ~mask) | (value & mask);
 }
 
 void ISS::init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint32_t entrypoint,
@@ -1463,6 +1339,27 @@ void ISS::init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *c
 	pc = entrypoint;
 }
 
+void ISS::set_isa(const std::string &isa) {
+	csrs.misa.select_isa_string(isa);
+	select_isa_variant();
+}
+
+void ISS::select_isa_variant() {
+	switch (csrs.misa.extensions) {
+		case isa::RV32IMAC::extensions:
+			isa_variant = IsaVariant::RV32IMAC;
+			break;
+		case isa::RV32IMAFC::extensions:
+			isa_variant = IsaVariant::RV32IMAFC;
+			break;
+		case isa::RV32GC::extensions:
+			isa_variant = IsaVariant::RV32GC;
+			break;
+		default:
+			isa_variant = IsaVariant::Generic;
+	}
+}
+
 void ISS::sys_exit() {
 	shall_exit = true;
 }
@@ -1503,12 +1400,44 @@ void ISS::enable_debug(void) {
     debug_mode = true;
 }
 
-void ISS::insert_breakpoint(uint64_t addr) {
-    breakpoints.insert(addr);
+void ISS::insert_breakpoint(uint64_t addr, const std::vector<AgentExpr> &conds) {
+	breakpoints.insert(addr, conds);
 }
 
 void ISS::remove_breakpoint(uint64_t addr) {
-    breakpoints.erase(addr);
+	breakpoints.erase(addr);
+}
+
+void ISS::insert_watchpoint(uint64_t addr, uint64_t len, WatchpointType type) {
+	watchpoints.insert(addr, len, type);
+}
+
+void ISS::remove_watchpoint(uint64_t addr, uint64_t len, WatchpointType type) {
+	watchpoints.remove(addr, len, type);
+}
+
+const WatchpointHit *ISS::get_watchpoint_hit(void) {
+	return watchpoints.get_hit();
+}
+
+uint64_t ISS::ax_register(unsigned regno) {
+	if (regno < RegFile::NUM_REGS)
+		return (uint32_t)regs.read(regno);
+	if (regno == RegFile::NUM_REGS)
+		return pc;
+	throw std::runtime_error("register " + std::to_string(regno) + " not available in agent expressions");
+}
+
+uint64_t ISS::ax_memory(uint64_t addr, unsigned num_bytes) {
+	// accesses of the debugger, not of the program: no timing, no PMP and watchpoint checks and no side effects of the
+	// address translation or of peripherals
+	uint64_t value = 0;
+	try {
+		if (mem->debug_load(addr, (uint8_t *)&value, num_bytes) == num_bytes)
+			return value;
+	} catch (SimulationTrap &) {
+	}
+	throw std::runtime_error("agent expression accesses invalid memory");
 }
 
 uint64_t ISS::get_hart_id() {
@@ -1831,12 +1760,15 @@ void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
             release_lr_sc_reservation();
 	}
 
-	auto new_cycles = instr_cycles[executed_op];
+	if (!timing) {
+		auto new_cycles = instr_cycles[executed_op];
+
+		if (!csrs.mcountinhibit.CY)
+			cycle_counter += new_cycles;
 
-	if (!csrs.mcountinhibit.CY)
-		cycle_counter += new_cycles;
+		quantum_keeper.inc(new_cycles);
+	}
 
-	quantum_keeper.inc(new_cycles);
 	if (quantum_keeper.need_sync()) {
 	    if (lr_sc_counter == 0) // match SystemC sync with bus unlocking in a tight LR_W/SC_W loop
 		    quantum_keeper.sync();
@@ -1844,18 +1776,40 @@ void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
 }
 
 void ISS::run_step() {
+	watchpoints.clear_hit();
+	select_isa_variant();
+
+	switch (isa_variant) {
+		case IsaVariant::RV32IMAC:
+			do_run_step<isa::RV32IMAC, true>();
+			break;
+		case IsaVariant::RV32IMAFC:
+			do_run_step<isa::RV32IMAFC, true>();
+			break;
+		case IsaVariant::RV32GC:
+			do_run_step<isa::RV32GC, true>();
+			break;
+		default:
+			do_run_step<isa::Generic, true>();
+	}
+}
+
+template <typename Isa, bool Debug>
+void ISS::do_run_step() {
 	assert(regs.read(0) == 0);
 
-	// speeds up the execution performance (non debug mode) significantly by
-	// checking the additional flag first
-	if (debug_mode && (breakpoints.find(pc) != breakpoints.end())) {
-		status = CoreExecStatus::HitBreakpoint;
-		return;
+	// resolved at compile time, the loop without breakpoints does not check the pc at all
+	if (Debug) {
+		auto conds = breakpoints.find(pc);
+		if (unlikely(conds != nullptr) && AgentExpr::any_holds(*conds, *this)) {
+			status = CoreExecStatus::HitBreakpoint;
+			return;
+		}
 	}
 
 	last_pc = pc;
 	try {
-		exec_step();
+		exec_step<Isa>();
 
 		auto x = compute_pending_interrupts();
 		if (x.target_mode != NoneMode) {
@@ -1874,26 +1828,63 @@ void ISS::run_step() {
 	// before every register write)
 	regs.regs[regs.zero] = 0;
 
+	// watchpoints stop after the access
+	if (unlikely(watchpoints.triggered()))
+		status = CoreExecStatus::HitBreakpoint;
+
 	// Do not use a check *pc == last_pc* here. The reason is that due to
 	// interrupts *pc* can be set to *last_pc* accidentally (when jumping back
 	// to *mepc*).
-	if (shall_exit)
+	if (shall_exit) {
 		status = CoreExecStatus::Terminated;
+		if (timing)
+			timing->flush();
+	}
 
 	performance_and_sync_update(op);
 }
 
 void ISS::run() {
-	// run a single step until either a breakpoint is hit or the execution
-	// terminates
+	watchpoints.clear_hit();
+	select_isa_variant();
+
+	// dispatch once to the execution loop specialised for the selected ISA,
+	// dispatch again in case the selection changes
 	do {
-		run_step();
+		switch (isa_variant) {
+			case IsaVariant::RV32IMAC:
+				do_run<isa::RV32IMAC>();
+				break;
+			case IsaVariant::RV32IMAFC:
+				do_run<isa::RV32IMAFC>();
+				break;
+			case IsaVariant::RV32GC:
+				do_run<isa::RV32GC>();
+				break;
+			default:
+				do_run<isa::Generic>();
+		}
 	} while (status == CoreExecStatus::Runnable);
 
 	// force sync to make sure that no action is missed
 	quantum_keeper.sync();
 }
 
+template <typename Isa>
+void ISS::do_run() {
+	// run a single step until either a breakpoint is hit or the execution
+	// terminates, breakpoints only change while the hart is stopped
+	if (debug_mode && !breakpoints.empty()) {
+		do {
+			do_run_step<Isa, true>();
+		} while (status == CoreExecStatus::Runnable && isa_variant == Isa::variant);
+	} else {
+		do {
+			do_run_step<Isa, false>();
+		} while (status == CoreExecStatus::Runnable && isa_variant == Isa::variant);
+	}
+}
+
 void ISS::show() {
 	boost::io::ios_flags_saver ifs(std::cout);
 	std::cout << "=[ core : " << csrs.mhartid.reg << " ]===========================" << std::endl;
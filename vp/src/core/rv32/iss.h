@@ -1,13 +1,17 @@
 #pragma once
 
+#include "core/common/breakpoints.h"
 #include "core/common/bus_lock_if.h"
 #include "core/common/clint_if.h"
 #include "core/common/instr.h"
 #include "core/common/irq_if.h"
+#include "core/common/pmp.h"
 #include "core/common/trap.h"
 #include "core/common/debug.h"
+#include "core/common/watchpoints.h"
 #include "csr.h"
 #include "fp.h"
+#include "fp_host.h"
 #include "mem_if.h"
 #include "syscall_if.h"
 #include "util/common.h"
@@ -21,7 +25,6 @@
 #include <map>
 #include <memory>
 #include <stdexcept>
-#include <unordered_set>
 #include <vector>
 
 #include <tlm_utils/simple_initiator_socket.h>
@@ -119,14 +122,17 @@ struct RegFile {
 	};
 };
 
-// NOTE: on this branch, currently the *simple-timing* model is still directly
-// integrated in the ISS. Merge the *timedb* branch to use the timing_if.
+// NOTE: the *simple-timing* model (instr_cycles) is directly integrated in the ISS and used unless a timing_if is
+// attached. A timing_if is called after decoding, before the instruction is executed, and is responsible to annotate
+// the cycles itself (see timing/timing_external.h).
 struct ISS;
 
 struct timing_if {
 	virtual ~timing_if() {}
 
 	virtual void update_timing(Instruction instr, Opcode::Mapping op, ISS &iss) = 0;
+	// called when the core terminates, to annotate timing that is still pending
+	virtual void flush() {}
 };
 
 /* Buffer to be used between the ISS and instruction memory interface to cache compressed instructions.
@@ -154,11 +160,43 @@ struct PendingInterrupts {
 
 struct benchmark { int num_of_instructions; int sys_call; };
 
-struct ISS : public external_interrupt_target, public clint_interrupt_target, public iss_syscall_if, public debug_target_if {
+/* Extension sets the ISS execution loop is specialised for at compile time. With a fixed set, all REQUIRE_ISA and
+ * compressed instruction checks are constant and the code paths of missing extensions compile away. The generic
+ * variant reads misa on every check and is used for all other configurations. */
+enum class IsaVariant { Generic, RV32IMAC, RV32IMAFC, RV32GC };
+
+namespace isa {
+struct Generic {
+	static constexpr IsaVariant variant = IsaVariant::Generic;
+
+	static inline bool has(const csr_misa &misa, uint32_t ext) {
+		return misa.extensions & ext;
+	}
+};
+
+template <IsaVariant V, uint32_t Extensions>
+struct Fixed {
+	static constexpr IsaVariant variant = V;
+	static constexpr uint32_t extensions = Extensions | csr_misa::N | csr_misa::U | csr_misa::S;
+
+	static constexpr bool has(const csr_misa &, uint32_t ext) {
+		return extensions & ext;
+	}
+};
+
+using RV32IMAC = Fixed<IsaVariant::RV32IMAC, csr_misa::I | csr_misa::M | csr_misa::A | csr_misa::C>;
+using RV32IMAFC = Fixed<IsaVariant::RV32IMAFC, csr_misa::I | csr_misa::M | csr_misa::A | csr_misa::F | csr_misa::C>;
+using RV32GC =
+    Fixed<IsaVariant::RV32GC, csr_misa::I | csr_misa::M | csr_misa::A | csr_misa::F | csr_misa::D | csr_misa::C>;
+}  // namespace isa
+
+struct ISS : public external_interrupt_target, public clint_interrupt_target, public iss_syscall_if, public debug_target_if,
+             public agent_expr_env {
 	clint_if *clint = nullptr;
 	instr_memory_if *instr_mem = nullptr;
 	data_memory_if *mem = nullptr;
 	syscall_emulator_if *sys = nullptr;  // optional, if provided, the iss will intercept and handle syscalls directly
+	timing_if *timing = nullptr;         // optional, replaces the built-in instr_cycles timing model
 	RegFile regs;
 	FpRegs fp_regs;
 	uint32_t pc = 0;
@@ -167,6 +205,7 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	bool shall_exit = false;
     bool ignore_wfi = false;
 	csr_table csrs;
+	PMP pmp{32};
 	PrivilegeLevel prv = MachineMode;
 	int64_t lr_sc_counter = 0;
 	uint64_t total_num_instr = 0;
@@ -177,8 +216,10 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	Instruction instr;
 	Opcode::Mapping op;
 
+	IsaVariant isa_variant = IsaVariant::Generic;
 	CoreExecStatus status = CoreExecStatus::Runnable;
-	std::unordered_set<uint32_t> breakpoints;
+	Breakpoints breakpoints;
+	Watchpoints watchpoints;
 	bool debug_mode = false;
 
 	sc_core::sc_event wfi_event;
@@ -194,12 +235,20 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	ISS(uint32_t hart_id, bool use_E_base_isa = false);
 
+	template <typename Isa>
 	void exec_step();
 
 	uint64_t _compute_and_get_current_cycles();
 
 	void init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint32_t entrypoint, uint32_t sp);
 
+	/* Select the extensions from an ISA string like "rv32imac", see csr_misa::select_isa_string. */
+	void set_isa(const std::string &isa);
+
+	/* Select the specialised execution loop matching misa. Done on entry of run/run_step, call it again whenever misa
+	 * changes during execution. */
+	void select_isa_variant();
+
 	void trigger_external_interrupt(PrivilegeLevel level) override;
 
 	void clear_external_interrupt(PrivilegeLevel level) override;
@@ -226,9 +275,16 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
     void set_status(CoreExecStatus) override;
     void block_on_wfi(bool) override;
 
-    void insert_breakpoint(uint64_t) override;
+    void insert_breakpoint(uint64_t, const std::vector<AgentExpr> &) override;
     void remove_breakpoint(uint64_t) override;
 
+    void insert_watchpoint(uint64_t, uint64_t, WatchpointType) override;
+    void remove_watchpoint(uint64_t, uint64_t, WatchpointType) override;
+    const WatchpointHit *get_watchpoint_hit(void) override;
+
+    uint64_t ax_register(unsigned) override;
+    uint64_t ax_memory(uint64_t, unsigned) override;
+
 	uint64_t get_hart_id() override;
 
 
@@ -250,17 +306,19 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	bool is_invalid_csr_access(uint32_t csr_addr, bool is_write);
 	void validate_csr_counter_read_access_rights(uint32_t addr);
 
+	template <typename Isa = isa::Generic>
 	unsigned pc_alignment_mask() {
-		if (csrs.misa.has_C_extension())
+		if (Isa::has(csrs.misa, C_ISA_EXT))
 			return ~0x1;
 		else
 			return ~0x3;
 	}
 
+	template <typename Isa>
 	inline void trap_check_pc_alignment() {
 		assert(!(pc & 0x1) && "not possible due to immediate formats and jump execution");
 
-		if (unlikely((pc & 0x3) && (!csrs.misa.has_C_extension()))) {
+		if (unlikely((pc & 0x3) && (!Isa::has(csrs.misa, C_ISA_EXT)))) {
 			// NOTE: misaligned instruction address not possible on machines supporting compressed instructions
 			raise_trap(EXC_INSTR_ADDR_MISALIGNED, pc);
 		}
@@ -325,6 +383,13 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void run() override;
 
+	/* *Debug* checks for breakpoints before the instruction */
+	template <typename Isa, bool Debug>
+	void do_run_step();
+
+	template <typename Isa>
+	void do_run();
+
 	void show();
 
 	private:
@@ -10,15 +10,21 @@ namespace rv32 {
 struct InstrMemoryProxy : public instr_memory_if {
 	MemoryDMI dmi;
 
+	ISS &core;
 	tlm_utils::tlm_quantumkeeper &quantum_keeper;
 	sc_core::sc_time clock_cycle = sc_core::sc_time(10, sc_core::SC_NS);
 	sc_core::sc_time access_delay = clock_cycle * 2;
 
-	InstrMemoryProxy(const MemoryDMI &dmi, ISS &owner) : dmi(dmi), quantum_keeper(owner.quantum_keeper) {}
+	InstrMemoryProxy(const MemoryDMI &dmi, ISS &owner) : dmi(dmi), core(owner), quantum_keeper(owner.quantum_keeper) {}
 
 	virtual uint32_t load_instr(uint64_t pc) override {
 		quantum_keeper.inc(access_delay);
-		return dmi.load<uint32_t>(pc);
+		core.pmp.check(pc, 2, FETCH, core.prv, pc);
+		uint32_t instr = dmi.load<uint32_t>(pc);
+		// the second half of an uncompressed instruction
+		if ((instr & 3) == 3)
+			core.pmp.check(pc + 2, 2, FETCH, core.prv, pc + 2);
+		return instr;
 	}
 };
 
@@ -86,6 +92,8 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 		for (auto &e : dmi_ranges) {
 			if (e.contains(addr)) {
 				quantum_keeper.inc(dmi_access_delay);
+				if (unlikely(e.has_latency()))
+					quantum_keeper.inc(e.get_read_latency(sizeof(T)));
 				return e.load<T>(addr);
 			}
 		}
@@ -103,6 +111,10 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 		for (auto &e : dmi_ranges) {
 			if (e.contains(addr)) {
 				quantum_keeper.inc(dmi_access_delay);
+				if (unlikely(e.has_latency()))
+					quantum_keeper.inc(e.get_write_latency(sizeof(T)));
+				if (unlikely(e.tracks_writes()))
+					e.mark_dirty(addr, sizeof(T));
 				e.store(addr, value);
 				done = true;
 			}
@@ -114,14 +126,46 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 	}
 
 
+    /* privilege level for data accesses, considering mstatus.MPRV */
+    inline PrivilegeLevel data_access_privilege() {
+        return iss.csrs.mstatus.mprv ? PrivilegeLevel(iss.csrs.mstatus.mpp) : iss.prv;
+    }
+
     template <typename T>
     inline T _load_data(uint64_t addr) {
-        return _raw_load_data<T>(v2p(addr, LOAD));
+        uint64_t paddr = v2p(addr, LOAD);
+        iss.pmp.check(paddr, sizeof(T), LOAD, data_access_privilege(), addr);
+        T ans = _raw_load_data<T>(paddr);
+        iss.watchpoints.check(addr, sizeof(T), LOAD);
+        return ans;
     }
 
     template <typename T>
     inline void _store_data(uint64_t addr, T value) {
-        _raw_store_data(v2p(addr, STORE), value);
+        uint64_t paddr = v2p(addr, STORE);
+        iss.pmp.check(paddr, sizeof(T), STORE, data_access_privilege(), addr);
+        _raw_store_data(paddr, value);
+        iss.watchpoints.check(addr, sizeof(T), STORE);
+    }
+
+    /* Translation and PMP check of an atomic access, done before the bus is locked (a fault would keep it locked).
+     * AMOs need read and write permission and raise store/AMO faults, LR is a load. */
+    template <typename T>
+    inline uint64_t _atomic_access_paddr(uint64_t addr, MemoryAccessType type) {
+        uint64_t paddr = v2p(addr, type);
+        if (type == STORE && !iss.pmp.is_allowed(paddr, sizeof(T), LOAD, data_access_privilege()))
+            PMP::raise_access_fault(STORE, addr);
+        iss.pmp.check(paddr, sizeof(T), type, data_access_privilege(), addr);
+        return paddr;
+    }
+
+    template <typename T>
+    inline T _locked_load_data(uint64_t addr, MemoryAccessType type) {
+        uint64_t paddr = _atomic_access_paddr<T>(addr, type);
+        bus_lock->lock(iss.get_hart_id());
+        T ans = _raw_load_data<T>(paddr);
+        iss.watchpoints.check(addr, sizeof(T), LOAD);
+        return ans;
     }
 
     uint64_t mmu_load_pte64(uint64_t addr) override {
@@ -134,12 +178,42 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
         _raw_store_data(addr, value);
     }
 
+    unsigned mmu_debug_load(uint64_t addr, uint8_t *data, unsigned num_bytes) override {
+        for (auto &e : dmi_ranges) {
+            if (e.contains(addr) && num_bytes <= e.get_end() - addr) {
+                memcpy(data, e.get_mem_ptr_to_global_addr<uint8_t>(addr), num_bytes);
+                return num_bytes;
+            }
+        }
+
+        tlm::tlm_generic_payload trans;
+        trans.set_command(tlm::TLM_READ_COMMAND);
+        trans.set_address(addr);
+        trans.set_data_ptr(data);
+        trans.set_data_length(num_bytes);
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+
+        unsigned nbytes = isock->transport_dbg(trans);
+        return trans.is_response_error() ? 0 : nbytes;
+    }
+
+    unsigned debug_load(uint64_t addr, uint8_t *data, unsigned num_bytes) override {
+        uint64_t paddr = mmu ? mmu->translate_debug(addr, LOAD) : addr;
+        return mmu_debug_load(paddr, data, num_bytes);
+    }
+
     void flush_tlb() override {
         mmu->flush_tlb();
     }
 
     uint32_t load_instr(uint64_t addr) override {
-        return _raw_load_data<uint32_t>(v2p(addr, FETCH));
+        uint64_t paddr = v2p(addr, FETCH);
+        iss.pmp.check(paddr, 2, FETCH, iss.prv, addr);
+        uint32_t instr = _raw_load_data<uint32_t>(paddr);
+        // the second half of an uncompressed instruction
+        if ((instr & 3) == 3)
+            iss.pmp.check(paddr + 2, 2, FETCH, iss.prv, addr + 2);
+        return instr;
     }
 
     int64_t load_double(uint64_t addr) override {
@@ -175,17 +249,16 @@ struct CombinedMemoryInterface : public sc_core::sc_module,
 	}
 
 	virtual int32_t atomic_load_word(uint64_t addr) override {
-		bus_lock->lock(iss.get_hart_id());
-		return load_word(addr);
+		return _locked_load_data<int32_t>(addr, STORE);
 	}
 	virtual void atomic_store_word(uint64_t addr, uint32_t value) override {
 		assert(bus_lock->is_locked(iss.get_hart_id()));
 		store_word(addr, value);
 	}
 	virtual int32_t atomic_load_reserved_word(uint64_t addr) override {
-		bus_lock->lock(iss.get_hart_id());
+		int32_t ans = _locked_load_data<int32_t>(addr, LOAD);
 		lr_addr = addr;
-		return load_word(addr);
+		return ans;
 	}
 	virtual bool atomic_store_conditional_word(uint64_t addr, uint32_t value) override {
 		/* According to the RISC-V ISA, an implementation can fail each LR/SC sequence that does not satisfy the forward
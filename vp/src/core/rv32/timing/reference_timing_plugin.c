@@ -0,0 +1,74 @@
+/* Reference implementation of the external timing plugin interface (see timing_plugin.h). It mirrors the
+ * SimpleTimingDecorator: one cycle per instruction, four for memory accesses and eight for multiplications and
+ * divisions. Use it as a starting point for external microarchitecture models. */
+
+#include "timing_plugin.h"
+
+#include <stdlib.h>
+
+#define OPCODE_LOAD 0x03
+#define OPCODE_LOAD_FP 0x07
+#define OPCODE_STORE 0x23
+#define OPCODE_STORE_FP 0x27
+#define OPCODE_AMO 0x2f
+#define OPCODE_OP 0x33
+#define OPCODE_OP_32 0x3b
+#define FUNCT7_MULDIV 0x01
+
+struct reference_timing {
+	uint64_t memory_access_cycles;
+	uint64_t mul_div_cycles;
+};
+
+static uint64_t instr_cycles(const struct reference_timing *t, uint32_t instr) {
+	switch (instr & 0x7f) {
+		case OPCODE_LOAD:
+		case OPCODE_LOAD_FP:
+		case OPCODE_STORE:
+		case OPCODE_STORE_FP:
+		case OPCODE_AMO:
+			return t->memory_access_cycles;
+		case OPCODE_OP:
+		case OPCODE_OP_32:
+			if ((instr >> 25) == FUNCT7_MULDIV)
+				return t->mul_div_cycles;
+			return 1;
+		default:
+			return 1;
+	}
+}
+
+static void *reference_create(const char *config) {
+	(void)config;  // no timing database required
+
+	struct reference_timing *t = malloc(sizeof(*t));
+	if (!t)
+		return NULL;
+	t->memory_access_cycles = 4;
+	t->mul_div_cycles = 8;
+	return t;
+}
+
+static void reference_destroy(void *ctx) {
+	free(ctx);
+}
+
+static uint64_t reference_get_cycles_for_block(void *ctx, const riscv_vp_timing_block *block) {
+	const struct reference_timing *t = ctx;
+	uint64_t cycles = 0;
+	for (uint32_t i = 0; i < block->num_instrs; ++i) cycles += instr_cycles(t, block->instrs[i]);
+	return cycles;
+}
+
+static const riscv_vp_timing_plugin reference_plugin = {
+    RISCV_VP_TIMING_MAGIC,
+    RISCV_VP_TIMING_ABI_VERSION,
+    sizeof(riscv_vp_timing_plugin),
+    reference_create,
+    reference_destroy,
+    reference_get_cycles_for_block,
+};
+
+const riscv_vp_timing_plugin *riscv_vp_timing_plugin_v1(void) {
+	return &reference_plugin;
+}
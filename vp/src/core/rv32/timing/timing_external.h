@@ -1,63 +1,158 @@
 #pragma once
 
 #include "../iss.h"
+#include "timing_plugin.h"
 
 #include <dlfcn.h>
-#include <boost/io/ios_state.hpp>
-#include <iomanip>
 
-std::string RISCV_TIMING_SIM_LIB = "riscv-timing-sim.so";
-std::string RISCV_TIMING_DB = "riscv-timing-db.xml";
+#include <array>
+#include <stdexcept>
+#include <string>
 
-// NOTE: the interface inside the library has to match this one exactly, don't
-// forget the *virtual* attribute
-struct SimTimingInterface {
-	virtual uint64_t get_cycles_for_instruction(uint64_t pc);
+namespace rv32 {
 
-	// only to detect errors in loading the shared library
-	virtual uint64_t get_magic_number();
-};
+std::string RISCV_TIMING_SIM_LIB = "riscv-timing-sim.so";
+std::string RISCV_TIMING_DB = "riscv-timing-db.xml";
 
+/* Collects the executed instructions into basic blocks and hands each block to the external timing simulator (see
+ * timing_plugin.h) with a single call. The resulting cycles are annotated to the quantum keeper of the core. */
 struct ExternalTimingDecorator : public timing_if {
-	SimTimingInterface *timing_sim = 0;
-	void *lib_handle = 0;
-	SimTimingInterface *(*create)(const char *) = 0;
-	void (*destroy)(SimTimingInterface *) = 0;
-
-	void initialize() {
-		lib_handle = dlopen(RISCV_TIMING_SIM_LIB.c_str(), RTLD_LAZY);
-		if (!lib_handle)
-			throw std::runtime_error("unable to open shared library '" + RISCV_TIMING_SIM_LIB + "'");
+	static constexpr unsigned MAX_BLOCK_SIZE = 64;
 
-		create = (SimTimingInterface * (*)(const char *)) dlsym(lib_handle, "create_riscv_vp_timing_interface");
-		if (!create)
-			throw std::runtime_error("unable to load 'create_riscv_vp_timing_interface' function");
+	void *lib_handle = nullptr;
+	const riscv_vp_timing_plugin *plugin = nullptr;
+	void *timing_sim = nullptr;
 
-		destroy = (void (*)(SimTimingInterface *))dlsym(lib_handle, "destroy_riscv_vp_timing_interface");
-		if (!destroy)
-			throw std::runtime_error("unable to load 'destroy_riscv_vp_timing_interface' function");
+	std::array<uint64_t, MAX_BLOCK_SIZE> pcs;
+	std::array<uint32_t, MAX_BLOCK_SIZE> instrs;
+	std::array<uint64_t, MAX_BLOCK_SIZE> mem_addrs;
+	unsigned num_instrs = 0;
+	uint64_t next_pc = 0;
+	ISS *block_owner = nullptr;
 
-		timing_sim = (SimTimingInterface *)create(RISCV_TIMING_DB.c_str());
+	void initialize(const std::string &lib, const std::string &config) {
+		lib_handle = dlopen(lib.c_str(), RTLD_NOW);
+		if (!lib_handle)
+			throw std::runtime_error("unable to open shared library '" + lib + "': " + dlerror());
+
+		auto entry = (riscv_vp_timing_plugin_entry_t)dlsym(lib_handle, RISCV_VP_TIMING_PLUGIN_SYMBOL);
+		if (!entry)
+			throw std::runtime_error(std::string("unable to load '") + RISCV_VP_TIMING_PLUGIN_SYMBOL + "' function");
+
+		plugin = entry();
+		if (!plugin || plugin->magic != RISCV_VP_TIMING_MAGIC)
+			throw std::runtime_error("shared library '" + lib + "' is not a riscv-vp timing plugin");
+		if (plugin->abi_version != RISCV_VP_TIMING_ABI_VERSION || plugin->size < sizeof(riscv_vp_timing_plugin))
+			throw std::runtime_error("timing plugin '" + lib + "' uses ABI version " +
+			                         std::to_string(plugin->abi_version) + ", expected " +
+			                         std::to_string(RISCV_VP_TIMING_ABI_VERSION));
+		if (!plugin->create || !plugin->destroy || !plugin->get_cycles_for_block)
+			throw std::runtime_error("timing plugin '" + lib + "' is incomplete");
+
+		timing_sim = plugin->create(config.c_str());
+		if (!timing_sim)
+			throw std::runtime_error("timing plugin '" + lib + "' failed to load '" + config + "'");
 	}
 
-	ExternalTimingDecorator() {
-		initialize();
+	ExternalTimingDecorator(const std::string &lib = RISCV_TIMING_SIM_LIB, const std::string &config = RISCV_TIMING_DB) {
+		initialize(lib, config);
 	}
 
 	~ExternalTimingDecorator() {
-		assert(timing_sim != 0);
-		destroy(timing_sim);
-		assert(lib_handle != 0);
+		// the core did not terminate, e.g. the simulation was stopped by sc_stop
+		flush();
+		assert(timing_sim != nullptr);
+		plugin->destroy(timing_sim);
+		assert(lib_handle != nullptr);
 		dlclose(lib_handle);
 	}
 
-	void on_begin_exec_step(Instruction instr, Opcode::mapping op, ISS &iss) override {
-		uint64_t cycles = timing_sim->get_cycles_for_instruction(iss.last_pc);
+	static bool ends_basic_block(Opcode::Mapping op) {
+		switch (op) {
+			case Opcode::JAL:
+			case Opcode::JALR:
+			case Opcode::BEQ:
+			case Opcode::BNE:
+			case Opcode::BLT:
+			case Opcode::BGE:
+			case Opcode::BLTU:
+			case Opcode::BGEU:
+			case Opcode::ECALL:
+			case Opcode::EBREAK:
+			case Opcode::FENCE_I:
+			case Opcode::URET:
+			case Opcode::SRET:
+			case Opcode::MRET:
+			case Opcode::WFI:
+			case Opcode::SFENCE_VMA:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	static uint64_t effective_address(Instruction instr, Opcode::Mapping op, ISS &iss) {
+		switch (op) {
+			case Opcode::LB:
+			case Opcode::LH:
+			case Opcode::LW:
+			case Opcode::LBU:
+			case Opcode::LHU:
+			case Opcode::FLW:
+			case Opcode::FLD:
+				return (uint32_t)(iss.regs[instr.rs1()] + instr.I_imm());
+			case Opcode::SB:
+			case Opcode::SH:
+			case Opcode::SW:
+			case Opcode::FSW:
+			case Opcode::FSD:
+				return (uint32_t)(iss.regs[instr.rs1()] + instr.S_imm());
+			case Opcode::LR_W:
+			case Opcode::SC_W:
+			case Opcode::AMOSWAP_W:
+			case Opcode::AMOADD_W:
+			case Opcode::AMOXOR_W:
+			case Opcode::AMOAND_W:
+			case Opcode::AMOOR_W:
+			case Opcode::AMOMIN_W:
+			case Opcode::AMOMAX_W:
+			case Opcode::AMOMINU_W:
+			case Opcode::AMOMAXU_W:
+				return (uint32_t)iss.regs[instr.rs1()];
+			default:
+				return 0;
+		}
+	}
+
+	void flush() override {
+		if (num_instrs == 0)
+			return;
 
-		assert(timing_sim->get_magic_number() == 0x5E5E5E5E5E5E5E5E);
+		riscv_vp_timing_block block{num_instrs, pcs.data(), instrs.data(), mem_addrs.data()};
+		uint64_t cycles = plugin->get_cycles_for_block(timing_sim, &block);
+		num_instrs = 0;
 
-		sc_core::sc_time delay = iss.cycle_time * cycles;
+		sc_core::sc_time delay = block_owner->cycle_time * cycles;
+		if (!block_owner->csrs.mcountinhibit.CY)
+			block_owner->cycle_counter += delay;
+		block_owner->quantum_keeper.inc(delay);
+	}
+
+	void update_timing(Instruction instr, Opcode::Mapping op, ISS &iss) override {
+		// a trap, interrupt or a core switch also starts a new block
+		if (num_instrs > 0 && (iss.last_pc != next_pc || &iss != block_owner))
+			flush();
 
-		iss.quantum_keeper.inc(delay);
+		block_owner = &iss;
+		pcs[num_instrs] = iss.last_pc;
+		instrs[num_instrs] = instr.data();
+		mem_addrs[num_instrs] = effective_address(instr, op, iss);
+		++num_instrs;
+		next_pc = iss.pc;
+
+		if (ends_basic_block(op) || num_instrs == MAX_BLOCK_SIZE)
+			flush();
 	}
 };
+
+}  // namespace rv32
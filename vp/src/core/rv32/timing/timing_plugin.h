@@ -0,0 +1,56 @@
+#ifndef RISCV_VP_TIMING_PLUGIN_H
+#define RISCV_VP_TIMING_PLUGIN_H
+
+/* Versioned C ABI between the VP and external timing simulators loaded with dlopen.
+ *
+ * A plugin exports a single function named RISCV_VP_TIMING_PLUGIN_SYMBOL that returns a pointer to a static
+ * *riscv_vp_timing_plugin* descriptor. The VP checks magic, ABI version and descriptor size once at load time and
+ * afterwards hands complete basic blocks to *get_cycles_for_block*, i.e. there is one call into the plugin per block
+ * and not per instruction.
+ *
+ * Only append new fields at the end of the descriptor; bump RISCV_VP_TIMING_ABI_VERSION on incompatible changes. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RISCV_VP_TIMING_ABI_VERSION 1
+#define RISCV_VP_TIMING_MAGIC 0x5E5E5E5E5E5E5E5EULL
+#define RISCV_VP_TIMING_PLUGIN_SYMBOL "riscv_vp_timing_plugin_v1"
+
+typedef struct riscv_vp_timing_block {
+	uint32_t num_instrs;
+	/* address of each instruction, consecutive within a block */
+	const uint64_t *pcs;
+	/* 32 bit encoding of each instruction (compressed instructions are passed in expanded form) */
+	const uint32_t *instrs;
+	/* effective address of loads, stores and AMOs, zero for all other instructions */
+	const uint64_t *mem_addrs;
+} riscv_vp_timing_block;
+
+typedef struct riscv_vp_timing_plugin {
+	uint64_t magic;
+	uint32_t abi_version;
+	/* sizeof(riscv_vp_timing_plugin) as seen by the plugin */
+	uint32_t size;
+
+	/* *config* is an opaque, plugin specific string (e.g. the path to a timing database), returns a context handle
+	 * or NULL on error */
+	void *(*create)(const char *config);
+	void (*destroy)(void *ctx);
+
+	/* returns the number of cycles needed to execute all instructions of *block* */
+	uint64_t (*get_cycles_for_block)(void *ctx, const riscv_vp_timing_block *block);
+} riscv_vp_timing_plugin;
+
+typedef const riscv_vp_timing_plugin *(*riscv_vp_timing_plugin_entry_t)(void);
+
+const riscv_vp_timing_plugin *riscv_vp_timing_plugin_v1(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RISCV_VP_TIMING_PLUGIN_H
@@ -2,6 +2,8 @@
 
 #include "../iss.h"
 
+namespace rv32 {
+
 struct SimpleTimingDecorator : public timing_if {
 	std::array<sc_core::sc_time, Opcode::NUMBER_OF_INSTRUCTIONS> instr_cycles;
 	sc_core::sc_time cycle_time = sc_core::sc_time(10, sc_core::SC_NS);
@@ -30,9 +32,13 @@ struct SimpleTimingDecorator : public timing_if {
 		instr_cycles[Opcode::REMU] = mul_div_cycles;
 	}
 
-	void on_begin_exec_step(Instruction instr, Opcode::mapping op, ISS &iss) override {
+	void update_timing(Instruction instr, Opcode::Mapping op, ISS &iss) override {
 		auto new_cycles = instr_cycles[op];
 
+		if (!iss.csrs.mcountinhibit.CY)
+			iss.cycle_counter += new_cycles;
 		iss.quantum_keeper.inc(new_cycles);
 	}
 };
+
+}  // namespace rv32
@@ -16,6 +16,11 @@ typedef __uint128_t uint128_t;
 
 #define RAISE_ILLEGAL_INSTRUCTION() raise_trap(EXC_ILLEGAL_INSTR, instr.data());
 
+// NOTE: only available in ISS::exec_step, which is specialised for the ISA extension set *Isa*
+#define REQUIRE_ISA(X)           \
+    if (!Isa::has(csrs.misa, X)) \
+        RAISE_ILLEGAL_INSTRUCTION()
+
 #define RD instr.rd()
 #define RS1 instr.rs1()
 #define RS2 instr.rs2()
@@ -120,8 +125,9 @@ ISS::ISS(uint64_t hart_id) : systemc_name("Core-" + std::to_string(hart_id)) {
 	instr_cycles[Opcode::REMU] = mul_div_cycles;
 }
 
+template <typename Isa>
 void ISS::exec_step() {
-	assert(((pc & ~pc_alignment_mask()) == 0) && "misaligned instruction");
+	assert(((pc & ~pc_alignment_mask<Isa>()) == 0) && "misaligned instruction");
 
 	uint32_t mem_word;
 	try {
@@ -136,6 +142,8 @@ void ISS::exec_step() {
 	if (instr.is_compressed()) {
 		op = instr.decode_and_expand_compressed(RV64);
 		pc += 2;
+		if (op != Opcode::UNDEF)
+			REQUIRE_ISA(csr_misa::C);
 	} else {
 		op = instr.decode_normal(RV64);
 		pc += 4;
@@ -275,14 +283,14 @@ void ISS::exec_step() {
 		case Opcode::JAL: {
 			auto link = pc;
 			pc = last_pc + instr.J_imm();
-			trap_check_pc_alignment();
+			trap_check_pc_alignment<Isa>();
 			regs[instr.rd()] = link;
 		} break;
 
 		case Opcode::JALR: {
 			auto link = pc;
 			pc = (regs[instr.rs1()] + instr.I_imm()) & ~1;
-			trap_check_pc_alignment();
+			trap_check_pc_alignment<Isa>();
 			regs[instr.rd()] = link;
 		} break;
 
@@ -352,42 +360,42 @@ void ISS::exec_step() {
 		case Opcode::BEQ:
 			if (regs[instr.rs1()] == regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BNE:
 			if (regs[instr.rs1()] != regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BLT:
 			if (regs[instr.rs1()] < regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BGE:
 			if (regs[instr.rs1()] >= regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BLTU:
 			if ((uint64_t)regs[instr.rs1()] < (uint64_t)regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
 		case Opcode::BGEU:
 			if ((uint64_t)regs[instr.rs1()] >= (uint64_t)regs[instr.rs2()]) {
 				pc = last_pc + instr.B_imm();
-				trap_check_pc_alignment();
+				trap_check_pc_alignment<Isa>();
 			}
 			break;
 
@@ -551,26 +559,31 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::MUL: {
+			REQUIRE_ISA(csr_misa::M);
 			int128_t ans = (int128_t)regs[instr.rs1()] * (int128_t)regs[instr.rs2()];
 			regs[instr.rd()] = (int64_t)ans;
 		} break;
 
 		case Opcode::MULH: {
+			REQUIRE_ISA(csr_misa::M);
 			int128_t ans = (int128_t)regs[instr.rs1()] * (int128_t)regs[instr.rs2()];
 			regs[instr.rd()] = ans >> 64;
 		} break;
 
 		case Opcode::MULHU: {
+			REQUIRE_ISA(csr_misa::M);
 			int128_t ans = ((uint128_t)(uint64_t)regs[instr.rs1()]) * (uint128_t)((uint64_t)regs[instr.rs2()]);
 			regs[instr.rd()] = ans >> 64;
 		} break;
 
 		case Opcode::MULHSU: {
+			REQUIRE_ISA(csr_misa::M);
 			int128_t ans = (int128_t)regs[instr.rs1()] * (uint128_t)((uint64_t)regs[instr.rs2()]);
 			regs[instr.rd()] = ans >> 64;
 		} break;
 
 		case Opcode::DIV: {
+			REQUIRE_ISA(csr_misa::M);
 			auto a = regs[instr.rs1()];
 			auto b = regs[instr.rs2()];
 			if (b == 0) {
@@ -583,6 +596,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::DIVU: {
+			REQUIRE_ISA(csr_misa::M);
 			auto a = regs[instr.rs1()];
 			auto b = regs[instr.rs2()];
 			if (b == 0) {
@@ -593,6 +607,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::REM: {
+			REQUIRE_ISA(csr_misa::M);
 			auto a = regs[instr.rs1()];
 			auto b = regs[instr.rs2()];
 			if (b == 0) {
@@ -605,6 +620,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::REMU: {
+			REQUIRE_ISA(csr_misa::M);
 			auto a = regs[instr.rs1()];
 			auto b = regs[instr.rs2()];
 			if (b == 0) {
@@ -615,10 +631,12 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::MULW: {
+			REQUIRE_ISA(csr_misa::M);
 			regs[instr.rd()] = (int32_t)(regs[instr.rs1()] * regs[instr.rs2()]);
 		} break;
 
 		case Opcode::DIVW: {
+			REQUIRE_ISA(csr_misa::M);
 			int32_t a = regs[instr.rs1()];
 			int32_t b = regs[instr.rs2()];
 			if (b == 0) {
@@ -631,6 +649,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::DIVUW: {
+			REQUIRE_ISA(csr_misa::M);
 			int32_t a = regs[instr.rs1()];
 			int32_t b = regs[instr.rs2()];
 			if (b == 0) {
@@ -641,6 +660,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::REMW: {
+			REQUIRE_ISA(csr_misa::M);
 			int32_t a = regs[instr.rs1()];
 			int32_t b = regs[instr.rs2()];
 			if (b == 0) {
@@ -653,6 +673,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::REMUW: {
+			REQUIRE_ISA(csr_misa::M);
 			int32_t a = regs[instr.rs1()];
 			int32_t b = regs[instr.rs2()];
 			if (b == 0) {
@@ -663,6 +684,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::LR_W: {
+			REQUIRE_ISA(csr_misa::A);
 			uint64_t addr = regs[instr.rs1()];
 			trap_check_addr_alignment<4, true>(addr);
 			regs[instr.rd()] = mem->atomic_load_reserved_word(addr);
@@ -671,6 +693,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::SC_W: {
+			REQUIRE_ISA(csr_misa::A);
 			uint64_t addr = regs[instr.rs1()];
 			trap_check_addr_alignment<4, false>(addr);
 			int32_t val = regs[instr.rs2()];
@@ -680,6 +703,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::AMOSWAP_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) {
 				(void)a;
 				return b;
@@ -687,38 +711,47 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::AMOADD_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return a + b; });
 		} break;
 
 		case Opcode::AMOXOR_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return a ^ b; });
 		} break;
 
 		case Opcode::AMOAND_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return a & b; });
 		} break;
 
 		case Opcode::AMOOR_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return a | b; });
 		} break;
 
 		case Opcode::AMOMIN_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return std::min(a, b); });
 		} break;
 
 		case Opcode::AMOMINU_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return std::min((uint32_t)a, (uint32_t)b); });
 		} break;
 
 		case Opcode::AMOMAX_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return std::max(a, b); });
 		} break;
 
 		case Opcode::AMOMAXU_W: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_w(instr, [](int32_t a, int32_t b) { return std::max((uint32_t)a, (uint32_t)b); });
 		} break;
 
 		case Opcode::LR_D: {
+			REQUIRE_ISA(csr_misa::A);
 			uint64_t addr = regs[instr.rs1()];
 			trap_check_addr_alignment<8, true>(addr);
 			regs[instr.rd()] = mem->atomic_load_reserved_double(addr);
@@ -727,6 +760,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::SC_D: {
+			REQUIRE_ISA(csr_misa::A);
 			uint64_t addr = regs[instr.rs1()];
 			trap_check_addr_alignment<8, false>(addr);
 			uint64_t val = regs[instr.rs2()];
@@ -738,6 +772,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::AMOSWAP_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) {
 				(void)a;
 				return b;
@@ -745,87 +780,103 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::AMOADD_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return a + b; });
 		} break;
 
 		case Opcode::AMOXOR_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return a ^ b; });
 		} break;
 
 		case Opcode::AMOAND_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return a & b; });
 		} break;
 
 		case Opcode::AMOOR_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return a | b; });
 		} break;
 
 		case Opcode::AMOMIN_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return std::min(a, b); });
 		} break;
 
 		case Opcode::AMOMINU_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return std::min((uint64_t)a, (uint64_t)b); });
 		} break;
 
 		case Opcode::AMOMAX_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return std::max(a, b); });
 		} break;
 
 		case Opcode::AMOMAXU_D: {
+			REQUIRE_ISA(csr_misa::A);
 			execute_amo_d(instr, [](int64_t a, int64_t b) { return std::max((uint64_t)a, (uint64_t)b); });
 		} break;
 
 			// RV64 F/D extension
 
 		case Opcode::FLW: {
+			REQUIRE_ISA(csr_misa::F);
 			uint64_t addr = regs[instr.rs1()] + instr.I_imm();
 			trap_check_addr_alignment<4, true>(addr);
 			fp_regs.write(RD, float32_t{(uint32_t)mem->load_uword(addr)});
 		} break;
 
 		case Opcode::FSW: {
+			REQUIRE_ISA(csr_misa::F);
 			uint64_t addr = regs[instr.rs1()] + instr.S_imm();
 			trap_check_addr_alignment<4, false>(addr);
 			mem->store_word(addr, fp_regs.u32(RS2));
 		} break;
 
 		case Opcode::FADD_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_add(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_add(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FSUB_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_sub(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_sub(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FMUL_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_mul(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_mul(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FDIV_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_div(fp_regs.f32(RS1), fp_regs.f32(RS2)));
+			fp_regs.write(RD, fast_f32_div(fp_regs.f32(RS1), fp_regs.f32(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FSQRT_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f32_sqrt(fp_regs.f32(RS1)));
+			fp_regs.write(RD, fast_f32_sqrt(fp_regs.f32(RS1)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FMIN_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 
 			bool rs1_smaller = f32_lt_quiet(fp_regs.f32(RS1), fp_regs.f32(RS2)) ||
@@ -844,6 +895,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMAX_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 
 			bool rs1_greater = f32_lt_quiet(fp_regs.f32(RS2), fp_regs.f32(RS1)) ||
@@ -862,6 +914,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMADD_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f32_mulAdd(fp_regs.f32(RS1), fp_regs.f32(RS2), fp_regs.f32(RS3)));
@@ -869,6 +922,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMSUB_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f32_mulAdd(fp_regs.f32(RS1), fp_regs.f32(RS2), f32_neg(fp_regs.f32(RS3))));
@@ -876,6 +930,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FNMADD_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f32_mulAdd(f32_neg(fp_regs.f32(RS1)), fp_regs.f32(RS2), f32_neg(fp_regs.f32(RS3))));
@@ -883,6 +938,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FNMSUB_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f32_mulAdd(f32_neg(fp_regs.f32(RS1)), fp_regs.f32(RS2), fp_regs.f32(RS3)));
@@ -890,6 +946,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_W_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f32_to_i32(fp_regs.f32(RS1), softfloat_roundingMode, true);
@@ -897,6 +954,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_WU_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = (int32_t)f32_to_ui32(fp_regs.f32(RS1), softfloat_roundingMode, true);
@@ -904,6 +962,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_S_W: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, i32_to_f32((int32_t)regs[RS1]));
@@ -911,6 +970,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_S_WU: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, ui32_to_f32((int32_t)regs[RS1]));
@@ -918,6 +978,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJ_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f32(RS1);
 			auto f2 = fp_regs.f32(RS2);
@@ -926,6 +987,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJN_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f32(RS1);
 			auto f2 = fp_regs.f32(RS2);
@@ -934,6 +996,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJX_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f32(RS1);
 			auto f2 = fp_regs.f32(RS2);
@@ -942,40 +1005,47 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMV_W_X: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_regs.write(RD, float32_t{(uint32_t)((int32_t)regs[RS1])});
 			fp_set_dirty();
 		} break;
 
 		case Opcode::FMV_X_W: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			regs[RD] = (int32_t)fp_regs.u32(RS1);
 		} break;
 
 		case Opcode::FEQ_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			regs[RD] = f32_eq(fp_regs.f32(RS1), fp_regs.f32(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FLT_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			regs[RD] = f32_lt(fp_regs.f32(RS1), fp_regs.f32(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FLE_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			regs[RD] = f32_le(fp_regs.f32(RS1), fp_regs.f32(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FCLASS_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			regs[RD] = (int32_t)f32_classify(fp_regs.f32(RS1));
 		} break;
 
 		case Opcode::FCVT_L_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f32_to_i64(fp_regs.f32(RS1), softfloat_roundingMode, true);
@@ -983,6 +1053,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_LU_S: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f32_to_ui64(fp_regs.f32(RS1), softfloat_roundingMode, true);
@@ -990,6 +1061,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_S_L: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, i64_to_f32(regs[RS1]));
@@ -997,6 +1069,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_S_LU: {
+			REQUIRE_ISA(csr_misa::F);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, ui64_to_f32(regs[RS1]));
@@ -1004,53 +1077,61 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FLD: {
+			REQUIRE_ISA(csr_misa::D);
 			uint64_t addr = regs[instr.rs1()] + instr.I_imm();
 			trap_check_addr_alignment<8, true>(addr);
 			fp_regs.write(RD, float64_t{(uint64_t)mem->load_double(addr)});
 		} break;
 
 		case Opcode::FSD: {
+			REQUIRE_ISA(csr_misa::D);
 			uint64_t addr = regs[instr.rs1()] + instr.S_imm();
 			trap_check_addr_alignment<8, false>(addr);
 			mem->store_double(addr, fp_regs.f64(RS2).v);
 		} break;
 
 		case Opcode::FADD_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f64_add(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+			fp_regs.write(RD, fast_f64_add(fp_regs.f64(RS1), fp_regs.f64(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FSUB_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f64_sub(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+			fp_regs.write(RD, fast_f64_sub(fp_regs.f64(RS1), fp_regs.f64(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FMUL_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f64_mul(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+			fp_regs.write(RD, fast_f64_mul(fp_regs.f64(RS1), fp_regs.f64(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FDIV_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f64_div(fp_regs.f64(RS1), fp_regs.f64(RS2)));
+			fp_regs.write(RD, fast_f64_div(fp_regs.f64(RS1), fp_regs.f64(RS2)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FSQRT_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
-			fp_regs.write(RD, f64_sqrt(fp_regs.f64(RS1)));
+			fp_regs.write(RD, fast_f64_sqrt(fp_regs.f64(RS1)));
 			fp_finish_instr();
 		} break;
 
 		case Opcode::FMIN_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 
 			bool rs1_smaller = f64_lt_quiet(fp_regs.f64(RS1), fp_regs.f64(RS2)) ||
@@ -1069,6 +1150,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMAX_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 
 			bool rs1_greater = f64_lt_quiet(fp_regs.f64(RS2), fp_regs.f64(RS1)) ||
@@ -1087,6 +1169,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMADD_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f64_mulAdd(fp_regs.f64(RS1), fp_regs.f64(RS2), fp_regs.f64(RS3)));
@@ -1094,6 +1177,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FMSUB_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f64_mulAdd(fp_regs.f64(RS1), fp_regs.f64(RS2), f64_neg(fp_regs.f64(RS3))));
@@ -1101,6 +1185,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FNMADD_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f64_mulAdd(f64_neg(fp_regs.f64(RS1)), fp_regs.f64(RS2), f64_neg(fp_regs.f64(RS3))));
@@ -1108,6 +1193,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FNMSUB_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f64_mulAdd(f64_neg(fp_regs.f64(RS1)), fp_regs.f64(RS2), fp_regs.f64(RS3)));
@@ -1115,6 +1201,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJ_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f64(RS1);
 			auto f2 = fp_regs.f64(RS2);
@@ -1123,6 +1210,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJN_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f64(RS1);
 			auto f2 = fp_regs.f64(RS2);
@@ -1131,6 +1219,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FSGNJX_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			auto f1 = fp_regs.f64(RS1);
 			auto f2 = fp_regs.f64(RS2);
@@ -1139,40 +1228,47 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FEQ_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			regs[RD] = f64_eq(fp_regs.f64(RS1), fp_regs.f64(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FLT_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			regs[RD] = f64_lt(fp_regs.f64(RS1), fp_regs.f64(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FLE_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			regs[RD] = f64_le(fp_regs.f64(RS1), fp_regs.f64(RS2));
 			fp_update_exception_flags();
 		} break;
 
 		case Opcode::FCLASS_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			regs[RD] = (int64_t)f64_classify(fp_regs.f64(RS1));
 		} break;
 
 		case Opcode::FMV_D_X: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_regs.write(RD, float64_t{(uint64_t)regs[RS1]});
 			fp_set_dirty();
 		} break;
 
 		case Opcode::FMV_X_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			regs[RD] = fp_regs.f64(RS1).v;
 		} break;
 
 		case Opcode::FCVT_W_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f64_to_i32(fp_regs.f64(RS1), softfloat_roundingMode, true);
@@ -1180,6 +1276,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_WU_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = (int32_t)f64_to_ui32(fp_regs.f64(RS1), softfloat_roundingMode, true);
@@ -1187,6 +1284,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_D_W: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, i32_to_f64((int32_t)regs[RS1]));
@@ -1194,6 +1292,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_D_WU: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, ui32_to_f64((int32_t)regs[RS1]));
@@ -1201,6 +1300,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_S_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f64_to_f32(fp_regs.f64(RS1)));
@@ -1208,6 +1308,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_D_S: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, f32_to_f64(fp_regs.f32(RS1)));
@@ -1215,6 +1316,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_L_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f64_to_i64(fp_regs.f64(RS1), softfloat_roundingMode, true);
@@ -1222,6 +1324,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_LU_D: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			regs[RD] = f64_to_ui64(fp_regs.f64(RS1), softfloat_roundingMode, true);
@@ -1229,6 +1332,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_D_L: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, i64_to_f64(regs[RS1]));
@@ -1236,6 +1340,7 @@ void ISS::exec_step() {
 		} break;
 
 		case Opcode::FCVT_D_LU: {
+			REQUIRE_ISA(csr_misa::D);
 			fp_prepare_instr();
 			fp_setup_rm();
 			fp_regs.write(RD, ui64_to_f64(regs[RS1]));
@@ -1296,8 +1401,9 @@ uint64_t ISS::_compute_and_get_current_cycles() {
 }
 
 void ISS::validate_csr_counter_read_access_rights(uint64_t addr) {
-	// match against counter CSR addresses, see RISC-V privileged spec for the address definitions
-	if ((addr >= 0xC00 && addr <= 0xC1F)) {
+	// match against counter CSR addresses, see RISC-V privileged spec for the address definitions (the upper halves
+	// at 0xC80 do not exist on RV64 and are rejected as invalid CSRs anyway)
+	if (CSR_ACCESS_TABLE[addr] & CsrAccessTable::COUNTER) {
 		auto cnt = addr & 0x1F;  // 32 counter in total, naturally aligned with the mcounteren and scounteren CSRs
 
 		if (s_mode() && !csr::is_bitset(csrs.mcounteren, cnt))
@@ -1311,188 +1417,98 @@ void ISS::validate_csr_counter_read_access_rights(uint64_t addr) {
 uint64_t ISS::get_csr_value(uint64_t addr) {
 	validate_csr_counter_read_access_rights(addr);
 
-	auto read = [=](auto &x, uint64_t mask) { return x.reg & mask; };
+	using Handler = csr_table::Handler;
 
-	using namespace csr;
+	auto &e = csrs.entries[addr];
+	switch (e.handler) {
+		case Handler::Invalid:
+			RAISE_ILLEGAL_INSTRUCTION();
+			break;
 
-	switch (addr) {
-		case TIME_ADDR:
-		case MTIME_ADDR: {
-			uint64_t mtime = clint->update_and_get_mtime();
-			csrs.time.reg = mtime;
-			return csrs.time.reg;
-		}
+		case Handler::Time:
+			csrs.time.reg = clint->update_and_get_mtime();
+			break;
 
-		case MCYCLE_ADDR:
+		case Handler::Cycle:
 			csrs.cycle.reg = _compute_and_get_current_cycles();
-			return csrs.cycle.reg;
-
-		case MINSTRET_ADDR:
-			return csrs.instret.reg;
-
-		SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV64:  // not implemented
-			return 0;
-
-			// TODO: SD should be updated as SD=XS|FS and SD should be read-only -> update mask
-		case MSTATUS_ADDR:
-			return read(csrs.mstatus, MSTATUS_READ_MASK);
-		case SSTATUS_ADDR:
-			return read(csrs.mstatus, SSTATUS_READ_MASK);
-		case USTATUS_ADDR:
-			return read(csrs.mstatus, USTATUS_MASK);
-
-		case MIP_ADDR:
-			return read(csrs.mip, MIP_READ_MASK);
-		case SIP_ADDR:
-			return read(csrs.mip, SIP_MASK);
-		case UIP_ADDR:
-			return read(csrs.mip, UIP_MASK);
-
-		case MIE_ADDR:
-			return read(csrs.mie, MIE_MASK);
-		case SIE_ADDR:
-			return read(csrs.mie, SIE_MASK);
-		case UIE_ADDR:
-			return read(csrs.mie, UIE_MASK);
-
-		case SATP_ADDR:
+			break;
+
+		case Handler::Satp:
 			if (csrs.mstatus.tvm)
 				RAISE_ILLEGAL_INSTRUCTION();
 			break;
 
-		case FCSR_ADDR:
-			return read(csrs.fcsr, FCSR_MASK);
-
-		case FFLAGS_ADDR:
+		case Handler::Fflags:
 			return csrs.fcsr.fflags;
 
-		case FRM_ADDR:
+		case Handler::Frm:
 			return csrs.fcsr.frm;
-	}
 
-	if (!csrs.is_valid_csr64_addr(addr))
-		RAISE_ILLEGAL_INSTRUCTION();
+		default:
+			break;
+	}
 
-	return csrs.default_read64(addr);
+	return *e.reg & e.read_mask;
 }
 
 void ISS::set_csr_value(uint64_t addr, uint64_t value) {
-	auto write = [=](auto &x, uint64_t mask) { x.reg = (x.reg & ~mask) | (value & mask); };
-
+	using Handler = csr_table::Handler;
 	using namespace csr;
 
-	switch (addr) {
-		case MISA_ADDR:                         // currently, read-only, thus cannot be changed at runtime
-		SWITCH_CASE_MATCH_ANY_HPMCOUNTER_RV64:  // not implemented
+	auto &e = csrs.entries[addr];
+	uint64_t mask = e.write_mask;
+	switch (e.handler) {
+		case Handler::Invalid:
+			RAISE_ILLEGAL_INSTRUCTION();
 			break;
 
-		case SATP_ADDR: {
+		case Handler::Satp: {
 			if (csrs.mstatus.tvm)
 				RAISE_ILLEGAL_INSTRUCTION();
 			auto mode = csrs.satp.mode;
-			write(csrs.satp, SATP_MASK);
+			csrs.satp.reg = (csrs.satp.reg & ~mask) | (value & mask);
 			if (csrs.satp.mode != SATP_MODE_BARE && csrs.satp.mode != SATP_MODE_SV39 &&
 			    csrs.satp.mode != SATP_MODE_SV48)
 				csrs.satp.mode = mode;
-			// std::cout << "[iss] satp=" << boost::format("%x") % csrs.satp.reg << std::endl;
-		} break;
-
-		case MTVEC_ADDR:
-			write(csrs.mtvec, MTVEC_MASK);
-			break;
-		case STVEC_ADDR:
-			write(csrs.stvec, MTVEC_MASK);
-			break;
-		case UTVEC_ADDR:
-			write(csrs.utvec, MTVEC_MASK);
-			break;
-
-		case MEPC_ADDR:
-			write(csrs.mepc, pc_alignment_mask());
-			break;
-		case SEPC_ADDR:
-			write(csrs.sepc, pc_alignment_mask());
-			break;
-		case UEPC_ADDR:
-			write(csrs.uepc, pc_alignment_mask());
-			break;
-
-		case MSTATUS_ADDR:
-			write(csrs.mstatus, MSTATUS_WRITE_MASK);
-			break;
-		case SSTATUS_ADDR:
-			write(csrs.mstatus, SSTATUS_WRITE_MASK);
-			break;
-		case USTATUS_ADDR:
-			write(csrs.mstatus, USTATUS_MASK);
-			break;
-
-		case MIP_ADDR:
-			write(csrs.mip, MIP_WRITE_MASK);
-			break;
-		case SIP_ADDR:
-			write(csrs.mip, SIP_MASK);
-			break;
-		case UIP_ADDR:
-			write(csrs.mip, UIP_MASK);
-			break;
-
-		case MIE_ADDR:
-			write(csrs.mie, MIE_MASK);
-			break;
-		case SIE_ADDR:
-			write(csrs.mie, SIE_MASK);
-			break;
-		case UIE_ADDR:
-			write(csrs.mie, UIE_MASK);
-			break;
-
-		case MIDELEG_ADDR:
-			write(csrs.mideleg, MIDELEG_MASK);
-			break;
-
-		case MEDELEG_ADDR:
-			write(csrs.medeleg, MEDELEG_MASK);
-			break;
-
-		case SIDELEG_ADDR:
-			write(csrs.sideleg, SIDELEG_MASK);
-			break;
-
-		case SEDELEG_ADDR:
-			write(csrs.sedeleg, SEDELEG_MASK);
-			break;
-
-		case MCOUNTEREN_ADDR:
-			write(csrs.mcounteren, MCOUNTEREN_MASK);
-			break;
+			return;
+		}
 
-		case SCOUNTEREN_ADDR:
-			write(csrs.scounteren, MCOUNTEREN_MASK);
+		case Handler::Epc:
+			mask = pc_alignment_mask();
 			break;
 
-		case MCOUNTINHIBIT_ADDR:
-			write(csrs.mcountinhibit, MCOUNTINHIBIT_MASK);
-			break;
+		case Handler::Pmpcfg: {
+			// each (even numbered) pmpcfg register holds the configuration of eight entries
+			unsigned n = (addr - PMPCFG0_ADDR) / 2;
+			uint64_t reg = 0;
+			for (unsigned i = 0; i < 8; ++i) {
+				pmp.set_cfg(n * 8 + i, value >> (i * 8));
+				reg |= (uint64_t)pmp.get_cfg(n * 8 + i) << (i * 8);
+			}
+			csrs.pmpcfg[n].reg = reg;
+			return;
+		}
 
-		case FCSR_ADDR:
-			write(csrs.fcsr, FCSR_MASK);
-			break;
+		case Handler::Pmpaddr: {
+			unsigned n = addr - PMPADDR0_ADDR;
+			pmp.set_addr(n, value);
+			csrs.pmpaddr[n].reg = pmp.get_addr(n);
+			return;
+		}
 
-		case FFLAGS_ADDR:
+		case Handler::Fflags:
 			csrs.fcsr.fflags = value;
-			break;
+			return;
 
-		case FRM_ADDR:
+		case Handler::Frm:
 			csrs.fcsr.frm = value;
-			break;
+			return;
 
 		default:
-			if (!csrs.is_valid_csr64_addr(addr))
-				RAISE_ILLEGAL_INSTRUCTION();
-
-			csrs.default_write64(addr, value);
+			break;
 	}
+
+	*e.reg = (*e.reg & ~mask) | (value & mask);
 }
 
 void ISS::init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint64_t entrypoint,
@@ -1504,6 +1520,24 @@ void ISS::init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *c
 	pc = entrypoint;
 }
 
+void ISS::set_isa(const std::string &isa) {
+	csrs.misa.select_isa_string(isa);
+	select_isa_variant();
+}
+
+void ISS::select_isa_variant() {
+	switch (csrs.misa.extensions) {
+		case isa::RV64IMAC::extensions:
+			isa_variant = IsaVariant::RV64IMAC;
+			break;
+		case isa::RV64GC::extensions:
+			isa_variant = IsaVariant::RV64GC;
+			break;
+		default:
+			isa_variant = IsaVariant::Generic;
+	}
+}
+
 void ISS::sys_exit() {
 	shall_exit = true;
 }
@@ -1536,14 +1570,46 @@ void ISS::enable_debug(void) {
 	debug_mode = true;
 }
 
-void ISS::insert_breakpoint(uint64_t addr) {
-	breakpoints.insert(addr);
+void ISS::insert_breakpoint(uint64_t addr, const std::vector<AgentExpr> &conds) {
+	breakpoints.insert(addr, conds);
 }
 
 void ISS::remove_breakpoint(uint64_t addr) {
 	breakpoints.erase(addr);
 }
 
+void ISS::insert_watchpoint(uint64_t addr, uint64_t len, WatchpointType type) {
+	watchpoints.insert(addr, len, type);
+}
+
+void ISS::remove_watchpoint(uint64_t addr, uint64_t len, WatchpointType type) {
+	watchpoints.remove(addr, len, type);
+}
+
+const WatchpointHit *ISS::get_watchpoint_hit(void) {
+	return watchpoints.get_hit();
+}
+
+uint64_t ISS::ax_register(unsigned regno) {
+	if (regno < RegFile::NUM_REGS)
+		return regs.read(regno);
+	if (regno == RegFile::NUM_REGS)
+		return pc;
+	throw std::runtime_error("register " + std::to_string(regno) + " not available in agent expressions");
+}
+
+uint64_t ISS::ax_memory(uint64_t addr, unsigned num_bytes) {
+	// accesses of the debugger, not of the program: no timing, no PMP and watchpoint checks and no side effects of the
+	// address translation or of peripherals
+	uint64_t value = 0;
+	try {
+		if (mem->debug_load(addr, (uint8_t *)&value, num_bytes) == num_bytes)
+			return value;
+	} catch (SimulationTrap &) {
+	}
+	throw std::runtime_error("agent expression accesses invalid memory");
+}
+
 uint64_t ISS::get_hart_id() {
 	return csrs.mhartid.reg;
 }
@@ -1874,18 +1940,37 @@ void ISS::performance_and_sync_update(Opcode::Mapping executed_op) {
 }
 
 void ISS::run_step() {
+	watchpoints.clear_hit();
+	select_isa_variant();
+
+	switch (isa_variant) {
+		case IsaVariant::RV64IMAC:
+			do_run_step<isa::RV64IMAC, true>();
+			break;
+		case IsaVariant::RV64GC:
+			do_run_step<isa::RV64GC, true>();
+			break;
+		default:
+			do_run_step<isa::Generic, true>();
+	}
+}
+
+template <typename Isa, bool Debug>
+void ISS::do_run_step() {
 	assert(regs.read(0) == 0);
 
-	// speeds up the execution performance (non debug mode) significantly by
-	// checking the additional flag first
-	if (debug_mode && (breakpoints.find(pc) != breakpoints.end())) {
-		status = CoreExecStatus::HitBreakpoint;
-		return;
+	// resolved at compile time, the loop without breakpoints does not check the pc at all
+	if (Debug) {
+		auto conds = breakpoints.find(pc);
+		if (unlikely(conds != nullptr) && AgentExpr::any_holds(*conds, *this)) {
+			status = CoreExecStatus::HitBreakpoint;
+			return;
+		}
 	}
 
 	last_pc = pc;
 	try {
-		exec_step();
+		exec_step<Isa>();
 
 		auto x = compute_pending_interrupts();
 		if (x.target_mode != NoneMode) {
@@ -1905,6 +1990,10 @@ void ISS::run_step() {
 	// before every register write)
 	regs.regs[regs.zero] = 0;
 
+	// watchpoints stop after the access
+	if (unlikely(watchpoints.triggered()))
+		status = CoreExecStatus::HitBreakpoint;
+
 	// Do not use a check *pc == last_pc* here. The reason is that due to
 	// interrupts *pc* can be set to *last_pc* accidentally (when jumping back
 	// to *mepc*).
@@ -1915,15 +2004,42 @@ void ISS::run_step() {
 }
 
 void ISS::run() {
-	// run a single step until either a breakpoint is hit or the execution terminates
+	watchpoints.clear_hit();
+	select_isa_variant();
+
+	// dispatch once to the execution loop specialised for the selected ISA, dispatch again in case the selection changes
 	do {
-		run_step();
+		switch (isa_variant) {
+			case IsaVariant::RV64IMAC:
+				do_run<isa::RV64IMAC>();
+				break;
+			case IsaVariant::RV64GC:
+				do_run<isa::RV64GC>();
+				break;
+			default:
+				do_run<isa::Generic>();
+		}
 	} while (status == CoreExecStatus::Runnable);
 
 	// force sync to make sure that no action is missed
 	quantum_keeper.sync();
 }
 
+template <typename Isa>
+void ISS::do_run() {
+	// run a single step until either a breakpoint is hit or the execution terminates, breakpoints only change while
+	// the hart is stopped
+	if (debug_mode && !breakpoints.empty()) {
+		do {
+			do_run_step<Isa, true>();
+		} while (status == CoreExecStatus::Runnable && isa_variant == Isa::variant);
+	} else {
+		do {
+			do_run_step<Isa, false>();
+		} while (status == CoreExecStatus::Runnable && isa_variant == Isa::variant);
+	}
+}
+
 void ISS::show() {
 	boost::io::ios_flags_saver ifs(std::cout);
 	std::cout << "=[ core : " << csrs.mhartid.reg << " ]===========================" << std::endl;
@@ -1,17 +1,21 @@
 #pragma once
 
+#include "core/common/breakpoints.h"
 #include "core/common/bus_lock_if.h"
 #include "core/common/clint_if.h"
 #include "core/common/core_defs.h"
 #include "core/common/instr.h"
 #include "core/common/irq_if.h"
+#include "core/common/pmp.h"
 #include "core/common/trap.h"
 #include "csr.h"
 #include "fp.h"
+#include "fp_host.h"
 #include "mem_if.h"
 #include "syscall_if.h"
 #include "util/common.h"
 #include "debug.h"
+#include "watchpoints.h"
 
 #include <assert.h>
 #include <stdint.h>
@@ -22,7 +26,6 @@
 #include <map>
 #include <memory>
 #include <stdexcept>
-#include <unordered_set>
 #include <vector>
 
 #include <tlm_utils/simple_initiator_socket.h>
@@ -132,12 +135,42 @@ struct timing_if {
 	virtual void update_timing(Instruction instr, Opcode::Mapping op, ISS &iss) = 0;
 };
 
+/* Extension sets the ISS execution loop is specialised for at compile time. With a fixed set, the compressed
+ * instruction checks are constant and compile away. The generic variant reads misa on every check and is used for
+ * all other configurations. */
+enum class IsaVariant { Generic, RV64IMAC, RV64GC };
+
+namespace isa {
+struct Generic {
+	static constexpr IsaVariant variant = IsaVariant::Generic;
+
+	static inline bool has(const csr_misa &misa, uint64_t ext) {
+		return misa.extensions & ext;
+	}
+};
+
+template <IsaVariant V, uint32_t Extensions>
+struct Fixed {
+	static constexpr IsaVariant variant = V;
+	static constexpr uint32_t extensions = Extensions | csr_misa::N | csr_misa::U | csr_misa::S;
+
+	static constexpr bool has(const csr_misa &, uint64_t ext) {
+		return extensions & ext;
+	}
+};
+
+using RV64IMAC = Fixed<IsaVariant::RV64IMAC, csr_misa::I | csr_misa::M | csr_misa::A | csr_misa::C>;
+using RV64GC =
+    Fixed<IsaVariant::RV64GC, csr_misa::I | csr_misa::M | csr_misa::A | csr_misa::F | csr_misa::D | csr_misa::C>;
+}  // namespace isa
+
 struct PendingInterrupts {
 	PrivilegeLevel target_mode;
 	uint64_t pending;
 };
 
-struct ISS : public external_interrupt_target, public clint_interrupt_target, public debug_target_if, public iss_syscall_if {
+struct ISS : public external_interrupt_target, public clint_interrupt_target, public debug_target_if, public iss_syscall_if,
+             public agent_expr_env {
 	clint_if *clint = nullptr;
 	instr_memory_if *instr_mem = nullptr;
 	data_memory_if *mem = nullptr;
@@ -150,6 +183,7 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	bool shall_exit = false;
 	bool ignore_wfi = false;
 	csr_table csrs;
+	PMP pmp{64};
 	PrivilegeLevel prv = MachineMode;
 	int64_t lr_sc_counter = 0;
 
@@ -157,8 +191,10 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	Instruction instr;
 	Opcode::Mapping op;
 
+	IsaVariant isa_variant = IsaVariant::Generic;
 	CoreExecStatus status = CoreExecStatus::Runnable;
-	std::unordered_set<uint64_t> breakpoints;
+	Breakpoints breakpoints;
+	Watchpoints watchpoints;
 	bool debug_mode = false;
 
 	sc_core::sc_event wfi_event;
@@ -185,15 +221,30 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	void set_status(CoreExecStatus) override;
 	void block_on_wfi(bool) override;
 
-	void insert_breakpoint(uint64_t) override;
+	void insert_breakpoint(uint64_t, const std::vector<AgentExpr> &) override;
 	void remove_breakpoint(uint64_t) override;
 
+	void insert_watchpoint(uint64_t, uint64_t, WatchpointType) override;
+	void remove_watchpoint(uint64_t, uint64_t, WatchpointType) override;
+	const WatchpointHit *get_watchpoint_hit(void) override;
+
+	uint64_t ax_register(unsigned) override;
+	uint64_t ax_memory(uint64_t, unsigned) override;
+
+	template <typename Isa>
 	void exec_step();
 
 	uint64_t _compute_and_get_current_cycles();
 
 	void init(instr_memory_if *instr_mem, data_memory_if *data_mem, clint_if *clint, uint64_t entrypoint, uint64_t sp);
 
+	/* Select the extensions from an ISA string like "rv64gc", see csr_misa::select_isa_string. */
+	void set_isa(const std::string &isa);
+
+	/* Select the specialised execution loop matching misa. Done on entry of run/run_step, call it again whenever misa
+	 * changes during execution. */
+	void select_isa_variant();
+
 	void trigger_external_interrupt(PrivilegeLevel level) override;
 
 	void clear_external_interrupt(PrivilegeLevel level) override;
@@ -229,24 +280,27 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 	void set_csr_value(uint64_t addr, uint64_t value);
 
 	inline bool is_invalid_csr_access(uint64_t csr_addr, bool is_write) {
-		PrivilegeLevel csr_prv = (0x300 & csr_addr) >> 8;
-		bool csr_readonly = ((0xC00 & csr_addr) >> 10) == 3;
+		uint8_t flags = CSR_ACCESS_TABLE[csr_addr];
+		PrivilegeLevel csr_prv = flags & CsrAccessTable::PRV_MASK;
+		bool csr_readonly = flags & CsrAccessTable::READ_ONLY;
 		return (is_write && csr_readonly) || (prv < csr_prv);
 	}
 
 	void validate_csr_counter_read_access_rights(uint64_t addr);
 
+	template <typename Isa = isa::Generic>
 	uint64_t pc_alignment_mask() {
-		if (csrs.misa.has_C_extension())
+		if (Isa::has(csrs.misa, csr_misa::C))
 			return ~uint64_t(0x1);
 		else
 			return ~uint64_t(0x3);
 	}
 
+	template <typename Isa>
 	inline void trap_check_pc_alignment() {
 		assert(!(pc & 0x1) && "not possible due to immediate formats and jump execution");
 
-		if (unlikely((pc & 0x3) && (!csrs.misa.has_C_extension()))) {
+		if (unlikely((pc & 0x3) && (!Isa::has(csrs.misa, csr_misa::C)))) {
 			// NOTE: misaligned instruction address not possible on machines supporting compressed instructions
 			raise_trap(EXC_INSTR_ADDR_MISALIGNED, pc);
 		}
@@ -327,6 +381,13 @@ struct ISS : public external_interrupt_target, public clint_interrupt_target, pu
 
 	void run() override;
 
+	/* *Debug* checks for breakpoints before the instruction */
+	template <typename Isa, bool Debug>
+	void do_run_step();
+
+	template <typename Isa>
+	void do_run();
+
 	void show();
 };
 
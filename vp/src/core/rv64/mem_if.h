@@ -38,6 +38,9 @@ struct data_memory_if {
 	virtual bool atomic_store_conditional_double(uint64_t addr, uint64_t value) = 0;
 
 	virtual void flush_tlb() = 0;
+
+	// debugger access to virtual memory without side effects, returns the number of bytes read
+	virtual unsigned debug_load(uint64_t addr, uint8_t *data, unsigned num_bytes) = 0;
 };
 
 }  // namespace rv64
\ No newline at end of file
@@ -57,6 +57,7 @@
 
 #include <tlm_utils/simple_target_socket.h>
 #include <systemc>
+#include <unordered_map>
 
 #include "iss.h"
 #include "syscall_if.h"
@@ -7,9 +7,14 @@
 
 #include "core/common/irq_if.h"
 
+/* Triggers *irq_number* at every multiple of *period*. While no hart has the interrupt enabled the timer does not
+ * wake up at all, when it gets enabled the ticks missed in between are caught up with a single trigger (the gateway
+ * only keeps a pending bit anyway). */
 struct BasicTimer : public sc_core::sc_module {
 	interrupt_gateway *plic = 0;
 	uint32_t irq_number = 0;
+	sc_core::sc_time period = sc_core::sc_time(1, sc_core::SC_MS);
+	uint64_t last_tick = 0;  // number of the last tick that was triggered
 
 	SC_HAS_PROCESS(BasicTimer);
 
@@ -19,9 +24,19 @@ struct BasicTimer : public sc_core::sc_module {
 
 	void run() {
 		while (true) {
-			sc_core::wait(sc_core::sc_time(1, sc_core::SC_MS));
-
-			plic->gateway_trigger_interrupt(irq_number);
+			const sc_core::sc_event *enable = plic->gateway_enable_event();
+			auto now = sc_core::sc_time_stamp();
+
+			if (enable && !plic->gateway_interrupt_enabled(irq_number))
+				sc_core::wait(*enable);
+			else
+				sc_core::wait(sc_core::sc_time::from_value((now.value() / period.value() + 1) * period.value()) - now);
+
+			uint64_t tick = sc_core::sc_time_stamp().value() / period.value();
+			if (tick > last_tick) {
+				last_tick = tick;
+				plic->gateway_trigger_interrupt(irq_number);
+			}
 		}
 	}
 };
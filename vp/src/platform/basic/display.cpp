@@ -6,10 +6,15 @@
  */
 
 #include "display.hpp"
+#include "display_kernels.h"
+#include <linux/futex.h>
 #include <math.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <unistd.h>
+#include <climits>
 
 typedef Framebuffer::Point Point;
 typedef Framebuffer::PointF PointF;
@@ -17,17 +22,28 @@ typedef Framebuffer::Color Color;
 typedef Framebuffer::Frame Frame;
 
 
-Display::Display(sc_module_name) {
+static_assert((Framebuffer::screenWidth * sizeof(Color)) % (1 << Display::BLOCK_SHIFT) == 0,
+              "a block must not span two lines");
+static_assert(Framebuffer::screenWidth / Display::TILE_SIZE == Display::BLOCKS_PER_LINE,
+              "a tile must be one block wide");
+
+Display::Display(sc_module_name) : dirty(3 * BLOCKS_PER_FRAME, 0) {
 	tsock.register_b_transport(this, &Display::transport);
 	createSM();
-	memset(frame.raw, 0, sizeof(Framebuffer));
+	memset(frame.raw, 0, SHMSIZE);
+	update = reinterpret_cast<FrameUpdate *>(frame.raw + sizeof(Framebuffer));
 }
 
 void Display::createSM() {
-	int shmid;
-	if ((shmid = shmget(SHMKEY, sizeof(Framebuffer), IPC_CREAT | 0666)) < 0) {
-		std::cerr << "Could not get " << sizeof(Framebuffer) << " Byte of shared Memory " << int(SHMKEY)
-		          << " for display" << std::endl;
+	int shmid = shmget(SHMKEY, SHMSIZE, IPC_CREAT | 0666);
+	if (shmid < 0 && errno == EINVAL) {
+		// left over by an older version with a smaller layout, replace it
+		if ((shmid = shmget(SHMKEY, 0, 0666)) >= 0 && shmctl(shmid, IPC_RMID, nullptr) == 0)
+			shmid = shmget(SHMKEY, SHMSIZE, IPC_CREAT | 0666);
+	}
+	if (shmid < 0) {
+		std::cerr << "Could not get " << SHMSIZE << " Byte of shared Memory " << int(SHMKEY) << " for display"
+		          << std::endl;
 		perror(NULL);
 		exit(1);
 	}
@@ -48,35 +64,56 @@ void Display::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay
 
 	if (cmd == tlm::TLM_WRITE_COMMAND) {
 		if (addr == offsetof(Framebuffer, command) && len == sizeof(Framebuffer::Command)) {  // apply command
+			const Framebuffer::Parameter &p = frame.buf->parameter;
+			unsigned pixels = 0;
+			sc_core::sc_time per_pixel = pixel_delay;
 			switch (*reinterpret_cast<Framebuffer::Command *>(ptr)) {
 				case Framebuffer::Command::clearAll:
 					memset(frame.raw, 0, sizeof(Framebuffer));
 					frame.buf->activeFrame++;
+					memset(dirty.data(), 0, dirty.size());
+					publishFullUpdate();
 					break;
 				case Framebuffer::Command::fillFrame:
-					fillFrame(frame.buf->parameter.fill.frame, frame.buf->parameter.fill.color);
+					pixels = fillFrame(p.fill.frame, p.fill.color);
 					break;
 				case Framebuffer::Command::applyFrame:
-					frame.buf->activeFrame++;
-					memcpy(&frame.buf->getInactiveFrame(), &frame.buf->getActiveFrame(), sizeof(Frame));
+					applyFrame();
 					break;
 				case Framebuffer::Command::drawLine:
-					drawLine(frame.buf->parameter.line.frame, frame.buf->parameter.line.from,
-					         frame.buf->parameter.line.to, frame.buf->parameter.line.color);
+					pixels = drawLine(p.line.frame, p.line.from, p.line.to, p.line.color);
+					break;
+				case Framebuffer::Command::fillRect:
+					pixels = fillRect(p.rect.frame, p.rect.x, p.rect.y, p.rect.width, p.rect.height, p.rect.color);
+					break;
+				case Framebuffer::Command::copyRect:
+					pixels = copyRect(p.copy.src, p.copy.srcX, p.copy.srcY, p.copy.dst, p.copy.dstX, p.copy.dstY,
+					                  p.copy.width, p.copy.height, p.copy.useKey, p.copy.key);
+					break;
+				case Framebuffer::Command::blendRect:
+					pixels = blendRect(p.copy.src, p.copy.srcX, p.copy.srcY, p.copy.dst, p.copy.dstX, p.copy.dstY,
+					                   p.copy.width, p.copy.height, p.copy.alpha);
+					per_pixel = blend_pixel_delay;
+					break;
+				case Framebuffer::Command::drawBitmap:
+					pixels = drawBitmap(p.bitmap.frame, p.bitmap.x, p.bitmap.y, p.bitmap.width, p.bitmap.height,
+					                    p.bitmap.bitmap, p.bitmap.fg, p.bitmap.bg, p.bitmap.transparent);
 					break;
 				default:
 					cerr << "unknown framebuffer command " << *ptr << endl;
 					sc_assert(false);
 					break;
 			}
+			delay += command_delay + per_pixel * pixels;
 			// reset parameter
 			memset(reinterpret_cast<void *>(&frame.buf->parameter), 0, sizeof(Framebuffer::Parameter));
-		} else if (addr >= offsetof(Framebuffer, parameter) &&
-		           addr + len < offsetof(Framebuffer, parameter) + sizeof(Framebuffer::Parameter)) {  // write the
-			                                                                                          // parameter
+		} else if (addr + len <= planesOffset) {  // write the parameter
 			memcpy(&frame.raw[addr], ptr, len);
-		} else {  // Write the actual framebuffer
+		} else {  // write the pixel planes, usually done through DMI
 			memcpy(&frame.raw[addr], ptr, len);
+			size_t begin = addr > planesOffset ? addr - planesOffset : 0;
+			size_t end = addr + len - planesOffset;
+			memset(&dirty[begin >> BLOCK_SHIFT], 1, ((end - 1) >> BLOCK_SHIFT) - (begin >> BLOCK_SHIFT) + 1);
 		}
 
 	} else if (cmd == tlm::TLM_READ_COMMAND && addr < sizeof(Framebuffer)) {  // read whatever you like
@@ -87,41 +124,263 @@ void Display::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay
 	delay += sc_core::sc_time(len * 5, sc_core::SC_NS);
 }
 
-void Display::fillFrame(Framebuffer::Type type, Color color) {
-	assert(sizeof(Frame) % 8 == 0);
-	assert(8 % sizeof(Color) == 0);
-	uint64_t *rawFrame = reinterpret_cast<uint64_t *>(&frame.buf->getFrame(type).raw);
-	uint_fast32_t steps = sizeof(Frame) / 8;
-	uint64_t wideColor = 0;
-	for (uint_fast8_t i = 0; i * sizeof(Color) < 8; i++) {
-		reinterpret_cast<Color *>(&wideColor)[i] = color;
+MemoryDMI Display::get_dmi(uint64_t start_addr) {
+	MemoryDMI dmi =
+	    MemoryDMI::create_start_size_mapping(&frame.raw[planesOffset], start_addr + planesOffset, planesSize);
+	dmi.set_dirty_map(dirty.data(), BLOCK_SHIFT);
+	return dmi;
+}
+
+void Display::applyFrame() {
+	Frame &drawn = frame.buf->getInactiveFrame();
+	Frame &shown = frame.buf->getActiveFrame();
+	uint8_t *drawnDirty = dirtyMap(drawn);
+	uint8_t *shownDirty = dirtyMap(shown);
+	uint8_t *backgroundDirty = dirtyMap(frame.buf->getBackground());
+
+	frame.buf->activeFrame++;
+
+	// The previously shown frame becomes the drawing frame, it differs from the drawn one only in the blocks written
+	// since the last flip (usually to the drawn frame, rarely to the shown one)
+	uint8_t *src = reinterpret_cast<uint8_t *>(&drawn);
+	uint8_t *dst = reinterpret_cast<uint8_t *>(&shown);
+	static_assert(BLOCKS_PER_FRAME % sizeof(uint64_t) == 0, "dirty maps are scanned in words");
+	for (unsigned w = 0; w < BLOCKS_PER_FRAME; w += sizeof(uint64_t)) {
+		uint64_t drawnWord, shownWord, backgroundWord;
+		memcpy(&drawnWord, drawnDirty + w, sizeof(uint64_t));
+		memcpy(&shownWord, shownDirty + w, sizeof(uint64_t));
+		memcpy(&backgroundWord, backgroundDirty + w, sizeof(uint64_t));
+		if (drawnWord | shownWord) {
+			for (unsigned i = w; i < w + sizeof(uint64_t); i++) {
+				if (drawnDirty[i] | shownDirty[i])
+					memcpy(dst + (i << BLOCK_SHIFT), src + (i << BLOCK_SHIFT), 1 << BLOCK_SHIFT);
+			}
+		}
+		uint64_t changed = drawnWord | shownWord | backgroundWord;
+		memcpy(drawnDirty + w, &changed, sizeof(uint64_t));
+	}
+
+	publishUpdate(drawnDirty);
+	memset(dirty.data(), 0, dirty.size());
+}
+
+void Display::publishUpdate(const uint8_t *changed) {
+	static const unsigned TILES_PER_LINE = BLOCKS_PER_LINE;
+	static const unsigned TILE_LINES = (Framebuffer::screenHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+	std::vector<FrameUpdate::Rect> rects;
+	int open[TILES_PER_LINE];  // rect ending in the previous tile line, by its first column
+	std::fill(open, open + TILES_PER_LINE, -1);
+
+	for (unsigned ty = 0; ty < TILE_LINES; ty++) {
+		unsigned y = ty * TILE_SIZE;
+		unsigned height = y + TILE_SIZE > Framebuffer::screenHeight ? Framebuffer::screenHeight - y : TILE_SIZE;
+
+		bool tiles[TILES_PER_LINE] = {};
+		for (unsigned line = y; line < y + height; line++) {
+			const uint8_t *blocks = &changed[line * BLOCKS_PER_LINE];
+			if (!memchr(blocks, 1, BLOCKS_PER_LINE))
+				continue;
+			for (unsigned tx = 0; tx < TILES_PER_LINE; tx++) tiles[tx] |= blocks[tx];
+		}
+
+		int next[TILES_PER_LINE];
+		std::fill(next, next + TILES_PER_LINE, -1);
+		for (unsigned tx = 0; tx < TILES_PER_LINE;) {
+			if (!tiles[tx]) {
+				tx++;
+				continue;
+			}
+			unsigned first = tx;
+			while (tx < TILES_PER_LINE && tiles[tx]) tx++;
+
+			uint16_t width = (tx - first) * TILE_SIZE;
+			if (open[first] >= 0 && rects[open[first]].width == width) {  // extend the rect above
+				rects[open[first]].height += height;
+				next[first] = open[first];
+			} else {
+				rects.push_back({uint16_t(first * TILE_SIZE), uint16_t(y), width, uint16_t(height)});
+				next[first] = rects.size() - 1;
+			}
+		}
+		std::copy(next, next + TILES_PER_LINE, open);
 	}
-	for (uint_fast32_t i = 0; i < steps; i++) {
-		rawFrame[i] = wideColor;
+
+	if (rects.empty())
+		return;
+
+	if (rects.size() > FrameUpdate::maxRects) {  // report the bounding box instead
+		FrameUpdate::Rect box = rects[0];
+		unsigned right = 0, bottom = 0;
+		for (auto &r : rects) {
+			box.x = std::min(box.x, r.x);
+			box.y = std::min(box.y, r.y);
+			right = std::max<unsigned>(right, r.x + r.width);
+			bottom = std::max<unsigned>(bottom, r.y + r.height);
+		}
+		box.width = right - box.x;
+		box.height = bottom - box.y;
+		rects.assign(1, box);
 	}
+
+	__atomic_store_n(&update->sequence, update->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	update->numRects = rects.size();
+	memcpy(update->rects, rects.data(), rects.size() * sizeof(FrameUpdate::Rect));
+	__atomic_store_n(&update->sequence, update->sequence + 1, __ATOMIC_RELEASE);
+
+	syscall(SYS_futex, &update->sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
 }
 
-void Display::drawLine(Framebuffer::Type type, PointF from, PointF to, Color color) {
+void Display::publishFullUpdate() {
+	std::vector<uint8_t> all(BLOCKS_PER_FRAME, 1);
+	publishUpdate(all.data());
+}
+
+void Display::markRect(Frame &plane, unsigned x, unsigned y, unsigned width, unsigned height) {
+	const unsigned W = Framebuffer::screenWidth, H = Framebuffer::screenHeight;
+	if (x >= W || y >= H || width == 0 || height == 0)
+		return;
+	width = std::min(width, W - x);
+	height = std::min(height, H - y);
+
+	uint8_t *map = dirtyMap(plane);
+	unsigned first = (x * sizeof(Color)) >> BLOCK_SHIFT;
+	unsigned last = ((x + width - 1) * sizeof(Color)) >> BLOCK_SHIFT;
+	for (unsigned line = y; line < y + height; line++)
+		memset(&map[line * BLOCKS_PER_LINE + first], 1, last - first + 1);
+}
+
+unsigned Display::fillFrame(Framebuffer::Type type, Color color) {
+	Frame &plane = frame.buf->getFrame(type);
+	const unsigned pixels = Framebuffer::screenWidth * Framebuffer::screenHeight;
+	display_kernels::fill(&plane.raw[0][0], pixels, color);
+	memset(dirtyMap(plane), 1, BLOCKS_PER_FRAME);
+	return pixels;
+}
+
+unsigned Display::fillRect(Framebuffer::Type type, unsigned x, unsigned y, unsigned width, unsigned height,
+                           Color color) {
+	const unsigned W = Framebuffer::screenWidth, H = Framebuffer::screenHeight;
+	if (x >= W || y >= H)
+		return 0;
+	width = std::min(width, W - x);
+	height = std::min(height, H - y);
+	if (width == 0 || height == 0)
+		return 0;
+
+	Frame &plane = frame.buf->getFrame(type);
+	for (unsigned line = y; line < y + height; line++) display_kernels::fill(&plane.raw[line][x], width, color);
+	markRect(plane, x, y, width, height);
+	return width * height;
+}
+
+template <typename RowFunction>
+unsigned Display::transferRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst,
+                               unsigned dstX, unsigned dstY, unsigned width, unsigned height, RowFunction row) {
+	const unsigned W = Framebuffer::screenWidth, H = Framebuffer::screenHeight;
+	if (srcX >= W || dstX >= W || srcY >= H || dstY >= H)
+		return 0;
+	width = std::min(width, std::min(W - srcX, W - dstX));
+	height = std::min(height, std::min(H - srcY, H - dstY));
+	if (width == 0 || height == 0)
+		return 0;
+
+	Frame &from = frame.buf->getFrame(src);
+	Frame &to = frame.buf->getFrame(dst);
+	// overlapping rects of one frame: the rows are processed away from the overlap, each through the line buffer
+	bool overlap = &from == &to && srcX < dstX + width && dstX < srcX + width && srcY < dstY + height &&
+	               dstY < srcY + height;
+	Color line[Framebuffer::screenWidth];
+
+	for (unsigned i = 0; i < height; i++) {
+		unsigned r = (overlap && dstY > srcY) ? height - 1 - i : i;
+		const Color *s = &from.raw[srcY + r][srcX];
+		if (overlap) {
+			memcpy(line, s, width * sizeof(Color));
+			s = line;
+		}
+		row(&to.raw[dstY + r][dstX], s, width);
+	}
+	markRect(to, dstX, dstY, width, height);
+	return width * height;
+}
+
+unsigned Display::copyRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst,
+                           unsigned dstX, unsigned dstY, unsigned width, unsigned height, bool useKey, Color key) {
+	return transferRect(src, srcX, srcY, dst, dstX, dstY, width, height, [=](Color *d, const Color *s, unsigned n) {
+		if (useKey)
+			display_kernels::copyKeyed(d, s, n, key);
+		else
+			memcpy(d, s, n * sizeof(Color));
+	});
+}
+
+unsigned Display::blendRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst,
+                            unsigned dstX, unsigned dstY, unsigned width, unsigned height, uint8_t alpha) {
+	return transferRect(src, srcX, srcY, dst, dstX, dstY, width, height,
+	                    [=](Color *d, const Color *s, unsigned n) { display_kernels::blend(d, s, n, alpha); });
+}
+
+unsigned Display::drawBitmap(Framebuffer::Type type, unsigned x, unsigned y, unsigned width, unsigned height,
+                             uint64_t bitmap, Color fg, Color bg, bool transparent) {
+	const unsigned W = Framebuffer::screenWidth, H = Framebuffer::screenHeight;
+	if (x >= W || y >= H || width == 0 || height == 0)
+		return 0;
+	unsigned stride = (width + 7) / 8;
+	unsigned visibleWidth = std::min(width, W - x);
+	height = std::min(height, H - y);
+
+	const uint8_t *bits = nullptr;
+	for (auto &e : dmi_ranges) {
+		if (e.contains(bitmap) && uint64_t(stride) * height <= e.get_end() - bitmap) {
+			bits = e.get_mem_ptr_to_global_addr<uint8_t>(bitmap);
+			break;
+		}
+	}
+	if (!bits) {
+		cerr << "framebuffer bitmap at 0x" << hex << bitmap << dec << " is not located in main memory" << endl;
+		return 0;
+	}
+
+	Frame &plane = frame.buf->getFrame(type);
+	for (unsigned r = 0; r < height; r++)
+		display_kernels::expand(&plane.raw[y + r][x], bits + r * stride, visibleWidth, fg, bg, transparent);
+	markRect(plane, x, y, visibleWidth, height);
+	return visibleWidth * height;
+}
+
+unsigned Display::drawLine(Framebuffer::Type type, PointF from, PointF to, Color color) {
+	const float W = Framebuffer::screenWidth, H = Framebuffer::screenHeight;
 	Frame &local = frame.buf->getFrame(type);
+	unsigned pixels = 0;
+	// vertical and horizontal lines are clipped to the screen (also rejects NaN), setPixel clips the others
 	if (from.x == to.x) {  // vertical line
 		if (from.y > to.y)
 			swap(from.y, to.y);
-		uint16_t intFromX = from.x;
-		uint16_t intToY = to.y;
-		for (uint16_t y = from.y; y <= intToY; y++) {
-			local.raw[y][intFromX] = color;
+		if (!(from.x >= 0 && from.x < W && to.y >= 0 && from.y < H))
+			return 0;
+		unsigned intFromX = from.x;
+		unsigned intFromY = std::max(from.y, 0.f);
+		unsigned intToY = std::min(to.y, H - 1);
+		for (unsigned y = intFromY; y <= intToY; y++) {
+			setPixel(local, intFromX, y, color);
+			pixels++;
 		}
-		return;
+		return pixels;
 	}
 	if (from.y == to.y) {  // horizontal line, the fastest
 		if (from.x > to.x)
 			swap(from.x, to.x);
-		uint16_t intFromY = from.y;
-		uint16_t intToX = to.x;
-		for (uint16_t x = from.x; x <= intToX; x++) {
-			local.raw[intFromY][x] = color;
-		}
-		return;
+		if (!(from.y >= 0 && from.y < H && to.x >= 0 && from.x < W))
+			return 0;
+		unsigned intFromX = std::max(from.x, 0.f);
+		unsigned intFromY = from.y;
+		unsigned intToX = std::min(to.x, W - 1);
+		pixels = intToX - intFromX + 1;
+		display_kernels::fill(&local.raw[intFromY][intFromX], pixels, color);
+		markRect(local, intFromX, intFromY, pixels, 1);
+		return pixels;
 	}
 
 	// Bresenham's line algorithm
@@ -145,11 +404,11 @@ void Display::drawLine(Framebuffer::Type type, PointF from, PointF to, Color col
 
 	const int maxX = (int)to.x;
 
-	for (int x = (int)from.x; x < maxX; x++) {
+	for (int x = (int)from.x; x < maxX; x++, pixels++) {
 		if (steep) {
-			local.raw[x][y] = color;
+			setPixel(local, y, x, color);
 		} else {
-			local.raw[y][x] = color;
+			setPixel(local, x, y, color);
 		}
 
 		error -= dy;
@@ -158,4 +417,5 @@ void Display::drawLine(Framebuffer::Type type, PointF from, PointF to, Color col
 			error += dx;
 		}
 	}
+	return pixels;
 }
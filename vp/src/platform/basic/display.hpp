@@ -9,14 +9,26 @@
 
 #include <tlm_utils/simple_target_socket.h>
 #include <systemc>
+#include <vector>
 #include "../../../../env/basic/vp-display/framebuffer.h"
+#include "core/common/dmi.h"
 
 using namespace std;
 using namespace sc_core;
 using namespace tlm_utils;
 
+/* The pixel planes (both frames and the background) are accessed directly by the cores and the DMA (see get_dmi),
+ * only the command and parameter area goes through transport. Writes are tracked in blocks of 64 bytes, i.e. 32
+ * pixels of a line. Presenting a frame swaps the frame index, copies only the written blocks into the new drawing
+ * frame and publishes the changed 32x32 pixel tiles to the viewer (see FrameUpdate). */
 struct Display : public sc_core::sc_module {
 	static const size_t addressRange = sizeof(Framebuffer);
+	static const size_t planesOffset = offsetof(Framebuffer, frames);
+	static const size_t planesSize = 3 * sizeof(Framebuffer::Frame);
+	static const unsigned BLOCK_SHIFT = 6;
+	static const unsigned BLOCKS_PER_LINE = (Framebuffer::screenWidth * sizeof(Framebuffer::Color)) >> BLOCK_SHIFT;
+	static const unsigned BLOCKS_PER_FRAME = sizeof(Framebuffer::Frame) >> BLOCK_SHIFT;
+	static const unsigned TILE_SIZE = 32;  // pixels, equals the width of a block
 
 	simple_target_socket<Display> tsock;
 
@@ -24,13 +36,57 @@ struct Display : public sc_core::sc_module {
 		uint8_t* raw;
 		Framebuffer* buf;
 	} frame;
+	FrameUpdate* update;
+
+	std::vector<uint8_t> dirty;  // one byte per block of all planes, written through the DMI ranges as well
+
+	std::vector<MemoryDMI> dmi_ranges;  // main memory, the source of drawBitmap
+
+	// modelled execution time of the 2D engine
+	sc_core::sc_time command_delay = sc_core::sc_time(100, sc_core::SC_NS);
+	sc_core::sc_time pixel_delay = sc_core::sc_time(1, sc_core::SC_NS);
+	sc_core::sc_time blend_pixel_delay = sc_core::sc_time(2, sc_core::SC_NS);
 
 	void createSM();
 
 	Display(sc_module_name);
 	void transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay);
 
-	// graphics acceleration functions
-	void fillFrame(Framebuffer::Type frame, Framebuffer::Color color);
-	void drawLine(Framebuffer::Type frame, Framebuffer::PointF from, Framebuffer::PointF to, Framebuffer::Color color);
+	/* DMI range of the pixel planes, *start_addr* is the base address of the display */
+	MemoryDMI get_dmi(uint64_t start_addr);
+
+	// graphics acceleration functions, return the number of pixels processed
+	unsigned fillFrame(Framebuffer::Type frame, Framebuffer::Color color);
+	unsigned drawLine(Framebuffer::Type frame, Framebuffer::PointF from, Framebuffer::PointF to,
+	                  Framebuffer::Color color);
+	unsigned fillRect(Framebuffer::Type frame, unsigned x, unsigned y, unsigned width, unsigned height,
+	                  Framebuffer::Color color);
+	unsigned copyRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst, unsigned dstX,
+	                  unsigned dstY, unsigned width, unsigned height, bool useKey, Framebuffer::Color key);
+	unsigned blendRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst, unsigned dstX,
+	                   unsigned dstY, unsigned width, unsigned height, uint8_t alpha);
+	unsigned drawBitmap(Framebuffer::Type frame, unsigned x, unsigned y, unsigned width, unsigned height,
+	                    uint64_t bitmap, Framebuffer::Color fg, Framebuffer::Color bg, bool transparent);
+	void applyFrame();
+
+   private:
+	uint8_t* dirtyMap(Framebuffer::Frame& plane) {
+		return &dirty[(reinterpret_cast<uint8_t*>(&plane) - &frame.raw[planesOffset]) >> BLOCK_SHIFT];
+	}
+
+	void setPixel(Framebuffer::Frame& plane, unsigned x, unsigned y, Framebuffer::Color color) {
+		if (x >= Framebuffer::screenWidth || y >= Framebuffer::screenHeight)
+			return;
+		plane.raw[y][x] = color;
+		dirtyMap(plane)[y * BLOCKS_PER_LINE + ((x * sizeof(Framebuffer::Color)) >> BLOCK_SHIFT)] = 1;
+	}
+
+	void markRect(Framebuffer::Frame& plane, unsigned x, unsigned y, unsigned width, unsigned height);
+	/* copyRect and blendRect, the row function is called for each clipped row */
+	template <typename RowFunction>
+	unsigned transferRect(Framebuffer::Type src, unsigned srcX, unsigned srcY, Framebuffer::Type dst, unsigned dstX,
+	                      unsigned dstY, unsigned width, unsigned height, RowFunction row);
+
+	void publishUpdate(const uint8_t* changed);
+	void publishFullUpdate();
 };
@@ -0,0 +1,220 @@
+#include "display_kernels.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#define DISPLAY_SIMD 1
+#include <immintrin.h>
+#else
+#define DISPLAY_SIMD 0
+#endif
+
+namespace display_kernels {
+
+namespace {
+
+// 0..255 to 0..256, such that 255 selects the source
+inline int blendFactor(uint8_t alpha) {
+	return alpha + (alpha >> 7);
+}
+
+inline Color blendPixel(Color d, Color s, int a) {
+	Color r = 0;
+	for (unsigned sh = 0; sh <= 8; sh += 4) {
+		int cs = (s >> sh) & 0xF;
+		int cd = (d >> sh) & 0xF;
+		r |= ((cd + (((cs - cd) * a) >> 8)) & 0xF) << sh;
+	}
+	return r;
+}
+
+void fillScalar(Color *dst, unsigned n, Color color) {
+	for (unsigned i = 0; i < n; i++) dst[i] = color;
+}
+
+void copyKeyedScalar(Color *dst, const Color *src, unsigned n, Color key) {
+	for (unsigned i = 0; i < n; i++) {
+		if (src[i] != key)
+			dst[i] = src[i];
+	}
+}
+
+void blendScalar(Color *dst, const Color *src, unsigned n, uint8_t alpha) {
+	int a = blendFactor(alpha);
+	for (unsigned i = 0; i < n; i++) dst[i] = blendPixel(dst[i], src[i], a);
+}
+
+void expandScalar(Color *dst, const uint8_t *bitmap, unsigned n, Color fg, Color bg, bool transparent) {
+	for (unsigned i = 0; i < n; i++) {
+		if (bitmap[i / 8] & (0x80 >> (i % 8)))
+			dst[i] = fg;
+		else if (!transparent)
+			dst[i] = bg;
+	}
+}
+
+#if DISPLAY_SIMD
+
+void fillSSE2(Color *dst, unsigned n, Color color) {
+	__m128i v = _mm_set1_epi16(color);
+	unsigned i = 0;
+	for (; i + 8 <= n; i += 8) _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+	fillScalar(dst + i, n - i, color);
+}
+
+void copyKeyedSSE2(Color *dst, const Color *src, unsigned n, Color key) {
+	__m128i k = _mm_set1_epi16(key);
+	unsigned i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+		__m128i skip = _mm_cmpeq_epi16(s, k);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+		                 _mm_or_si128(_mm_and_si128(skip, d), _mm_andnot_si128(skip, s)));
+	}
+	copyKeyedScalar(dst + i, src + i, n - i, key);
+}
+
+void blendSSE2(Color *dst, const Color *src, unsigned n, uint8_t alpha) {
+	__m128i a = _mm_set1_epi16(blendFactor(alpha));
+	__m128i mask = _mm_set1_epi16(0xF);
+	unsigned i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+		__m128i r = _mm_setzero_si128();
+		for (int sh = 0; sh <= 8; sh += 4) {
+			__m128i cs = _mm_and_si128(_mm_srli_epi16(s, sh), mask);
+			__m128i cd = _mm_and_si128(_mm_srli_epi16(d, sh), mask);
+			__m128i c = _mm_add_epi16(cd, _mm_srai_epi16(_mm_mullo_epi16(_mm_sub_epi16(cs, cd), a), 8));
+			r = _mm_or_si128(r, _mm_slli_epi16(_mm_and_si128(c, mask), sh));
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), r);
+	}
+	blendScalar(dst + i, src + i, n - i, alpha);
+}
+
+void expandSSE2(Color *dst, const uint8_t *bitmap, unsigned n, Color fg, Color bg, bool transparent) {
+	__m128i bits = _mm_set_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);  // first pixel in the lowest lane
+	__m128i f = _mm_set1_epi16(fg);
+	__m128i b = _mm_set1_epi16(bg);
+	unsigned i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i set = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(bitmap[i / 8]), bits), bits);
+		__m128i other = transparent ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i)) : b;
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+		                 _mm_or_si128(_mm_and_si128(set, f), _mm_andnot_si128(set, other)));
+	}
+	expandScalar(dst + i, bitmap + i / 8, n - i, fg, bg, transparent);
+}
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 void fillAVX2(Color *dst, unsigned n, Color color) {
+	__m256i v = _mm256_set1_epi16(color);
+	unsigned i = 0;
+	for (; i + 16 <= n; i += 16) _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), v);
+	_mm256_zeroupper();  // the SSE2 version finishes the row
+	fillSSE2(dst + i, n - i, color);
+}
+
+AVX2 void copyKeyedAVX2(Color *dst, const Color *src, unsigned n, Color key) {
+	__m256i k = _mm256_set1_epi16(key);
+	unsigned i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		__m256i skip = _mm256_cmpeq_epi16(s, k);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+		                    _mm256_or_si256(_mm256_and_si256(skip, d), _mm256_andnot_si256(skip, s)));
+	}
+	_mm256_zeroupper();  // the SSE2 version finishes the row
+	copyKeyedSSE2(dst + i, src + i, n - i, key);
+}
+
+AVX2 void blendAVX2(Color *dst, const Color *src, unsigned n, uint8_t alpha) {
+	__m256i a = _mm256_set1_epi16(blendFactor(alpha));
+	__m256i mask = _mm256_set1_epi16(0xF);
+	unsigned i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		__m256i r = _mm256_setzero_si256();
+		for (int sh = 0; sh <= 8; sh += 4) {
+			__m256i cs = _mm256_and_si256(_mm256_srli_epi16(s, sh), mask);
+			__m256i cd = _mm256_and_si256(_mm256_srli_epi16(d, sh), mask);
+			__m256i c =
+			    _mm256_add_epi16(cd, _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(cs, cd), a), 8));
+			r = _mm256_or_si256(r, _mm256_slli_epi16(_mm256_and_si256(c, mask), sh));
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), r);
+	}
+	_mm256_zeroupper();  // the SSE2 version finishes the row
+	blendSSE2(dst + i, src + i, n - i, alpha);
+}
+
+AVX2 void expandAVX2(Color *dst, const uint8_t *bitmap, unsigned n, Color fg, Color bg, bool transparent) {
+	// two bitmap bytes per vector, the first one in the upper half of the 16 bit word
+	__m256i bits = _mm256_set_epi16(0x0001, 0x0002, 0x0004, 0x0008, 0x0010, 0x0020, 0x0040, 0x0080, 0x0100, 0x0200,
+	                                0x0400, 0x0800, 0x1000, 0x2000, 0x4000, int16_t(0x8000));
+	__m256i f = _mm256_set1_epi16(fg);
+	__m256i b = _mm256_set1_epi16(bg);
+	unsigned i = 0;
+	for (; i + 16 <= n; i += 16) {
+		int16_t word = (bitmap[i / 8] << 8) | bitmap[i / 8 + 1];
+		__m256i set = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16(word), bits), bits);
+		__m256i other = transparent ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i)) : b;
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+		                    _mm256_or_si256(_mm256_and_si256(set, f), _mm256_andnot_si256(set, other)));
+	}
+	_mm256_zeroupper();  // the SSE2 version finishes the row
+	expandSSE2(dst + i, bitmap + i / 8, n - i, fg, bg, transparent);
+}
+
+#undef AVX2
+
+#endif  // DISPLAY_SIMD
+
+struct Implementation {
+	const char *name;
+	void (*fill)(Color *, unsigned, Color);
+	void (*copyKeyed)(Color *, const Color *, unsigned, Color);
+	void (*blend)(Color *, const Color *, unsigned, uint8_t);
+	void (*expand)(Color *, const uint8_t *, unsigned, Color, Color, bool);
+};
+
+const Implementation &selected() {
+	static const Implementation impl = []() -> Implementation {
+#if DISPLAY_SIMD
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return {"avx2", fillAVX2, copyKeyedAVX2, blendAVX2, expandAVX2};
+		return {"sse2", fillSSE2, copyKeyedSSE2, blendSSE2, expandSSE2};
+#else
+		return {"scalar", fillScalar, copyKeyedScalar, blendScalar, expandScalar};
+#endif
+	}();
+	return impl;
+}
+
+}  // namespace
+
+void fill(Color *dst, unsigned n, Color color) {
+	selected().fill(dst, n, color);
+}
+
+void copyKeyed(Color *dst, const Color *src, unsigned n, Color key) {
+	selected().copyKeyed(dst, src, n, key);
+}
+
+void blend(Color *dst, const Color *src, unsigned n, uint8_t alpha) {
+	selected().blend(dst, src, n, alpha);
+}
+
+void expand(Color *dst, const uint8_t *bitmap, unsigned n, Color fg, Color bg, bool transparent) {
+	selected().expand(dst, bitmap, n, fg, bg, transparent);
+}
+
+const char *implementation() {
+	return selected().name;
+}
+
+}  // namespace display_kernels
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Row kernels of the 2D engine of the Display, pixels are 16 bit RGB444 (the upper nibble is unused).
+ *
+ * On x86 hosts SSE2 is used, AVX2 if the host supports it (selected at runtime), the scalar versions otherwise and
+ * for the remainder of each row. All kernels produce identical results. */
+namespace display_kernels {
+
+typedef uint16_t Color;
+
+void fill(Color *dst, unsigned n, Color color);
+/* *src* pixels equal to *key* are skipped, *dst* and *src* must not overlap */
+void copyKeyed(Color *dst, const Color *src, unsigned n, Color key);
+/* per channel dst += (src - dst) * alpha / 255 (computed with a shift, exact for 0 and 255), no overlap allowed */
+void blend(Color *dst, const Color *src, unsigned n, uint8_t alpha);
+/* *n* pixels from the bits of *bitmap* (MSB first), cleared bits are *bg* or left untouched if *transparent* */
+void expand(Color *dst, const uint8_t *bitmap, unsigned n, Color fg, Color bg, bool transparent);
+
+/* name of the selected implementation */
+const char *implementation();
+
+}  // namespace display_kernels
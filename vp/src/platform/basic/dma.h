@@ -6,9 +6,28 @@
 #include <tlm_utils/simple_initiator_socket.h>
 #include <tlm_utils/simple_target_socket.h>
 
-#include <unordered_map>
-#include <array>
+#include <stddef.h>
+#include <string.h>
 
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "core/common/bus_lock_if.h"
+#include "core/common/dmi.h"
+#include "core/common/irq_if.h"
+
+/* DMA engine with NUM_CHANNELS independent register sets, channel 0 is located at the original register addresses.
+ * Writing OP starts the channel, either with the single operation described by its registers or, with OP_CHAIN set,
+ * with a chain of descriptors in memory (scatter-gather). Completion is signaled with one interrupt per started
+ * channel and the DONE bit of its STAT register.
+ *
+ * Transfers between two *dmi_ranges* are performed with a single host call each, the modelled transfer time (the
+ * same as for the TLM path, i.e. per BURST_SIZE bytes and memory access) is annotated at once. All other transfers
+ * use the TLM socket in BURST_SIZE chunks. In both cases the engine waits until no hart holds the bus lock, i.e. an
+ * LR/SC sequence is never interleaved with a DMA access. */
 struct SimpleDMA : public sc_core::sc_module {
 	tlm_utils::simple_initiator_socket<SimpleDMA> isock;
 	tlm_utils::simple_target_socket<SimpleDMA> tsock;
@@ -16,15 +35,17 @@ struct SimpleDMA : public sc_core::sc_module {
 	interrupt_gateway *plic = 0;
 	uint32_t irq_number = 0;
 
-	std::array<uint8_t, 64> buffer;
+	// optional, memories the engine accesses directly
+	std::vector<MemoryDMI> dmi_ranges;
+	std::shared_ptr<bus_lock_if> bus_lock;
+	sc_core::sc_time dmi_burst_delay = sc_core::sc_time(10, sc_core::SC_NS);
 
-	uint32_t src = 0;
-	uint32_t dst = 0;
-	uint32_t len = 0;
-	uint32_t op = 0;
-	uint32_t stat = 0;
+	static constexpr unsigned NUM_CHANNELS = 4;
+	static constexpr unsigned BURST_SIZE = 64;
+	static constexpr unsigned MAX_CHAIN_LENGTH = 4096;  // longer chains (e.g. cyclic ones) fail with STAT_ERROR
 
-	std::unordered_map<uint64_t, uint32_t *> addr_to_reg;
+	std::array<uint8_t, BURST_SIZE> buffer;
+	std::array<uint8_t, BURST_SIZE> buffer2;
 
 	enum {
 		OP_NOP = 0,
@@ -33,6 +54,8 @@ struct SimpleDMA : public sc_core::sc_module {
 		OP_MEMCMP = 3,
 		OP_MEMCHR = 4,
 		OP_MEMMOVE = 5,
+		OP_MASK = 0xff,
+		OP_CHAIN = 1u << 31,  // DESC holds the address of the first descriptor
 	};
 
 	enum {
@@ -41,8 +64,45 @@ struct SimpleDMA : public sc_core::sc_module {
 		LEN_ADDR = 8,
 		OP_ADDR = 12,
 		STAT_ADDR = 16,
+		VALUE_ADDR = 20,   // fill byte of OP_MEMSET, searched byte of OP_MEMCHR
+		RESULT_ADDR = 24,  // OP_MEMCMP: sign of the first difference, OP_MEMCHR: address of the match or 0
+		DESC_ADDR = 28,
+		CHANNEL_SIZE = 32,
+	};
+
+	enum {
+		STAT_BUSY = 1 << 0,
+		STAT_DONE = 1 << 1,   // cleared by writing STAT
+		STAT_ERROR = 1 << 2,  // unknown operation or too long chain, cleared by writing STAT
 	};
 
+	/* descriptor of the chained mode, the result is written back into the descriptor */
+	struct Descriptor {
+		uint32_t src;
+		uint32_t dst;
+		uint32_t len;
+		uint32_t op;
+		uint32_t value;
+		uint32_t result;
+		uint32_t next;  // 0 terminates the chain
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Descriptor) == 32, "descriptor layout");
+
+	struct Channel {
+		uint32_t src = 0;
+		uint32_t dst = 0;
+		uint32_t len = 0;
+		uint32_t op = 0;
+		uint32_t stat = 0;
+		uint32_t value = 0;
+		uint32_t result = 0;
+		uint32_t desc = 0;
+	};
+
+	std::array<Channel, NUM_CHANNELS> channels;
+	std::deque<unsigned> pending;  // started channels, served in order
+
 	sc_core::sc_event run_event;
 
 	SC_HAS_PROCESS(SimpleDMA);
@@ -51,66 +111,193 @@ struct SimpleDMA : public sc_core::sc_module {
 		tsock.register_b_transport(this, &SimpleDMA::transport);
 
 		SC_THREAD(run);
+	}
+
+	/* Returns the host pointer of [addr, addr + n) if it is located within a single DMI range. */
+	MemoryDMI *find_dmi(uint64_t addr, uint64_t n) {
+		for (auto &e : dmi_ranges) {
+			if (e.contains(addr) && n <= e.get_end() - addr)
+				return &e;
+		}
+		return nullptr;
+	}
 
-		addr_to_reg = {
-		    {SRC_ADDR, &src},
-		    {DST_ADDR, &dst},
-		    {LEN_ADDR, &len},
-		    {OP_ADDR, &op},
-		};
+	/* modelled time of *n* bytes of direct accesses, see class comment */
+	sc_core::sc_time dmi_delay(MemoryDMI *e, uint64_t n, bool write) {
+		uint64_t bursts = (n + BURST_SIZE - 1) / BURST_SIZE;
+		sc_core::sc_time t = dmi_burst_delay * (double)bursts;
+		if (e->has_latency())
+			t += write ? e->get_write_latency(n) : e->get_read_latency(n);
+		return t;
 	}
 
-	void _copy_block(uint32_t off, uint32_t n) {
-		do_transaction(tlm::TLM_READ_COMMAND, src + off, &buffer[0], n);
-		do_transaction(tlm::TLM_WRITE_COMMAND, dst + off, &buffer[0], n);
+	static uint32_t burst_length(uint32_t remaining) {
+		return remaining < BURST_SIZE ? remaining : BURST_SIZE;
 	}
 
-	void _perform_memcpy() {
-		auto n = len;
-		uint32_t off = 0;
+	void wait_for_bus() {
+		if (bus_lock)
+			bus_lock->wait_until_unlocked();
+	}
 
-		while (n > buffer.size()) {
-			_copy_block(off, buffer.size());
-			n -= buffer.size();
-			off += buffer.size();
+	/* Executes a single operation, returns false for unknown operations. */
+	bool execute(uint32_t op, uint32_t src, uint32_t dst, uint32_t len, uint8_t value, uint32_t &result,
+	             sc_core::sc_time &delay) {
+		if (len == 0 && op != OP_NOP && op <= OP_MEMMOVE) {
+			result = 0;
+			return true;
 		}
 
-		_copy_block(off, n);
+		MemoryDMI *s = nullptr, *d = nullptr;
+
+		switch (op) {
+			case OP_NOP:
+				return true;
+
+			case OP_MEMCPY:
+			case OP_MEMMOVE:
+				s = find_dmi(src, len);
+				d = find_dmi(dst, len);
+				if (s && d) {
+					wait_for_bus();
+					// memmove for both, as software might pass overlapping buffers to OP_MEMCPY as well
+					memmove(d->get_mem_ptr_to_global_addr<uint8_t>(dst), s->get_mem_ptr_to_global_addr<uint8_t>(src),
+					        len);
+					if (d->tracks_writes())
+						d->mark_dirty(dst, len);
+					delay += dmi_delay(s, len, false) + dmi_delay(d, len, true);
+				} else {
+					tlm_move(src, dst, len, delay);
+				}
+				return true;
+
+			case OP_MEMSET:
+				d = find_dmi(dst, len);
+				if (d) {
+					wait_for_bus();
+					memset(d->get_mem_ptr_to_global_addr<uint8_t>(dst), value, len);
+					if (d->tracks_writes())
+						d->mark_dirty(dst, len);
+					delay += dmi_delay(d, len, true);
+				} else {
+					buffer.fill(value);
+					for (uint32_t off = 0; off < len; off += BURST_SIZE)
+						do_transaction(tlm::TLM_WRITE_COMMAND, dst + off, &buffer[0], burst_length(len - off),
+						               delay);
+				}
+				return true;
+
+			case OP_MEMCMP:
+				s = find_dmi(src, len);
+				d = find_dmi(dst, len);
+				if (s && d) {
+					wait_for_bus();
+					int r = memcmp(s->get_mem_ptr_to_global_addr<uint8_t>(src),
+					               d->get_mem_ptr_to_global_addr<uint8_t>(dst), len);
+					result = (r > 0) - (r < 0);
+					delay += dmi_delay(s, len, false) + dmi_delay(d, len, false);
+				} else {
+					result = 0;
+					for (uint32_t off = 0; off < len && result == 0; off += BURST_SIZE) {
+						uint32_t n = burst_length(len - off);
+						do_transaction(tlm::TLM_READ_COMMAND, src + off, &buffer[0], n, delay);
+						do_transaction(tlm::TLM_READ_COMMAND, dst + off, &buffer2[0], n, delay);
+						int r = memcmp(&buffer[0], &buffer2[0], n);
+						result = (r > 0) - (r < 0);
+					}
+				}
+				return true;
+
+			case OP_MEMCHR:
+				s = find_dmi(src, len);
+				if (s) {
+					wait_for_bus();
+					const uint8_t *p = s->get_mem_ptr_to_global_addr<uint8_t>(src);
+					const uint8_t *m = (const uint8_t *)memchr(p, value, len);
+					// only the bytes up to the match are read
+					uint32_t n = m ? (m - p) + 1 : len;
+					result = m ? src + (m - p) : 0;
+					delay += dmi_delay(s, n, false);
+				} else {
+					result = 0;
+					for (uint32_t off = 0; off < len; off += BURST_SIZE) {
+						uint32_t n = burst_length(len - off);
+						do_transaction(tlm::TLM_READ_COMMAND, src + off, &buffer[0], n, delay);
+						const uint8_t *m = (const uint8_t *)memchr(&buffer[0], value, n);
+						if (m) {
+							result = src + off + (m - &buffer[0]);
+							break;
+						}
+					}
+				}
+				return true;
+
+			default:
+				return false;
+		}
 	}
 
-	void run() {
-		while (true) {
-			sc_core::wait(run_event);
+	/* Chunked copy through the TLM socket, copies backwards if the destination overlaps the end of the source. */
+	void tlm_move(uint32_t src, uint32_t dst, uint32_t len, sc_core::sc_time &delay) {
+		bool backwards = dst > src && dst - src < len;
+		uint32_t off = backwards ? len : 0;
+		uint32_t remaining = len;
+
+		while (remaining > 0) {
+			uint32_t n = burst_length(remaining);
+			if (backwards)
+				off -= n;
+			do_transaction(tlm::TLM_READ_COMMAND, src + off, &buffer[0], n, delay);
+			do_transaction(tlm::TLM_WRITE_COMMAND, dst + off, &buffer[0], n, delay);
+			if (!backwards)
+				off += n;
+			remaining -= n;
+		}
+	}
+
+	/* Executes all descriptors of a chain, returns false if any of them is invalid or the chain holds more than
+	 * MAX_CHAIN_LENGTH descriptors. */
+	bool execute_chain(uint32_t addr, sc_core::sc_time &delay) {
+		for (unsigned n = 0; addr != 0; ++n) {
+			if (n == MAX_CHAIN_LENGTH)
+				return false;
 
-			switch (op) {
-				case OP_NOP:
-					break;
+			Descriptor desc;
+			do_transaction(tlm::TLM_READ_COMMAND, addr, (uint8_t *)&desc, sizeof(desc), delay);
 
-				case OP_MEMCPY:
-					_perform_memcpy();
-					break;
+			if (!execute(desc.op, desc.src, desc.dst, desc.len, desc.value, desc.result, delay))
+				return false;
 
-				case OP_MEMSET:
-					assert(false && "not implemented");
-					break;
+			if (desc.op == OP_MEMCMP || desc.op == OP_MEMCHR)
+				do_transaction(tlm::TLM_WRITE_COMMAND, addr + offsetof(Descriptor, result), (uint8_t *)&desc.result,
+				               sizeof(desc.result), delay);
+			addr = desc.next;
+		}
+		return true;
+	}
+
+	void run() {
+		while (true) {
+			sc_core::wait(run_event);
 
-				case OP_MEMCMP:
-					assert(false && "not implemented");
-					break;
+			while (!pending.empty()) {
+				Channel &c = channels[pending.front()];
+				pending.pop_front();
 
-				case OP_MEMCHR:
-					assert(false && "not implemented");
-					break;
+				// the modelled time of the whole operation is annotated and waited for at once
+				sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
+				bool ok;
+				if (c.op & OP_CHAIN)
+					ok = execute_chain(c.desc, delay);
+				else
+					ok = execute(c.op & OP_MASK, c.src, c.dst, c.len, c.value, c.result, delay);
 
-				case OP_MEMMOVE:
-					assert(false && "not implemented");
-					break;
+				if (delay != sc_core::SC_ZERO_TIME)
+					sc_core::wait(delay);
 
-				default:
-					assert(false && "unknown operation requested by software");
+				c.stat = (c.stat & ~STAT_BUSY) | STAT_DONE | (ok ? 0 : STAT_ERROR);
+				plic->gateway_trigger_interrupt(irq_number);
 			}
-
-			plic->gateway_trigger_interrupt(irq_number);
 		}
 	}
 
@@ -121,30 +308,67 @@ struct SimpleDMA : public sc_core::sc_module {
 		auto ptr = trans.get_data_ptr();
 
 		assert(len == 4);  // NOTE: only allow to read/write whole register
-
-		auto it = addr_to_reg.find(addr);
-		assert(it != addr_to_reg.end());  // access to non-mapped address
+		assert(addr % 4 == 0);
+
+		unsigned ch = addr / CHANNEL_SIZE;
+		assert(ch < NUM_CHANNELS);  // access to non-mapped address
+		Channel &c = channels[ch];
+
+		uint32_t *reg = nullptr;
+		switch (addr % CHANNEL_SIZE) {
+			case SRC_ADDR:
+				reg = &c.src;
+				break;
+			case DST_ADDR:
+				reg = &c.dst;
+				break;
+			case LEN_ADDR:
+				reg = &c.len;
+				break;
+			case OP_ADDR:
+				reg = &c.op;
+				break;
+			case STAT_ADDR:
+				reg = &c.stat;
+				break;
+			case VALUE_ADDR:
+				reg = &c.value;
+				break;
+			case RESULT_ADDR:
+				reg = &c.result;
+				break;
+			case DESC_ADDR:
+				reg = &c.desc;
+				break;
+		}
 
 		// actual read/write
 		if (cmd == tlm::TLM_READ_COMMAND) {
-			*((uint32_t *)ptr) = *it->second;
+			*((uint32_t *)ptr) = *reg;
 		} else if (cmd == tlm::TLM_WRITE_COMMAND) {
-			*it->second = *((uint32_t *)ptr);
+			if (c.stat & STAT_BUSY)
+				return;  // registers of a running channel are read-only
+
+			if (reg == &c.stat)
+				c.stat = 0;
+			else
+				*reg = *((uint32_t *)ptr);
 		} else {
 			assert(false && "unsupported tlm command for dma access");
 		}
 
 		// post read/write actions
-		if ((cmd == tlm::TLM_WRITE_COMMAND) && (addr == OP_ADDR)) {
+		if ((cmd == tlm::TLM_WRITE_COMMAND) && (reg == &c.op)) {
+			c.stat = STAT_BUSY;
+			pending.push_back(ch);
 			run_event.notify(sc_core::sc_time(10, sc_core::SC_NS));
 		}
 
 		(void)delay;  // zero delay
 	}
 
-	void do_transaction(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, unsigned num_bytes) {
-		sc_core::sc_time delay = sc_core::SC_ZERO_TIME;
-
+	void do_transaction(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, unsigned num_bytes,
+	                    sc_core::sc_time &delay) {
 		tlm::tlm_generic_payload trans;
 		trans.set_command(cmd);
 		trans.set_address(addr);
@@ -152,9 +376,6 @@ struct SimpleDMA : public sc_core::sc_module {
 		trans.set_data_length(num_bytes);
 
 		isock->b_transport(trans, delay);
-
-		if (delay != sc_core::SC_ZERO_TIME)
-			sc_core::wait(delay);
 	}
 };
 
@@ -17,6 +17,8 @@
 #include <net/if.h>
 //#include <linux/if_ether.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 
 #include <ifaddrs.h>
@@ -178,10 +180,9 @@ printHex:
 	cout.flags(f);
 }
 
-EthernetDevice::EthernetDevice(sc_core::sc_module_name, uint32_t irq_number, uint8_t *mem, std::string clonedev)
-    : irq_number(irq_number), mem(mem) {
+EthernetDevice::EthernetDevice(sc_core::sc_module_name, uint32_t irq_number, std::string clonedev)
+    : irq_number(irq_number) {
 	tsock.register_b_transport(this, &EthernetDevice::transport);
-	SC_THREAD(run);
 
 	router
 	    .add_register_bank({
@@ -199,7 +200,27 @@ EthernetDevice::EthernetDevice(sc_core::sc_module_name, uint32_t irq_number, uin
 
 	if (!disabled) {
 		init_network(clonedev);
+
+		rx_event.reset(new AsyncEvent());
+		SYS_CHECK(stop_efd = eventfd(0, EFD_CLOEXEC), "eventfd");
+		rx_thread = new std::thread(&EthernetDevice::receive, this);
+
+		SC_THREAD(run);
+	}
+}
+
+EthernetDevice::~EthernetDevice() {
+	if (rx_thread) {
+		uint64_t one = 1;
+		if (write(stop_efd, &one, sizeof(one)) == sizeof(one))
+			rx_thread->join();
+		else
+			rx_thread->detach();
+		delete rx_thread;
+		close(stop_efd);
 	}
+	if (sockfd > 0)
+		close(sockfd);
 }
 
 void EthernetDevice::init_network(std::string clonedev) {
@@ -240,9 +261,25 @@ void EthernetDevice::init_network(std::string clonedev) {
 	fcntl(sockfd, F_SETFL, O_NONBLOCK);
 }
 
-void EthernetDevice::send_raw_frame() {
+void EthernetDevice::dma_transfer(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, unsigned num_bytes,
+                                  sc_core::sc_time &delay) {
+	tlm::tlm_generic_payload trans;
+	trans.set_command(cmd);
+	trans.set_address(addr);
+	trans.set_data_ptr(data);
+	trans.set_data_length(num_bytes);
+	trans.set_response_status(tlm::TLM_OK_RESPONSE);
+
+	isock->b_transport(trans, delay);
+
+	if (trans.is_response_error())
+		throw runtime_error("[ethernet] DMA access failed at address " + to_string(addr));
+}
+
+void EthernetDevice::send_raw_frame(sc_core::sc_time &delay) {
+	assert(send_size <= FRAME_SIZE);
 	uint8_t sendbuf[send_size < 60 ? 60 : send_size];
-	memcpy(sendbuf, &mem[send_src - 0x80000000], send_size);
+	dma_transfer(tlm::TLM_READ_COMMAND, send_src, sendbuf, send_size, delay);
 	if (send_size < 60) {
 		memset(&sendbuf[send_size], 0, 60 - send_size);
 		send_size = 60;
@@ -312,32 +349,64 @@ bool EthernetDevice::isPacketForUs(uint8_t *packet, ssize_t) {
 	return true;
 }
 
-bool EthernetDevice::try_recv_raw_frame() {
-	ssize_t ans;
-
-	ans = read(sockfd, recv_frame_buf, FRAME_SIZE);
-	assert(ans <= FRAME_SIZE);
-	if (ans == 0) {
-		cerr << "[ethernet] recv socket received zero bytes ... connection "
-		        "closed?"
-		     << endl;
-		throw runtime_error("read failed");
-	} else if (ans == -1) {
-		if (errno == EWOULDBLOCK || errno == EAGAIN) {
-			return true;
-		} else
-			throw runtime_error("recvfrom failed");
+/* Host thread: reads all available frames, keeps the ones for us and
+ * notifies the SystemC side once per batch. */
+void EthernetDevice::receive() {
+	struct pollfd fds[2] = {
+	    {stop_efd, POLLIN, 0},
+	    {sockfd, POLLIN, 0},
+	};
+	Frame frame;
+
+	while (true) {
+		if (poll(fds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			throw runtime_error("poll failed");
+		}
+		if (fds[0].revents)
+			return;
+
+		bool received = false;
+		while (true) {
+			ssize_t ans = read(sockfd, frame.data, FRAME_SIZE);
+			if (ans == 0) {
+				cerr << "[ethernet] recv socket received zero bytes ... connection "
+				        "closed?"
+				     << endl;
+				throw runtime_error("read failed");
+			} else if (ans == -1) {
+				if (errno == EWOULDBLOCK || errno == EAGAIN)
+					break;
+				throw runtime_error("recvfrom failed");
+			}
+			assert(ans <= FRAME_SIZE);
+
+			if (!isPacketForUs(frame.data, ans))
+				continue;
+
+			frame.size = ans;
+			if (rx_ring.push(frame))
+				received = true;
+			else
+				++rx_dropped;
+		}
+
+		if (received)
+			rx_event->notify();
 	}
-	assert(ETH_ALEN == 6);
+}
 
-	if (!isPacketForUs(recv_frame_buf, ans)) {
+/* Presents the next received frame to software, returns false if a frame
+ * is already presented or none is available. */
+bool EthernetDevice::present_next_frame() {
+	if (has_frame || !rx_ring.pop(recv_frame))
 		return false;
-	}
 
 	has_frame = true;
-	receive_size = ans;
+	receive_size = recv_frame.size;
 	cout << "RECEIVED FRAME <---<---<---<---<--- ";
-	dump_ethernet_frame(recv_frame_buf, ans);
+	dump_ethernet_frame(recv_frame.data, recv_frame.size);
 	cout << endl;
 
 	return true;
@@ -2,19 +2,25 @@
 #define RISCV_VP_ETHERNET_H
 
 #include <unistd.h>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
 #include <ios>
 #include <list>
 #include <map>
+#include <memory>
+#include <thread>
 #include <unordered_map>
 
 #include <systemc>
 
+#include <tlm_utils/simple_initiator_socket.h>
 #include <tlm_utils/simple_target_socket.h>
 
 #include "core/common/irq_if.h"
+#include "platform/common/async_event.h"
+#include "util/spsc_ring.h"
 #include "util/tlm_map.h"
 
 struct arp_eth_header {
@@ -31,10 +37,16 @@ struct arp_eth_header {
 
 struct EthernetDevice : public sc_core::sc_module {
 	tlm_utils::simple_target_socket<EthernetDevice> tsock;
+	tlm_utils::simple_initiator_socket<EthernetDevice> isock;  // DMA into guest memory
 
 	interrupt_gateway *plic = 0;
 	uint32_t irq_number = 0;
-	sc_core::sc_event run_event;
+
+	/* RX interrupt coalescing: the interrupt for a newly received frame is
+	 * delayed until *rx_coalesce_frames* frames are pending or the first
+	 * one has been pending for *rx_coalesce_time*. */
+	unsigned rx_coalesce_frames = 1;
+	sc_core::sc_time rx_coalesce_time = sc_core::SC_ZERO_TIME;
 
 	// memory mapped configuration registers
 	uint32_t status = 0;
@@ -47,8 +59,6 @@ struct EthernetDevice : public sc_core::sc_module {
 	uint8_t *VIRTUAL_MAC_ADDRESS = reinterpret_cast<uint8_t *>(mac);
 	uint8_t BROADCAST_MAC_ADDRESS[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
 
-	uint8_t *mem = nullptr;
-
 	vp::map::LocalRouter router;
 
 	int sockfd = 0;
@@ -57,8 +67,21 @@ struct EthernetDevice : public sc_core::sc_module {
 	static const uint16_t MTU_SIZE = 1500;
 	static const uint16_t FRAME_SIZE = MTU_SIZE + 14;
 
-	uint8_t recv_frame_buf[FRAME_SIZE];
-	bool has_frame;
+	struct Frame {
+		uint16_t size;
+		uint8_t data[FRAME_SIZE];
+	};
+
+	/* Frames are received by a host thread and handed to the SystemC
+	 * side through the ring, frames are dropped if it is full. */
+	SPSCRing<Frame, 32> rx_ring;
+	std::unique_ptr<AsyncEvent> rx_event;  // only created if the device is enabled
+	std::thread *rx_thread = nullptr;
+	int stop_efd = -1;
+	uint64_t rx_dropped = 0;
+
+	Frame recv_frame;  // frame currently presented to software
+	bool has_frame = false;
 	bool disabled;
 
 	static const uint16_t STATUS_REG_ADDR = 0x00;
@@ -76,17 +99,19 @@ struct EthernetDevice : public sc_core::sc_module {
 
 	SC_HAS_PROCESS(EthernetDevice);
 
-	EthernetDevice(sc_core::sc_module_name, uint32_t irq_number, uint8_t *mem, std::string clonedev);
+	EthernetDevice(sc_core::sc_module_name, uint32_t irq_number, std::string clonedev);
+	~EthernetDevice();
 
 	void init_network(std::string clonedev);
 	void add_all_if_ips();
 
-	void send_raw_frame();
-	bool try_recv_raw_frame();
+	void send_raw_frame(sc_core::sc_time &delay);
+	void receive();
+	bool present_next_frame();
 	bool isPacketForUs(uint8_t *packet, ssize_t size);
+	void dma_transfer(tlm::tlm_command cmd, uint64_t addr, uint8_t *data, unsigned num_bytes, sc_core::sc_time &delay);
 
 	void register_access_callback(const vp::map::register_access_t &r) {
-		assert(mem);
 		assert(!disabled && "Tried accessing disabled network device");
 
 		r.fn();
@@ -94,11 +119,15 @@ struct EthernetDevice : public sc_core::sc_module {
 		if (r.write && r.vptr == &status) {
 			if (r.nv == RECV_OPERATION) {
 				assert(has_frame);
-				memcpy(&mem[receive_dst - 0x80000000], recv_frame_buf, receive_size);
+				dma_transfer(tlm::TLM_WRITE_COMMAND, receive_dst, recv_frame.data, receive_size, r.delay);
 				has_frame = false;
 				receive_size = 0;
+
+				// software is draining, hand out further frames right away
+				if (present_next_frame())
+					plic->gateway_trigger_interrupt(irq_number);
 			} else if (r.nv == SEND_OPERATION) {
-				send_raw_frame();
+				send_raw_frame(r.delay);
 			} else {
 				throw std::runtime_error("unsupported operation");
 			}
@@ -109,19 +138,22 @@ struct EthernetDevice : public sc_core::sc_module {
 		router.transport(trans, delay);
 	}
 
+	/* Only runs when the host thread has received frames, i.e. an idle
+	 * network does not cause any simulation activity. */
 	void run() {
-		while (!disabled) {
-			run_event.notify(sc_core::sc_time(10000, sc_core::SC_US));
-			sc_core::wait(run_event);  // 10000 times per second by default
-
-			// check if data is available on the socket, if yes store it in an
-			// internal buffer
-			if (!has_frame) {
-				while (!try_recv_raw_frame())
-					;
-				if (has_frame)
-					plic->gateway_trigger_interrupt(irq_number);
+		while (true) {
+			sc_core::wait(*rx_event);
+
+			if (!present_next_frame())
+				continue;  // not idle (software is draining) or nothing for us
+
+			if (rx_coalesce_frames > 1 && rx_coalesce_time != sc_core::SC_ZERO_TIME) {
+				auto deadline = sc_core::sc_time_stamp() + rx_coalesce_time;
+				while (1 + rx_ring.size() < rx_coalesce_frames && sc_core::sc_time_stamp() < deadline)
+					sc_core::wait(deadline - sc_core::sc_time_stamp(), *rx_event);
 			}
+
+			plic->gateway_trigger_interrupt(irq_number);
 		}
 	}
 };
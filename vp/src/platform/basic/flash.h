@@ -7,8 +7,11 @@
 #include <stdint.h>
 #include <sys/ioctl.h>
 #include <unistd.h>  //truncate
+#include <algorithm>
 #include <fstream>   //file IO
 #include <iostream>
+#include <list>
+#include <unordered_map>
 
 #include <tlm_utils/simple_target_socket.h>
 #include <systemc>
@@ -19,63 +22,100 @@ using namespace std;
 using namespace sc_core;
 using namespace tlm_utils;
 
+/* Write-back cache of the *capacity* most recently used blocks of the
+ * backing file. Dirty blocks are only written when they are evicted or
+ * on flush, hence repeated accesses to a working set (e.g. FAT and
+ * directory blocks) do not cause any host syscalls. */
 template <size_t width>
-struct Blockbuffer {
-	uint8_t buf[width];
-	uint64_t offs;
-	bool dirty;
-	bool active;
+struct BlockCache {
+	struct Entry {
+		uint64_t block;
+		bool dirty;
+		uint8_t buf[width];
+	};
+	typedef std::list<Entry> lru_list;  // most recently used first
+
+	const size_t capacity;
 	int fd;
-	Blockbuffer(int fileDescriptor) : offs(0), dirty(false), active(false), fd(fileDescriptor){};
+	lru_list entries;
+	std::unordered_map<uint64_t, typename lru_list::iterator> index;
+
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t writebacks = 0;
+
+	BlockCache(int fileDescriptor, size_t capacity) : capacity(std::max<size_t>(capacity, 1)), fd(fileDescriptor) {
+		index.reserve(this->capacity);
+	};
+
+	/* Returns the cached block, *evicted* is set if a dirty block had to
+	 * be written back to make room. */
+	Entry& lookup(uint64_t block, bool& hit, bool& evicted) {
+		evicted = false;
+		if (!entries.empty() && entries.front().block == block) {  // consecutive accesses to the same block
+			hit = true;
+			++hits;
+			return entries.front();
+		}
+
+		auto it = index.find(block);
+		if (it != index.end()) {
+			hit = true;
+			++hits;
+			entries.splice(entries.begin(), entries, it->second);
+			return entries.front();
+		}
 
-	void setPos(uint64_t blockOffset) {
-		if (blockOffset != offs || !active) {
-			if (dirty && active) {  // commit changes
-				writeBlock(offs);
+		hit = false;
+		++misses;
+		if (entries.size() < capacity) {
+			entries.emplace_front();
+		} else {  // reuse the least recently used entry
+			Entry& victim = entries.back();
+			if (victim.dirty) {
+				writeBlock(victim);
+				evicted = true;
 			}
-			offs = blockOffset;
-			readBlock(blockOffset);
-			active = true;
+			index.erase(victim.block);
+			entries.splice(entries.begin(), entries, std::prev(entries.end()));
 		}
-	}
-	void setData(const uint8_t* source, uint16_t pos, uint16_t length) {
-		assert(active);
-		memcpy(&buf[pos], source, length);
-		dirty = true;
-	}
-	void getData(uint8_t* target, uint16_t pos, uint16_t length) {
-		assert(active);
-		memcpy(target, &buf[pos], length);
+
+		Entry& e = entries.front();
+		e.block = block;
+		readBlock(e);
+		index[block] = entries.begin();
+		return e;
 	}
 
-	void writeBlock(uint64_t blockOffset) {
-		if (lseek64(fd, blockOffset * width, SEEK_SET) < 0) {
-			cerr << "Could not seek device: " << strerror(errno) << endl;
-			return;
+	/* Writes all dirty blocks, returns their number. */
+	size_t flush() {
+		size_t n = 0;
+		for (auto& e : entries) {
+			if (e.dirty) {
+				writeBlock(e);
+				++n;
+			}
 		}
-		if (write(fd, buf, width) != width) {
+		if (n > 0 && fdatasync(fd) < 0)
+			cerr << "Could not sync device: " << strerror(errno) << endl;
+		return n;
+	}
+
+	void writeBlock(Entry& e) {
+		++writebacks;
+		if (pwrite64(fd, e.buf, width, e.block * width) != width) {
 			cerr << "Could not write device: " << strerror(errno) << endl;
 			return;
 		}
-		dirty = false;
+		e.dirty = false;
 	}
 
-	void readBlock(uint64_t blockOffset) {
-		if (lseek64(fd, blockOffset * width, SEEK_SET) < 0) {
-			cerr << "Could not seek device: " << strerror(errno) << endl;
-			return;
-		}
-		if (read(fd, buf, width) != width) {
+	void readBlock(Entry& e) {
+		e.dirty = false;
+		if (pread64(fd, e.buf, width, e.block * width) != width) {
 			cerr << "Could not read device: " << strerror(errno) << endl;
 			return;
 		}
-		dirty = false;
-	}
-	void clear() {
-		if (active && dirty) {
-			writeBlock(offs);
-		}
-		active = false;
 	}
 };
 
@@ -84,11 +124,20 @@ struct Flashcontroller : public sc_core::sc_module {
 	static const unsigned int FLASH_ADDR_REG = 0;
 	static const unsigned int FLASH_SIZE_REG = sizeof(uint64_t);
 	static const unsigned int DATA_ADDR = FLASH_SIZE_REG + sizeof(uint64_t);
-	static const unsigned int ADDR_SPACE = DATA_ADDR + BLOCKSIZE;
+	static const unsigned int FLASH_CTRL_REG = DATA_ADDR + BLOCKSIZE;
+	static const unsigned int ADDR_SPACE = FLASH_CTRL_REG + sizeof(uint32_t);
+
+	static const uint32_t FLASH_CTRL_FLUSH = 1;  // write back all cached blocks
+
+	// delay model: accesses to cached blocks vs. flash page read/program
+	static const unsigned int ACCESS_NS_PER_BYTE = 30;
+	static const unsigned int FLASH_READ_US = 50;
+	static const unsigned int FLASH_PROGRAM_US = 250;
+
+	static const size_t DEFAULT_CACHE_BLOCKS = 64;
 
 	simple_target_socket<Flashcontroller> tsock;
-	uint8_t blockbufRaw[sizeof(Blockbuffer<BLOCKSIZE>)];
-	Blockbuffer<BLOCKSIZE>* blockBuf;
+	BlockCache<BLOCKSIZE>* blockCache;
 
 	union {
 		uint64_t asInt;
@@ -103,14 +152,16 @@ struct Flashcontroller : public sc_core::sc_module {
 	string mFilepath;
 	int mFiledescriptor;
 
-	Flashcontroller(sc_module_name, string& filepath) : blockBuf(nullptr), mFilepath(filepath), mFiledescriptor(-1) {
+	Flashcontroller(sc_module_name, string& filepath, size_t cacheBlocks = DEFAULT_CACHE_BLOCKS)
+	    : blockCache(nullptr), mFilepath(filepath), mFiledescriptor(-1) {
 		tsock.register_b_transport(this, &Flashcontroller::transport);
 
 		if (filepath.length() == 0) {  // No file
 			return;
 		}
 
-		mFiledescriptor = open(mFilepath.c_str(), O_SYNC | O_RDWR);
+		// no O_SYNC, dirty blocks are synced on flush
+		mFiledescriptor = open(mFilepath.c_str(), O_RDWR);
 		if (mFiledescriptor < 0) {
 			cerr << "Could not open device " << mFilepath << ": " << strerror(errno) << endl;
 			return;
@@ -126,16 +177,20 @@ struct Flashcontroller : public sc_core::sc_module {
 			}
 			cerr << "Could get size of _file_ " << mFilepath << ": " << mDeviceNumBlocks.asInt << endl;
 			mDeviceNumBlocks.asInt /= BLOCKSIZE;
+		} else {
+			mDeviceNumBlocks.asInt /= BLOCKSIZE;  // BLKGETSIZE64 returns bytes
 		}
 		mTargetBlock.asInt = 0;
-		blockBuf = new (blockbufRaw) Blockbuffer<BLOCKSIZE>(mFiledescriptor);
+		blockCache = new BlockCache<BLOCKSIZE>(mFiledescriptor, cacheBlocks);
 	}
 
 	~Flashcontroller() {
-		if (blockBuf != nullptr) {
-			blockBuf->clear();
+		if (blockCache != nullptr) {
+			blockCache->flush();
+			delete blockCache;
 		}
-		close(mFiledescriptor);
+		if (mFiledescriptor >= 0)
+			close(mFiledescriptor);
 	}
 
 	void transport(tlm::tlm_generic_payload& trans, sc_core::sc_time& delay) {
@@ -144,9 +199,11 @@ struct Flashcontroller : public sc_core::sc_module {
 		auto* ptr = trans.get_data_ptr();
 		auto len = trans.get_data_length();
 
-		assert((addr < DATA_ADDR + BLOCKSIZE) && "Access flashcontroller out of bounds");
+		assert((addr + len <= ADDR_SPACE) && "Access flashcontroller out of bounds");
 		assert(mFiledescriptor >= 0);
 
+		delay += sc_core::sc_time(len * ACCESS_NS_PER_BYTE, sc_core::SC_NS);
+
 		if (/*addr >= FLASH_ADDR_REG &&*/ addr < FLASH_SIZE_REG) {  // Address register
 			if (cmd == tlm::TLM_WRITE_COMMAND) {
 				memcpy(&mTargetBlock.asRaw[addr - FLASH_ADDR_REG], ptr, len);
@@ -155,27 +212,41 @@ struct Flashcontroller : public sc_core::sc_module {
 			} else {
 				sc_assert(false && "unsupported tlm command");
 			}
-			delay += sc_core::sc_time(len * 30, sc_core::SC_NS);
 		} else if (addr >= FLASH_SIZE_REG && addr < DATA_ADDR) {  // Size register
 			if (cmd == tlm::TLM_READ_COMMAND) {
 				memcpy(ptr, &mDeviceNumBlocks.asRaw[addr - FLASH_SIZE_REG], len);
 			} else {
 				sc_assert(false && "unsupported tlm command");
 			}
-			delay += sc_core::sc_time(len * 30, sc_core::SC_NS);
+		} else if (addr >= FLASH_CTRL_REG) {  // Control register
+			if (cmd == tlm::TLM_WRITE_COMMAND) {
+				uint32_t ctrl = 0;
+				memcpy(&ctrl, ptr, std::min<size_t>(len, sizeof(ctrl)));
+				if (ctrl & FLASH_CTRL_FLUSH)
+					delay += blockCache->flush() * sc_core::sc_time(FLASH_PROGRAM_US, sc_core::SC_US);
+			} else if (cmd == tlm::TLM_READ_COMMAND) {
+				memset(ptr, 0, len);  // flushes complete immediately
+			} else {
+				sc_assert(false && "unsupported tlm command");
+			}
 		} else {  // Data region
 			assert(mTargetBlock.asInt < mDeviceNumBlocks.asInt && "Access Flash out of bounds!");
 
-			blockBuf->setPos(mTargetBlock.asInt);  // Loads Block into buffer
+			bool hit, evicted;
+			auto& block = blockCache->lookup(mTargetBlock.asInt, hit, evicted);
 			if (cmd == tlm::TLM_WRITE_COMMAND) {
-				blockBuf->setData(ptr, addr - DATA_ADDR, len);
+				memcpy(&block.buf[addr - DATA_ADDR], ptr, len);
+				block.dirty = true;
 			} else if (cmd == tlm::TLM_READ_COMMAND) {
-				blockBuf->getData(ptr, addr - DATA_ADDR, len);
+				memcpy(ptr, &block.buf[addr - DATA_ADDR], len);
 			} else {
 				sc_assert(false && "unsupported tlm command");
 			}
-			// TODO: Add delay based on blockBuf cache
-			delay += sc_core::sc_time(len, sc_core::SC_US);
+
+			if (!hit)
+				delay += sc_core::sc_time(FLASH_READ_US, sc_core::SC_US);
+			if (evicted)
+				delay += sc_core::sc_time(FLASH_PROGRAM_US, sc_core::SC_US);
 		}
 	}
 };
@@ -18,6 +18,7 @@
 #include "sensor2.h"
 #include "syscall.h"
 #include "terminal.h"
+#include "timing/timing_external.h"
 #include "util/options.h"
 #include "platform/common/options.h"
 
@@ -40,6 +41,9 @@ public:
 	std::string flash_device;
 	std::string network_device;
 	std::string test_signature;
+	std::string timing_plugin;
+	std::string timing_plugin_config;
+	std::string isa;
 
 	addr_t mem_size = 1024 * 1024 * 32;  // 32 MB ram, to place it before the CLINT and run the base examples (assume
 	                                     // memory start at zero) without modifications
@@ -64,12 +68,19 @@ public:
 	addr_t mram_end_addr = mram_start_addr + mram_size - 1;
 	addr_t dma_start_addr = 0x70000000;
 	addr_t dma_end_addr = 0x70001000;
+	addr_t mram_ctrl_start_addr = 0x70002000;
+	addr_t mram_ctrl_end_addr = mram_ctrl_start_addr + SimpleMRAM::CTRL_SIZE - 1;
 	addr_t flash_start_addr = 0x71000000;
-	addr_t flash_end_addr = flash_start_addr + Flashcontroller::ADDR_SPACE;  // Usually 528 Byte
+	addr_t flash_end_addr = flash_start_addr + Flashcontroller::ADDR_SPACE;  // Usually 532 Byte
 	addr_t display_start_addr = 0x72000000;
 	addr_t display_end_addr = display_start_addr + Display::addressRange;
 
 	bool use_E_base_isa = false;
+	unsigned int network_rx_coalesce_frames = 1;
+	unsigned int network_rx_coalesce_us = 0;
+	bool mram_write_through = false;
+	unsigned int mram_sync_interval_us = 0;
+	unsigned int flash_cache_blocks = Flashcontroller::DEFAULT_CACHE_BLOCKS;
 
 	OptionValue<unsigned long> entry_point;
 
@@ -79,12 +90,20 @@ public:
 			("memory-start", po::value<unsigned int>(&mem_start_addr),"set memory start address")
 			("memory-size", po::value<unsigned int>(&mem_size), "set memory size")
 			("use-E-base-isa", po::bool_switch(&use_E_base_isa), "use the E instead of the I integer base ISA")
+			("isa", po::value<std::string>(&isa), "select the ISA extensions, e.g. rv32imac or rv32gc")
 			("entry-point", po::value<std::string>(&entry_point.option),"set entry point address (ISS program counter)")
 			("mram-image", po::value<std::string>(&mram_image)->default_value(""),"MRAM image file for persistency")
 			("mram-image-size", po::value<unsigned int>(&mram_size), "MRAM image size")
+			("mram-write-through", po::bool_switch(&mram_write_through), "sync every MRAM store to disk (disables DMI for the MRAM)")
+			("mram-sync-interval-us", po::value<unsigned int>(&mram_sync_interval_us), "additionally sync the MRAM image to disk periodically (simulated time)")
 			("flash-device", po::value<std::string>(&flash_device)->default_value(""),"blockdevice for flash emulation")
+			("flash-cache-blocks", po::value<unsigned int>(&flash_cache_blocks),"number of 512 byte blocks cached by the flash controller")
 			("network-device", po::value<std::string>(&network_device)->default_value(""),"name of the tap network adapter, e.g. /dev/tap6")
-			("signature", po::value<std::string>(&test_signature)->default_value(""),"output filename for the test execution signature");
+			("network-rx-coalesce-frames", po::value<unsigned int>(&network_rx_coalesce_frames),"delay the network receive interrupt until this many frames are pending")
+			("network-rx-coalesce-us", po::value<unsigned int>(&network_rx_coalesce_us),"maximum delay of the network receive interrupt in microseconds")
+			("signature", po::value<std::string>(&test_signature)->default_value(""),"output filename for the test execution signature")
+			("timing-plugin", po::value<std::string>(&timing_plugin)->default_value(""),"external timing simulator library, e.g. riscv-timing-sim.so")
+			("timing-plugin-config", po::value<std::string>(&timing_plugin_config)->default_value(RISCV_TIMING_DB),"configuration passed to the external timing simulator");
         	// clang-format on
 	}
 
@@ -120,7 +139,7 @@ int sc_main(int argc, char **argv) {
 	SimpleMemory mem("SimpleMemory", opt.mem_size);
 	SimpleTerminal term("SimpleTerminal");
 	ELFLoader loader(opt.input_program.c_str());
-	SimpleBus<3, 12> bus("SimpleBus");
+	SimpleBus<4, 13> bus("SimpleBus");
 	CombinedMemoryInterface iss_mem_if("MemoryInterface", core);
 	SyscallHandler sys("SyscallHandler");
 	FE310_PLIC<1, 64, 96, 32> plic("PLIC");
@@ -129,9 +148,11 @@ int sc_main(int argc, char **argv) {
 	SimpleSensor2 sensor2("SimpleSensor2", 5);
 	BasicTimer timer("BasicTimer", 3);
 	SimpleMRAM mram("SimpleMRAM", opt.mram_image, opt.mram_size);
+	mram.write_through = opt.mram_write_through;
+	mram.sync_interval = sc_core::sc_time(opt.mram_sync_interval_us, sc_core::SC_US);
 	SimpleDMA dma("SimpleDMA", 4);
-	Flashcontroller flashController("Flashcontroller", opt.flash_device);
-	EthernetDevice ethernet("EthernetDevice", 7, mem.data, opt.network_device);
+	Flashcontroller flashController("Flashcontroller", opt.flash_device, opt.flash_cache_blocks);
+	EthernetDevice ethernet("EthernetDevice", 7, opt.network_device);
 	Display display("Display");
 	DebugMemoryInterface dbg_if("DebugMemoryInterface");
 
@@ -147,6 +168,9 @@ int sc_main(int argc, char **argv) {
 		instr_mem_if = &instr_mem;
 	if (opt.use_data_dmi) {
 		iss_mem_if.dmi_ranges.emplace_back(dmi);
+		if (mram.dmi_allowed())
+			iss_mem_if.dmi_ranges.emplace_back(mram.get_dmi(opt.mram_start_addr));
+		iss_mem_if.dmi_ranges.emplace_back(display.get_dmi(opt.display_start_addr));
 	}
 
 	uint64_t entry_point = loader.get_entrypoint();
@@ -161,12 +185,20 @@ int sc_main(int argc, char **argv) {
 		return -1;
 	}
 	core.init(instr_mem_if, data_mem_if, &clint, entry_point, rv32_align_address(opt.mem_end_addr));
+	if (!opt.isa.empty())
+		core.set_isa(opt.isa);
 	sys.init(mem.data, opt.mem_start_addr, loader.get_heap_addr());
 	sys.register_core(&core);
 
 	if (opt.intercept_syscalls)
 		core.sys = &sys;
 
+	std::unique_ptr<ExternalTimingDecorator> external_timing;
+	if (!opt.timing_plugin.empty()) {
+		external_timing.reset(new ExternalTimingDecorator(opt.timing_plugin, opt.timing_plugin_config));
+		core.timing = external_timing.get();
+	}
+
 	// address mapping
 	bus.ports[0] = new PortMapping(opt.mem_start_addr, opt.mem_end_addr);
 	bus.ports[1] = new PortMapping(opt.clint_start_addr, opt.clint_end_addr);
@@ -180,6 +212,7 @@ int sc_main(int argc, char **argv) {
 	bus.ports[9] = new PortMapping(opt.ethernet_start_addr, opt.ethernet_end_addr);
 	bus.ports[10] = new PortMapping(opt.display_start_addr, opt.display_end_addr);
 	bus.ports[11] = new PortMapping(opt.sys_start_addr, opt.sys_end_addr);
+	bus.ports[12] = new PortMapping(opt.mram_ctrl_start_addr, opt.mram_ctrl_end_addr);
 
 	// connect TLM sockets
 	iss_mem_if.isock.bind(bus.tsocks[0]);
@@ -189,6 +222,17 @@ int sc_main(int argc, char **argv) {
 	dma_connector.isock.bind(bus.tsocks[1]);
 	dma.isock.bind(dma_connector.tsock);
 	dma_connector.bus_lock = bus_lock;
+	dma.bus_lock = bus_lock;
+	dma.dmi_ranges.emplace_back(dmi);
+	if (mram.dmi_allowed())
+		dma.dmi_ranges.emplace_back(mram.get_dmi(opt.mram_start_addr));
+	dma.dmi_ranges.emplace_back(display.get_dmi(opt.display_start_addr));
+	display.dmi_ranges.emplace_back(dmi);
+
+	PeripheralWriteConnector ethernet_connector("EthernetDevice-Connector");
+	ethernet_connector.isock.bind(bus.tsocks[3]);
+	ethernet.isock.bind(ethernet_connector.tsock);
+	ethernet_connector.bus_lock = bus_lock;
 
 	bus.isocks[0].bind(mem.tsock);
 	bus.isocks[1].bind(clint.tsock);
@@ -202,6 +246,7 @@ int sc_main(int argc, char **argv) {
 	bus.isocks[9].bind(ethernet.tsock);
 	bus.isocks[10].bind(display.tsock);
 	bus.isocks[11].bind(sys.tsock);
+	bus.isocks[12].bind(mram.ctrl_tsock);
 
 	// connect interrupt signals/communication
 	plic.target_harts[0] = &core;
@@ -211,12 +256,16 @@ int sc_main(int argc, char **argv) {
 	timer.plic = &plic;
 	sensor2.plic = &plic;
 	ethernet.plic = &plic;
+	ethernet.rx_coalesce_frames = opt.network_rx_coalesce_frames;
+	ethernet.rx_coalesce_time = sc_core::sc_time(opt.network_rx_coalesce_us, sc_core::SC_US);
 
 	std::vector<debug_target_if *> threads;
 	threads.push_back(&core);
 
 	core.trace = opt.trace_mode;  // switch for printing instructions
 	if (opt.use_debug_runner) {
+		dbg_if.dmi_ranges.emplace_back(dmi);
+		dbg_if.add_memory_map(bus);
 		auto server = new GDBServer("GDBServer", threads, &dbg_if, opt.debug_port);
 		new GDBServerRunner("GDBRunner", server, &core);
 	} else {
@@ -1,60 +1,115 @@
 #pragma once
 
+#include <fcntl.h>
 #include <stdint.h>
-#include <unistd.h>  //truncate
-#include <fstream>   //file IO
+#include <sys/mman.h>
+#include <unistd.h>  //ftruncate
+#include <cstring>
 #include <iostream>
+#include <system_error>
 
 #include <tlm_utils/simple_target_socket.h>
 #include <systemc>
 
 #include "bus.h"
+#include "core/common/dmi.h"
 
 using namespace std;
 using namespace sc_core;
 using namespace tlm_utils;
 
+/* Non-volatile memory backed by a shared mapping of the image file. The cores access the mapping directly (see
+ * get_dmi), stores reach the page cache of the host immediately and hence survive a crash of the simulator.
+ *
+ * To survive a crash of the host, the mapping is synced to disk:
+ *   - on exit and whenever software writes the persist register (*ctrl_tsock*),
+ *   - optionally every *sync_interval* of simulated time,
+ *   - optionally after every store (*write_through*, only the slow TLM path is used, no DMI). */
 struct SimpleMRAM : public sc_core::sc_module {
+	static const unsigned int ACCESS_NS_PER_BYTE = 30;
+	static const unsigned int CTRL_SIZE = sizeof(uint32_t);  // the persist register
+
 	simple_target_socket<SimpleMRAM> tsock;
+	simple_target_socket<SimpleMRAM> ctrl_tsock;
 
 	string mFilepath;
 	uint32_t mSize;
-	fstream file;
+	uint8_t *data = nullptr;
+	int fd = -1;
+
+	bool write_through = false;
+	sc_core::sc_time sync_interval = sc_core::SC_ZERO_TIME;
+
+	SC_HAS_PROCESS(SimpleMRAM);
 
 	SimpleMRAM(sc_module_name, string &filepath, uint32_t size) : mFilepath(filepath), mSize(size) {
 		tsock.register_b_transport(this, &SimpleMRAM::transport);
+		ctrl_tsock.register_b_transport(this, &SimpleMRAM::transport_ctrl);
 
-		if (filepath.size() == 0 || size == 0) {  // no file
+		if (size == 0)
 			return;
+
+		if (filepath.size() == 0) {  // no file, i.e. not persistent
+			data = (uint8_t *)mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		} else {
+			fd = open(mFilepath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+			if (fd < 0)
+				throw std::system_error(errno, std::generic_category(), mFilepath);
+			if (ftruncate(fd, mSize) < 0)
+				throw std::system_error(errno, std::generic_category(), mFilepath);
+			data = (uint8_t *)mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 		}
-		file.open(mFilepath, ofstream::in | ofstream::out | ofstream::binary);
-		if (!file.is_open() || !file.good()) {
-			// cout << "Failed to open " << mFilepath << ": " << strerror(errno)
-			// << endl;
-			file.open(mFilepath, ofstream::in | ofstream::out | ofstream::binary | ios_base::trunc);
-		}
-		int stat = truncate(mFilepath.c_str(), mSize);
-		assert(stat == 0 && "truncate failed");
-		assert(file.is_open() && file.good() && "File could not be opened");
+		if (data == MAP_FAILED)
+			throw std::system_error(errno, std::generic_category(), "mmap");
+
+		SC_THREAD(run);
 	}
 
 	~SimpleMRAM() {
-		file.close();
+		if (data && data != MAP_FAILED) {
+			persist();
+			munmap(data, mSize);
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+
+	/* DMI range for the cores, annotates the access latency of the TLM path */
+	MemoryDMI get_dmi(uint64_t start_addr) {
+		MemoryDMI dmi = MemoryDMI::create_start_size_mapping(data, start_addr, mSize);
+		dmi.set_latency_per_byte(sc_core::sc_time(ACCESS_NS_PER_BYTE, sc_core::SC_NS),
+		                         sc_core::sc_time(ACCESS_NS_PER_BYTE, sc_core::SC_NS));
+		return dmi;
+	}
+
+	bool dmi_allowed() const {
+		return data != nullptr && !write_through;
+	}
+
+	void persist(unsigned addr = 0, unsigned num_bytes = 0) {
+		if (fd < 0)
+			return;
+
+		if (num_bytes == 0) {
+			addr = 0;
+			num_bytes = mSize;
+		}
+		// msync requires a page aligned address
+		unsigned offset = addr % sysconf(_SC_PAGESIZE);
+		if (msync(data + addr - offset, num_bytes + offset, MS_SYNC) < 0)
+			cerr << "Failed to sync " << mFilepath << ": " << strerror(errno) << endl;
 	}
 
 	void write_data(unsigned addr, uint8_t *src, unsigned num_bytes) {
 		assert(addr + num_bytes <= mSize);
-		file.seekg(addr, file.beg);
-		file.write(reinterpret_cast<char *>(src), num_bytes);
-		if (!file.is_open() || !file.good()) {
-			cout << "Failed to write " << mFilepath << ": " << strerror(errno) << endl;
-		}
+		memcpy(data + addr, src, num_bytes);
+		if (write_through)
+			persist(addr, num_bytes);
 	}
 
 	void read_data(unsigned addr, uint8_t *dst, unsigned num_bytes) {
 		assert(addr + num_bytes <= mSize);
-		file.seekg(addr, file.beg);
-		file.read(reinterpret_cast<char *>(dst), num_bytes);
+		memcpy(dst, data + addr, num_bytes);
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
@@ -63,6 +118,7 @@ struct SimpleMRAM : public sc_core::sc_module {
 		auto *ptr = trans.get_data_ptr();
 		auto len = trans.get_data_length();
 
+		assert(data != nullptr);
 		assert(addr < mSize);
 
 		if (cmd == tlm::TLM_WRITE_COMMAND) {
@@ -73,6 +129,30 @@ struct SimpleMRAM : public sc_core::sc_module {
 			sc_assert(false && "unsupported tlm command");
 		}
 
-		delay += sc_core::sc_time(len * 30, sc_core::SC_NS);
+		delay += sc_core::sc_time(len * ACCESS_NS_PER_BYTE, sc_core::SC_NS);
+	}
+
+	/* any write to the persist register syncs the whole image, reads return zero */
+	void transport_ctrl(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+		tlm::tlm_command cmd = trans.get_command();
+
+		if (cmd == tlm::TLM_WRITE_COMMAND)
+			persist();
+		else if (cmd == tlm::TLM_READ_COMMAND)
+			memset(trans.get_data_ptr(), 0, trans.get_data_length());
+		else
+			sc_assert(false && "unsupported tlm command");
+
+		delay += sc_core::sc_time(ACCESS_NS_PER_BYTE, sc_core::SC_NS);
+	}
+
+	void run() {
+		if (fd < 0 || sync_interval == sc_core::SC_ZERO_TIME)
+			return;
+
+		while (true) {
+			sc_core::wait(sync_interval);
+			persist();
+		}
 	}
 };
@@ -3,12 +3,11 @@
 #include <err.h>
 #include <fcntl.h>
 #include <poll.h>
-#include <semaphore.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <mutex>
-#include <queue>
+#include <sys/eventfd.h>
+#include <algorithm>
 #include <thread>
 
 #define stop_fd (stop_pipe[0])
@@ -25,6 +24,9 @@
 /* Extracts the interrupt trigger threshold from a control register */
 #define UART_CTRL_CNT(REG) ((REG) >> 16)
 
+/* Transmit FIFO level as observed by software */
+#define UART_TX_LEVEL(FIFO) std::min((FIFO).size(), (size_t)UART_FIFO_DEPTH)
+
 enum {
 	TXDATA_REG_ADDR = 0x0,
 	RXDATA_REG_ADDR = 0x4,
@@ -55,16 +57,10 @@ AbstractUART::AbstractUART(sc_core::sc_module_name, uint32_t irqsrc) {
 	if (pipe(stop_pipe) == -1)
 		throw std::system_error(errno, std::generic_category());
 
-	sem_unlink("autx0");
-	txfull_p = sem_open("autx0", O_CREAT | O_EXCL, 0700, 0);
-	if (txfull_p == SEM_FAILED) {
+	if ((tx_efd = eventfd(0, EFD_CLOEXEC)) == -1)
 		throw std::system_error(errno, std::generic_category());
-	}
-	sem_unlink("aurx0");
-	rxempty_p = sem_open("aurx0",O_CREAT | O_EXCL, 0700, UART_FIFO_DEPTH);
-	if (rxempty_p == SEM_FAILED) {
+	if ((rx_efd = eventfd(0, EFD_CLOEXEC)) == -1)
 		throw std::system_error(errno, std::generic_category());
-	}
 	SC_METHOD(interrupt);
 	sensitive << asyncEvent;
 	dont_initialize();
@@ -74,7 +70,7 @@ AbstractUART::~AbstractUART(void) {
 	stop = true;
 
 	if (txthr) {
-		spost(txfull_p); // unblock transmit thread
+		efd_signal(tx_efd); // unblock transmit thread
 		txthr->join();
 		delete txthr;
 	}
@@ -83,6 +79,7 @@ AbstractUART::~AbstractUART(void) {
 		uint8_t byte = 0;
 		if (write(stop_pipe[1], &byte, sizeof(byte)) == -1) // unblock receive thread
 			err(EXIT_FAILURE, "couldn't unblock uart receive thread");
+		efd_signal(rx_efd); // unblock rxpush
 		rcvthr->join();
 		delete rcvthr;
 	}
@@ -90,10 +87,8 @@ AbstractUART::~AbstractUART(void) {
 	close(stop_pipe[0]);
 	close(stop_pipe[1]);
 
-	sem_unlink("autx0");
-	sem_close(txfull_p);
-	sem_unlink("aurx0");
-	sem_close(rxempty_p);
+	close(tx_efd);
+	close(rx_efd);
 }
 
 void AbstractUART::start_threads(int fd) {
@@ -104,49 +99,49 @@ void AbstractUART::start_threads(int fd) {
 	txthr = new std::thread(&AbstractUART::transmit, this);
 }
 
+/* Called from the receive thread, blocks while the FIFO is full. The
+ * SystemC side is notified once per handle_input call (see receive). */
 void AbstractUART::rxpush(uint8_t data) {
-	swait(rxempty_p);
+	while (!rx_fifo.push(data)) {
+		asyncEvent.notify();
+
+		rx_sleeping = true;
+		if (!rx_fifo.full() || stop) {
+			rx_sleeping = false;
+		} else {
+			efd_wait(rx_efd);
+		}
 
-	rcvmtx.lock();
-	rx_fifo.push(data);
-	rcvmtx.unlock();
-	asyncEvent.notify();
+		if (stop)
+			return;
+	}
 }
 
 void AbstractUART::register_access_callback(const vp::map::register_access_t &r) {
 	if (r.read) {
 		if (r.vptr == &txdata) {
-			txmtx.lock();
-			txdata = (tx_fifo.size() >= UART_FIFO_DEPTH) ? UART_FULL : 0;
-			txmtx.unlock();
+			txdata = tx_fifo.full() ? UART_FULL : 0;
 		} else if (r.vptr == &rxdata) {
-			rcvmtx.lock();
-			if (rx_fifo.empty()) {
-				rxdata = 1 << 31;
+			uint8_t data;
+			if (rx_fifo.pop(data)) {
+				rxdata = data;
+				if (rx_sleeping.exchange(false))
+					efd_signal(rx_efd);
 			} else {
-				rxdata = rx_fifo.front();
-				rx_fifo.pop();
-
-				spost(rxempty_p);
+				rxdata = 1 << 31;
 			}
-
-			rcvmtx.unlock();
 		} else if (r.vptr == &txctrl) {
 			// std::cout << "TXctl";
 		} else if (r.vptr == &rxctrl) {
 			// std::cout << "RXctrl";
 		} else if (r.vptr == &ip) {
 			uint32_t ret = 0;
-			txmtx.lock();
-			if (tx_fifo.size() < UART_CTRL_CNT(txctrl)) {
+			if (UART_TX_LEVEL(tx_fifo) < UART_CTRL_CNT(txctrl)) {
 				ret |= UART_TXWM;
 			}
-			txmtx.unlock();
-			rcvmtx.lock();
 			if (rx_fifo.size() > UART_CTRL_CNT(rxctrl)) {
 				ret |= UART_RXWM;
 			}
-			rcvmtx.unlock();
 			ip = ret;
 		} else if (r.vptr == &ie) {
 			// do nothing
@@ -171,15 +166,11 @@ void AbstractUART::register_access_callback(const vp::map::register_access_t &r)
 		asyncEvent.notify();
 
 	if (r.write && r.vptr == &txdata) {
-		txmtx.lock();
-		if (tx_fifo.size() >= UART_FIFO_DEPTH) {
-			txmtx.unlock();
+		if (!tx_fifo.push(txdata))
 			return; /* write is ignored */
-		}
 
-		tx_fifo.push(txdata);
-		txmtx.unlock();
-		spost(txfull_p);
+		if (tx_sleeping.exchange(false))
+			efd_signal(tx_efd);
 	}
 }
 
@@ -187,20 +178,27 @@ void AbstractUART::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &
 	router.transport(trans, delay);
 }
 
+/* Drains everything written so far and hands it to write_data with a
+ * single call, the FIFO can be refilled by the guest meanwhile. */
 void AbstractUART::transmit(void) {
-	uint8_t data;
+	uint8_t buf[decltype(tx_fifo)::capacity];
 
 	while (!stop) {
-		swait(txfull_p);
-		if (stop) break;
-
-		txmtx.lock();
-		data = tx_fifo.front();
-		tx_fifo.pop();
-		txmtx.unlock();
+		size_t n = tx_fifo.pop(buf, sizeof(buf));
+		if (n > 0) {
+			asyncEvent.notify();
+			write_data(buf, n);
+			continue;
+		}
 
-		asyncEvent.notify();
-		write_data(data);
+		/* the flag has to be visible before the FIFO is checked again,
+		 * otherwise a concurrent push might not signal the eventfd */
+		tx_sleeping = true;
+		if (!tx_fifo.empty() || stop) {
+			tx_sleeping = false;
+			continue;
+		}
+		efd_wait(tx_efd);
 	}
 }
 
@@ -219,8 +217,8 @@ void AbstractUART::receive(void) {
 			} else if (ev & POLLIN) {
 				if (fd == stop_fd)
 					break;
-				else
-					handle_input(fd);
+				handle_input(fd);
+				asyncEvent.notify();
 			}
 		}
 	}
@@ -234,30 +232,30 @@ void AbstractUART::interrupt(void) {
 	 * the PLIC methods are very likely not thread safe. */
 
 	if (ie & UART_RXWM) {
-		rcvmtx.lock();
 		if (rx_fifo.size() > UART_CTRL_CNT(rxctrl))
 			trigger = true;
-		rcvmtx.unlock();
 	}
 
 	if (ie & UART_TXWM) {
-		txmtx.lock();
-		if (tx_fifo.size() < UART_CTRL_CNT(txctrl))
+		if (UART_TX_LEVEL(tx_fifo) < UART_CTRL_CNT(txctrl))
 			trigger = true;
-		txmtx.unlock();
 	}
 
 	if (trigger)
 		plic->gateway_trigger_interrupt(irq);
 }
 
-void AbstractUART::swait(sem_t *sem) {
-	if (sem_wait(sem))
-		throw std::system_error(errno, std::generic_category());
+void AbstractUART::efd_wait(int fd) {
+	uint64_t count;
+	while (read(fd, &count, sizeof(count)) == -1) {
+		if (errno != EINTR)
+			throw std::system_error(errno, std::generic_category());
+	}
 }
 
-void AbstractUART::spost(sem_t *sem) {
-	if (sem_post(sem))
+void AbstractUART::efd_signal(int fd) {
+	uint64_t one = 1;
+	if (write(fd, &one, sizeof(one)) == -1)
 		throw std::system_error(errno, std::generic_category());
 }
 	
\ No newline at end of file
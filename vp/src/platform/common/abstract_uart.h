@@ -3,17 +3,16 @@
 
 #include <stdint.h>
 #include <poll.h>
-#include <semaphore.h>
 #include <stdbool.h>
 
 #include <systemc>
 #include <tlm_utils/simple_target_socket.h>
 
+#include <atomic>
 #include <thread>
-#include <mutex>
-#include <queue>
 
 #include "core/common/irq_if.h"
+#include "util/spsc_ring.h"
 #include "util/tlm_map.h"
 #include "platform/common/async_event.h"
 
@@ -32,7 +31,8 @@ protected:
 	void rxpush(uint8_t);
 
 private:
-	virtual void write_data(uint8_t) = 0;
+	/* called from the transmit thread with all bytes that are pending at once */
+	virtual void write_data(const uint8_t *, size_t) = 0;
 	virtual void handle_input(int fd) = 0;
 
 	void register_access_callback(const vp::map::register_access_t &);
@@ -41,8 +41,8 @@ private:
 	void receive(void);
 	void interrupt(void);
 
-	void swait(sem_t *);
-	void spost(sem_t *);
+	void efd_wait(int);
+	void efd_signal(int);
 
 	uint32_t irq;
 
@@ -56,10 +56,9 @@ private:
 	uint32_t div = 0;
 
 	std::thread *rcvthr = NULL, *txthr = NULL;
-	std::mutex rcvmtx, txmtx;
 	AsyncEvent asyncEvent;
 
-	bool stop;
+	std::atomic<bool> stop;
 	int stop_pipe[2];
 
 	enum {
@@ -67,11 +66,16 @@ private:
 	};
 	struct pollfd fds[NFDS];
 
-	std::queue<uint8_t> tx_fifo;
-	std::queue<uint8_t> rx_fifo;
+	/* The transmit ring is larger than the 8 entry hardware FIFO such
+	 * that the guest does not stall while the host performs the
+	 * (batched) write. Software only observes the hardware FIFO level. */
+	SPSCRing<uint8_t, 1024> tx_fifo;
+	SPSCRing<uint8_t, 8> rx_fifo;
 
-	sem_t *rxempty_p;
-	sem_t *txfull_p;
+	/* eventfd wakeups, only signaled if the other side sleeps */
+	int tx_efd, rx_efd;
+	std::atomic<bool> tx_sleeping{false};
+	std::atomic<bool> rx_sleeping{false};
 	vp::map::LocalRouter router = {"UART"};
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <tlm_utils/simple_target_socket.h>
+#include <algorithm>
+#include <array>
 #include <systemc>
 
 #include "core/common/irq_if.h"
@@ -14,7 +16,7 @@
  */
 template <unsigned NumberCores, unsigned NumberInterrupts, unsigned NumberInterruptEntries, uint32_t MaxPriority>
 struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
-	static_assert(NumberInterrupts <= 4096, "out of bound");
+	static_assert(NumberInterrupts <= 1024, "out of bound");  // the priority registers end at 0x1000
 	static_assert(NumberCores <= 15360, "out of bound");
 
 	tlm_utils::simple_target_socket<FE310_PLIC> tsock;
@@ -24,12 +26,19 @@ struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
 	// shared for all harts priority 1 is the lowest. Zero means do not interrupt
 	// NOTE: addressing starts at 0x4 because interrupt 0 is reserved, however some example SW still writes to address
 	// 0x0, hence we added it to the address map
-	RegisterRange regs_interrupt_priorities{0x0, 4 * (NumberInterrupts + 1)};
+	RegisterRange regs_interrupt_priorities{0x0, 4 * NumberInterrupts};
 	ArrayView<uint32_t> interrupt_priorities{regs_interrupt_priorities};
 
 	RegisterRange regs_pending_interrupts{0x1000, 4 * NumberInterruptEntries};
 	ArrayView<uint32_t> pending_interrupts{regs_pending_interrupts};
 
+	// number of 32 bit words that hold interrupt sources (pending and enable registers may be larger)
+	static constexpr unsigned NumberWords = (NumberInterrupts + 31) / 32;
+	static_assert(NumberWords <= NumberInterruptEntries, "out of bound");
+
+	// bitmap of the interrupt sources for each priority level, allows to search the pending interrupts word-wise
+	std::array<std::array<uint32_t, NumberWords>, MaxPriority + 1> priority_sources{};
+
 	struct HartConfig {
 		uint32_t priority_threshold;
 		uint32_t claim_response;
@@ -41,13 +50,15 @@ struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
 	RegisterRange regs_hart_config{0x200000, sizeof(HartConfig) * NumberCores};
 	ArrayView<HartConfig> hart_config{regs_hart_config};
 
-	std::vector<RegisterRange *> register_ranges{&regs_interrupt_priorities, &regs_pending_interrupts,
-	                                             &regs_hart_enabled_interrupts, &regs_hart_config};
+	vp::mm::RegisterMap register_map{"FE310_PLIC",
+	                                 {&regs_interrupt_priorities, &regs_pending_interrupts,
+	                                  &regs_hart_enabled_interrupts, &regs_hart_config}};
 
 	PrivilegeLevel irq_level;
 	std::array<bool, NumberCores> hart_eip{};
 
 	sc_core::sc_event e_run;
+	sc_core::sc_event e_enable;  // the enabled interrupts of some hart changed
 	sc_core::sc_time clock_cycle;
 
 	SC_HAS_PROCESS(FE310_PLIC);
@@ -57,16 +68,19 @@ struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
 		tsock.register_b_transport(this, &FE310_PLIC::transport);
 
 		regs_pending_interrupts.readonly = true;
-		regs_hart_config.alignment = 4;
+		regs_hart_config.set_alignment(4);
 
-		regs_interrupt_priorities.post_write_callback =
-		    std::bind(&FE310_PLIC::post_write_interrupt_priorities, this, std::placeholders::_1);
-		regs_hart_config.post_write_callback = std::bind(&FE310_PLIC::post_write_hart_config, this, std::placeholders::_1);
-		regs_hart_config.pre_read_callback = std::bind(&FE310_PLIC::pre_read_hart_config, this, std::placeholders::_1);
+		regs_interrupt_priorities.post_write_callback
+		    .bind<FE310_PLIC, &FE310_PLIC::post_write_interrupt_priorities>(this);
+		regs_hart_enabled_interrupts.post_write_callback
+		    .bind<FE310_PLIC, &FE310_PLIC::post_write_hart_enabled_interrupts>(this);
+		regs_hart_config.post_write_callback.bind<FE310_PLIC, &FE310_PLIC::post_write_hart_config>(this);
+		regs_hart_config.pre_read_callback.bind<FE310_PLIC, &FE310_PLIC::pre_read_hart_config>(this);
 
 		for (unsigned i = 0; i < NumberInterrupts; ++i) {
 			interrupt_priorities[i] = 1;
 		}
+		update_priority_sources();
 
 		for (unsigned n = 0; n < NumberCores; ++n) {
 		    target_harts[n] = nullptr;
@@ -94,6 +108,20 @@ struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
 		e_run.notify(clock_cycle);
 	}
 
+	bool gateway_interrupt_enabled(uint32_t irq_id) {
+		assert(irq_id < NumberInterrupts);
+
+		for (unsigned n = 0; n < NumberCores; ++n) {
+			if (hart_enabled_interrupts(n, irq_id / 32) & (1u << (irq_id % 32)))
+				return true;
+		}
+		return false;
+	}
+
+	const sc_core::sc_event *gateway_enable_event() {
+		return &e_enable;
+	}
+
 	void clear_pending_interrupt(unsigned irq_id) {
 		assert(irq_id < NumberInterrupts);  // NOTE: ignore clear of zero interrupt (zero is not available)
 		// std::cout << "[vp::plic] clear pending interrupt " << irq_id << std::endl;
@@ -105,39 +133,62 @@ struct FE310_PLIC : public sc_core::sc_module, public interrupt_gateway {
 	}
 
 	unsigned hart_get_next_pending_interrupt(unsigned hart_id, bool consider_threshold) {
-		unsigned min_id = 0;
-		unsigned max_priority = 0;
+		unsigned min_priority = 1;
+		if (consider_threshold) {
+			auto threshold = hart_config[hart_id].priority_threshold;
+			if (threshold >= MaxPriority)
+				return 0;
+			min_priority = threshold + 1;
+		}
 
-		for (unsigned i = 1; i < NumberInterrupts; ++i) {
-			unsigned idx = i / 32;
-			unsigned off = i % 32;
-
-			if (hart_enabled_interrupts(hart_id, idx) & (1 << off)) {
-				if (pending_interrupts[idx] & (1 << off)) {
-					auto prio = interrupt_priorities[i];
-					if (prio > 0 && (!consider_threshold || (prio > hart_config[hart_id].priority_threshold))) {
-						if (prio > max_priority) {
-							max_priority = prio;
-							min_id = i;
-						}
-					}
-				}
+		std::array<uint32_t, NumberWords> candidates;
+		uint32_t any = 0;
+		for (unsigned idx = 0; idx < NumberWords; ++idx) {
+			candidates[idx] = pending_interrupts[idx] & hart_enabled_interrupts(hart_id, idx);
+			any |= candidates[idx];
+		}
+		if (!any)
+			return 0;
+
+		// highest priority first, the lowest ID wins among interrupts with the same priority
+		for (unsigned prio = MaxPriority; prio >= min_priority; --prio) {
+			for (unsigned idx = 0; idx < NumberWords; ++idx) {
+				uint32_t bits = candidates[idx] & priority_sources[prio][idx];
+				if (bits)
+					return idx * 32 + __builtin_ctz(bits);
 			}
 		}
 
-		return min_id;
+		return 0;
+	}
+
+	void update_priority_sources() {
+		for (auto &e : priority_sources) e.fill(0);
+
+		// interrupt 0 does not exist and priority 0 never interrupts, hence both are never looked up
+		for (unsigned i = 1; i < NumberInterrupts; ++i) {
+			priority_sources[interrupt_priorities[i]][i / 32] |= 1u << (i % 32);
+		}
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 		delay += 4 * clock_cycle;
 
-		vp::mm::route("FE310_PLIC", register_ranges, trans, delay);
+		register_map.route(trans, delay);
 	}
 
 	void post_write_interrupt_priorities(RegisterRange::WriteInfo t) {
 		(void)t;
 
-		for (auto &x : interrupt_priorities) x = std::min(x, MaxPriority);
+		for (unsigned i = 0; i < NumberInterrupts; ++i)
+			interrupt_priorities[i] = std::min(interrupt_priorities[i], MaxPriority);
+		update_priority_sources();
+	}
+
+	void post_write_hart_enabled_interrupts(RegisterRange::WriteInfo t) {
+		(void)t;
+
+		e_enable.notify(sc_core::SC_ZERO_TIME);
 	}
 
 	bool pre_read_hart_config(RegisterRange::ReadInfo t) {
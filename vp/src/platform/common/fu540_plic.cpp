@@ -29,14 +29,15 @@ FU540_PLIC::FU540_PLIC(sc_core::sc_module_name, unsigned harts) {
 	clock_cycle = sc_core::sc_time(10, sc_core::SC_NS);
 
 	create_registers();
+	for (unsigned irq = 1; irq <= NUMIRQ; irq++)
+		update_prio_sources(irq);
 	tsock.register_b_transport(this, &FU540_PLIC::transport);
 
 	SC_THREAD(run);
 };
 
 void FU540_PLIC::create_registers(void) {
-	regs_interrupt_priorities.post_write_callback =
-		std::bind(&FU540_PLIC::write_irq_prios, this, std::placeholders::_1);
+	regs_interrupt_priorities.post_write_callback.bind<FU540_PLIC, &FU540_PLIC::write_irq_prios>(this);
 
 	/* make pending interrupts read-only */
 	regs_pending_interrupts.pre_write_callback =
@@ -47,16 +48,16 @@ void FU540_PLIC::create_registers(void) {
 	assert_addr(0x4, 0xD4, &regs_interrupt_priorities);
 	assert_addr(0x1000, 0x1004, &regs_pending_interrupts);
 
-	register_ranges.push_back(&regs_interrupt_priorities);
-	register_ranges.push_back(&regs_pending_interrupts);
+	register_map.add(&regs_interrupt_priorities);
+	register_map.add(&regs_pending_interrupts);
 
 	/* create IRQ enable and context registers */
 	create_hart_regs(ENABLE_BASE, ENABLE_PER_HART, enabled_irqs);
 	create_hart_regs(CONTEXT_BASE, CONTEXT_PER_HART, hart_context);
 
 	/* only supports "naturally aligned 32-bit memory accesses" */
-	for (size_t i = 0; i < register_ranges.size(); i++)
-		register_ranges[i]->alignment = sizeof(uint32_t);
+	for (auto r : register_map)
+		r->set_alignment(sizeof(uint32_t));
 }
 
 void FU540_PLIC::create_hart_regs(uint64_t addr, uint64_t inc, hartmap &map) {
@@ -67,7 +68,7 @@ void FU540_PLIC::create_hart_regs(uint64_t addr, uint64_t inc, hartmap &map) {
 			r->post_write_callback = std::bind(&FU540_PLIC::write_hartctx, this, std::placeholders::_1, h, l);
 		}
 
-		register_ranges.push_back(r);
+		register_map.add(r);
 		return r;
 	};
 
@@ -89,7 +90,7 @@ void FU540_PLIC::create_hart_regs(uint64_t addr, uint64_t inc, hartmap &map) {
 
 void FU540_PLIC::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 	delay += 4 * clock_cycle; /* copied from FE310_PLIC */
-	vp::mm::route("FU540_PLIC", register_ranges, trans, delay);
+	register_map.route(trans, delay);
 };
 
 void FU540_PLIC::gateway_trigger_interrupt(uint32_t irq) {
@@ -162,6 +163,17 @@ void FU540_PLIC::write_irq_prios(RegisterRange::WriteInfo t) {
 
 	auto &elem = interrupt_priorities[idx];
 	elem = std::min(elem, uint32_t(MAX_PRIO));
+
+	/* the priority registers start with interrupt 1 */
+	update_prio_sources(idx + 1);
+}
+
+void FU540_PLIC::update_prio_sources(unsigned int irq) {
+	assert(irq > 0 && irq <= NUMIRQ);
+
+	for (auto &srcs : prio_sources)
+		srcs[GET_IDX(irq)] &= ~GET_OFF(irq);
+	prio_sources[interrupt_priorities[irq - 1]][GET_IDX(irq)] |= GET_OFF(irq);
 }
 
 void FU540_PLIC::run(void) {
@@ -177,28 +189,35 @@ void FU540_PLIC::run(void) {
 	}
 }
 
-/* Returns next enabled pending interrupt with highest priority */
+/* Returns next enabled pending interrupt with highest priority, the
+ * search is done word-wise on the pending & enabled bitmap, starting
+ * with the highest priority level */
 unsigned int FU540_PLIC::next_pending_irq(unsigned int hart, PrivilegeLevel lvl, bool ignth) {
 	assert(!(hart == 0 && lvl == SupervisorMode));
 
 	HartConfig *conf = enabled_irqs[hart];
-	unsigned int selirq = 0, maxpri = 0;
-
-	for (unsigned irq = 1; irq <= NUMIRQ; irq++) {
-		if (!conf->is_enabled(irq, lvl) || !is_pending(irq))
-			continue;
+	ArrayView<uint32_t> &enabled = (lvl == MachineMode) ? conf->m_mode : conf->s_mode;
 
-		uint32_t prio = interrupt_priorities[irq];
-		if (!ignth && prio < get_threshold(hart, lvl))
-			continue;
-
-		if (prio > maxpri) {
-			maxpri = prio;
-			selirq = irq;
+	std::array<uint32_t, NUMWORDS> candidates;
+	uint32_t any = 0;
+	for (unsigned idx = 0; idx < NUMWORDS; idx++) {
+		candidates[idx] = pending_interrupts[idx] & enabled[idx];
+		any |= candidates[idx];
+	}
+	if (!any)
+		return 0;
+
+	/* priority 0 means "never interrupt" */
+	uint32_t minpri = ignth ? 1 : std::max(get_threshold(hart, lvl), uint32_t(1));
+	for (uint32_t prio = MAX_PRIO; prio >= minpri; prio--) {
+		for (unsigned idx = 0; idx < NUMWORDS; idx++) {
+			uint32_t bits = candidates[idx] & prio_sources[prio][idx];
+			if (bits)
+				return idx * 32 + __builtin_ctz(bits);
 		}
 	}
 
-	return selirq;
+	return 0;
 }
 
 bool FU540_PLIC::has_pending_irq(unsigned int hart, PrivilegeLevel *level) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <array>
 #include <map>
 
 /**
@@ -43,7 +44,7 @@ private:
 	sc_core::sc_event e_run;
 	sc_core::sc_time clock_cycle;
 
-	std::vector<RegisterRange*> register_ranges;
+	vp::mm::RegisterMap register_map{"FU540_PLIC"};
 
 	/* hart_id (0..4) → hart_config */
 	typedef std::map<unsigned int, HartConfig*> hartmap;
@@ -55,9 +56,13 @@ private:
 	ArrayView<uint32_t> interrupt_priorities{regs_interrupt_priorities};
 
 	/* See Section 10.4 */
-	RegisterRange regs_pending_interrupts{0x1000, sizeof(uint32_t) * 2};
+	static constexpr unsigned NUMWORDS = (NUMIRQ + 1 + 31) / 32;
+	RegisterRange regs_pending_interrupts{0x1000, sizeof(uint32_t) * NUMWORDS};
 	ArrayView<uint32_t> pending_interrupts{regs_pending_interrupts};
-	
+
+	/* interrupt sources of each priority level, see next_pending_irq */
+	std::array<std::array<uint32_t, NUMWORDS>, MAX_PRIO + 1> prio_sources{};
+
 	void create_registers(void);
 	void create_hart_regs(uint64_t, uint64_t, hartmap&);
 	void transport(tlm::tlm_generic_payload&, sc_core::sc_time&);
@@ -66,6 +71,7 @@ private:
 	void write_irq_prios(RegisterRange::WriteInfo);
 	void run(void);
 	unsigned int next_pending_irq(unsigned int, PrivilegeLevel, bool);
+	void update_prio_sources(unsigned int);
 	bool has_pending_irq(unsigned int, PrivilegeLevel*);
 	uint32_t get_threshold(unsigned int, PrivilegeLevel);
 	void clear_pending(unsigned int);
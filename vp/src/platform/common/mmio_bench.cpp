@@ -0,0 +1,74 @@
+/* Host benchmark of the register access path of the CLINT and the FE310 PLIC: TLM transactions are passed directly
+ * to the transport function of the devices (no bus, no simulation is started), covering register ranges with and
+ * without access callbacks.
+ *
+ * Usage: mmio-bench [accesses] [runs], prints the best of *runs* for each access. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <systemc>
+
+#include "core/common/clint.h"
+#include "fe310_plic.h"
+
+namespace {
+
+struct NullTarget : public clint_interrupt_target {
+	void trigger_timer_interrupt(bool) override {}
+	void trigger_software_interrupt(bool) override {}
+};
+
+unsigned long accesses = 20000000;
+unsigned runs = 6;
+
+template <typename Device>
+void bench(const char *name, Device &dev, tlm::tlm_command cmd, uint64_t addr) {
+	// the address is not known at compile time in the simulation either
+	const volatile uint64_t target = addr;
+	uint32_t data = 0;
+	tlm::tlm_generic_payload trans;
+	trans.set_data_ptr((unsigned char *)&data);
+	sc_core::sc_time delay;
+
+	double best = 0;
+	for (unsigned r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < accesses; ++i) {
+			trans.set_command(cmd);
+			trans.set_address(target);
+			trans.set_data_length(4);
+			dev.transport(trans, delay);
+		}
+		std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+		best = r ? std::min(best, t.count()) : t.count();
+	}
+
+	double ns = best / accesses;
+	printf("%-32s %6.2f ns %8.1f M accesses/s\n", name, ns, 1000 / ns);
+}
+
+}  // namespace
+
+int sc_main(int argc, char **argv) {
+	if (argc > 1)
+		accesses = strtoul(argv[1], nullptr, 0);
+	if (argc > 2)
+		runs = std::max(1ul, strtoul(argv[2], nullptr, 0));
+
+	NullTarget hart;
+	CLINT<1> clint("clint");
+	clint.target_harts[0] = &hart;
+
+	FE310_PLIC<1, 53, 96, 7> plic("plic");
+
+	bench("CLINT mtime read", clint, tlm::TLM_READ_COMMAND, 0xBFF8);
+	bench("CLINT msip write", clint, tlm::TLM_WRITE_COMMAND, 0x0);
+	bench("PLIC priority read", plic, tlm::TLM_READ_COMMAND, 0x8);
+	bench("PLIC pending read", plic, tlm::TLM_READ_COMMAND, 0x1000);
+	bench("PLIC threshold read", plic, tlm::TLM_READ_COMMAND, 0x200000);
+	return 0;
+}
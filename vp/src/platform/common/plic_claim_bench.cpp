@@ -0,0 +1,79 @@
+/* Host benchmark of the claim latency of the FE310 PLIC for 53, 96 and 1024 interrupt sources: a single source is
+ * pending (the last one, with the lowest priority, which is found last) while all sources are enabled, and hart 0
+ * claims it through its claim register. No simulation is started.
+ *
+ * Usage: plic-claim-bench [claims] [runs], prints the best of *runs* for each configuration. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <systemc>
+
+#include "fe310_plic.h"
+
+namespace {
+
+unsigned long claims = 2000000;
+unsigned runs = 6;
+
+template <unsigned NumberInterrupts>
+void bench() {
+	static constexpr unsigned NumberEntries = NumberInterrupts / 32 + 1;
+	static constexpr uint32_t MaxPriority = 7;
+	static constexpr uint64_t CLAIM_REG_ADDR = 0x200004;
+
+	std::string name = "plic" + std::to_string(NumberInterrupts);
+	auto plic = new FE310_PLIC<1, NumberInterrupts, NumberEntries, MaxPriority>(name.c_str());
+
+	uint32_t data = 0;
+	tlm::tlm_generic_payload trans;
+	trans.set_data_ptr((unsigned char *)&data);
+	trans.set_data_length(4);
+	sc_core::sc_time delay;
+
+	// priorities 2..MaxPriority, except for the pending source
+	const unsigned irq = NumberInterrupts - 1;
+	for (unsigned i = 1; i < NumberInterrupts; ++i) {
+		data = (i == irq) ? 1 : 2 + i % (MaxPriority - 1);
+		trans.set_command(tlm::TLM_WRITE_COMMAND);
+		trans.set_address(4 * i);
+		plic->transport(trans, delay);
+	}
+	for (unsigned i = 0; i < NumberEntries; ++i) plic->hart_enabled_interrupts(0, i) = 0xffffffff;
+
+	double best = 0;
+	unsigned long errors = 0;
+	for (unsigned r = 0; r < runs; ++r) {
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned long i = 0; i < claims; ++i) {
+			plic->pending_interrupts[irq / 32] |= 1u << (irq % 32);
+			trans.set_command(tlm::TLM_READ_COMMAND);
+			trans.set_address(CLAIM_REG_ADDR);
+			plic->transport(trans, delay);
+			errors += data != irq;
+		}
+		std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+		best = r ? std::min(best, t.count()) : t.count();
+	}
+
+	printf("%5u sources: %8.1f ns per claim%s\n", NumberInterrupts, best / claims,
+	       errors ? " (wrong interrupt claimed)" : "");
+}
+
+}  // namespace
+
+int sc_main(int argc, char **argv) {
+	if (argc > 1)
+		claims = strtoul(argv[1], nullptr, 0);
+	if (argc > 2)
+		runs = std::max(1ul, strtoul(argv[2], nullptr, 0));
+
+	bench<53>();
+	bench<96>();
+	bench<1024>();
+	return 0;
+}
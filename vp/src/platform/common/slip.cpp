@@ -124,7 +124,12 @@ void SLIP::handle_input(int fd) {
 	rxpush(SLIP_END);
 }
 
-void SLIP::write_data(uint8_t data) {
+void SLIP::write_data(const uint8_t *data, size_t len) {
+	for (size_t i = 0; i < len; i++)
+		write_byte(data[i]);
+}
+
+void SLIP::write_byte(uint8_t data) {
 	if (data == SLIP_END) {
 		if (sndsiz > 0)
 			send_packet();
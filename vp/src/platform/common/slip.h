@@ -13,7 +13,8 @@ public:
 private:
 	int get_mtu(const char *);
 	void send_packet(void);
-	void write_data(uint8_t) override;
+	void write_byte(uint8_t);
+	void write_data(const uint8_t *, size_t) override;
 	void handle_input(int fd) override;
 
 	int tunfd;
@@ -15,40 +15,44 @@
 #define KEY_EXIT 'x'        /* x (character to exit in command mode) */
 #define KEY_CEXIT CTRL(KEY_EXIT) /* Ctrl-x (character to exit in command mode) */
 
-UART::UART(const sc_core::sc_module_name& name, uint32_t irqsrc)
-		: AbstractUART(name, irqsrc) {
-	enableRawMode(STDIN_FILENO);
-	start_threads(STDIN_FILENO);
+UART::UART(const sc_core::sc_module_name& name, uint32_t irqsrc, bool input)
+		: AbstractUART(name, irqsrc), input(input) {
+	if (input)
+		enableRawMode(STDIN_FILENO);
+	start_threads(input ? STDIN_FILENO : -1); /* poll ignores negative descriptors */
 }
 
 UART::~UART(void) {
-	disableRawMode(STDIN_FILENO);
+	if (input)
+		disableRawMode(STDIN_FILENO);
 }
 
 void UART::handle_input(int fd) {
-	uint8_t buf;
+	uint8_t buf[64];
 	ssize_t nread;
 
-	nread = read(fd, &buf, sizeof(buf));
+	nread = read(fd, buf, sizeof(buf));
 	if (nread == -1)
 		throw std::system_error(errno, std::generic_category());
-	else if (nread != sizeof(buf))
+	else if (nread == 0)
 		throw std::runtime_error("short read");
 
-	switch (state) {
-	case STATE_NORMAL:
-		rxpush(buf);
-		break;
-	case STATE_COMMAND:
-		handle_cmd(buf);
-		break;
-	}
+	for (ssize_t i = 0; i < nread; i++) {
+		switch (state) {
+		case STATE_NORMAL:
+			rxpush(buf[i]);
+			break;
+		case STATE_COMMAND:
+			handle_cmd(buf[i]);
+			break;
+		}
 
-	/* update state of input state machine for next run */
-	if (buf == KEY_ESC && state != STATE_COMMAND) {
-		state = STATE_COMMAND;
-	} else {
-		state = STATE_NORMAL;
+		/* update state of input state machine for next character */
+		if (buf[i] == KEY_ESC && state != STATE_COMMAND) {
+			state = STATE_COMMAND;
+		} else {
+			state = STATE_NORMAL;
+		}
 	}
 }
 
@@ -66,12 +70,16 @@ void UART::handle_cmd(uint8_t cmd) {
 	}
 }
 
-void UART::write_data(uint8_t data) {
-	ssize_t nwritten;
+void UART::write_data(const uint8_t *data, size_t len) {
+	while (len > 0) {
+		ssize_t nwritten = write(STDOUT_FILENO, data, len);
+		if (nwritten == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		}
 
-	nwritten = write(STDOUT_FILENO, &data, sizeof(data));
-	if (nwritten == -1)
-		throw std::system_error(errno, std::generic_category());
-	else if (nwritten != sizeof(data))
-		throw std::runtime_error("short write");
+		data += nwritten;
+		len -= nwritten;
+	}
 }
@@ -7,7 +7,8 @@
 
 class UART : public AbstractUART {
 public:
-	UART(const sc_core::sc_module_name&, uint32_t);
+	/* without *input* the terminal is left to another device (e.g. the virtio console), output still goes to stdout */
+	UART(const sc_core::sc_module_name&, uint32_t, bool input = true);
 	~UART(void);
 
 private:
@@ -23,10 +24,11 @@ private:
 	 * character is interpreted by ::handle_cmd.
 	 */
 	uart_state state = STATE_NORMAL;
+	bool input;
 	void handle_cmd(uint8_t);
 
 	void handle_input(int fd) override;
-	void write_data(uint8_t) override;
+	void write_data(const uint8_t *, size_t) override;
 };
 
 #endif  // RISCV_VP_UART_H
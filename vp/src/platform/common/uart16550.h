@@ -16,7 +16,7 @@ struct UART16550 : public sc_core::sc_module {
 	RegisterRange mm_regs{0x0, 8};
 	ArrayView<uint8_t> regs{mm_regs};
 
-	std::vector<RegisterRange *> register_ranges{&mm_regs};
+	vp::mm::RegisterMap register_map{"UART16550", {&mm_regs}};
 
 	std::deque<uint8_t> rx_fifo;
 	bool initialized = false;
@@ -38,8 +38,8 @@ struct UART16550 : public sc_core::sc_module {
 		raw.c_lflag &= ~(ICANON);  // Bytewise read
 		tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
 
-		mm_regs.pre_read_callback = std::bind(&UART16550::pre_read_regs, this, std::placeholders::_1);
-		mm_regs.post_write_callback = std::bind(&UART16550::post_write_regs, this, std::placeholders::_1);
+		mm_regs.pre_read_callback.bind<UART16550, &UART16550::pre_read_regs>(this);
+		mm_regs.post_write_callback.bind<UART16550, &UART16550::post_write_regs>(this);
 	}
 
 	~UART16550() {
@@ -93,6 +93,6 @@ struct UART16550 : public sc_core::sc_module {
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
-		vp::mm::route("UART16550", register_ranges, trans, delay);
+		register_map.route(trans, delay);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include "virtio.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <stdexcept>
+#include <system_error>
+
+enum {
+	MAGIC_VALUE_REG_ADDR = 0x000,
+	VERSION_REG_ADDR = 0x004,
+	DEVICE_ID_REG_ADDR = 0x008,
+	VENDOR_ID_REG_ADDR = 0x00c,
+	DEVICE_FEATURES_REG_ADDR = 0x010,
+	DEVICE_FEATURES_SEL_REG_ADDR = 0x014,
+	DRIVER_FEATURES_REG_ADDR = 0x020,
+	DRIVER_FEATURES_SEL_REG_ADDR = 0x024,
+	QUEUE_SEL_REG_ADDR = 0x030,
+	QUEUE_NUM_MAX_REG_ADDR = 0x034,
+	QUEUE_NUM_REG_ADDR = 0x038,
+	QUEUE_READY_REG_ADDR = 0x044,
+	QUEUE_NOTIFY_REG_ADDR = 0x050,
+	INTERRUPT_STATUS_REG_ADDR = 0x060,
+	INTERRUPT_ACK_REG_ADDR = 0x064,
+	STATUS_REG_ADDR = 0x070,
+	QUEUE_DESC_LOW_REG_ADDR = 0x080,
+	QUEUE_DESC_HIGH_REG_ADDR = 0x084,
+	QUEUE_DRIVER_LOW_REG_ADDR = 0x090,
+	QUEUE_DRIVER_HIGH_REG_ADDR = 0x094,
+	QUEUE_DEVICE_LOW_REG_ADDR = 0x0a0,
+	QUEUE_DEVICE_HIGH_REG_ADDR = 0x0a4,
+	CONFIG_GENERATION_REG_ADDR = 0x0fc,
+	CONFIG_SPACE_ADDR = 0x100,
+};
+
+#define VIRTIO_MMIO_MAGIC 0x74726976  // "virt"
+#define VIRTIO_MMIO_VERSION 2
+#define VIRTIO_VENDOR_ID 0x554d4551  // same as QEMU, drivers do not care
+
+static inline void set_low(uint64_t &reg, uint32_t value) {
+	reg = (reg & ~uint64_t(0xffffffff)) | value;
+}
+
+static inline void set_high(uint64_t &reg, uint32_t value) {
+	reg = (reg & 0xffffffff) | (uint64_t(value) << 32);
+}
+
+size_t VirtqChain::read(size_t off, void *dst, size_t len) const {
+	uint8_t *p = (uint8_t *)dst;
+	size_t done = 0;
+	for (auto &v : out) {
+		if (done == len)
+			break;
+		if (off >= v.iov_len) {
+			off -= v.iov_len;
+			continue;
+		}
+		size_t n = std::min(v.iov_len - off, len - done);
+		memcpy(p + done, (uint8_t *)v.iov_base + off, n);
+		done += n;
+		off = 0;
+	}
+	return done;
+}
+
+size_t VirtqChain::write(size_t off, const void *src, size_t len) const {
+	const uint8_t *p = (const uint8_t *)src;
+	size_t done = 0;
+	for (auto &v : in) {
+		if (done == len)
+			break;
+		if (off >= v.iov_len) {
+			off -= v.iov_len;
+			continue;
+		}
+		size_t n = std::min(v.iov_len - off, len - done);
+		memcpy((uint8_t *)v.iov_base + off, p + done, n);
+		done += n;
+		off = 0;
+	}
+	return done;
+}
+
+void VirtqChain::slice(const std::vector<struct iovec> &iov, size_t off, size_t len, std::vector<struct iovec> &dst) {
+	for (auto &v : iov) {
+		if (len == 0)
+			break;
+		if (off >= v.iov_len) {
+			off -= v.iov_len;
+			continue;
+		}
+		size_t n = std::min(v.iov_len - off, len);
+		dst.push_back({(uint8_t *)v.iov_base + off, n});
+		len -= n;
+		off = 0;
+	}
+}
+
+void VirtQueue::reset() {
+	num = MAX_SIZE;
+	ready = false;
+	desc_addr = avail_addr = used_addr = 0;
+	desc = nullptr;
+	last_avail_idx = used_idx = signalled_used_idx = 0;
+}
+
+uint8_t *VirtQueue::translate(uint64_t addr, uint64_t len) {
+	if (addr < guest->get_start() || addr > guest->get_end() || len > guest->get_end() - addr)
+		throw std::runtime_error("[virtio] guest address out of memory range: " + std::to_string(addr));
+	return guest->get_raw_mem_ptr() + (addr - guest->get_start());
+}
+
+void VirtQueue::enable(bool event_idx) {
+	if (num == 0 || num > MAX_SIZE || (num & (num - 1)))
+		throw std::runtime_error("[virtio] invalid queue size " + std::to_string(num));
+	if ((desc_addr % 16) || (avail_addr % 2) || (used_addr % 4))
+		throw std::runtime_error("[virtio] misaligned virtqueue");
+
+	this->event_idx = event_idx;
+
+	desc = (Desc *)translate(desc_addr, sizeof(Desc) * num);
+
+	uint16_t *avail = (uint16_t *)translate(avail_addr, sizeof(uint16_t) * (3 + num));
+	avail_flags = &avail[0];
+	avail_idx = &avail[1];
+	avail_ring = &avail[2];
+	used_event = &avail[2 + num];
+
+	uint8_t *used = translate(used_addr, 2 * sizeof(uint16_t) + sizeof(UsedElem) * num + sizeof(uint16_t));
+	used_flags = (uint16_t *)used;
+	used_idx_ptr = (uint16_t *)(used + sizeof(uint16_t));
+	used_ring = (UsedElem *)(used + 2 * sizeof(uint16_t));
+	avail_event = (uint16_t *)(used + 2 * sizeof(uint16_t) + sizeof(UsedElem) * num);
+
+	*used_flags = 0;
+	ready = true;
+}
+
+bool VirtQueue::has_available() const {
+	return ready && *avail_idx != last_avail_idx;
+}
+
+bool VirtQueue::pop(VirtqChain &chain) {
+	if (!has_available())
+		return false;
+	if ((uint16_t)(*avail_idx - last_avail_idx) > num)
+		throw std::runtime_error("[virtio] driver made too many buffers available");
+
+	chain.head = avail_ring[last_avail_idx % num];
+	chain.out.clear();
+	chain.in.clear();
+	chain.out_len = 0;
+	chain.in_len = 0;
+	++last_avail_idx;
+
+	uint16_t i = chain.head;
+	for (unsigned n = 0;; ++n) {
+		if (i >= num || n >= num)
+			throw std::runtime_error("[virtio] invalid descriptor chain");
+
+		Desc d = desc[i];
+		if (d.flags & VIRTQ_DESC_F_INDIRECT)
+			throw std::runtime_error("[virtio] indirect descriptors have not been negotiated");
+
+		struct iovec v = {translate(d.addr, d.len), d.len};
+		if (d.flags & VIRTQ_DESC_F_WRITE) {
+			chain.in.push_back(v);
+			chain.in_len += d.len;
+		} else {
+			if (!chain.in.empty())
+				throw std::runtime_error("[virtio] device readable descriptor after writable one");
+			chain.out.push_back(v);
+			chain.out_len += d.len;
+		}
+
+		if (!(d.flags & VIRTQ_DESC_F_NEXT))
+			break;
+		i = d.next;
+	}
+
+	return true;
+}
+
+void VirtQueue::push(const VirtqChain &chain, uint32_t len) {
+	used_ring[used_idx % num] = {chain.head, len};
+	++used_idx;
+	*used_idx_ptr = used_idx;
+}
+
+void VirtQueue::set_notification(bool enable) {
+	if (event_idx) {
+		if (enable)
+			*avail_event = last_avail_idx;
+	} else {
+		*used_flags = enable ? 0 : VIRTQ_USED_F_NO_NOTIFY;
+	}
+}
+
+bool VirtQueue::should_interrupt() {
+	uint16_t old_idx = signalled_used_idx;
+	signalled_used_idx = used_idx;
+	if (old_idx == used_idx)
+		return false;
+
+	if (!event_idx)
+		return !(*avail_flags & VIRTQ_AVAIL_F_NO_INTERRUPT);
+	// see vring_need_event in the specification
+	return (uint16_t)(used_idx - *used_event - 1) < (uint16_t)(used_idx - old_idx);
+}
+
+VirtioMMIO::VirtioMMIO(sc_core::sc_module_name, uint32_t irq, uint32_t device_id, MemoryDMI guest,
+                       unsigned num_queues, uint64_t features)
+    : irq(irq),
+      device_id(device_id),
+      device_features(features | (1ull << VIRTIO_F_VERSION_1) | (1ull << VIRTIO_RING_F_EVENT_IDX)),
+      guest(guest) {
+	queues.assign(num_queues, VirtQueue(&this->guest));
+	tsock.register_b_transport(this, &VirtioMMIO::transport);
+
+	SC_METHOD(process_queues);
+	sensitive << notify_event;
+	dont_initialize();
+}
+
+VirtioMMIO::~VirtioMMIO() {
+	stop_host_thread();
+}
+
+void VirtioMMIO::start_host_thread(int fd) {
+	if ((stop_efd = eventfd(0, EFD_CLOEXEC)) == -1)
+		throw std::system_error(errno, std::generic_category());
+	host_event.reset(new AsyncEvent());
+
+	SC_METHOD(process_host_input);
+	sensitive << *host_event;
+	dont_initialize();
+
+	host_thread = new std::thread(&VirtioMMIO::host_loop, this, fd);
+}
+
+/* Has to be called by the destructor of a device that uses host_input,
+ * as the thread must not outlive the device specific members. */
+void VirtioMMIO::stop_host_thread() {
+	if (!host_thread)
+		return;
+
+	uint64_t one = 1;
+	if (write(stop_efd, &one, sizeof(one)) != sizeof(one))
+		throw std::system_error(errno, std::generic_category());
+	host_thread->join();
+	delete host_thread;
+	host_thread = nullptr;
+	close(stop_efd);
+}
+
+void VirtioMMIO::host_loop(int fd) {
+	struct pollfd fds[2] = {
+	    {stop_efd, POLLIN, 0},
+	    {fd, POLLIN, 0},
+	};
+
+	while (true) {
+		if (poll(fds, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		}
+		if (fds[0].revents)
+			return;
+		if (fds[1].revents & (POLLERR | POLLNVAL))
+			throw std::runtime_error("[virtio] host file descriptor failed");
+		if (fds[1].revents)
+			host_input(fd);
+	}
+}
+
+void VirtioMMIO::process_host_input() {
+	if (driver_ok())
+		host_ready();
+}
+
+void VirtioMMIO::used_buffers(VirtQueue &queue) {
+	if (queue.should_interrupt())
+		raise_interrupt(VIRTIO_INT_USED_BUFFER);
+}
+
+void VirtioMMIO::raise_interrupt(uint32_t reason) {
+	interrupt_status |= reason;
+	plic->gateway_trigger_interrupt(irq);
+}
+
+void VirtioMMIO::process_queues() {
+	while (pending_queues) {
+		unsigned idx = __builtin_ctz(pending_queues);
+		pending_queues &= ~(1u << idx);
+		if (driver_ok() && queues[idx].ready)
+			queue_notify(idx);
+	}
+}
+
+void VirtioMMIO::reset() {
+	driver_features = 0;
+	device_features_sel = 0;
+	driver_features_sel = 0;
+	queue_sel = 0;
+	interrupt_status = 0;
+	status = 0;
+	pending_queues = 0;
+	for (auto &q : queues) q.reset();
+	device_reset();
+}
+
+uint32_t VirtioMMIO::read_reg(uint64_t addr) {
+	switch (addr) {
+		case MAGIC_VALUE_REG_ADDR:
+			return VIRTIO_MMIO_MAGIC;
+		case VERSION_REG_ADDR:
+			return VIRTIO_MMIO_VERSION;
+		case DEVICE_ID_REG_ADDR:
+			return device_id;
+		case VENDOR_ID_REG_ADDR:
+			return VIRTIO_VENDOR_ID;
+		case DEVICE_FEATURES_REG_ADDR:
+			return device_features_sel < 2 ? device_features >> (32 * device_features_sel) : 0;
+		case QUEUE_NUM_MAX_REG_ADDR:
+			return queue_sel < queues.size() ? VirtQueue::MAX_SIZE : 0;
+		case QUEUE_READY_REG_ADDR:
+			return queue_sel < queues.size() && queues[queue_sel].ready;
+		case INTERRUPT_STATUS_REG_ADDR:
+			return interrupt_status;
+		case STATUS_REG_ADDR:
+			return status;
+		case CONFIG_GENERATION_REG_ADDR:
+			return 0;  // the configuration space does not change
+		default:
+			return 0;  // write only or reserved
+	}
+}
+
+void VirtioMMIO::write_reg(uint64_t addr, uint32_t value) {
+	VirtQueue *q = queue_sel < queues.size() ? &queues[queue_sel] : nullptr;
+
+	switch (addr) {
+		case DEVICE_FEATURES_SEL_REG_ADDR:
+			device_features_sel = value;
+			break;
+		case DRIVER_FEATURES_REG_ADDR:
+			if (driver_features_sel == 0)
+				set_low(driver_features, value);
+			else if (driver_features_sel == 1)
+				set_high(driver_features, value);
+			break;
+		case DRIVER_FEATURES_SEL_REG_ADDR:
+			driver_features_sel = value;
+			break;
+		case QUEUE_SEL_REG_ADDR:
+			queue_sel = value;
+			break;
+		case QUEUE_NUM_REG_ADDR:
+			if (q)
+				q->num = value;
+			break;
+		case QUEUE_READY_REG_ADDR:
+			if (!q)
+				break;
+			if (value)
+				q->enable(driver_features & (1ull << VIRTIO_RING_F_EVENT_IDX));
+			else
+				q->ready = false;
+			break;
+		case QUEUE_NOTIFY_REG_ADDR:
+			if (value < queues.size()) {
+				pending_queues |= 1u << value;
+				notify_event.notify(sc_core::SC_ZERO_TIME);
+			}
+			break;
+		case INTERRUPT_ACK_REG_ADDR:
+			interrupt_status &= ~value;
+			if (interrupt_status)
+				plic->gateway_trigger_interrupt(irq);
+			break;
+		case STATUS_REG_ADDR:
+			if (value == 0) {
+				reset();
+				break;
+			}
+			if ((value & VIRTIO_STATUS_FEATURES_OK) && (driver_features & ~device_features))
+				value &= ~VIRTIO_STATUS_FEATURES_OK;  // driver accepted features we do not offer
+			status = value;
+			if (driver_ok())
+				host_ready();  // input might have arrived before the driver was ready
+			break;
+		case QUEUE_DESC_LOW_REG_ADDR:
+			if (q)
+				set_low(q->desc_addr, value);
+			break;
+		case QUEUE_DESC_HIGH_REG_ADDR:
+			if (q)
+				set_high(q->desc_addr, value);
+			break;
+		case QUEUE_DRIVER_LOW_REG_ADDR:
+			if (q)
+				set_low(q->avail_addr, value);
+			break;
+		case QUEUE_DRIVER_HIGH_REG_ADDR:
+			if (q)
+				set_high(q->avail_addr, value);
+			break;
+		case QUEUE_DEVICE_LOW_REG_ADDR:
+			if (q)
+				set_low(q->used_addr, value);
+			break;
+		case QUEUE_DEVICE_HIGH_REG_ADDR:
+			if (q)
+				set_high(q->used_addr, value);
+			break;
+		default:
+			break;  // read only or reserved
+	}
+}
+
+void VirtioMMIO::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+	uint64_t addr = trans.get_address();
+	uint8_t *ptr = trans.get_data_ptr();
+	unsigned len = trans.get_data_length();
+
+	if (addr >= CONFIG_SPACE_ADDR) {
+		// the configuration space is read only for all implemented devices
+		uint64_t off = addr - CONFIG_SPACE_ADDR;
+		if (trans.is_read()) {
+			memset(ptr, 0, len);
+			if (off < config.size())
+				memcpy(ptr, config.data() + off, std::min<uint64_t>(len, config.size() - off));
+		}
+	} else {
+		if (len != 4 || (addr % 4))
+			throw std::runtime_error("[virtio] only aligned 32 bit register accesses are supported");
+
+		uint32_t value;
+		if (trans.is_read()) {
+			value = read_reg(addr);
+			memcpy(ptr, &value, sizeof(value));
+		} else {
+			memcpy(&value, ptr, sizeof(value));
+			write_reg(addr, value);
+		}
+	}
+
+	trans.set_response_status(tlm::TLM_OK_RESPONSE);
+}
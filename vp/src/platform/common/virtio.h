@@ -0,0 +1,205 @@
+#ifndef RISCV_VP_VIRTIO_H
+#define RISCV_VP_VIRTIO_H
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <systemc>
+#include <tlm_utils/simple_target_socket.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "core/common/dmi.h"
+#include "core/common/irq_if.h"
+#include "platform/common/async_event.h"
+
+/* virtio over MMIO (virtio specification v1.1, section 4.2), only the
+ * non-legacy register layout (version 2) is implemented. */
+
+// device types
+#define VIRTIO_ID_NONE 0  // the driver ignores the device, used for unconfigured devices
+#define VIRTIO_ID_NET 1
+#define VIRTIO_ID_BLOCK 2
+#define VIRTIO_ID_CONSOLE 3
+
+// device independent feature bits
+#define VIRTIO_RING_F_EVENT_IDX 29
+#define VIRTIO_F_VERSION_1 32
+
+// device status
+#define VIRTIO_STATUS_ACKNOWLEDGE 1
+#define VIRTIO_STATUS_DRIVER 2
+#define VIRTIO_STATUS_DRIVER_OK 4
+#define VIRTIO_STATUS_FEATURES_OK 8
+#define VIRTIO_STATUS_DEVICE_NEEDS_RESET 64
+#define VIRTIO_STATUS_FAILED 128
+
+// interrupt status
+#define VIRTIO_INT_USED_BUFFER 1
+#define VIRTIO_INT_CONFIG_CHANGE 2
+
+#define VIRTQ_DESC_F_NEXT 1
+#define VIRTQ_DESC_F_WRITE 2
+#define VIRTQ_DESC_F_INDIRECT 4
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT 1
+#define VIRTQ_USED_F_NO_NOTIFY 1
+
+/* A descriptor chain with all buffers translated to host pointers, see
+ * VirtQueue::pop. *out* buffers are read by the device, *in* buffers
+ * are written by the device. */
+struct VirtqChain {
+	uint16_t head;
+	std::vector<struct iovec> out;
+	std::vector<struct iovec> in;
+	size_t out_len;
+	size_t in_len;
+
+	/* gather/scatter *len* bytes starting at offset *off*, return the number of bytes copied */
+	size_t read(size_t off, void *dst, size_t len) const;
+	size_t write(size_t off, const void *src, size_t len) const;
+
+	/* appends the buffers of the byte range [off, off + len) of *iov* to *dst* */
+	static void slice(const std::vector<struct iovec> &iov, size_t off, size_t len, std::vector<struct iovec> &dst);
+};
+
+/* Split virtqueue, the rings are accessed in place through the DMI
+ * pointer of the guest memory. */
+class VirtQueue {
+   public:
+	static constexpr uint32_t MAX_SIZE = 256;
+
+	uint32_t num = MAX_SIZE;
+	bool ready = false;
+	uint64_t desc_addr = 0;
+	uint64_t avail_addr = 0;
+	uint64_t used_addr = 0;
+
+	VirtQueue(MemoryDMI *guest) : guest(guest) {}
+
+	void reset();
+	/* resolves the ring addresses, called once the driver sets QueueReady */
+	void enable(bool event_idx);
+
+	bool has_available() const;
+	/* takes the next available descriptor chain, returns false if there is none */
+	bool pop(VirtqChain &chain);
+	/* returns a chain to the driver, *len* bytes have been written to its in buffers */
+	void push(const VirtqChain &chain, uint32_t len);
+	/* suppress driver notifications while the device processes the queue anyway */
+	void set_notification(bool enable);
+	/* whether the driver asked to be interrupted for the chains pushed since the last call */
+	bool should_interrupt();
+
+   private:
+	struct Desc {
+		uint64_t addr;
+		uint32_t len;
+		uint16_t flags;
+		uint16_t next;
+	};
+
+	struct UsedElem {
+		uint32_t id;
+		uint32_t len;
+	};
+
+	MemoryDMI *guest;
+	bool event_idx = false;
+
+	Desc *desc = nullptr;
+	volatile uint16_t *avail_flags = nullptr;
+	volatile uint16_t *avail_idx = nullptr;
+	uint16_t *avail_ring = nullptr;
+	volatile uint16_t *used_event = nullptr;  // with VIRTIO_RING_F_EVENT_IDX
+	volatile uint16_t *used_flags = nullptr;
+	volatile uint16_t *used_idx_ptr = nullptr;
+	UsedElem *used_ring = nullptr;
+	volatile uint16_t *avail_event = nullptr;  // with VIRTIO_RING_F_EVENT_IDX
+
+	uint16_t last_avail_idx = 0;
+	uint16_t used_idx = 0;
+	uint16_t signalled_used_idx = 0;
+
+	uint8_t *translate(uint64_t addr, uint64_t len);
+};
+
+/* Common part of all virtio-mmio devices: the register interface, the
+ * virtqueues and an optional host thread that waits for input on a file
+ * descriptor.
+ *
+ * Queue notifications are not processed within the register write but
+ * in a SystemC method at the end of the current delta cycle. Until then
+ * (with VIRTIO_RING_F_EVENT_IDX) the driver does not notify again, and
+ * all chains handled in one pass cause at most one interrupt. */
+class VirtioMMIO : public sc_core::sc_module {
+   public:
+	tlm_utils::simple_target_socket<VirtioMMIO> tsock;
+	interrupt_gateway *plic = nullptr;
+
+	VirtioMMIO(sc_core::sc_module_name, uint32_t irq, uint32_t device_id, MemoryDMI guest, unsigned num_queues,
+	           uint64_t features);
+	virtual ~VirtioMMIO();
+
+	SC_HAS_PROCESS(VirtioMMIO);
+
+   protected:
+	std::vector<VirtQueue> queues;
+	std::vector<uint8_t> config;  // device specific configuration space
+
+	bool driver_ok() const {
+		return status & VIRTIO_STATUS_DRIVER_OK;
+	}
+
+	/* to be called after chains have been pushed to *queue* */
+	void used_buffers(VirtQueue &queue);
+
+	void start_host_thread(int fd);
+	void stop_host_thread();
+
+	/* called for each queue the driver notified */
+	virtual void queue_notify(unsigned idx) = 0;
+	/* called when the driver resets the device */
+	virtual void device_reset() {}
+	/* called from the host thread once *fd* is readable */
+	virtual void host_input(int fd) {}
+	/* called from SystemC after host_input signaled new data */
+	virtual void host_ready() {}
+
+	void signal_host_ready() {
+		host_event->notify();
+	}
+
+   private:
+	const uint32_t irq;
+	const uint32_t device_id;
+	const uint64_t device_features;
+	MemoryDMI guest;
+
+	uint64_t driver_features = 0;
+	uint32_t device_features_sel = 0;
+	uint32_t driver_features_sel = 0;
+	uint32_t queue_sel = 0;
+	uint32_t interrupt_status = 0;
+	uint32_t status = 0;
+
+	uint32_t pending_queues = 0;
+	sc_core::sc_event notify_event;
+
+	std::unique_ptr<AsyncEvent> host_event;
+	std::thread *host_thread = nullptr;
+	int stop_efd = -1;
+
+	void transport(tlm::tlm_generic_payload &, sc_core::sc_time &);
+	uint32_t read_reg(uint64_t addr);
+	void write_reg(uint64_t addr, uint32_t value);
+	void reset();
+	void raise_interrupt(uint32_t);
+	void process_queues();
+	void process_host_input();
+	void host_loop(int fd);
+};
+
+#endif  // RISCV_VP_VIRTIO_H
@@ -0,0 +1,162 @@
+#include "virtio_blk.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#include <stdexcept>
+#include <system_error>
+
+#define VIRTIO_BLK_F_SEG_MAX 2
+#define VIRTIO_BLK_F_RO 5
+#define VIRTIO_BLK_F_BLK_SIZE 6
+#define VIRTIO_BLK_F_FLUSH 9
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+#define VIRTIO_BLK_T_FLUSH 4
+#define VIRTIO_BLK_T_GET_ID 8
+
+#define VIRTIO_BLK_S_OK 0
+#define VIRTIO_BLK_S_IOERR 1
+#define VIRTIO_BLK_S_UNSUPP 2
+
+#define VIRTIO_BLK_ID_BYTES 20
+
+/* struct virtio_blk_req without data and status */
+struct VirtioBlkHeader {
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t sector;
+};
+
+static uint64_t features(bool read_only) {
+	uint64_t f = (1ull << VIRTIO_BLK_F_SEG_MAX) | (1ull << VIRTIO_BLK_F_BLK_SIZE) | (1ull << VIRTIO_BLK_F_FLUSH);
+	if (read_only)
+		f |= 1ull << VIRTIO_BLK_F_RO;
+	return f;
+}
+
+VirtioBlk::VirtioBlk(sc_core::sc_module_name name, uint32_t irq, MemoryDMI guest, const std::string &image,
+                     bool read_only)
+    : VirtioMMIO(name, irq, image.empty() ? VIRTIO_ID_NONE : VIRTIO_ID_BLOCK, guest, 1, features(read_only)) {
+	if (!image.empty()) {
+		fd = open(image.c_str(), (read_only ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+		if (fd == -1)
+			throw std::system_error(errno, std::generic_category(), image);
+
+		struct stat st;
+		if (fstat(fd, &st) == -1)
+			throw std::system_error(errno, std::generic_category(), image);
+		capacity = st.st_size / SECTOR_SIZE;
+	}
+
+	// struct virtio_blk_config up to blk_size: capacity, size_max, seg_max, geometry, blk_size
+	uint32_t seg_max = VirtQueue::MAX_SIZE - 2;  // minus header and status
+	uint32_t blk_size = SECTOR_SIZE;
+	config.assign(24, 0);
+	memcpy(&config[0], &capacity, sizeof(capacity));
+	memcpy(&config[12], &seg_max, sizeof(seg_max));
+	memcpy(&config[20], &blk_size, sizeof(blk_size));
+}
+
+VirtioBlk::~VirtioBlk() {
+	if (fd >= 0)
+		close(fd);
+}
+
+void VirtioBlk::queue_notify(unsigned idx) {
+	VirtQueue &q = queues[idx];
+
+	do {
+		q.set_notification(false);
+		while (q.pop(chain)) {
+			uint32_t len = 0;
+			uint8_t status = handle_request(len);
+			chain.write(chain.in_len - 1, &status, sizeof(status));
+			q.push(chain, len + sizeof(status));
+		}
+		q.set_notification(true);
+	} while (q.has_available());
+
+	used_buffers(q);
+}
+
+/* Returns the request status, *len* is set to the number of data bytes
+ * written to the driver (excluding the status). */
+uint8_t VirtioBlk::handle_request(uint32_t &len) {
+	VirtioBlkHeader hdr;
+	if (chain.read(0, &hdr, sizeof(hdr)) != sizeof(hdr) || chain.in_len == 0)
+		throw std::runtime_error("[virtio-blk] malformed request");
+
+	size_t data_in = chain.in_len - 1;  // the last byte is the status
+	size_t data_out = chain.out_len - sizeof(hdr);
+
+	switch (hdr.type) {
+		case VIRTIO_BLK_T_IN:
+			if (data_in % SECTOR_SIZE || !transfer(false, hdr.sector, data_in))
+				return VIRTIO_BLK_S_IOERR;
+			len = data_in;
+			return VIRTIO_BLK_S_OK;
+
+		case VIRTIO_BLK_T_OUT:
+			if (data_out % SECTOR_SIZE || !transfer(true, hdr.sector, data_out))
+				return VIRTIO_BLK_S_IOERR;
+			return VIRTIO_BLK_S_OK;
+
+		case VIRTIO_BLK_T_FLUSH:
+			return fdatasync(fd) == 0 ? VIRTIO_BLK_S_OK : VIRTIO_BLK_S_IOERR;
+
+		case VIRTIO_BLK_T_GET_ID: {
+			char id[VIRTIO_BLK_ID_BYTES] = "riscv-vp-virtio-blk";
+			len = chain.write(0, id, std::min(data_in, sizeof(id)));
+			return VIRTIO_BLK_S_OK;
+		}
+
+		default:
+			return VIRTIO_BLK_S_UNSUPP;
+	}
+}
+
+/* Transfers *len* bytes starting at *sector* between the image and the
+ * data buffers of the current request. */
+bool VirtioBlk::transfer(bool write, uint64_t sector, size_t len) {
+	uint64_t num_sectors = len / SECTOR_SIZE;
+	if (sector > capacity || num_sectors > capacity - sector)
+		return false;
+
+	iov.clear();
+	if (write)
+		VirtqChain::slice(chain.out, sizeof(VirtioBlkHeader), len, iov);
+	else
+		VirtqChain::slice(chain.in, 0, len, iov);
+
+	off_t offset = sector * SECTOR_SIZE;
+	size_t i = 0;
+	while (i < iov.size()) {
+		ssize_t ans = write ? pwritev(fd, &iov[i], iov.size() - i, offset) : preadv(fd, &iov[i], iov.size() - i, offset);
+		if (ans == -1) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		} else if (ans == 0) {
+			return false;
+		}
+
+		// continue after short transfers
+		offset += ans;
+		while (i < iov.size() && (size_t)ans >= iov[i].iov_len) {
+			ans -= iov[i].iov_len;
+			++i;
+		}
+		if (i < iov.size()) {
+			iov[i].iov_base = (uint8_t *)iov[i].iov_base + ans;
+			iov[i].iov_len -= ans;
+		}
+	}
+
+	return true;
+}
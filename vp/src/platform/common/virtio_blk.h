@@ -0,0 +1,31 @@
+#ifndef RISCV_VP_VIRTIO_BLK_H
+#define RISCV_VP_VIRTIO_BLK_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include "virtio.h"
+
+/* virtio block device backed by a disk image file, the data is
+ * transferred with preadv/pwritev directly from/to guest memory. The
+ * device is announced as VIRTIO_ID_NONE if no image is configured. */
+class VirtioBlk : public VirtioMMIO {
+   public:
+	VirtioBlk(sc_core::sc_module_name, uint32_t irq, MemoryDMI guest, const std::string &image, bool read_only);
+	~VirtioBlk();
+
+   private:
+	static constexpr uint32_t SECTOR_SIZE = 512;
+
+	int fd = -1;
+	uint64_t capacity = 0;  // in sectors
+	VirtqChain chain;
+	std::vector<struct iovec> iov;
+
+	void queue_notify(unsigned) override;
+	uint8_t handle_request(uint32_t &len);
+	bool transfer(bool write, uint64_t offset, size_t len);
+};
+
+#endif  // RISCV_VP_VIRTIO_BLK_H
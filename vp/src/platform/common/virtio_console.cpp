@@ -0,0 +1,116 @@
+#include "virtio_console.h"
+#include "core/common/rawmode.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <system_error>
+
+/* character → control key */
+#define CTRL(c) ((c) & 0x1f)
+
+#define KEY_ESC CTRL('a')         /* Ctrl-a (character to enter command mode) */
+#define KEY_EXIT 'x'              /* x (character to exit in command mode) */
+#define KEY_CEXIT CTRL(KEY_EXIT) /* Ctrl-x (character to exit in command mode) */
+
+enum {
+	RX_QUEUE = 0,
+	TX_QUEUE = 1,
+	NUM_QUEUES,
+};
+
+VirtioConsole::VirtioConsole(sc_core::sc_module_name name, uint32_t irq, MemoryDMI guest, bool enabled)
+    : VirtioMMIO(name, irq, enabled ? VIRTIO_ID_CONSOLE : VIRTIO_ID_NONE, guest, NUM_QUEUES, 0), enabled(enabled) {
+	// struct virtio_console_config: cols, rows, max_nr_ports, emerg_wr (none of the features is offered)
+	config.assign(12, 0);
+
+	if (enabled) {
+		enableRawMode(STDIN_FILENO);
+		start_host_thread(STDIN_FILENO);
+	}
+}
+
+VirtioConsole::~VirtioConsole() {
+	stop_host_thread();
+	if (enabled)
+		disableRawMode(STDIN_FILENO);
+}
+
+void VirtioConsole::queue_notify(unsigned idx) {
+	if (idx == RX_QUEUE)
+		host_ready();
+	else if (idx == TX_QUEUE)
+		transmit();
+}
+
+void VirtioConsole::transmit() {
+	VirtQueue &txq = queues[TX_QUEUE];
+
+	do {
+		txq.set_notification(false);
+		while (txq.pop(chain)) {
+			for (auto &v : chain.out) {
+				const uint8_t *data = (const uint8_t *)v.iov_base;
+				size_t len = v.iov_len;
+				while (len > 0) {
+					ssize_t nwritten = write(STDOUT_FILENO, data, len);
+					if (nwritten == -1) {
+						if (errno == EINTR)
+							continue;
+						throw std::system_error(errno, std::generic_category());
+					}
+					data += nwritten;
+					len -= nwritten;
+				}
+			}
+			txq.push(chain, 0);
+		}
+		txq.set_notification(true);
+	} while (txq.has_available());
+
+	used_buffers(txq);
+}
+
+/* Host thread: handles the escape sequences of the UART and forwards
+ * everything else. */
+void VirtioConsole::host_input(int fd) {
+	uint8_t buf[64];
+	ssize_t nread = read(fd, buf, sizeof(buf));
+	if (nread == -1) {
+		if (errno == EINTR)
+			return;
+		throw std::system_error(errno, std::generic_category());
+	} else if (nread == 0) {
+		throw std::runtime_error("short read");
+	}
+
+	for (ssize_t i = 0; i < nread; i++) {
+		if (escape) {
+			escape = false;
+			if (buf[i] == KEY_EXIT || buf[i] == KEY_CEXIT)
+				exit(EXIT_SUCCESS);
+			if (buf[i] != KEY_ESC)
+				continue; /* unknown command → ignore, double escape is forwarded */
+		} else if (buf[i] == KEY_ESC) {
+			escape = true;
+			continue;
+		}
+		rx_ring.push(buf[i]);
+	}
+
+	signal_host_ready();
+}
+
+void VirtioConsole::host_ready() {
+	VirtQueue &rxq = queues[RX_QUEUE];
+
+	while (!rx_ring.empty() && rxq.pop(chain)) {
+		uint32_t len = 0;
+		for (auto &v : chain.in) len += rx_ring.pop((uint8_t *)v.iov_base, v.iov_len);
+		rxq.push(chain, len);
+	}
+
+	used_buffers(rxq);
+}
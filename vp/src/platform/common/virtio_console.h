@@ -0,0 +1,30 @@
+#ifndef RISCV_VP_VIRTIO_CONSOLE_H
+#define RISCV_VP_VIRTIO_CONSOLE_H
+
+#include <stdint.h>
+
+#include "util/spsc_ring.h"
+#include "virtio.h"
+
+/* virtio console with a single port (hvc0 in Linux) connected to the
+ * terminal. Like the UART, Ctrl-a x terminates the simulation. The
+ * device is announced as VIRTIO_ID_NONE if it is not enabled. */
+class VirtioConsole : public VirtioMMIO {
+   public:
+	VirtioConsole(sc_core::sc_module_name, uint32_t irq, MemoryDMI guest, bool enabled);
+	~VirtioConsole();
+
+   private:
+	/* input is dropped if the driver does not keep up */
+	SPSCRing<uint8_t, 4096> rx_ring;
+	bool enabled;
+	bool escape = false;  // Ctrl-a has been pressed
+	VirtqChain chain;
+
+	void queue_notify(unsigned) override;
+	void host_input(int) override;
+	void host_ready() override;
+	void transmit();
+};
+
+#endif  // RISCV_VP_VIRTIO_CONSOLE_H
@@ -0,0 +1,192 @@
+#include "virtio_net.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <linux/if.h>
+#include <linux/if_tun.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#define VIRTIO_NET_F_MTU 3
+#define VIRTIO_NET_F_MAC 5
+#define VIRTIO_NET_F_STATUS 16
+
+#define VIRTIO_NET_S_LINK_UP 1
+
+/* struct virtio_net_hdr, all offloads are disabled hence the device
+ * only has to set num_buffers (the last field) on receive */
+#define VIRTIO_NET_HDR_SIZE 12
+#define VIRTIO_NET_HDR_NUM_BUFFERS 10
+
+enum {
+	RX_QUEUE = 0,
+	TX_QUEUE = 1,
+	NUM_QUEUES,
+};
+
+static const uint8_t MAC_ADDRESS[6] = {0x02, 0x00, 0x00, 0x12, 0x34, 0x56};
+
+VirtioNet::VirtioNet(sc_core::sc_module_name name, uint32_t irq, MemoryDMI guest, const std::string &tap_device,
+                     const std::string &socket_path)
+    : VirtioMMIO(name, irq, (tap_device.empty() && socket_path.empty()) ? VIRTIO_ID_NONE : VIRTIO_ID_NET, guest,
+                 NUM_QUEUES, (1ull << VIRTIO_NET_F_MTU) | (1ull << VIRTIO_NET_F_MAC) | (1ull << VIRTIO_NET_F_STATUS)) {
+	if (!tap_device.empty() && !socket_path.empty())
+		throw std::runtime_error("[virtio-net] either a TAP device or a socket can be used");
+
+	// struct virtio_net_config: mac, status, max_virtqueue_pairs, mtu
+	config.assign(12, 0);
+	memcpy(&config[0], MAC_ADDRESS, sizeof(MAC_ADDRESS));
+	config[6] = VIRTIO_NET_S_LINK_UP;
+	config[8] = 1;
+	config[10] = MTU & 0xff;
+	config[11] = MTU >> 8;
+
+	if (!tap_device.empty())
+		fd = open_tap(tap_device);
+	else if (!socket_path.empty())
+		fd = open_socket(socket_path);
+	else
+		return;
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == -1)
+		throw std::system_error(errno, std::generic_category());
+	start_host_thread(fd);
+}
+
+VirtioNet::~VirtioNet() {
+	stop_host_thread();
+	if (fd >= 0)
+		close(fd);
+}
+
+void VirtioNet::show() {
+	std::cout << "[vp::virtio-net] " << rx_dropped << " received frames dropped" << std::endl;
+}
+
+int VirtioNet::open_tap(const std::string &dev) {
+	int tapfd = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+	if (tapfd == -1)
+		throw std::system_error(errno, std::generic_category(), "/dev/net/tun");
+
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = IFF_TAP | IFF_NO_PI; /* read/write raw Ethernet frames */
+	strncpy(ifr.ifr_name, dev.c_str(), IFNAMSIZ - 1);
+	if (ioctl(tapfd, TUNSETIFF, (void *)&ifr) == -1) {
+		int e = errno;
+		close(tapfd);
+		throw std::system_error(e, std::generic_category(), dev);
+	}
+
+	return tapfd;
+}
+
+int VirtioNet::open_socket(const std::string &path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		throw std::runtime_error("[virtio-net] socket path too long: " + path);
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+	int sockfd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (sockfd == -1)
+		throw std::system_error(errno, std::generic_category());
+	if (connect(sockfd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		int e = errno;
+		close(sockfd);
+		throw std::system_error(e, std::generic_category(), path);
+	}
+
+	return sockfd;
+}
+
+void VirtioNet::queue_notify(unsigned idx) {
+	if (idx == RX_QUEUE)
+		host_ready();  // new receive buffers
+	else if (idx == TX_QUEUE)
+		transmit();
+}
+
+/* Sends all pending frames, the payload is written directly from guest
+ * memory. Frames the host cannot take right now are dropped. */
+void VirtioNet::transmit() {
+	VirtQueue &txq = queues[TX_QUEUE];
+
+	do {
+		txq.set_notification(false);
+		while (txq.pop(chain)) {
+			iov.clear();
+			VirtqChain::slice(chain.out, VIRTIO_NET_HDR_SIZE, chain.out_len, iov);
+			if (!iov.empty() && writev(fd, iov.data(), iov.size()) == -1) {
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS)
+					throw std::system_error(errno, std::generic_category());
+			}
+			txq.push(chain, 0);
+		}
+		txq.set_notification(true);
+	} while (txq.has_available());
+
+	used_buffers(txq);
+}
+
+/* Host thread: reads all available frames and notifies the SystemC side
+ * once per batch. */
+void VirtioNet::host_input(int fd) {
+	Frame frame;
+	bool received = false;
+
+	while (true) {
+		ssize_t ans = read(fd, frame.data, sizeof(frame.data));
+		if (ans == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::generic_category());
+		} else if (ans == 0) {
+			throw std::runtime_error("[virtio-net] connection closed");
+		}
+
+		frame.size = ans;
+		if (rx_ring.push(frame))
+			received = true;
+		else
+			++rx_dropped;
+	}
+
+	if (received)
+		signal_host_ready();
+}
+
+/* Copies received frames into the receive buffers of the driver. */
+void VirtioNet::host_ready() {
+	VirtQueue &rxq = queues[RX_QUEUE];
+	uint8_t hdr[VIRTIO_NET_HDR_SIZE] = {};
+	hdr[VIRTIO_NET_HDR_NUM_BUFFERS] = 1;
+
+	Frame *frame;
+	while ((frame = rx_ring.front()) && rxq.pop(chain)) {
+		uint32_t len = 0;
+		if (chain.in_len >= VIRTIO_NET_HDR_SIZE + frame->size) {
+			chain.write(0, hdr, sizeof(hdr));
+			chain.write(VIRTIO_NET_HDR_SIZE, frame->data, frame->size);
+			len = VIRTIO_NET_HDR_SIZE + frame->size;
+		} else {
+			++rx_dropped;  // the driver discards the empty buffer
+		}
+		rxq.push(chain, len);
+		rx_ring.discard();
+	}
+
+	used_buffers(rxq);
+}
@@ -0,0 +1,51 @@
+#ifndef RISCV_VP_VIRTIO_NET_H
+#define RISCV_VP_VIRTIO_NET_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include "util/spsc_ring.h"
+#include "virtio.h"
+
+/* virtio network device, frames are exchanged with a TAP device or with
+ * a connected unix SOCK_SEQPACKET socket (one frame per message). The
+ * device is announced as VIRTIO_ID_NONE if neither is configured. */
+class VirtioNet : public VirtioMMIO {
+   public:
+	VirtioNet(sc_core::sc_module_name, uint32_t irq, MemoryDMI guest, const std::string &tap_device,
+	          const std::string &socket_path);
+	~VirtioNet();
+
+	void show();
+
+   private:
+	static constexpr uint16_t MTU = 1500;
+	static constexpr size_t MAX_FRAME_SIZE = MTU + 18;  // Ethernet header with VLAN tag
+
+	struct Frame {
+		uint16_t size;
+		uint8_t data[MAX_FRAME_SIZE];
+	};
+
+	/* filled by the host thread, frames stay in the ring until the
+	 * driver provides receive buffers and are dropped if it is full */
+	SPSCRing<Frame, 256> rx_ring;
+	// counted by the host thread (ring full) and the SystemC thread (receive buffer too small)
+	std::atomic<uint64_t> rx_dropped{0};
+
+	int fd = -1;
+	VirtqChain chain;
+	std::vector<struct iovec> iov;
+
+	int open_tap(const std::string &);
+	int open_socket(const std::string &);
+
+	void queue_notify(unsigned) override;
+	void host_input(int) override;
+	void host_ready() override;
+	void transmit();
+};
+
+#endif  // RISCV_VP_VIRTIO_NET_H
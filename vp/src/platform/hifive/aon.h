@@ -8,9 +8,22 @@
 #include "core/common/irq_if.h"
 #include "util/tlm_map.h"
 
+/* Always-on domain of the FE310. Of the watchdog only the registers exist. The RTC counts the cycles of the 32768 Hz
+ * low frequency clock, the counter is computed from the time since *rtc_base* and the compare interrupt is only
+ * scheduled while a hart has it enabled. */
 struct AON : public sc_core::sc_module {
 	tlm_utils::simple_target_socket<AON> tsock;
 
+	static constexpr uint64_t LFCLK_HZ = 32768;
+	static constexpr uint64_t PS_PER_SEC = 1000000000000;
+	static constexpr uint64_t RTC_COUNT_MASK = (uint64_t(1) << 48) - 1;
+
+	enum : uint32_t {
+		RTC_SCALE_MASK = 0xF,
+		RTC_ENALWAYS = 1 << 12,
+		RTC_CMPIP = 1 << 28,
+	};
+
 	uint32_t wdogcfg = 0;
 	uint32_t wdogcount = 0;
 	uint32_t wdogfeed = 0;
@@ -111,8 +124,17 @@ struct AON : public sc_core::sc_module {
 	};
 
 	vp::map::LocalRouter router = {"AON"};
+	interrupt_gateway *plic = nullptr;
 
-	AON(sc_core::sc_module_name) {
+	const unsigned int_rtccmp;
+	sc_core::sc_time rtc_base;
+	uint64_t rtc_count = 0;  // counter value at *rtc_base*
+	bool rtc_ip = false;     // compare interrupt as last seen by the gateway
+	sc_core::sc_event e_rtc;
+
+	SC_HAS_PROCESS(AON);
+
+	AON(sc_core::sc_module_name, unsigned int_rtccmp) : int_rtccmp(int_rtccmp) {
 		tsock.register_b_transport(this, &AON::transport);
 
 		router
@@ -144,10 +166,92 @@ struct AON : public sc_core::sc_module {
 		        {BACKUP30_REG_ADDR, &backup30},   {BACKUP31_REG_ADDR, &backup31},
 		    })
 		    .register_handler(this, &AON::register_access_callback);
+
+		SC_THREAD(run_rtc);
 	}
 
 	void register_access_callback(const vp::map::register_access_t &r) {
+		auto now = sc_core::sc_time_stamp() + r.delay;
+		bool rtc_reg = r.vptr == &rtccfg || r.vptr == &rtccountlo || r.vptr == &rtccounthi || r.vptr == &rtcs ||
+		               r.vptr == &rtccmp0;
+
+		if (!rtc_reg) {
+			r.fn();
+			return;
+		}
+
+		uint64_t count = rtc_count_at(now);
+		if (r.read) {
+			rtccountlo = count;
+			rtccounthi = count >> 32;
+			rtcs = count >> (rtccfg & RTC_SCALE_MASK);
+			rtccfg = (rtccfg & ~RTC_CMPIP) | (rtc_ip_at(count) ? RTC_CMPIP : 0);
+		} else if (r.vptr == &rtcs) {
+			return;  // read-only
+		}
+
 		r.fn();
+
+		if (r.write) {
+			// the counter continues from here with the new configuration
+			if (r.vptr == &rtccountlo)
+				count = (count & ~uint64_t(UINT32_MAX)) | rtccountlo;
+			else if (r.vptr == &rtccounthi)
+				count = (uint64_t(rtccounthi & 0xFFFF) << 32) | (count & UINT32_MAX);
+			rtccfg &= ~RTC_CMPIP;
+			rtc_count = count;
+			rtc_base = now;
+
+			update_rtc(now);
+			schedule_rtc();
+		}
+	}
+
+	uint64_t rtc_count_at(const sc_core::sc_time &t) const {
+		if (!(rtccfg & RTC_ENALWAYS) || t <= rtc_base)
+			return rtc_count;
+		uint64_t ps = (t - rtc_base).value();
+		uint64_t ticks = ps / PS_PER_SEC * LFCLK_HZ + ps % PS_PER_SEC * LFCLK_HZ / PS_PER_SEC;
+		return (rtc_count + ticks) & RTC_COUNT_MASK;
+	}
+
+	bool rtc_ip_at(uint64_t count) const {
+		return uint32_t(count >> (rtccfg & RTC_SCALE_MASK)) >= rtccmp0;
+	}
+
+	void update_rtc(const sc_core::sc_time &now) {
+		bool ip = rtc_ip_at(rtc_count_at(now));
+		if (ip && !rtc_ip)
+			plic->gateway_trigger_interrupt(int_rtccmp);
+		rtc_ip = ip;
+	}
+
+	/* The compare interrupt stays pending until software moves rtccmp0, only its next rising edge is scheduled. */
+	void schedule_rtc() {
+		e_rtc.cancel();
+
+		uint64_t target = uint64_t(rtccmp0) << (rtccfg & RTC_SCALE_MASK);
+		if (!(rtccfg & RTC_ENALWAYS) || rtc_ip || rtc_count >= target || !plic->gateway_interrupt_enabled(int_rtccmp))
+			return;
+
+		uint64_t ticks = target - rtc_count;
+		uint64_t ps = ticks / LFCLK_HZ * PS_PER_SEC + (ticks % LFCLK_HZ * PS_PER_SEC + LFCLK_HZ - 1) / LFCLK_HZ;
+		auto goal = rtc_base + sc_core::sc_time::from_value(ps);
+		auto now = sc_core::sc_time_stamp();
+		e_rtc.notify(goal > now ? goal - now : sc_core::SC_ZERO_TIME);
+	}
+
+	void run_rtc() {
+		while (true) {
+			const sc_core::sc_event *enable = plic->gateway_enable_event();
+			if (enable)
+				sc_core::wait(e_rtc | *enable);
+			else
+				sc_core::wait(e_rtc);
+
+			update_rtc(sc_core::sc_time_stamp());
+			schedule_rtc();
+		}
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
@@ -2,6 +2,11 @@
 
 using namespace std;
 
+// timestamps of the pushed GPIO events
+static uint64_t to_ps(const sc_core::sc_time &t) {
+	return t / sc_core::sc_time(1, sc_core::SC_PS);
+}
+
 GPIO::GPIO(sc_core::sc_module_name, unsigned int_gpio_base) : int_gpio_base(int_gpio_base) {
 	tsock.register_b_transport(this, &GPIO::transport);
 
@@ -65,12 +70,14 @@ void GPIO::register_access_callback(const vp::map::register_access_t &r) {
 			// client and the interrupt was not fired yet.
 			value = (value & ~output_en) | (port & output_en);
 			server.state = (server.state & ~output_en) | (port & output_en);
+			server.publish(to_ps(sc_core::sc_time_stamp() + r.delay));
 		} else if (r.vptr == &pullup_en) {
 			// cout << "[GPIO] pullup changed" << endl;
 			// bitPrint(reinterpret_cast<unsigned char*>(&pullup_en),
 			// sizeof(uint32_t));
 			value |= reg_bak ^ pullup_en;
 			server.state |= reg_bak ^ pullup_en;
+			server.publish(to_ps(sc_core::sc_time_stamp() + r.delay));
 		} else if (r.vptr == &fall_intr_en) {
 			// cout << "[GPIO] set fall_intr_en to ";
 			// bitPrint(reinterpret_cast<unsigned char*>(&fall_intr_en),
@@ -113,6 +120,9 @@ void GPIO::synchronousChange() {
 	GpioCommon::Reg serverSnapshot = server.state;
 	uint32_t diff = (serverSnapshot ^ value) & input_en;
 
+	// inputs changed by a client, for the other subscribers
+	server.publish(to_ps(sc_core::sc_time_stamp()));
+
 	// bitPrint(reinterpret_cast<unsigned char*>(&diff), 4);
 	// bitPrint(reinterpret_cast<unsigned char*>(&fall_intr_pending), 4);
 
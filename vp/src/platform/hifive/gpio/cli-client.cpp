@@ -14,7 +14,7 @@ using namespace std;
 
 int main(int argc, char* argv[]) {
 	if (argc < 3) {
-		cout << "usage: " << argv[0] << " host port (e.g. localhost 1339)" << endl;
+		cout << "usage: " << argv[0] << " host port [shared] (e.g. localhost 1339)" << endl;
 		exit(-1);
 	}
 
@@ -25,38 +25,24 @@ int main(int argc, char* argv[]) {
 		return -1;
 	}
 
-	while (true) {
-		if (!gpio.update()) {
-			cerr << "Error updating" << endl;
-			return -1;
-		}
-		bitPrint(reinterpret_cast<unsigned char*>(&gpio.state), sizeof(GpioCommon::Reg));
-		usleep(125000);
-	}
-
-	for (uint8_t i = 0; i < 64; i++) {
-		if (!gpio.setBit(i, 1)) {
-			cerr << "Error setting Bit " << i << endl;
-			return -1;
-		}
-		if (!gpio.update()) {
-			cerr << "Error updating" << endl;
-			return -1;
-		}
-		bitPrint(reinterpret_cast<unsigned char*>(&gpio.state), sizeof(GpioCommon::Reg));
-		usleep(750);
+	// print every change with its simulation time
+	bool shared = argc > 3 && string(argv[3]) == "shared";
+	if (!gpio.subscribe(~GpioCommon::Reg(0), shared)) {
+		cerr << "Error subscribing" << endl;
+		return -1;
 	}
-
-	for (uint8_t i = 0; i < 64; i++) {
-		if (!gpio.setBit(i, 0)) {
-			cerr << "Error resetting Bit " << i << endl;
-			return -1;
-		}
-		if (!gpio.update()) {
-			cerr << "Error updating" << endl;
-			return -1;
+	uint32_t dropped = 0;
+	while (gpio.receiveEvents(
+	    [](const GpioCommon::Event& e) {
+		    cout << e.time / 1000 << " ns: ";
+		    bitPrint(reinterpret_cast<unsigned char*>(const_cast<GpioCommon::Reg*>(&e.state)), sizeof(GpioCommon::Reg));
+	    },
+	    true, &dropped)) {
+		if (dropped) {
+			cerr << dropped << " events dropped" << endl;
+			dropped = 0;
 		}
-		bitPrint(reinterpret_cast<unsigned char*>(&gpio.state), sizeof(GpioCommon::Reg));
-		usleep(750);
 	}
+	cerr << "connection closed" << endl;
+	return 0;
 }
@@ -6,6 +6,7 @@
  */
 
 #include <unistd.h>
+#include <chrono>
 #include <csignal>
 #include <functional>
 #include <iostream>
@@ -60,6 +61,7 @@ int main(int argc, char* argv[]) {
 	gpio.registerOnChange(bind(onChangeCallback, &gpio, placeholders::_1, placeholders::_2));
 	thread server(bind(&GpioServer::startListening, &gpio));
 
+	auto start = chrono::steady_clock::now();
 	while (!stop && !gpio.isStopped()) {
 		usleep(100000);
 		if (!(gpio.state & (1 << 11))) {
@@ -67,6 +69,7 @@ int main(int argc, char* argv[]) {
 			if (!(gpio.state & 0xFF)) {
 				gpio.state = 1;
 			}
+			gpio.publish(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count() * 1000);
 		}
 	}
 	gpio.quit();
@@ -11,14 +11,18 @@
 #include <errno.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <iostream>
+#include <vector>
 
 #define ENABLE_DEBUG (0)
 #include "debug.h"
@@ -34,15 +38,21 @@ static void *get_in_addr(struct sockaddr *sa) {
 	return &(((struct sockaddr_in6 *)sa)->sin6_addr);
 }
 
-GpioClient::GpioClient() : fd(-1) {}
+GpioClient::GpioClient() : fd(-1), subscribed(false), ring(nullptr) {}
 
 GpioClient::~GpioClient() {
+	if (ring) {
+		shmdt(ring);
+	}
 	if (fd >= 0) {
 		close(fd);
 	}
 }
 
 bool GpioClient::update() {
+	if (subscribed)
+		return receiveEvents(nullptr, false);
+
 	Request req;
 	memset(&req, 0, sizeof(Request));
 	req.op = GET_BANK;
@@ -71,11 +81,137 @@ bool GpioClient::setBit(uint8_t pos, Tristate val) {
 	return true;
 }
 
+bool GpioClient::setBank(Reg mask, Reg value) {
+	Request req;
+	memset(&req, 0, sizeof(Request));
+	req.op = SET_BANK;
+	BankUpdate update = {mask, value};
+
+	if (!writeAll(fd, &req, sizeof(Request)) || !writeAll(fd, &update, sizeof(BankUpdate))) {
+		cerr << "Error in write" << endl;
+		return false;
+	}
+	return true;
+}
+
+bool GpioClient::subscribe(Reg mask, bool shared) {
+	Request req;
+	memset(&req, 0, sizeof(Request));
+	req.op = shared ? SUBSCRIBE_SHARED : SUBSCRIBE;
+	Subscription sub = {mask};
+
+	if (!writeAll(fd, &req, sizeof(Request)) || !writeAll(fd, &sub, sizeof(Subscription))) {
+		cerr << "Error in write" << endl;
+		return false;
+	}
+	if (shared) {
+		SharedRing reply;
+		if (!readAll(fd, &reply, sizeof(SharedRing)) || reply.shmid < 0) {
+			cerr << "Server could not set up the shared event ring" << endl;
+			return false;
+		}
+		ring = reinterpret_cast<EventRing *>(shmat(reply.shmid, nullptr, 0));
+		if (ring == (EventRing *)-1) {
+			perror("shmat");
+			ring = nullptr;
+			return false;
+		}
+	}
+	subscribed = true;
+	return true;
+}
+
+static bool readable(int fd, int timeout) {
+	struct pollfd pfd = {fd, POLLIN, 0};
+	int ret;
+	while ((ret = poll(&pfd, 1, timeout)) < 0 && errno == EINTR)
+		;
+	return ret > 0;
+}
+
+bool GpioClient::receiveBatch(const std::function<void(const Event &)> &onEvent, uint32_t *dropped) {
+	EventBatch header;
+	if (!readAll(fd, &header, sizeof(EventBatch)))
+		return false;
+	if (dropped)
+		*dropped += header.dropped;
+
+	std::vector<Event> events(header.count);
+	if (!readAll(fd, events.data(), header.count * sizeof(Event)))
+		return false;
+	for (auto &e : events) {
+		state = e.state;
+		if (onEvent)
+			onEvent(e);
+	}
+	return true;
+}
+
+bool GpioClient::receiveEvents(std::function<void(const Event &)> onEvent, bool wait, uint32_t *dropped) {
+	if (!subscribed)
+		return false;
+
+	if (!ring) {
+		// at least one batch if waiting, then all that already arrived
+		if (wait && !receiveBatch(onEvent, dropped))
+			return false;
+		while (readable(fd, 0)) {
+			if (!receiveBatch(onEvent, dropped))
+				return false;
+		}
+		return true;
+	}
+
+	bool received = false;
+	while (true) {
+		while (readable(fd, 0)) {  // doorbells, i.e. empty batches
+			if (!receiveBatch(onEvent, dropped))
+				return false;
+		}
+
+		uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		for (uint64_t tail = ring->tail; tail != head; tail++) {
+			Event e = ring->events[tail % EventRing::capacity];
+			__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+			state = e.state;
+			if (onEvent)
+				onEvent(e);
+			received = true;
+		}
+		uint32_t lost = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+		if (lost) {
+			state = __atomic_load_n(&ring->state, __ATOMIC_RELAXED);
+			if (dropped)
+				*dropped += lost;
+		}
+
+		// request a doorbell, then check again to not miss an event pushed in between
+		__atomic_store_n(&ring->waiting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) != ring->tail)
+			continue;
+		if (received || !wait)
+			return true;
+		if (!readable(fd, -1))
+			return false;
+	}
+}
+
 bool GpioClient::setupConnection(const char *host, const char *port) {
 	struct addrinfo hints, *servinfo, *p;
 	int rv;
 	char s[INET6_ADDRSTRLEN];
 
+	// reconnecting
+	if (ring) {
+		shmdt(ring);
+		ring = nullptr;
+	}
+	if (fd >= 0) {
+		close(fd);
+		fd = -1;
+	}
+	subscribed = false;
+
 	memset(&hints, 0, sizeof hints);
 	hints.ai_family = AF_UNSPEC;
 	hints.ai_socktype = SOCK_STREAM;
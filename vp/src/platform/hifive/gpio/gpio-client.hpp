@@ -7,15 +7,34 @@
 
 #pragma once
 
+#include <functional>
 #include "gpiocommon.hpp"
 
 class GpioClient : public GpioCommon {
 	int fd;
+	bool subscribed;
+	EventRing* ring;  // with a shared subscription
+
+	bool receiveBatch(const std::function<void(const Event&)>& onEvent, uint32_t* dropped);
 
    public:
 	GpioClient();
 	~GpioClient();
 	bool setupConnection(const char* host, const char* port);
+	/* fetches the state, with a subscription the pushed events are applied instead (without blocking) */
 	bool update();
 	bool setBit(uint8_t pos, Tristate val);
+	bool setBank(Reg mask, Reg value);
+
+	/* Requests the changes of the pins in *mask* to be pushed, *shared* passes them through shared memory (the VP
+	 * has to run on the same host). */
+	bool subscribe(Reg mask, bool shared = false);
+	/* Delivers the pushed events in order and updates *state*, blocks until there is at least one if *wait* is
+	 * set. Afterwards the connection becomes readable (see getFd) as soon as further events arrive. Returns false
+	 * if the connection is closed. */
+	bool receiveEvents(std::function<void(const Event&)> onEvent, bool wait, uint32_t* dropped = nullptr);
+
+	int getFd() const {
+		return fd;
+	}
 };
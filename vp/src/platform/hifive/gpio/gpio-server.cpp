@@ -15,10 +15,13 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -36,7 +39,7 @@ static void *get_in_addr(struct sockaddr *sa) {
 	return &(((struct sockaddr_in6 *)sa)->sin6_addr);
 }
 
-GpioServer::GpioServer() : fd(-1), stop(false), fun(nullptr) {}
+GpioServer::GpioServer() : fd(-1), port(nullptr), stop(false), fun(nullptr), numSubscribers(0) {}
 
 GpioServer::~GpioServer() {
 	if (fd >= 0) {
@@ -132,6 +135,8 @@ void GpioServer::startListening() {
 	}
 	// printf("gpio-server: accepting connections (%d)\n", fd);
 
+	thread sender(&GpioServer::sendEvents, this);
+
 	struct sockaddr_storage their_addr;  // connector's address information
 	socklen_t sin_size = sizeof their_addr;
 	char s[INET6_ADDRSTRLEN];
@@ -143,59 +148,225 @@ void GpioServer::startListening() {
 			cerr << "gpio-server accept return " << new_fd << endl;
 			perror("accept");
 			stop = true;
-			return;
+			break;
+		}
+		if (stop) {  // woken up by quit
+			close(new_fd);
+			break;
 		}
 
 		inet_ntop(their_addr.ss_family, get_in_addr((struct sockaddr *)&their_addr), s, sizeof s);
 		DEBUG("gpio-server: got connection from %s\n", s);
-		handleConnection(new_fd);
+
+		lock_guard<mutex> lock(connectionsMutex);
+		connections.push_back(new_fd);
+		connectionThreads.emplace_back(&GpioServer::handleConnection, this, new_fd);
+	}
+
+	// terminate the connection threads, they close their connection themselves
+	{
+		lock_guard<mutex> lock(connectionsMutex);
+		for (int conn : connections) shutdown(conn, SHUT_RDWR);
+	}
+	for (auto &t : connectionThreads) t.join();
+	connectionThreads.clear();
+
+	{
+		lock_guard<mutex> lock(subscribersMutex);
+		subscribersCond.notify_all();
+	}
+	sender.join();
+}
+
+void GpioServer::setBit(uint8_t bit, Tristate val) {
+	if (fun != nullptr) {
+		fun(bit, val);
+	} else {
+		if (val == 0)
+			state &= ~(1l << bit);
+		else if (val == 1)
+			state |= 1l << bit;
+		else if (val == 2)
+			cout << "set bit " << bit << " unset" << endl;
 	}
 }
 
 void GpioServer::handleConnection(int conn) {
 	Request req;
 	memset(&req, 0, sizeof(Request));
-	int bytes;
-	while ((bytes = read(conn, &req, sizeof(Request))) == sizeof(Request)) {
+	bool subscribed = false;
+	while (readAll(conn, &req, sizeof(Request))) {
 		// hexPrint(reinterpret_cast<char*>(&req), bytes);
-		switch (req.op) {
-			case GET_BANK:
-				if (write(conn, &state, sizeof(Reg)) != sizeof(Reg)) {
-					cerr << "could not write answer" << endl;
-					close(conn);
-					return;
-				}
-				break;
-			case SET_BIT: {
-				// printRequest(&req);
-				if (req.setBit.pos > 63) {
-					cerr << "invalid request" << endl;
-					return;
-				}
-				if (req.setBit.val > 2) {
-					cerr << "invalid request" << endl;
-					return;
-				}
-
-				if (fun != nullptr) {
-					fun(req.setBit.pos, req.setBit.val);
-				} else {
-					if (req.setBit.val == 0)
-						state &= ~(1l << req.setBit.pos);
-					else if (req.setBit.val == 1)
-						state |= 1l << req.setBit.pos;
-					else if (req.setBit.val == 2)
-						cout << "set bit " << req.setBit.pos << " unset" << endl;
-				}
-
+		if (subscribed && req.op != SET_BIT && req.op != SET_BANK) {
+			cerr << "invalid request on subscribed connection" << endl;
+			break;
+		}
+		if (req.op == GET_BANK) {
+			if (!writeAll(conn, &state, sizeof(Reg))) {
+				cerr << "could not write answer" << endl;
 				break;
 			}
-			default:
+		} else if (req.op == SET_BIT) {
+			// printRequest(&req);
+			if (req.setBit.pos > 63 || req.setBit.val > 2) {
 				cerr << "invalid request" << endl;
-				return;
+				break;
+			}
+			setBit(req.setBit.pos, req.setBit.val);
+		} else if (req.op == SET_BANK) {
+			BankUpdate update;
+			if (!readAll(conn, &update, sizeof(BankUpdate)))
+				break;
+			for (uint8_t bit = 0; bit < 64; bit++) {
+				if (update.mask & (1ull << bit))
+					setBit(bit, (update.value >> bit) & 1);
+			}
+		} else if (req.op == SUBSCRIBE || req.op == SUBSCRIBE_SHARED) {
+			Subscription sub;
+			if (!readAll(conn, &sub, sizeof(Subscription)) || !subscribe(conn, sub.mask, req.op == SUBSCRIBE_SHARED))
+				break;
+			subscribed = true;
+		} else {
+			cerr << "invalid request" << endl;
+			break;
 		}
 	}
 
-	DEBUG("gpio-client disconnected (%d)\n", bytes);
+	DEBUG("gpio-client disconnected\n");
+	if (subscribed)
+		unsubscribe(conn);
+	lock_guard<mutex> lock(connectionsMutex);
+	connections.erase(find(connections.begin(), connections.end(), conn));
 	close(conn);
 }
+
+bool GpioServer::subscribe(int conn, Reg mask, bool shared) {
+	EventRing *ring = nullptr;
+	SharedRing reply = {-1};
+	if (shared) {
+		reply.shmid = shmget(IPC_PRIVATE, sizeof(EventRing), IPC_CREAT | 0600);
+		if (reply.shmid >= 0) {
+			ring = reinterpret_cast<EventRing *>(shmat(reply.shmid, nullptr, 0));
+			if (ring == (EventRing *)-1) {
+				shmctl(reply.shmid, IPC_RMID, nullptr);
+				reply.shmid = -1;
+				ring = nullptr;
+			}
+		}
+		if (!ring)
+			perror("gpio-server: shared event ring");
+		else
+			memset(ring, 0, sizeof(EventRing));
+		// the reply goes out before any event batch, the sender thread does not know the subscriber yet
+		if (!writeAll(conn, &reply, sizeof(SharedRing)) || !ring) {
+			if (ring) {
+				shmdt(ring);
+				shmctl(reply.shmid, IPC_RMID, nullptr);
+			}
+			return false;
+		}
+	}
+
+	lock_guard<mutex> lock(subscribersMutex);
+	subscribers.emplace_back();
+	Subscriber &s = subscribers.back();
+	s.conn = conn;
+	s.mask = mask;
+	s.last = state;
+	s.ring = ring;
+	s.shmid = reply.shmid;
+	queueEvent(s, Event{lastTime, state});  // the client starts with the current state
+	numSubscribers++;
+	subscribersCond.notify_all();
+	return true;
+}
+
+void GpioServer::unsubscribe(int conn) {
+	unique_lock<mutex> lock(subscribersMutex);
+	for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+		if (it->conn != conn)
+			continue;
+		subscribersCond.wait(lock, [&] { return !it->sending; });
+		if (it->ring) {
+			shmdt(it->ring);
+			shmctl(it->shmid, IPC_RMID, nullptr);
+		}
+		subscribers.erase(it);
+		numSubscribers--;
+		return;
+	}
+}
+
+void GpioServer::queueEvent(Subscriber &s, const Event &e) {
+	if (s.ring) {
+		EventRing *r = s.ring;
+		__atomic_store_n(&r->state, e.state, __ATOMIC_RELAXED);
+		uint64_t head = r->head;
+		if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= EventRing::capacity) {
+			__atomic_fetch_add(&r->dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		r->events[head % EventRing::capacity] = e;
+		// pairs with the client setting *waiting* and checking *head* before it sleeps
+		__atomic_store_n(&r->head, head + 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST)) {
+			__atomic_store_n(&r->waiting, 0, __ATOMIC_RELAXED);
+			s.doorbell = true;
+			subscribersCond.notify_all();
+		}
+	} else if (s.pending.size() >= maxPendingEvents) {
+		s.pending.back() = e;  // keep the latest state
+		s.dropped++;
+	} else {
+		if (s.pending.empty())
+			subscribersCond.notify_all();
+		s.pending.push_back(e);
+	}
+}
+
+void GpioServer::publish(uint64_t time) {
+	lastTime = time;
+	if (numSubscribers.load(memory_order_relaxed) == 0)
+		return;
+
+	Reg now = state;
+	lock_guard<mutex> lock(subscribersMutex);
+	for (auto &s : subscribers) {
+		if ((now ^ s.last) & s.mask) {
+			s.last = now;
+			queueEvent(s, Event{time, now});
+		}
+	}
+}
+
+void GpioServer::sendEvents() {
+	vector<Event> batch;
+	unique_lock<mutex> lock(subscribersMutex);
+	while (!stop) {
+		bool sent = false;
+		for (auto &s : subscribers) {
+			if (s.pending.empty() && !s.doorbell && !s.dropped)
+				continue;
+
+			EventBatch header = {uint32_t(s.pending.size()), s.dropped};
+			batch.swap(s.pending);
+			s.dropped = 0;
+			s.doorbell = false;
+			s.sending = true;
+
+			// write without the lock, the subscriber is not removed while *sending* is set. Errors are noticed by
+			// the connection thread, which unsubscribes.
+			lock.unlock();
+			if (writeAll(s.conn, &header, sizeof(EventBatch)))
+				writeAll(s.conn, batch.data(), batch.size() * sizeof(Event));
+			batch.clear();
+			lock.lock();
+
+			s.sending = false;
+			subscribersCond.notify_all();
+			sent = true;
+		}
+		if (!sent)
+			subscribersCond.wait(lock);
+	}
+}
@@ -7,15 +7,53 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "gpiocommon.hpp"
 
+/* Serves any number of clients, each connection is handled by its own thread. Pin changes are pushed to the
+ * subscribed clients by a sender thread, see publish. */
 class GpioServer : public GpioCommon {
+	static constexpr size_t maxPendingEvents = 1 << 16;  // per subscriber, further events replace the last one
+
+	struct Subscriber {
+		int conn;
+		Reg mask;
+		Reg last;                    // state of the last event
+		std::vector<Event> pending;  // to be sent by the sender thread
+		uint32_t dropped = 0;
+		EventRing* ring = nullptr;  // SUBSCRIBE_SHARED
+		int shmid = -1;
+		bool doorbell = false;
+		bool sending = false;  // the sender thread writes to *conn*
+	};
+
 	int fd;
 	const char *port;
 	volatile bool stop;
 	std::function<void(uint8_t bit, Tristate val)> fun;
+
+	uint64_t lastTime = 0;
+	std::mutex subscribersMutex;
+	std::condition_variable subscribersCond;
+	std::list<Subscriber> subscribers;
+	std::atomic<unsigned> numSubscribers;
+
+	std::mutex connectionsMutex;
+	std::vector<int> connections;
+	std::vector<std::thread> connectionThreads;
+
 	void handleConnection(int conn);
+	void setBit(uint8_t bit, Tristate val);
+	bool subscribe(int conn, Reg mask, bool shared);
+	void unsubscribe(int conn);
+	void queueEvent(Subscriber &s, const Event &e);
+	void sendEvents();
 
    public:
 	GpioServer();
@@ -25,4 +63,9 @@ class GpioServer : public GpioCommon {
 	bool isStopped();
 	void registerOnChange(std::function<void(uint8_t bit, Tristate val)> fun);
 	void startListening();
+
+	/* To be called after each change of *state*, *time* is the (simulation) time of the change in ps. Only
+	 * queues the event for the subscribers whose pins changed, no system call unless a sleeping client has to be
+	 * woken up. */
+	void publish(uint64_t time);
 };
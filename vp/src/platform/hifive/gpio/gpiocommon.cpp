@@ -7,7 +7,9 @@
 
 #include "gpiocommon.hpp"
 
+#include <errno.h>
 #include <stdio.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
@@ -31,11 +33,48 @@ void bitPrint(unsigned char* buf, size_t size) {
 	printf("\n");
 }
 
+bool readAll(int fd, void* buf, size_t len) {
+	uint8_t* p = reinterpret_cast<uint8_t*>(buf);
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+bool writeAll(int fd, const void* buf, size_t len) {
+	const uint8_t* p = reinterpret_cast<const uint8_t*>(buf);
+	while (len > 0) {
+		ssize_t n = send(fd, p, len, MSG_NOSIGNAL);  // a closed connection is reported, not signaled
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
 void GpioCommon::printRequest(Request* req) {
 	switch (req->op) {
 		case GET_BANK:
 			cout << "GET BANK";
 			break;
+		case SET_BANK:
+			cout << "SET BANK";
+			break;
+		case SUBSCRIBE:
+			cout << "SUBSCRIBE";
+			break;
+		case SUBSCRIBE_SHARED:
+			cout << "SUBSCRIBE SHARED";
+			break;
 		case SET_BIT:
 			cout << "SET BIT ";
 			cout << to_string(req->setBit.pos) << " to ";
@@ -19,7 +19,7 @@ struct GpioCommon {
 	typedef uint64_t Reg;
 	typedef uint8_t Tristate;
 
-	enum Operation : uint8_t { GET_BANK = 1, SET_BIT, SET_PWM };
+	enum Operation : uint8_t { GET_BANK = 1, SET_BIT, SET_PWM, SET_BANK, SUBSCRIBE, SUBSCRIBE_SHARED };
 
 	struct Request {
 		Operation op;
@@ -38,7 +38,53 @@ struct GpioCommon {
 		};
 	};
 
+	/* SET_BANK is followed by a BankUpdate, it changes all pins of *mask* at once (a batch of inputs) */
+	struct BankUpdate {
+		Reg mask;
+		Reg value;
+	};
+
+	/* SUBSCRIBE and SUBSCRIBE_SHARED are followed by a Subscription. From then on the server pushes the pin changes
+	 * within *mask* as EventBatches on the connection, starting with the current state. Requests other than
+	 * SET_BIT and SET_BANK must not be used on a subscribed connection. */
+	struct Subscription {
+		Reg mask;
+	};
+
+	struct Event {
+		uint64_t time;  // simulation time in ps
+		Reg state;      // all pins after the change
+	};
+
+	/* followed by *count* Events. With SUBSCRIBE_SHARED the events are placed in the EventRing instead and an empty
+	 * batch is sent as doorbell only if the client set *waiting* */
+	struct EventBatch {
+		uint32_t count;
+		uint32_t dropped;  // events merged into the last one, because the client did not keep up
+	};
+
+	/* reply to SUBSCRIBE_SHARED, the System V shared memory segment holding the EventRing (-1 on failure) */
+	struct SharedRing {
+		int32_t shmid;
+	};
+
+	/* single producer (the server), single consumer (the client) ring in shared memory */
+	struct EventRing {
+		static constexpr uint32_t capacity = 1 << 16;  // power of two
+
+		uint64_t head;     // next event to write, only written by the server
+		uint64_t tail;     // next event to read, only written by the client
+		uint32_t waiting;  // set by the client before it waits for the doorbell
+		uint32_t dropped;  // events lost because the ring was full, reset by the client
+		Reg state;         // the latest state, also updated while events are dropped
+		Event events[capacity];
+	};
+
 	Reg state;
 	void printRequest(Request* req);
 	GpioCommon();
 };
+
+/* reads/writes exactly *len* bytes from/to a socket, returns false on error or EOF */
+bool readAll(int fd, void* buf, size_t len);
+bool writeAll(int fd, const void* buf, size_t len);
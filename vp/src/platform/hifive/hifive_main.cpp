@@ -14,6 +14,7 @@
 #include "mem.h"
 #include "memory.h"
 #include "prci.h"
+#include "pwm.h"
 #include "slip.h"
 #include "spi.h"
 #include "uart.h"
@@ -74,6 +75,12 @@ public:
 	addr_t spi2_end_addr = 0x10034FFF;
 	addr_t gpio0_start_addr = 0x10012000;
 	addr_t gpio0_end_addr = 0x10012FFF;
+	addr_t pwm0_start_addr = 0x10015000;
+	addr_t pwm0_end_addr = 0x10015FFF;
+	addr_t pwm1_start_addr = 0x10025000;
+	addr_t pwm1_end_addr = 0x10025FFF;
+	addr_t pwm2_start_addr = 0x10035000;
+	addr_t pwm2_end_addr = 0x10035FFF;
 	addr_t flash_size = 1024 * 1024 * 512;  // 512 MB flash
 	addr_t flash_start_addr = 0x20000000;
 	addr_t flash_end_addr = flash_start_addr + flash_size - 1;
@@ -83,12 +90,14 @@ public:
 
 	bool enable_can = false;
 	std::string tun_device = "tun0";
+	std::string isa;
 
 	HifiveOptions(void) {
         	// clang-format off
 		add_options()
 			("enable-can", po::bool_switch(&enable_can), "enable support for CAN peripheral")
-			("tun-device", po::value<std::string>(&tun_device), "tun device used by SLIP");
+			("tun-device", po::value<std::string>(&tun_device), "tun device used by SLIP")
+			("isa", po::value<std::string>(&isa), "select the ISA extensions, e.g. rv32imac (the FE310 configuration)");
         	// clang-format on
 	}
 };
@@ -105,17 +114,20 @@ int sc_main(int argc, char **argv) {
 	SimpleMemory dram("DRAM", opt.dram_size);
 	SimpleMemory flash("Flash", opt.flash_size);
 	ELFLoader loader(opt.input_program.c_str());
-	SimpleBus<2, 14> bus("SimpleBus");
+	SimpleBus<2, 17> bus("SimpleBus");
 	CombinedMemoryInterface iss_mem_if("MemoryInterface", core);
 	SyscallHandler sys("SyscallHandler");
 
 	FE310_PLIC<1, 53, 64, 7> plic("PLIC");
 	CLINT<1> clint("CLINT");
-	AON aon("AON");
+	AON aon("AON", INT_RTCCMP);
 	PRCI prci("PRCI");
 	GPIO gpio0("GPIO0", INT_GPIO_BASE);
-	SPI spi0("SPI0");
-	SPI spi1("SPI1");
+	PWM pwm0("PWM0", INT_PWM0_BASE, 8);
+	PWM pwm1("PWM1", INT_PWM1_BASE, 16);
+	PWM pwm2("PWM2", INT_PWM2_BASE, 16);
+	SPI spi0("SPI0", INT_SPI0_BASE);
+	SPI spi1("SPI1", INT_SPI1_BASE);
 	std::unique_ptr<CAN> can = nullptr;
 	if (opt.enable_can) {
 		can = std::make_unique<CAN>();
@@ -123,7 +135,7 @@ int sc_main(int argc, char **argv) {
 	}
 	SS1106 oled([&gpio0]{return gpio0.value & (1 << 10);});		//pin 16 is offset 10
 	spi1.connect(2, oled);
-	SPI spi2("SPI2");
+	SPI spi2("SPI2", INT_SPI2_BASE);
 	UART uart0("UART0", 3);
 	SLIP slip("SLIP", 4, opt.tun_device);
 	MaskROM maskROM("MASKROM");
@@ -142,6 +154,10 @@ int sc_main(int argc, char **argv) {
 		instr_mem_if = &instr_mem;
 	if (opt.use_data_dmi)
 		iss_mem_if.dmi_ranges.emplace_back(dram_dmi);
+	for (SPI *spi : {&spi0, &spi1, &spi2}) {
+		spi->dmi_ranges.emplace_back(dram_dmi);
+		spi->dmi_ranges.emplace_back(flash_dmi);
+	}
 
 	bus.ports[0] = new PortMapping(opt.flash_start_addr, opt.flash_end_addr);
 	bus.ports[1] = new PortMapping(opt.dram_start_addr, opt.dram_end_addr);
@@ -157,11 +173,16 @@ int sc_main(int argc, char **argv) {
 	bus.ports[11] = new PortMapping(opt.spi1_start_addr, opt.spi1_end_addr);
 	bus.ports[12] = new PortMapping(opt.spi2_start_addr, opt.spi2_end_addr);
 	bus.ports[13] = new PortMapping(opt.uart1_start_addr, opt.uart1_end_addr);
+	bus.ports[14] = new PortMapping(opt.pwm0_start_addr, opt.pwm0_end_addr);
+	bus.ports[15] = new PortMapping(opt.pwm1_start_addr, opt.pwm1_end_addr);
+	bus.ports[16] = new PortMapping(opt.pwm2_start_addr, opt.pwm2_end_addr);
 
 	loader.load_executable_image(flash, flash.size, opt.flash_start_addr, false);
 	loader.load_executable_image(dram, dram.size, opt.dram_start_addr, false);
 
 	core.init(instr_mem_if, data_mem_if, &clint, loader.get_entrypoint(), rv32_align_address(opt.dram_end_addr));
+	if (!opt.isa.empty())
+		core.set_isa(opt.isa);
 	sys.init(dram.data, opt.dram_start_addr, loader.get_heap_addr());
 	sys.register_core(&core);
 
@@ -185,11 +206,21 @@ int sc_main(int argc, char **argv) {
 	bus.isocks[11].bind(spi1.tsock);
 	bus.isocks[12].bind(spi2.tsock);
 	bus.isocks[13].bind(slip.tsock);
+	bus.isocks[14].bind(pwm0.tsock);
+	bus.isocks[15].bind(pwm1.tsock);
+	bus.isocks[16].bind(pwm2.tsock);
 
 	// connect interrupt signals/communication
 	plic.target_harts[0] = &core;
 	clint.target_harts[0] = &core;
+	aon.plic = &plic;
 	gpio0.plic = &plic;
+	pwm0.plic = &plic;
+	pwm1.plic = &plic;
+	pwm2.plic = &plic;
+	spi0.plic = &plic;
+	spi1.plic = &plic;
+	spi2.plic = &plic;
 	uart0.plic = &plic;
 	slip.plic = &plic;
 
@@ -198,6 +229,9 @@ int sc_main(int argc, char **argv) {
 
 	core.trace = opt.trace_mode;  // switch for printing instructions
 	if (opt.use_debug_runner) {
+		dbg_if.dmi_ranges.emplace_back(dram_dmi);
+		dbg_if.dmi_ranges.emplace_back(flash_dmi);
+		dbg_if.add_memory_map(bus);
 		auto server = new GDBServer("GDBServer", threads, &dbg_if, opt.debug_port);
 		new GDBServerRunner("GDBRunner", server, &core);
 	} else {
@@ -8,7 +8,9 @@
 
 #include "oled.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 #include <sys/types.h>
 #include <sys/shm.h>
@@ -104,6 +106,22 @@ SS1106::~SS1106(){
 };
 
 
+void SS1106::transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+{
+	//The DC pin does not change within a burst, display data is copied row-wise
+	size_t n = 0;
+	if(getDCPin() && state->page < height/8 && state->column < width)
+	{
+		n = std::min<size_t>(len, width - state->column);
+		memcpy(&state->frame[state->page][state->column], tx, n);
+		state->column += n;
+		state->changed = 1;
+		if(rx)
+			memset(rx, 0, n);
+	}
+	SpiInterface::transfer(tx + n, rx ? rx + n : nullptr, len - n);
+}
+
 uint8_t SS1106::write(uint8_t byte)
 {
 	if(getDCPin())
@@ -46,4 +46,5 @@ public:
 	~SS1106();
 
 	uint8_t write(uint8_t byte) override;
+	void transfer(const uint8_t *tx, uint8_t *rx, size_t len) override;
 };
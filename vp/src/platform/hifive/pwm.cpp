@@ -0,0 +1,246 @@
+#include "pwm.h"
+
+PWM::PWM(sc_core::sc_module_name, unsigned int_pwm_base, unsigned cmp_width)
+    : int_pwm_base(int_pwm_base),
+      cmp_width(cmp_width),
+      cmp_mask((1u << cmp_width) - 1),
+      count_mask((1u << (cmp_width + 15)) - 1),
+      pwmcmp{{&pwmcmp0, &pwmcmp1, &pwmcmp2, &pwmcmp3}} {
+	tsock.register_b_transport(this, &PWM::transport);
+
+	router
+	    .add_register_bank({
+	        {PWMCFG_REG_ADDR, &pwmcfg},
+	        {PWMCOUNT_REG_ADDR, &pwmcount},
+	        {PWMS_REG_ADDR, &pwms},
+	        {PWMCMP0_REG_ADDR, &pwmcmp0},
+	        {PWMCMP1_REG_ADDR, &pwmcmp1},
+	        {PWMCMP2_REG_ADDR, &pwmcmp2},
+	        {PWMCMP3_REG_ADDR, &pwmcmp3},
+	    })
+	    .register_handler(this, &PWM::register_access_callback);
+
+	SC_THREAD(run);
+}
+
+uint32_t PWM::outputs() {
+	auto now = sc_core::sc_time_stamp();
+	sync(now);
+
+	uint32_t ip = ipAt(cycles(now));
+	uint32_t out = 0;
+	for (unsigned i = 0; i < NUM_CMP; ++i) {
+		// a ganged comparator is switched off by the next one
+		bool gang = pwmcfg & (1 << (CFG_GANG_SHIFT + i));
+		if ((ip & (1 << i)) && !(gang && (ip & (1 << ((i + 1) % NUM_CMP)))))
+			out |= 1 << i;
+	}
+	return out;
+}
+
+void PWM::register_access_callback(const vp::map::register_access_t &r) {
+	rebase(sc_core::sc_time_stamp() + r.delay);
+
+	uint32_t ip = ipAt(0);
+	if (r.read) {
+		pwmcfg = (pwmcfg & ~(0xF << CFG_IP_SHIFT)) | (ip << CFG_IP_SHIFT);
+		pwms = (pwmcount >> scale()) & cmp_mask;
+	} else if (r.vptr == &pwms) {
+		return;  // read-only view of the counter
+	}
+
+	r.fn();
+
+	if (!r.write)
+		return;
+
+	if (r.vptr == &pwmcfg) {
+		// software sets and clears the ip bits, comparators that are still on set them again
+		ip = (pwmcfg >> CFG_IP_SHIFT) & 0xF;
+		ip_sticky = ip;
+	} else if (r.vptr == &pwmcount) {
+		pwmcount &= count_mask;
+	} else {
+		*r.vptr &= cmp_mask;
+	}
+
+	uint32_t now = ipAt(0);
+	ip_sticky = (pwmcfg & CFG_STICKY) ? now : 0;
+	trigger(now & ~ip);
+	schedule();
+}
+
+void PWM::transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+	router.transport(trans, delay);
+}
+
+void PWM::run() {
+	while (true) {
+		const sc_core::sc_event *enable = plic->gateway_enable_event();
+		if (enable)
+			sc_core::wait(e_edge | *enable);
+		else
+			sc_core::wait(e_edge);
+
+		sync(sc_core::sc_time_stamp());
+		schedule();
+	}
+}
+
+uint64_t PWM::cycles(const sc_core::sc_time &t) const {
+	if (t <= time_base)
+		return 0;
+	return (t - time_base).value() / clock_cycle.value();
+}
+
+unsigned PWM::scale() const {
+	return pwmcfg & CFG_SCALE_MASK;
+}
+
+uint64_t PWM::resetLimit() const {
+	if (pwmcfg & CFG_ZEROCMP)
+		return uint64_t(pwmcmp0) << scale();
+	return count_mask;
+}
+
+uint64_t PWM::firstReset() const {
+	uint64_t limit = resetLimit();
+	return pwmcount >= limit ? 1 : limit - pwmcount + 1;
+}
+
+uint64_t PWM::countAt(uint64_t k) const {
+	if (!(pwmcfg & (CFG_ENALWAYS | CFG_ENONESHOT)))
+		return pwmcount;
+
+	uint64_t reset = firstReset();
+	if (k < reset)
+		return pwmcount + k;
+	if (!(pwmcfg & CFG_ENALWAYS))
+		return 0;  // one shot is over
+	return (k - reset) % (resetLimit() + 1);
+}
+
+uint32_t PWM::levelsAt(uint64_t count) const {
+	// pwms wraps within a counter period unless the scale uses up all 15 extra bits
+	uint32_t s = (count >> scale()) & cmp_mask;
+	uint32_t half = 1u << (cmp_width - 1);
+
+	uint32_t levels = 0;
+	for (unsigned i = 0; i < NUM_CMP; ++i) {
+		uint32_t cmp = *pwmcmp[i];
+		bool on;
+		if (pwmcfg & (1 << (CFG_CENTER_SHIFT + i))) {
+			// counts up and down again, deglitch keeps the output on until the next wrap
+			uint32_t centered = s < half ? s : cmp_mask - s;
+			on = centered >= cmp || ((pwmcfg & CFG_DEGLITCH) && cmp < half && s >= cmp);
+		} else {
+			on = s >= cmp;
+		}
+		if (on)
+			levels |= 1 << i;
+	}
+	return levels;
+}
+
+uint32_t PWM::ipAt(uint64_t k) const {
+	uint32_t ip = levelsAt(countAt(k));
+	if (pwmcfg & CFG_STICKY)
+		ip |= ip_sticky;
+	return ip;
+}
+
+/* First cycle after *k* at which comparator *i* switches on, the counter value is (pwmcmpX << pwmscale) then. */
+uint64_t PWM::nextEdge(unsigned i, uint64_t k) const {
+	uint32_t cmp = *pwmcmp[i];
+	bool center = pwmcfg & (1 << (CFG_CENTER_SHIFT + i));
+	if (!(pwmcfg & (CFG_ENALWAYS | CFG_ENONESHOT)) || cmp == 0 || (center && cmp >= (1u << (cmp_width - 1))))
+		return NEVER;  // stopped or always on
+
+	bool zerocmp = pwmcfg & CFG_ZEROCMP;
+	uint64_t v = uint64_t(cmp) << scale();
+	uint64_t pattern = (uint64_t(1) << (scale() + cmp_width)) - 1;  // pwms wraps
+	uint64_t limit = resetLimit();
+	if (zerocmp && v > limit)
+		return NEVER;
+
+	// up to the first reset, the counter counts up from pwmcount
+	uint64_t reset = firstReset();
+	uint64_t c = pwmcount + k + 1;
+	if (zerocmp) {
+		if (c <= v)
+			return k + 1 + (v - c);
+	} else if (k + 1 + ((v - c) & pattern) < reset) {
+		return k + 1 + ((v - c) & pattern);
+	}
+
+	if (!(pwmcfg & CFG_ENALWAYS))
+		return NEVER;
+
+	// from then on it repeats with period limit + 1
+	uint64_t start = std::max(k + 1, reset);
+	uint64_t q = (start - reset) % (limit + 1);
+	if (zerocmp)
+		return start + (v >= q ? v - q : v + limit + 1 - q);
+	return start + ((v - q) & pattern);
+}
+
+/* Processes the edges up to *now*: triggers their interrupts and holds the sticky ip bits. */
+void PWM::sync(const sc_core::sc_time &now) {
+	uint64_t k = cycles(now);
+	if (k <= checked)
+		return;
+
+	bool sticky = pwmcfg & CFG_STICKY;
+	uint32_t rising = 0;
+	for (unsigned i = 0; i < NUM_CMP; ++i) {
+		if (sticky && (ip_sticky & (1 << i)))
+			continue;
+		if (nextEdge(i, checked) <= k)
+			rising |= 1 << i;
+	}
+	if (sticky)
+		ip_sticky |= rising;
+	checked = k;
+	trigger(rising);
+}
+
+/* Moves *time_base* to *now*, such that registers can be accessed and changed directly. */
+void PWM::rebase(const sc_core::sc_time &now) {
+	sync(now);
+
+	uint64_t k = cycles(now);
+	if (pwmcfg & (CFG_ENALWAYS | CFG_ENONESHOT)) {
+		bool reset = k >= firstReset();
+		pwmcount = countAt(k);
+		if (reset)
+			pwmcfg &= ~CFG_ENONESHOT;
+	}
+	time_base += sc_core::sc_time::from_value(k * clock_cycle.value());
+	checked = 0;
+}
+
+void PWM::trigger(uint32_t ip) {
+	for (unsigned i = 0; i < NUM_CMP; ++i) {
+		if (ip & (1 << i))
+			plic->gateway_trigger_interrupt(int_pwm_base + i);
+	}
+}
+
+void PWM::schedule() {
+	e_edge.cancel();
+
+	bool sticky = pwmcfg & CFG_STICKY;
+	uint64_t next = NEVER;
+	for (unsigned i = 0; i < NUM_CMP; ++i) {
+		if (sticky && (ip_sticky & (1 << i)))
+			continue;  // stays on until software clears it
+		if (plic->gateway_interrupt_enabled(int_pwm_base + i))
+			next = std::min(next, nextEdge(i, checked));
+	}
+	if (next == NEVER)
+		return;
+
+	auto goal = time_base + sc_core::sc_time::from_value(next * clock_cycle.value());
+	auto now = sc_core::sc_time_stamp();
+	e_edge.notify(goal > now ? goal - now : sc_core::SC_ZERO_TIME);
+}
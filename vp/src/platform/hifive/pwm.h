@@ -0,0 +1,92 @@
+#pragma once
+
+#include "core/common/irq_if.h"
+#include "util/tlm_map.h"
+
+#include <tlm_utils/simple_target_socket.h>
+#include <array>
+#include <systemc>
+
+/* PWM block of the FE310 (chapter 14 of the manual), with four comparators that raise one interrupt each.
+ *
+ * The counter is not ticked. Its value follows from the clock cycles elapsed since the last register access
+ * (*time_base*, where it had the value *pwmcount*). Only the next rising edge of the comparators whose interrupt some
+ * hart has enabled is scheduled. Edges in between are caught up when the block is accessed or wakes up (sticky ip
+ * bits, interrupts that get enabled later). The output pins are computed on demand, see *outputs*. */
+struct PWM : public sc_core::sc_module {
+	tlm_utils::simple_target_socket<PWM> tsock;
+
+	static constexpr unsigned NUM_CMP = 4;
+	static constexpr uint64_t NEVER = UINT64_MAX;
+
+	enum : uint32_t {
+		CFG_SCALE_MASK = 0xF,
+		CFG_STICKY = 1 << 8,
+		CFG_ZEROCMP = 1 << 9,
+		CFG_DEGLITCH = 1 << 10,
+		CFG_ENALWAYS = 1 << 12,
+		CFG_ENONESHOT = 1 << 13,
+		CFG_CENTER_SHIFT = 16,
+		CFG_GANG_SHIFT = 24,
+		CFG_IP_SHIFT = 28,
+	};
+
+	// memory mapped configuration registers
+	uint32_t pwmcfg = 0;
+	uint32_t pwmcount = 0;
+	uint32_t pwms = 0;
+	uint32_t pwmcmp0 = 0;
+	uint32_t pwmcmp1 = 0;
+	uint32_t pwmcmp2 = 0;
+	uint32_t pwmcmp3 = 0;
+
+	enum {
+		PWMCFG_REG_ADDR = 0x00,
+		PWMCOUNT_REG_ADDR = 0x08,
+		PWMS_REG_ADDR = 0x10,
+		PWMCMP0_REG_ADDR = 0x20,
+		PWMCMP1_REG_ADDR = 0x24,
+		PWMCMP2_REG_ADDR = 0x28,
+		PWMCMP3_REG_ADDR = 0x2C,
+	};
+
+	vp::map::LocalRouter router = {"PWM"};
+	interrupt_gateway *plic = nullptr;
+
+	const unsigned int_pwm_base;
+	const unsigned cmp_width;  // 8 bit for PWM0, 16 bit for PWM1 and PWM2
+	const uint32_t cmp_mask;
+	const uint32_t count_mask;  // the counter has 15 bits more than the comparators
+	const std::array<uint32_t *, NUM_CMP> pwmcmp;
+	sc_core::sc_time clock_cycle = sc_core::sc_time(10, sc_core::SC_NS);
+
+	sc_core::sc_time time_base;
+	uint64_t checked = 0;      // cycles since *time_base* up to which the edges have been processed
+	uint32_t ip_sticky = 0;    // ip bits held by *CFG_STICKY*
+	sc_core::sc_event e_edge;  // next rising edge of an enabled interrupt
+
+	SC_HAS_PROCESS(PWM);
+	PWM(sc_core::sc_module_name, unsigned int_pwm_base, unsigned cmp_width);
+
+	/* current value of the four output pins */
+	uint32_t outputs();
+
+	void register_access_callback(const vp::map::register_access_t &r);
+	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay);
+
+	void run();
+
+	uint64_t cycles(const sc_core::sc_time &t) const;
+	unsigned scale() const;
+	uint64_t resetLimit() const;  // last counter value before it wraps to zero
+	uint64_t firstReset() const;  // cycle at which the counter is zero for the first time
+	uint64_t countAt(uint64_t k) const;
+	uint32_t levelsAt(uint64_t count) const;
+	uint32_t ipAt(uint64_t k) const;
+	uint64_t nextEdge(unsigned i, uint64_t k) const;
+
+	void sync(const sc_core::sc_time &now);
+	void rebase(const sc_core::sc_time &now);
+	void trigger(uint32_t ip);
+	void schedule();
+};
@@ -5,26 +5,76 @@
 
 #include <tlm_utils/simple_target_socket.h>
 
+#include "core/common/dmi.h"
 #include "core/common/irq_if.h"
 #include "util/tlm_map.h"
 
 #include <map>
-#include <queue>
+#include <vector>
 
 class SpiInterface {
    public:
 	virtual ~SpiInterface(){};
 	virtual uint8_t write(uint8_t byte) = 0;
+
+	/* Full duplex burst, *rx* is null if the answer is not needed. Devices that handle runs of bytes at once override
+	 * this, by default every byte goes through write. */
+	virtual void transfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			uint8_t byte = write(tx[i]);
+			if (rx)
+				rx[i] = byte;
+		}
+	}
 };
 
 typedef uint32_t Pin;
 
+/* Ring buffer of the FIFOs, *Depth* must be a power of two. */
+template <unsigned Depth>
+struct SpiFifo {
+	static_assert((Depth & (Depth - 1)) == 0, "depth must be a power of two");
+
+	uint8_t data[Depth];
+	unsigned head = 0;  // both only increase, the difference is the fill level
+	unsigned tail = 0;
+
+	unsigned size() const {
+		return tail - head;
+	}
+	bool empty() const {
+		return head == tail;
+	}
+	bool full() const {
+		return size() == Depth;
+	}
+	/* drops the oldest entry when full */
+	void push(uint8_t byte) {
+		if (full())
+			++head;
+		data[tail++ % Depth] = byte;
+	}
+	uint8_t pop() {
+		assert(!empty());
+		return data[head++ % Depth];
+	}
+};
+
+/* SPI controller of the FE310 (chapter 19 of the manual).
+ *
+ * Transmitted bytes reach the device immediately, hence the TX FIFO is always empty. The RX FIFO holds the 8 most
+ * recent answers, none are kept in TX only mode (fmt.dir). The watermark interrupts are raised on their rising edge.
+ *
+ * As an extension of the VP, the block registers move a whole buffer in one transfer: write the source (*bulk_tx*)
+ * and destination (*bulk_rx*, 0 to discard the answers) addresses in main memory, writing the length then performs
+ * the transfer on the current chip select. */
 struct SPI : public sc_core::sc_module {
 	tlm_utils::simple_target_socket<SPI> tsock;
 
-	//single queue for all targets
-	static constexpr uint_fast8_t queue_size   = 16;
-	std::queue<uint8_t> rxqueue;
+	static constexpr unsigned FIFO_DEPTH = 8;
+
+	//single FIFO for all targets
+	SpiFifo<FIFO_DEPTH> rxfifo;
 	std::map<Pin, SpiInterface *> targets;
 
 	// memory mapped configuration registers
@@ -44,6 +94,9 @@ struct SPI : public sc_core::sc_module {
 	uint32_t ffmt = 0;
 	uint32_t ie = 0;
 	uint32_t ip = 0;
+	uint32_t bulk_tx = 0;
+	uint32_t bulk_rx = 0;
+	uint32_t bulk_len = 0;
 
 	enum {
 		SCKDIV_REG_ADDR = 0x00,
@@ -62,15 +115,24 @@ struct SPI : public sc_core::sc_module {
 		FFMT_REG_ADDR = 0x64,
 		IE_REG_ADDR = 0x70,
 		IP_REG_ADDR = 0x74,
+		BULK_TX_REG_ADDR = 0x80,
+		BULK_RX_REG_ADDR = 0x84,
+		BULK_LEN_REG_ADDR = 0x88,
 	};
 
 	static constexpr uint_fast8_t SPI_IP_TXWM = 0x1;
 	static constexpr uint_fast8_t SPI_IP_RXWM = 0x2;
-
+	static constexpr uint32_t SPI_FMT_DIR_TX = 1 << 3;
+	static constexpr uint32_t SPI_RXDATA_EMPTY = 1 << 31;
 
 	vp::map::LocalRouter router = {"SPI"};
+	interrupt_gateway *plic = nullptr;
+	const unsigned int_spi;
+	uint32_t irq_active = 0;  // enabled and pending interrupts as last passed to the gateway
 
-	SPI(sc_core::sc_module_name) {
+	std::vector<MemoryDMI> dmi_ranges;  // memory accessible by block transfers
+
+	SPI(sc_core::sc_module_name, unsigned int_spi) : int_spi(int_spi) {
 		tsock.register_b_transport(this, &SPI::transport);
 
 		router
@@ -91,6 +153,9 @@ struct SPI : public sc_core::sc_module {
 		        {FFMT_REG_ADDR, &ffmt},
 		        {IE_REG_ADDR, &ie},
 		        {IP_REG_ADDR, &ip},
+		        {BULK_TX_REG_ADDR, &bulk_tx},
+		        {BULK_RX_REG_ADDR, &bulk_rx},
+		        {BULK_LEN_REG_ADDR, &bulk_len},
 		    })
 		    .register_handler(this, &SPI::register_access_callback);
 	}
@@ -102,14 +167,20 @@ struct SPI : public sc_core::sc_module {
 				if (target == targets.end()) {
 					std::cerr << "Read on unregistered Chip-Select " << csid << std::endl;
 				} else {
-					if (rxqueue.empty()) {
-						rxdata = 1 << 31;
+					if (rxfifo.empty()) {
+						rxdata = SPI_RXDATA_EMPTY;
 					} else {
-						rxdata = rxqueue.front();
-						rxqueue.pop();
+						rxdata = rxfifo.pop();
+						update_irq();
 					}
 				}
+			} else if (r.vptr == &txdata) {
+				txdata = 0;  // never full
+			} else if (r.vptr == &ip) {
+				ip = pending();
 			}
+		} else if (r.vptr == &ip) {
+			return;  // read-only
 		}
 
 		r.fn();
@@ -121,23 +192,70 @@ struct SPI : public sc_core::sc_module {
 				// std::cout << std::hex << txdata << " ";
 				auto target = targets.find(csid);
 				if (target != targets.end()) {
-					rxqueue.push(target->second->write(txdata));
-
-					//TODO: Model RX-Watermark IP
-					if(rxqueue.size() > queue_size)
-						rxqueue.pop();
-
-					//TODO: Model latency.
-					if(txmark > 0 && (ie & SPI_IP_TXWM))
-						ip |= SPI_IP_TXWM;
+					uint8_t byte = target->second->write(txdata);
+					if (!(fmt & SPI_FMT_DIR_TX))
+						rxfifo.push(byte);
+					update_irq();
 				} else {
 					std::cerr << "Write on unregistered Chip-Select " << csid << std::endl;
 				}
 				txdata = 0;
+			} else if (r.vptr == &bulk_len) {
+				bulk_transfer();
+				bulk_len = 0;
+			} else if (r.vptr == &txmark || r.vptr == &rxmark || r.vptr == &ie) {
+				update_irq();
 			}
 		}
 	}
 
+	uint32_t pending() const {
+		uint32_t p = 0;
+		if (txmark > 0)  // fewer entries than txmark in the (always empty) TX FIFO
+			p |= SPI_IP_TXWM;
+		if (rxfifo.size() > rxmark)
+			p |= SPI_IP_RXWM;
+		return p;
+	}
+
+	void update_irq() {
+		uint32_t active = pending() & ie;
+		if ((active & ~irq_active) && plic)
+			plic->gateway_trigger_interrupt(int_spi);
+		irq_active = active;
+	}
+
+	/* pointer to *len* bytes of main memory at *addr*, null if they are not in one range */
+	uint8_t *bulk_memory(uint32_t addr, uint32_t len, bool write) {
+		for (auto &e : dmi_ranges) {
+			if (e.contains(addr) && len <= e.get_end() - addr) {
+				if (write && e.tracks_writes())
+					e.mark_dirty(addr, len);
+				return e.get_mem_ptr_to_global_addr<uint8_t>(addr);
+			}
+		}
+		return nullptr;
+	}
+
+	void bulk_transfer() {
+		auto target = targets.find(csid);
+		if (target == targets.end()) {
+			std::cerr << "Block transfer on unregistered Chip-Select " << csid << std::endl;
+			return;
+		}
+		if (bulk_len == 0)
+			return;
+
+		const uint8_t *tx = bulk_memory(bulk_tx, bulk_len, false);
+		uint8_t *rx = bulk_rx ? bulk_memory(bulk_rx, bulk_len, true) : nullptr;
+		if (!tx || (bulk_rx && !rx)) {
+			std::cerr << "SPI block transfer of " << bulk_len << " bytes is not located in main memory" << std::endl;
+			return;
+		}
+
+		target->second->transfer(tx, rx, bulk_len);
+	}
+
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 		router.transport(trans, delay);
 	}
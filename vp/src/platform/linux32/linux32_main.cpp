@@ -11,6 +11,9 @@
 #include "mmu.h"
 #include "platform/common/slip.h"
 #include "platform/common/uart.h"
+#include "platform/common/virtio_blk.h"
+#include "platform/common/virtio_console.h"
+#include "platform/common/virtio_net.h"
 #include "prci.h"
 #include "syscall.h"
 #include "debug.h"
@@ -57,10 +60,21 @@ public:
 	addr_t plic_end_addr = 0x10000000;
 	addr_t prci_start_addr = 0x10000000;
 	addr_t prci_end_addr = 0x1000FFFF;
+	addr_t virtio_net_start_addr = 0x10080000;
+	addr_t virtio_net_end_addr = 0x10080fff;
+	addr_t virtio_blk_start_addr = 0x10081000;
+	addr_t virtio_blk_end_addr = 0x10081fff;
+	addr_t virtio_console_start_addr = 0x10082000;
+	addr_t virtio_console_end_addr = 0x10082fff;
 
 	OptionValue<unsigned long> entry_point;
 	std::string dtb_file;
 	std::string tun_device = "tun0";
+	std::string virtio_net_tap;
+	std::string virtio_net_socket;
+	std::string virtio_blk_image;
+	bool virtio_blk_read_only = false;
+	bool virtio_console = false;
 
 	LinuxOptions(void) {
         	// clang-format off
@@ -69,7 +83,12 @@ public:
 			("memory-size", po::value<unsigned int>(&mem_size), "set memory size")
 			("entry-point", po::value<std::string>(&entry_point.option),"set entry point address (ISS program counter)")
 			("dtb-file", po::value<std::string>(&dtb_file)->required(), "dtb file for boot loading")
-			("tun-device", po::value<std::string>(&tun_device), "tun device used by SLIP");
+			("tun-device", po::value<std::string>(&tun_device), "tun device used by SLIP")
+			("virtio-net-tap", po::value<std::string>(&virtio_net_tap), "TAP device used by the virtio network device")
+			("virtio-net-socket", po::value<std::string>(&virtio_net_socket), "unix seqpacket socket used by the virtio network device instead of a TAP device")
+			("virtio-blk-image", po::value<std::string>(&virtio_blk_image), "disk image used by the virtio block device")
+			("virtio-blk-read-only", po::bool_switch(&virtio_blk_read_only), "do not write to the disk image")
+			("virtio-console", po::bool_switch(&virtio_console), "connect the terminal input to the virtio console instead of UART0");
         	// clang-format on
 	}
 
@@ -119,15 +138,18 @@ int sc_main(int argc, char **argv) {
 	SimpleMemory mem("SimpleMemory", opt.mem_size);
 	SimpleMemory dtb_rom("DBT_ROM", opt.dtb_rom_size);
 	ELFLoader loader(opt.input_program.c_str());
-	SimpleBus<NUM_CORES + 1, 8> bus("SimpleBus");
+	SimpleBus<NUM_CORES + 1, 11> bus("SimpleBus");
 	SyscallHandler sys("SyscallHandler");
 	FU540_PLIC plic("PLIC", NUM_CORES);
 	CLINT<NUM_CORES> clint("CLINT");
 	PRCI prci("PRCI");
-	UART uart0("UART0", 3);
+	UART uart0("UART0", 3, !opt.virtio_console);
 	SLIP slip("SLIP", 4, opt.tun_device);
 	DebugMemoryInterface dbg_if("DebugMemoryInterface");
 	MemoryDMI dmi = MemoryDMI::create_start_size_mapping(mem.data, opt.mem_start_addr, mem.size);
+	VirtioNet virtio_net("VirtioNet", 5, dmi, opt.virtio_net_tap, opt.virtio_net_socket);
+	VirtioBlk virtio_blk("VirtioBlk", 6, dmi, opt.virtio_blk_image, opt.virtio_blk_read_only);
+	VirtioConsole virtio_console("VirtioConsole", 7, dmi, opt.virtio_console);
 
 	Core *cores[NUM_CORES];
 	for (unsigned i = 0; i < NUM_CORES; i++) {
@@ -163,6 +185,9 @@ int sc_main(int argc, char **argv) {
 	bus.ports[5] = new PortMapping(opt.uart1_start_addr, opt.uart1_end_addr);
 	bus.ports[6] = new PortMapping(opt.plic_start_addr, opt.plic_end_addr);
 	bus.ports[7] = new PortMapping(opt.prci_start_addr, opt.prci_end_addr);
+	bus.ports[8] = new PortMapping(opt.virtio_net_start_addr, opt.virtio_net_end_addr);
+	bus.ports[9] = new PortMapping(opt.virtio_blk_start_addr, opt.virtio_blk_end_addr);
+	bus.ports[10] = new PortMapping(opt.virtio_console_start_addr, opt.virtio_console_end_addr);
 
 	// connect TLM sockets
 	for (size_t i = 0; i < NUM_CORES; i++) {
@@ -177,6 +202,9 @@ int sc_main(int argc, char **argv) {
 	bus.isocks[5].bind(slip.tsock);
 	bus.isocks[6].bind(plic.tsock);
 	bus.isocks[7].bind(prci.tsock);
+	bus.isocks[8].bind(virtio_net.tsock);
+	bus.isocks[9].bind(virtio_blk.tsock);
+	bus.isocks[10].bind(virtio_console.tsock);
 
 	// connect interrupt signals/communication
 	for (size_t i = 0; i < NUM_CORES; i++) {
@@ -185,6 +213,9 @@ int sc_main(int argc, char **argv) {
 	}
 	uart0.plic = &plic;
 	slip.plic = &plic;
+	virtio_net.plic = &plic;
+	virtio_blk.plic = &plic;
+	virtio_console.plic = &plic;
 
 	for (size_t i = 0; i < NUM_CORES; i++) {
 		// switch for printing instructions
@@ -223,6 +254,7 @@ int sc_main(int argc, char **argv) {
 			mmus.push_back(&cores[i]->memif);
 		}
 
+		dbg_if.dmi_ranges.emplace_back(dmi);
 		auto server = new GDBServer("GDBServer", dharts, &dbg_if, opt.debug_port, mmus);
 		for (size_t i = 0; i < dharts.size(); i++)
 			new GDBServerRunner(("GDBRunner" + std::to_string(i)).c_str(), server, dharts[i]);
@@ -236,6 +268,8 @@ int sc_main(int argc, char **argv) {
 	for (size_t i = 0; i < NUM_CORES; i++) {
 		cores[i]->iss.show();
 	}
+	clint.show();
+	virtio_net.show();
 
 	return 0;
 }
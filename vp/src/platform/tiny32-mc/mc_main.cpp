@@ -116,6 +116,7 @@ int sc_main(int argc, char **argv) {
 	threads.push_back(&core1);
 
 	if (opt.use_debug_runner) {
+		dbg_if.add_memory_map(bus);
 		auto server = new GDBServer("GDBServer", threads, &dbg_if, opt.debug_port);
 		new GDBServerRunner("GDBRunner0", server, &core0);
 		new GDBServerRunner("GDBRunner1", server, &core1);
@@ -116,6 +116,8 @@ int sc_main(int argc, char **argv) {
 	threads.push_back(&core);
 
 	if (opt.use_debug_runner) {
+		dbg_if.dmi_ranges.emplace_back(dmi);
+		dbg_if.add_memory_map(bus);
 		auto server = new GDBServer("GDBServer", threads, &dbg_if, opt.debug_port);
 		new GDBServerRunner("GDBRunner", server, &core);
 	} else {
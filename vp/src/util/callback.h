@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstring>
+#include <functional>
+
+namespace vp {
+
+/*
+ * Callback of the register and memory mapping layers (tlm_map.h, memory_map.h), invoked through a per-target
+ * trampoline:
+ *  - bind<Module, &Module::fn>(this) resolves the member function at compile time,
+ *  - bind(this, &Module::fn) stores the member function pointer inline, no heap allocation,
+ *  - any other callable (e.g. a lambda or the result of std::bind) is assigned and kept in a std::function.
+ * Only the last one goes through std::function on the call path.
+ */
+template <typename R, typename... Args>
+class Callback {
+	typedef R (*invoke_t)(const Callback &, const Args &...);
+
+	void *obj = nullptr;
+	char member_fn[2 * sizeof(void *)];  // large enough for a member function pointer on all common ABIs
+	invoke_t invoke = nullptr;
+	std::function<R(Args...)> fn;
+
+	template <typename Module, R (Module::*MemberFun)(Args...)>
+	static R invoke_bound(const Callback &self, const Args &... args) {
+		return (static_cast<Module *>(self.obj)->*MemberFun)(args...);
+	}
+
+	template <typename Module, typename MemberFun>
+	static R invoke_stored(const Callback &self, const Args &... args) {
+		MemberFun f;
+		memcpy(&f, self.member_fn, sizeof(f));
+		return (static_cast<Module *>(self.obj)->*f)(args...);
+	}
+
+	static R invoke_function(const Callback &self, const Args &... args) {
+		return self.fn(args...);
+	}
+
+   public:
+	template <typename Module, R (Module::*MemberFun)(Args...)>
+	void bind(Module *this_) {
+		obj = this_;
+		invoke = &invoke_bound<Module, MemberFun>;
+	}
+
+	template <typename Module, typename MemberFun>
+	void bind(Module *this_, MemberFun mf) {
+		static_assert(sizeof(MemberFun) <= sizeof(member_fn), "member function pointer too large");
+		obj = this_;
+		memcpy(member_fn, &mf, sizeof(mf));
+		invoke = &invoke_stored<Module, MemberFun>;
+	}
+
+	template <typename F>
+	Callback &operator=(F f) {
+		fn = std::move(f);
+		invoke = &invoke_function;
+		return *this;
+	}
+
+	explicit operator bool() const {
+		return invoke != nullptr;
+	}
+
+	R operator()(const Args &... args) const {
+		return invoke(*this, args...);
+	}
+};
+
+}  // namespace vp
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
+#include <initializer_list>
 #include <vector>
+#include "callback.h"
 #include "common.h"
 
 struct RegisterRange {
@@ -19,16 +23,17 @@ struct RegisterRange {
 		sc_core::sc_time &delay;
 	};
 
-	typedef std::function<bool(WriteInfo)> PreWriteCallback;
-	typedef std::function<void(WriteInfo)> PostWriteCallback;
-	typedef std::function<bool(ReadInfo)> PreReadCallback;
-	typedef std::function<void(ReadInfo)> PostReadCallback;
+	/* Member functions are bound with bind<Module, &Module::fn>(this), any other callable can be assigned. */
+	typedef vp::Callback<bool, WriteInfo> PreWriteCallback;
+	typedef vp::Callback<void, WriteInfo> PostWriteCallback;
+	typedef vp::Callback<bool, ReadInfo> PreReadCallback;
+	typedef vp::Callback<void, ReadInfo> PostReadCallback;
 
 	uint64_t start;
 	uint64_t end;
 	std::vector<uint8_t> mem;
 	bool readonly = false;
-	uint64_t alignment = 1;
+	uint64_t alignment_mask = 0;  // see set_alignment
 
 	PreWriteCallback pre_write_callback;
 	PostWriteCallback post_write_callback;
@@ -62,10 +67,16 @@ struct RegisterRange {
 		return {start, sizeof(T) * num_elems};
 	}
 
-	bool contains(uint64_t addr) {
+	bool contains(uint64_t addr) const {
 		return addr >= start && addr <= end;
 	}
 
+	/* Address and length of all accesses have to be a multiple of *alignment*, which is a power of two. */
+	void set_alignment(uint64_t alignment) {
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+		alignment_mask = alignment - 1;
+	}
+
 	uint64_t to_local(uint64_t addr) {
 		return addr - start;
 	}
@@ -113,7 +124,7 @@ struct RegisterRange {
 		auto len = trans.get_data_length();
 		auto ptr = trans.get_data_ptr();
 
-		ensure((addr % alignment == 0) && (len % alignment == 0));
+		ensure(((addr | len) & alignment_mask) == 0);
 
 		if (cmd == tlm::TLM_READ_COMMAND) {
 			read(addr, ptr, len, trans, delay);
@@ -217,5 +228,70 @@ void route(const char *name, Iter &iterable_mm, tlm::tlm_generic_payload &trans,
 	throw std::runtime_error(std::string(name) + " unable to route address " + std::to_string(trans.get_address()));
 }
 
+/* Routes accesses to a fixed set of non-overlapping register ranges, which are sorted by start address once at
+ * construction. Small maps are scanned in order (stopping at the first range that ends at or after the address),
+ * larger ones (e.g. the per hart contexts of the FU540 PLIC) use a binary search. */
+class RegisterMap {
+	static constexpr size_t LINEAR_SEARCH_LIMIT = 8;
+
+	const char *name;
+	std::vector<RegisterRange *> ranges;
+
+   public:
+	RegisterMap(const char *name, std::initializer_list<RegisterRange *> ranges = {}) : name(name) {
+		for (auto r : ranges) add(r);
+	}
+
+	void add(RegisterRange *r) {
+		auto it = std::upper_bound(ranges.begin(), ranges.end(), r->start,
+		                           [](uint64_t addr, const RegisterRange *e) { return addr < e->start; });
+		if ((it != ranges.end() && (*it)->start <= r->end) || (it != ranges.begin() && (*(it - 1))->end >= r->start))
+			throw std::runtime_error(std::string(name) + " overlapping register ranges");
+		ranges.insert(it, r);
+	}
+
+	std::vector<RegisterRange *>::const_iterator begin() const {
+		return ranges.begin();
+	}
+
+	std::vector<RegisterRange *>::const_iterator end() const {
+		return ranges.end();
+	}
+
+	size_t size() const {
+		return ranges.size();
+	}
+
+	RegisterRange *operator[](size_t idx) const {
+		return ranges[idx];
+	}
+
+	RegisterRange *find(uint64_t addr) const {
+		if (ranges.size() <= LINEAR_SEARCH_LIMIT) {
+			for (auto r : ranges) {
+				if (addr <= r->end)
+					return addr >= r->start ? r : nullptr;
+			}
+			return nullptr;
+		}
+
+		// last range that starts at or before addr
+		auto it = std::upper_bound(ranges.begin(), ranges.end(), addr,
+		                           [](uint64_t addr, const RegisterRange *e) { return addr < e->start; });
+		if (it == ranges.begin())
+			return nullptr;
+		--it;
+		return (*it)->contains(addr) ? *it : nullptr;
+	}
+
+	void route(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) const {
+		auto r = find(trans.get_address());
+		if (!r)
+			throw std::runtime_error(std::string(name) + " unable to route address " +
+			                         std::to_string(trans.get_address()));
+		r->process(trans, delay);
+	}
+};
+
 }  // namespace mm
 }  // namespace vp
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+
+/* Bounded lock-free ring buffer for exactly one producer and one consumer thread. The indices grow monotonically
+ * (wrapping around is harmless as the capacity is a power of two), hence no slot has to be kept free. */
+template <typename T, size_t N>
+class SPSCRing {
+	static_assert(N > 0 && (N & (N - 1)) == 0, "capacity has to be a power of two");
+
+	alignas(64) std::atomic<size_t> head{0};  // next element to pop, only written by the consumer
+	alignas(64) std::atomic<size_t> tail{0};  // next free slot, only written by the producer
+	T buf[N];
+
+   public:
+	static constexpr size_t capacity = N;
+
+	/* producer side */
+	bool push(const T &value) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == N)
+			return false;
+		buf[t % N] = value;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* consumer side */
+	bool pop(T &value) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (tail.load(std::memory_order_acquire) == h)
+			return false;
+		value = buf[h % N];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	/* consumer side, the oldest element stays in the ring until discard is called */
+	T *front() {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (tail.load(std::memory_order_acquire) == h)
+			return nullptr;
+		return &buf[h % N];
+	}
+
+	void discard() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	/* consumer side, pops up to *max* elements at once and returns their number */
+	size_t pop(T *dst, size_t max) {
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t n = std::min(tail.load(std::memory_order_acquire) - h, max);
+		for (size_t i = 0; i < n; ++i) dst[i] = buf[(h + i) % N];
+		head.store(h + n, std::memory_order_release);
+		return n;
+	}
+
+	/* an upper bound when called by the producer, a lower bound when called by the consumer */
+	size_t size() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	bool full() const {
+		return size() == N;
+	}
+};
@@ -7,8 +7,12 @@
 #include <tlm_utils/simple_target_socket.h>
 
 #include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
 #include <functional>
-#include <unordered_map>
+#include <vector>
+
+#include "callback.h"
 
 /*
  * Optional modelling layer to simplify TLM register and memory access.
@@ -69,37 +73,46 @@ struct AddressMapping : public AbstractMapping {
 	uint64_t start;
 	uint64_t end;
 	access_mode mode;
-	fn_transport_t handler;
+	Callback<void, tlm::tlm_generic_payload &, sc_core::sc_time &> handler;
 
 	template <typename Module, typename MemberFun>
 	AddressMapping &register_handler(Module *this_, MemberFun fn) {
 		assert(!handler);
-		handler = std::bind(fn, this_, std::placeholders::_1, std::placeholders::_2);
+		handler.bind(this_, fn);
 		return *this;
 	}
 
 	AddressMapping &register_handler(AddressMapping::fn_transport_t fn) {
 		assert(!handler);
-		handler = fn;
+		handler = std::move(fn);
 		return *this;
 	}
 
-	bool try_handle(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+	bool contains(uint64_t addr) const {
+		return addr >= start && addr < end;
+	}
+
+	void handle(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 		auto addr = trans.get_address();
 		auto len = trans.get_data_length();
 		auto cmd = trans.get_command();
 
-		if (addr >= start && addr < end) {
-			assert((addr + len <= end) && "memory out of bounds access");
-			assert(mode.can_read() || cmd != tlm::TLM_READ_COMMAND);
-			assert(mode.can_write() || cmd != tlm::TLM_WRITE_COMMAND);
+		assert((addr + len <= end) && "memory out of bounds access");
+		assert(mode.can_read() || cmd != tlm::TLM_READ_COMMAND);
+		assert(mode.can_write() || cmd != tlm::TLM_WRITE_COMMAND);
+		(void)len;
+		(void)cmd;
 
-			trans.set_address(addr - start);
+		trans.set_address(addr - start);
 
-			handler(trans, delay);
-			return true;
-		}
-		return false;
+		handler(trans, delay);
+	}
+
+	bool try_handle(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) override {
+		if (!contains(trans.get_address()))
+			return false;
+		handle(trans, delay);
+		return true;
 	}
 };
 
@@ -124,9 +137,27 @@ struct reg_mapping_t {
 	}
 };
 
-struct register_access_t {
-	typedef std::function<void()> callback_t;
+/* Performs the actual (possibly partial) bus read/write of a register access. */
+struct bus_access_t {
+	reg_mapping_t *reg;
+	tlm::tlm_generic_payload *trans;
+
+	void operator()() const {
+		auto off = trans->get_address() % 4;
+		if (trans->get_command() == tlm::TLM_READ_COMMAND) {
+			uint32_t n = reg->bus_read();
+			memcpy(trans->get_data_ptr(), ((uint8_t *)&n) + off, trans->get_data_length());
+		} else if (trans->get_command() == tlm::TLM_WRITE_COMMAND) {
+			uint32_t n = reg->value();
+			memcpy(((uint8_t *)&n) + off, trans->get_data_ptr(), trans->get_data_length());
+			reg->bus_write(n);
+		} else {
+			throw std::runtime_error("unsupported TLM command detected");
+		}
+	}
+};
 
+struct register_access_t {
 	/*
 	 * vptr points to the actual register.
 	 * nv is the new value that will be assigned to the register (only valid for
@@ -136,86 +167,104 @@ struct register_access_t {
 	bool write;
 	uint32_t *vptr;
 	uint32_t nv;
-	callback_t fn;
+	bus_access_t fn;
 	sc_core::sc_time &delay;
 	uint64_t addr;
 };
 
+/*
+ * Register bank compiled into a dense table, indexed by the word offset of the access, that refers to the register
+ * descriptors. A lookup is a bounds check and two loads.
+ */
 struct RegisterMapping : public AbstractMapping {
-	typedef std::function<void()> callback_t;
 	typedef std::function<void(const register_access_t &)> handler_t;
 
-	std::unordered_map<uint64_t, reg_mapping_t> addr_to_reg;
-	handler_t handler;
+	std::vector<reg_mapping_t> regs;
+	std::vector<uint16_t> word_to_reg;  // register index + 1, zero if no register is mapped
+	uint64_t base = 0;
+	Callback<void, const register_access_t &> handler;
 
 	RegisterMapping &add_register(reg_mapping_t m) {
-		addr_to_reg.insert(std::make_pair(m.addr, m));
+		assert(!find(m.addr) && "register at this address already available");
+		regs.push_back(m);
+		rebuild();
 		return *this;
 	}
 
 	template <typename Module, typename MemberFun>
 	RegisterMapping &register_handler(Module *this_, MemberFun fn) {
 		assert(!handler);
-		handler = std::bind(fn, this_, std::placeholders::_1);
+		handler.bind(this_, fn);
 		return *this;
 	}
 
 	RegisterMapping &register_handler(RegisterMapping::handler_t fn) {
 		assert(!handler);
-		handler = fn;
+		handler = std::move(fn);
 		return *this;
 	}
 
-	bool try_handle(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
+	void rebuild() {
+		assert(!regs.empty() && regs.size() < UINT16_MAX);
+		uint64_t first = UINT64_MAX, last = 0;
+		for (auto &r : regs) {
+			assert(r.addr % 4 == 0 && "registers have to be word aligned");
+			first = std::min(first, r.addr);
+			last = std::max(last, r.addr);
+		}
+
+		base = first;
+		word_to_reg.assign((last - first) / 4 + 1, 0);
+		for (size_t i = 0; i < regs.size(); ++i) word_to_reg[(regs[i].addr - base) / 4] = i + 1;
+	}
+
+	reg_mapping_t *find(uint64_t addr) {
+		uint64_t word = (addr - base) / 4;  // wraps around for addresses below base
+		if (addr < base || word >= word_to_reg.size())
+			return nullptr;
+		auto idx = word_to_reg[word];
+		return idx ? &regs[idx - 1] : nullptr;
+	}
+
+	void handle(reg_mapping_t &r, tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
 		auto addr = trans.get_address();
-		auto new_vptr = (uint32_t *)trans.get_data_ptr();
 		auto len = trans.get_data_length();
 		auto cmd = trans.get_command();
 
-		auto it = addr_to_reg.find(addr - addr % 4);  // clamp to nearest register
-		if (it == addr_to_reg.end())
-			return false;
-
 		assert(len + (addr % 4) <= 4);  // do not allow access beyond the register
 		assert(cmd == tlm::TLM_READ_COMMAND || cmd == tlm::TLM_WRITE_COMMAND);
-
-		reg_mapping_t &r = it->second;
-
 		assert(r.mode.can_read() || cmd != tlm::TLM_READ_COMMAND);
 		assert(r.mode.can_write() || cmd != tlm::TLM_WRITE_COMMAND);
-
-		auto fn = [cmd, &r, new_vptr, &trans]() {
-		    (void) new_vptr;
-			auto off = trans.get_address() % 4;
-			if (cmd == tlm::TLM_READ_COMMAND) {
-				uint32_t n = r.bus_read();
-				memcpy(trans.get_data_ptr(), ((uint8_t *)&n) + off, trans.get_data_length());
-				//*new_vptr = r.bus_read();
-			} else if (cmd == tlm::TLM_WRITE_COMMAND) {
-				uint32_t n = r.value();
-				memcpy(((uint8_t *)&n) + off, trans.get_data_ptr(), trans.get_data_length());
-				r.bus_write(n);
-				// r.bus_write(*new_vptr);
-			} else {
-				throw std::runtime_error("unsupported TLM command detected");
-			}
-		};
-
 		assert(handler && "no callback function provided");
+		(void)len;
 
 		// introduce *nv* to get rid of "use of uninitialized value" warnings
 		uint32_t nv = 0;
 		if (cmd == tlm::TLM_WRITE_COMMAND)
-			nv = *new_vptr;
+			nv = *(uint32_t *)trans.get_data_ptr();
+
+		handler({cmd == tlm::TLM_READ_COMMAND, cmd == tlm::TLM_WRITE_COMMAND, r.vptr, nv, {&r, &trans}, delay, addr});
+	}
 
-		handler({cmd == tlm::TLM_READ_COMMAND, cmd == tlm::TLM_WRITE_COMMAND, r.vptr, nv, fn, delay, addr});
+	bool try_handle(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) override {
+		auto r = find(trans.get_address());
+		if (!r)
+			return false;
+		handle(*r, trans, delay);
 		return true;
 	}
 };
 
 struct LocalRouter {
+	/* Mappings in insertion order, dispatched without virtual calls. Exactly one of both pointers is set. */
+	struct route_t {
+		RegisterMapping *bank;
+		AddressMapping *range;
+	};
+
 	std::string name;
 	std::vector<AbstractMapping *> maps;
+	std::vector<route_t> routes;
 
 	LocalRouter(const std::string &name = "unamed") : name(name) {}
 
@@ -227,9 +276,17 @@ struct LocalRouter {
 	}
 
 	void transport(tlm::tlm_generic_payload &trans, sc_core::sc_time &delay) {
-		for (auto &m : maps) {
-			if (m->try_handle(trans, delay))
+		auto addr = trans.get_address();
+		for (auto &e : routes) {
+			if (e.bank) {
+				if (auto r = e.bank->find(addr)) {
+					e.bank->handle(*r, trans, delay);
+					return;
+				}
+			} else if (e.range->contains(addr)) {
+				e.range->handle(trans, delay);
 				return;
+			}
 		}
 		throw std::runtime_error("access of unmapped address (local TLM router): name=" + name + ", addr=0x" +
 		                         (boost::format("%X") % trans.get_address()).str());
@@ -238,10 +295,13 @@ struct LocalRouter {
 	RegisterMapping &add_register_bank(const std::vector<reg_mapping_t> &regs) {
 		auto p = new RegisterMapping();
 		for (auto &m : regs) {
-			assert(p->addr_to_reg.find(m.addr) == p->addr_to_reg.end() && "register at this address already available");
-			p->addr_to_reg.insert(std::make_pair(m.addr, m));
+			assert(std::none_of(p->regs.begin(), p->regs.end(), [&](const reg_mapping_t &r) { return r.addr == m.addr; }) &&
+			       "register at this address already available");
+			p->regs.push_back(m);
 		}
+		p->rebuild();
 		maps.push_back(p);
+		routes.push_back({p, nullptr});
 		return *p;
 	}
 
@@ -251,6 +311,7 @@ struct LocalRouter {
 		p->end = end;
 		p->mode = m;
 		maps.push_back(p);
+		routes.push_back({nullptr, p});
 		return *p;
 	}
 